@@ -0,0 +1,1455 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/buffer.h"
+#include "../header_files/checksum.h"
+#include "../header_files/codec.h"
+#include "../header_files/compress.h"
+#include "../header_files/decompress.h"
+#include "../header_files/codec_registry.h"
+
+
+#define BENCH_CHUNK_SIZE_BYTES      (1024u * 1024u)   // Corpora are generated and coded one chunk at a time
+#define BENCH_MESSAGE_SIZE_BYTES    (512u)            // Message size of the buffer API case
+#define BENCH_TOKEN_MAX_SIZE        (64u)
+#define BENCH_DEFAULT_SIZE_MIB      (64u)
+#define BENCH_DEFAULT_REPEAT_COUNT  (3u)
+#define BENCH_DEFAULT_THRESHOLD     (5.0)             // Percent change reported as a regression
+#define BENCH_MAX_RESULTS           (128u)
+#define BENCH_MAX_CODECS            (16u)       // Text rle and the registry codecs
+#define BENCH_JSON_LINE_SIZE        (1024u)
+#define BENCH_PATH_SIZE             (4096u)
+#define BENCH_CHECK_SIZE_BYTES      (64u * 1024u)     // Message corrupted by the decoder checks
+
+// Synthetic corpora, generated from a fixed seed so every run sees the same data
+typedef enum {
+    BENCH_CORPUS_RUNS,       // Long runs of one letter, 256..16384 bytes (padded fixed-width records)
+    BENCH_CORPUS_RANDOM,     // Uniform random bytes, the worst case of both formats
+    BENCH_CORPUS_ENGLISH,    // Words, spaces and punctuation, short runs only
+    BENCH_CORPUS_DIGITS,     // CSV-like numeric records, every digit takes the escape path of the text format
+    BENCH_CORPUS_COUNT
+} tenu_bench_corpus;
+
+// How the data reaches the codec
+typedef enum {
+    BENCH_MODE_STREAM,       // Push/pull streaming through a codec context, one chunk at a time
+    BENCH_MODE_MESSAGES,     // Buffer API on BENCH_MESSAGE_SIZE_BYTES messages with one reused context
+    BENCH_MODE_FILE,         // compress()/decompress() on files, I/O included (--dir only)
+    BENCH_MODE_COUNT
+} tenu_bench_mode;
+
+static const char *gapc_corpus_names[BENCH_CORPUS_COUNT] = {"runs", "random", "english", "digits"};
+static const char *gapc_mode_names[BENCH_MODE_COUNT] = {"stream", "messages", "file"};
+static const char *gapc_format_names[] = {"rle", "rle2"};     // File extension of every format
+
+static const char *gapc_words[] = {"the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with", "be", "by",
+                                   "on", "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have", "an",
+                                   "had", "they", "you", "were", "their", "one", "all", "we", "can", "her", "has", "there",
+                                   "been", "if", "more", "when", "will", "would", "who", "so", "no", "little", "all", "full",
+                                   "seem", "pass", "still", "well", "off", "too", "Mississippi", "bookkeeper", "coffee", "see"};
+
+// Deterministic corpus generator, the data does not depend on how it is cut into chunks
+typedef struct {
+    tenu_bench_corpus enu_corpus;
+    u64  u64_rand_state;
+    char ac_token[BENCH_TOKEN_MAX_SIZE];    // Token being copied out
+    u64  u64_token_size;
+    u64  u64_token_offset;
+    char c_run_char;                        // Run being copied out, runs corpus only
+    u64  u64_run_left;
+    u64  u64_record_idx;
+} tstr_bench_generator;
+
+// Timings of one repetition of one case
+typedef struct {
+    u64 u64_compress_ns;
+    u64 u64_decompress_ns;
+    u64 u64_input_size;
+    u64 u64_output_size;
+} tstr_bench_sample;
+
+// Result of one corpus/format/mode case, also the unit of the JSON output
+typedef struct {
+    char ac_corpus[16];
+    char ac_format[16];             // Text rle or the name of the block codec
+    char ac_mode[16];
+    u64 u64_input_size;
+    u64 u64_output_size;
+    f64 f64_ratio;                  // Input size over output size
+    f64 f64_compress_mbps;          // Best of all repetitions
+    f64 f64_decompress_mbps;
+    u64 u64_allocs_cold;            // Heap allocations of the first repetition
+    u64 u64_allocs_warm;            // Heap allocations of the last repetition, contexts reused
+    u64 u64_peak_rss_kib;
+} tstr_bench_result;
+
+// Heap allocations made through malloc/calloc/realloc since the start, see __wrap_malloc()
+static u64 gu64_alloc_count = 0;
+
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pv_data, size_t size);
+
+/**
+ * @brief Count one allocation, the benchmark is linked with -Wl,--wrap=malloc
+ * 
+ * @param[in] size Size of the allocation
+ * @return void* Allocated memory
+ */
+void *__wrap_malloc(size_t size)
+{
+    __atomic_add_fetch(&gu64_alloc_count, 1, __ATOMIC_RELAXED);
+
+    return __real_malloc(size);
+}
+
+/**
+ * @brief Count one allocation, the benchmark is linked with -Wl,--wrap=calloc
+ * 
+ * @param[in] count Number of elements
+ * @param[in] size Size of one element
+ * @return void* Allocated memory
+ */
+void *__wrap_calloc(size_t count, size_t size)
+{
+    __atomic_add_fetch(&gu64_alloc_count, 1, __ATOMIC_RELAXED);
+
+    return __real_calloc(count, size);
+}
+
+/**
+ * @brief Count one allocation, the benchmark is linked with -Wl,--wrap=realloc
+ * 
+ * @param[in] pv_data Memory to resize
+ * @param[in] size New size
+ * @return void* Resized memory
+ */
+void *__wrap_realloc(void *pv_data, size_t size)
+{
+    __atomic_add_fetch(&gu64_alloc_count, 1, __ATOMIC_RELAXED);
+
+    return __real_realloc(pv_data, size);
+}
+
+/**
+ * @brief Small deterministic xorshift generator, so every run sees the same data
+ * 
+ * @param[in out] pu64_state Generator state
+ * @return u64 Next pseudo-random number
+ */
+static u64 u64_bench_rand(u64 *pu64_state)
+{
+    *pu64_state ^= *pu64_state << 13;
+    *pu64_state ^= *pu64_state >> 7;
+    *pu64_state ^= *pu64_state << 17;
+
+    return *pu64_state;
+}
+
+/**
+ * @brief Start a corpus from its seed
+ * 
+ * @param[in out] pstr_generator Generator to initialize
+ * @param[in] enu_corpus Corpus to generate
+ * @return void
+ */
+static void bench_generator_init(tstr_bench_generator *pstr_generator, const tenu_bench_corpus enu_corpus)
+{
+    memset(pstr_generator, 0, sizeof(*pstr_generator));
+    pstr_generator->enu_corpus = enu_corpus;
+    pstr_generator->u64_rand_state = 0x9E3779B97F4A7C15u + (u64)enu_corpus;
+}
+
+/**
+ * @brief Draw the next token of the corpus, a run or a few bytes of text
+ * 
+ * @param[in out] pstr_generator Generator state
+ * @return void
+ */
+static void bench_generator_next(tstr_bench_generator *pstr_generator)
+{
+    u64 u64_rand = u64_bench_rand(&pstr_generator->u64_rand_state);
+
+    pstr_generator->u64_token_size = 0;
+    pstr_generator->u64_token_offset = 0;
+
+    switch (pstr_generator->enu_corpus)
+    {
+        case BENCH_CORPUS_RUNS:
+        {
+            // A new letter every time, so neighbouring runs never merge
+            pstr_generator->c_run_char = (char)('a' + ((pstr_generator->c_run_char - 'a' + 1 + (u64_rand % 25)) % 26));
+            pstr_generator->u64_run_left = 256 + ((u64_rand >> 8) % 16129);
+            break;
+        }
+        case BENCH_CORPUS_RANDOM:
+        {
+            memcpy(pstr_generator->ac_token, &u64_rand, sizeof(u64_rand));
+            pstr_generator->u64_token_size = sizeof(u64_rand);
+            break;
+        }
+        case BENCH_CORPUS_ENGLISH:
+        {
+            const char *pc_word = gapc_words[u64_rand % (sizeof(gapc_words) / sizeof(gapc_words[0]))];
+            const char *pc_separator = (0 == ((u64_rand >> 16) % 97)) ? ".\n" : ((0 == ((u64_rand >> 16) % 11)) ? ", " : " ");
+
+            pstr_generator->u64_token_size = (u64)snprintf(pstr_generator->ac_token, BENCH_TOKEN_MAX_SIZE, "%s%s", pc_word, pc_separator);
+            break;
+        }
+        case BENCH_CORPUS_DIGITS:
+        {
+            pstr_generator->u64_token_size = (u64)snprintf(pstr_generator->ac_token, BENCH_TOKEN_MAX_SIZE, "%010lu,%06lu,%lu.%02lu,%lu\n",
+                                                           1700000000u + pstr_generator->u64_record_idx, (u64_rand >> 12) % 1000000u,
+                                                           (u64_rand >> 32) % 100000u, (u64_rand >> 4) % 100u, (u64_rand >> 50) % 1000u);
+            pstr_generator->u64_record_idx++;
+            break;
+        }
+        default: break;
+    }
+}
+
+/**
+ * @brief Generate the next bytes of the corpus
+ * 
+ * @param[in out] pstr_generator Generator state
+ * @param[in out] pc_output_data Buffer to hold the data
+ * @param[in] u64_output_data_size Number of bytes to generate
+ * @return void
+ */
+static void bench_generate(tstr_bench_generator *pstr_generator, char *pc_output_data, const u64 u64_output_data_size)
+{
+    u64 i = 0;
+
+    while (i < u64_output_data_size)
+    {
+        u64 u64_copy_size = u64_output_data_size - i;
+
+        if (0 != pstr_generator->u64_run_left)
+        {
+            u64_copy_size = (u64_copy_size < pstr_generator->u64_run_left) ? u64_copy_size : pstr_generator->u64_run_left;
+
+            memset(&pc_output_data[i], pstr_generator->c_run_char, u64_copy_size);
+            pstr_generator->u64_run_left -= u64_copy_size;
+        }
+        else if (pstr_generator->u64_token_offset < pstr_generator->u64_token_size)
+        {
+            u64 u64_token_left = pstr_generator->u64_token_size - pstr_generator->u64_token_offset;
+
+            u64_copy_size = (u64_copy_size < u64_token_left) ? u64_copy_size : u64_token_left;
+
+            memcpy(&pc_output_data[i], &pstr_generator->ac_token[pstr_generator->u64_token_offset], u64_copy_size);
+            pstr_generator->u64_token_offset += u64_copy_size;
+        }
+        else
+        {
+            bench_generator_next(pstr_generator);
+            u64_copy_size = 0;
+        }
+
+        i += u64_copy_size;
+    }
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ * 
+ * @return u64 Current time
+ */
+static u64 u64_bench_now_ns(void)
+{
+    struct timespec str_now;
+
+    clock_gettime(CLOCK_MONOTONIC, &str_now);
+
+    return ((u64)str_now.tv_sec * 1000000000u) + (u64)str_now.tv_nsec;
+}
+
+/**
+ * @brief Restart the peak RSS measurement of the process
+ * 
+ * Kernels without /proc/self/clear_refs keep the peak of the whole run.
+ * 
+ * @return void
+ */
+static void bench_reset_peak_rss(void)
+{
+    FILE *pf_clear_refs = fopen("/proc/self/clear_refs", "w");
+
+    if (NULL != pf_clear_refs)
+    {
+        fputs("5", pf_clear_refs);
+        fclose(pf_clear_refs);
+    }
+}
+
+/**
+ * @brief Peak resident set size since the last bench_reset_peak_rss()
+ * 
+ * @return u64 Peak RSS in KiB
+ */
+static u64 u64_bench_peak_rss_kib(void)
+{
+    u64 u64_peak_kib = 0;
+    char ac_line[256];
+    FILE *pf_status = fopen("/proc/self/status", "r");
+
+    if (NULL != pf_status)
+    {
+        while (NULL != fgets(ac_line, sizeof(ac_line), pf_status))
+        {
+            if (1 == sscanf(ac_line, "VmHWM: %lu kB", &u64_peak_kib))
+            {
+                break;
+            }
+        }
+
+        fclose(pf_status);
+    }
+
+    if (0 == u64_peak_kib)
+    {
+        struct rusage str_usage;
+
+        getrusage(RUSAGE_SELF, &str_usage);
+        u64_peak_kib = (u64)str_usage.ru_maxrss;
+    }
+
+    return u64_peak_kib;
+}
+
+/**
+ * @brief Stream the corpus through a compressing and a decompressing context, chunk by chunk
+ * 
+ * Generation and verification are not timed. The decoded data is checked against the
+ * input through their CRC32C.
+ * 
+ * @param[in] enu_corpus Corpus to code
+ * @param[in] u64_corpus_size Size of the corpus
+ * @param[in out] pstr_compressor Compressing context, reused across repetitions
+ * @param[in out] pstr_decompressor Decompressing context, reused across repetitions
+ * @param[in out] pc_chunk Chunk buffer (BENCH_CHUNK_SIZE_BYTES)
+ * @param[in out] pstr_sample Pointer to hold the timings
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_stream(const tenu_bench_corpus enu_corpus, const u64 u64_corpus_size, tstr_codec_context *pstr_compressor,
+                            tstr_codec_context *pstr_decompressor, char *pc_chunk, tstr_bench_sample *pstr_sample)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_bench_generator str_generator;
+    tstr_byte_buffer str_coded;
+    tstr_byte_buffer str_decoded;
+    u32 u32_input_crc = CRC32C_INITIAL_VALUE;
+    u32 u32_decoded_crc = CRC32C_INITIAL_VALUE;
+    u64 u64_decoded_size = 0;
+    u64 u64_offset = 0;
+
+    bench_generator_init(&str_generator, enu_corpus);
+    byte_buffer_init(&str_coded);
+    byte_buffer_init(&str_decoded);
+    memset(pstr_sample, 0, sizeof(*pstr_sample));
+
+    do
+    {
+        // The last pass has no input left and closes both streams
+        while ((SUCCESS_STATUS == s32_ret_val) && (u64_offset <= u64_corpus_size))
+        {
+            u64 u64_chunk_size = u64_corpus_size - u64_offset;
+            u64 u64_start_ns = 0;
+
+            u64_chunk_size = (u64_chunk_size < BENCH_CHUNK_SIZE_BYTES) ? u64_chunk_size : BENCH_CHUNK_SIZE_BYTES;
+
+            bench_generate(&str_generator, pc_chunk, u64_chunk_size);
+            u32_input_crc = crc32c_update(u32_input_crc, pc_chunk, u64_chunk_size);
+
+            u64_start_ns = u64_bench_now_ns();
+
+            s32_ret_val = codec_compress_push(pstr_compressor, pc_chunk, u64_chunk_size);
+            ERROR_BREAK(s32_ret_val);
+
+            if (0 == u64_chunk_size)
+            {
+                s32_ret_val = codec_compress_finish(pstr_compressor);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            s32_ret_val = codec_pull(pstr_compressor, &str_coded);
+            ERROR_BREAK(s32_ret_val);
+
+            pstr_sample->u64_compress_ns += u64_bench_now_ns() - u64_start_ns;
+            pstr_sample->u64_output_size += str_coded.u64_size;
+
+            u64_start_ns = u64_bench_now_ns();
+
+            if (0 != str_coded.u64_size)
+            {
+                s32_ret_val = codec_decompress_push(pstr_decompressor, str_coded.pc_data, str_coded.u64_size);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            if (0 == u64_chunk_size)
+            {
+                s32_ret_val = codec_decompress_finish(pstr_decompressor);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            s32_ret_val = codec_pull(pstr_decompressor, &str_decoded);
+            ERROR_BREAK(s32_ret_val);
+
+            pstr_sample->u64_decompress_ns += u64_bench_now_ns() - u64_start_ns;
+
+            u32_decoded_crc = crc32c_update(u32_decoded_crc, str_decoded.pc_data, str_decoded.u64_size);
+            u64_decoded_size += str_decoded.u64_size;
+
+            u64_offset += (0 == u64_chunk_size) ? 1 : u64_chunk_size;
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        if ((u64_decoded_size != u64_corpus_size) || (u32_decoded_crc != u32_input_crc))
+        {
+            LOG_ERROR("Stream round trip of %s does not match: %lu of %lu bytes.", gapc_corpus_names[enu_corpus], u64_decoded_size, u64_corpus_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+        pstr_sample->u64_input_size = u64_corpus_size;
+
+    } while (0);
+
+    byte_buffer_free(&str_coded);
+    byte_buffer_free(&str_decoded);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Code the corpus as independent messages through the buffer API of one context
+ * 
+ * @param[in] enu_corpus Corpus to code
+ * @param[in] u64_corpus_size Size of the corpus
+ * @param[in out] pstr_context Context shared by all messages, reused across repetitions
+ * @param[in out] pc_chunk Chunk buffer (BENCH_CHUNK_SIZE_BYTES)
+ * @param[in out] pstr_packed Buffer for the coded messages of one chunk
+ * @param[in out] pc_decoded Buffer for the decoded messages of one chunk (BENCH_CHUNK_SIZE_BYTES)
+ * @param[in out] pstr_sample Pointer to hold the timings
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_messages(const tenu_bench_corpus enu_corpus, const u64 u64_corpus_size, tstr_codec_context *pstr_context, char *pc_chunk,
+                              tstr_byte_buffer *pstr_packed, char *pc_decoded, tstr_bench_sample *pstr_sample)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    const u64 u64_message_bound = codec_compress_bound(pstr_context->enu_format, BENCH_MESSAGE_SIZE_BYTES);
+    const u32 u32_chunk_messages = BENCH_CHUNK_SIZE_BYTES / BENCH_MESSAGE_SIZE_BYTES;
+    u64 au64_packed_sizes[BENCH_CHUNK_SIZE_BYTES / BENCH_MESSAGE_SIZE_BYTES];
+    tstr_bench_generator str_generator;
+    u64 u64_offset = 0;
+
+    bench_generator_init(&str_generator, enu_corpus);
+    memset(pstr_sample, 0, sizeof(*pstr_sample));
+
+    do
+    {
+        s32_ret_val = byte_buffer_reserve(pstr_packed, u32_chunk_messages * u64_message_bound);
+        ERROR_BREAK(s32_ret_val);
+
+        while (u64_offset < u64_corpus_size)
+        {
+            u64 u64_chunk_size = u64_corpus_size - u64_offset;
+            u64 u64_packed_offset = 0;
+            u64 u64_start_ns = 0;
+            u32 u32_message_count = 0;
+
+            u64_chunk_size = (u64_chunk_size < BENCH_CHUNK_SIZE_BYTES) ? u64_chunk_size : BENCH_CHUNK_SIZE_BYTES;
+            u32_message_count = (u32)((u64_chunk_size + BENCH_MESSAGE_SIZE_BYTES - 1) / BENCH_MESSAGE_SIZE_BYTES);
+
+            bench_generate(&str_generator, pc_chunk, u64_chunk_size);
+
+            u64_start_ns = u64_bench_now_ns();
+
+            for (u32 m = 0; m < u32_message_count; m++)
+            {
+                u64 u64_message_offset = (u64)m * BENCH_MESSAGE_SIZE_BYTES;
+                u64 u64_message_size = u64_chunk_size - u64_message_offset;
+
+                u64_message_size = (u64_message_size < BENCH_MESSAGE_SIZE_BYTES) ? u64_message_size : BENCH_MESSAGE_SIZE_BYTES;
+
+                s32_ret_val = codec_compress_buffer(pstr_context, &pc_chunk[u64_message_offset], u64_message_size, &pstr_packed->pc_data[u64_packed_offset],
+                                                    u64_message_bound, &au64_packed_sizes[m]);
+                ERROR_BREAK(s32_ret_val);
+
+                u64_packed_offset += au64_packed_sizes[m];
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            pstr_sample->u64_compress_ns += u64_bench_now_ns() - u64_start_ns;
+            pstr_sample->u64_output_size += u64_packed_offset;
+
+            u64_packed_offset = 0;
+            u64_start_ns = u64_bench_now_ns();
+
+            for (u32 m = 0; m < u32_message_count; m++)
+            {
+                u64 u64_message_offset = (u64)m * BENCH_MESSAGE_SIZE_BYTES;
+                u64 u64_decoded_size = 0;
+
+                s32_ret_val = codec_decompress_buffer(pstr_context, &pstr_packed->pc_data[u64_packed_offset], au64_packed_sizes[m], &pc_decoded[u64_message_offset],
+                                                      BENCH_MESSAGE_SIZE_BYTES, &u64_decoded_size);
+                ERROR_BREAK(s32_ret_val);
+
+                u64_packed_offset += au64_packed_sizes[m];
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            pstr_sample->u64_decompress_ns += u64_bench_now_ns() - u64_start_ns;
+
+            if (0 != memcmp(pc_chunk, pc_decoded, u64_chunk_size))
+            {
+                LOG_ERROR("Message round trip of %s does not match at offset %lu.", gapc_corpus_names[enu_corpus], u64_offset);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            u64_offset += u64_chunk_size;
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        pstr_sample->u64_input_size = u64_corpus_size;
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief CRC32C and size of a file
+ * 
+ * @param[in] pc_path Path of the file
+ * @param[in out] pc_chunk Chunk buffer (BENCH_CHUNK_SIZE_BYTES)
+ * @param[in out] pu32_crc Pointer to hold the CRC32C
+ * @param[in out] pu64_size Pointer to hold the size
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_file_crc(const char *pc_path, char *pc_chunk, u32 *pu32_crc, u64 *pu64_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    FILE *pf_file = NULL;
+
+    *pu32_crc = CRC32C_INITIAL_VALUE;
+    *pu64_size = 0;
+
+    do
+    {
+        s32_ret_val = open_file(pc_path, "rb", &pf_file);
+        ERROR_BREAK(s32_ret_val);
+
+        while (1)
+        {
+            u64 u64_read_size = 0;
+
+            s32_ret_val = read_file_window(pf_file, pc_chunk, BENCH_CHUNK_SIZE_BYTES, &u64_read_size);
+            ERROR_BREAK(s32_ret_val);
+
+            if (0 == u64_read_size)
+            {
+                break;
+            }
+
+            *pu32_crc = crc32c_update(*pu32_crc, pc_chunk, u64_read_size);
+            *pu64_size += u64_read_size;
+        }
+
+    } while (0);
+
+    if (NULL != pf_file)
+    {
+        close_file(&pf_file);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Write the corpus to a file, chunk by chunk
+ * 
+ * @param[in] enu_corpus Corpus to write
+ * @param[in] u64_corpus_size Size of the corpus
+ * @param[in] pc_path Path of the file
+ * @param[in out] pc_chunk Chunk buffer (BENCH_CHUNK_SIZE_BYTES)
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_write_corpus(const tenu_bench_corpus enu_corpus, const u64 u64_corpus_size, const char *pc_path, char *pc_chunk)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_bench_generator str_generator;
+    FILE *pf_file = NULL;
+    u64 u64_offset = 0;
+
+    bench_generator_init(&str_generator, enu_corpus);
+
+    do
+    {
+        s32_ret_val = open_file(pc_path, "wb", &pf_file);
+        ERROR_BREAK(s32_ret_val);
+
+        while (u64_offset < u64_corpus_size)
+        {
+            u64 u64_chunk_size = u64_corpus_size - u64_offset;
+
+            u64_chunk_size = (u64_chunk_size < BENCH_CHUNK_SIZE_BYTES) ? u64_chunk_size : BENCH_CHUNK_SIZE_BYTES;
+
+            bench_generate(&str_generator, pc_chunk, u64_chunk_size);
+
+            s32_ret_val = write_file(pf_file, pc_chunk, u64_chunk_size);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_offset += u64_chunk_size;
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = close_file(&pf_file);
+        ERROR_BREAK(s32_ret_val);
+
+    } while (0);
+
+    if (NULL != pf_file)
+    {
+        close_file(&pf_file);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Compress and decompress a corpus file through the file commands of the CLI
+ * 
+ * The compressed file is renamed before it is decompressed, so the decoded file gets a
+ * name of its own instead of a numbered one next to the corpus.
+ * 
+ * @param[in] pc_dir Directory of the corpus file
+ * @param[in] enu_corpus Corpus in the file
+ * @param[in] pstr_options Format and thread count
+ * @param[in out] pc_chunk Chunk buffer (BENCH_CHUNK_SIZE_BYTES)
+ * @param[in out] pstr_sample Pointer to hold the timings
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_file(const char *pc_dir, const tenu_bench_corpus enu_corpus, const tstr_codec_options *pstr_options, char *pc_chunk,
+                          tstr_bench_sample *pstr_sample)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    const char *pc_format = gapc_format_names[pstr_options->enu_format];
+    char ac_corpus_path[BENCH_PATH_SIZE];
+    char ac_coded_path[BENCH_PATH_SIZE];
+    char ac_packed_path[BENCH_PATH_SIZE];
+    char ac_decoded_path[BENCH_PATH_SIZE];
+    u32 u32_input_crc = 0;
+    u32 u32_decoded_crc = 0;
+    u64 u64_decoded_size = 0;
+    u64 u64_start_ns = 0;
+
+    snprintf(ac_corpus_path, sizeof(ac_corpus_path), "%s/bench_%s.txt", pc_dir, gapc_corpus_names[enu_corpus]);
+    snprintf(ac_coded_path, sizeof(ac_coded_path), "%s/bench_%s.%s", pc_dir, gapc_corpus_names[enu_corpus], pc_format);
+    snprintf(ac_packed_path, sizeof(ac_packed_path), "%s/bench_%s_packed.%s", pc_dir, gapc_corpus_names[enu_corpus], pc_format);
+    snprintf(ac_decoded_path, sizeof(ac_decoded_path), "%s/bench_%s_packed.txt", pc_dir, gapc_corpus_names[enu_corpus]);
+
+    memset(pstr_sample, 0, sizeof(*pstr_sample));
+
+    do
+    {
+        s32_ret_val = s32_bench_file_crc(ac_corpus_path, pc_chunk, &u32_input_crc, &pstr_sample->u64_input_size);
+        ERROR_BREAK(s32_ret_val);
+
+        remove(ac_coded_path);
+        remove(ac_packed_path);
+        remove(ac_decoded_path);
+
+        u64_start_ns = u64_bench_now_ns();
+
+        s32_ret_val = compress(ac_corpus_path, pstr_options, NULL, NULL);
+        ERROR_BREAK(s32_ret_val);
+
+        pstr_sample->u64_compress_ns = u64_bench_now_ns() - u64_start_ns;
+
+        if (0 != rename(ac_coded_path, ac_packed_path))
+        {
+            LOG_ERROR("Error renaming %s.", ac_coded_path);
+            s32_ret_val = ERROR_FILE_WRITE_FAILED;
+            break;
+        }
+
+        u64_start_ns = u64_bench_now_ns();
+
+        s32_ret_val = decompress(ac_packed_path, pstr_options, NULL, NULL);
+        ERROR_BREAK(s32_ret_val);
+
+        pstr_sample->u64_decompress_ns = u64_bench_now_ns() - u64_start_ns;
+
+        s32_ret_val = s32_bench_file_crc(ac_packed_path, pc_chunk, &u32_decoded_crc, &pstr_sample->u64_output_size);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = s32_bench_file_crc(ac_decoded_path, pc_chunk, &u32_decoded_crc, &u64_decoded_size);
+        ERROR_BREAK(s32_ret_val);
+
+        if ((u64_decoded_size != pstr_sample->u64_input_size) || (u32_decoded_crc != u32_input_crc))
+        {
+            LOG_ERROR("File round trip of %s does not match.", ac_corpus_path);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+    } while (0);
+
+    remove(ac_packed_path);
+    remove(ac_decoded_path);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Name of the case run with the given options, rle for the text format, the codec name otherwise 
+ * 
+ * @param[in] pstr_options Format and block codec
+ * @return const char* Name of the case
+ */
+static const char *pc_bench_codec_name(const tstr_codec_options *pstr_options)
+{
+    const tstr_codec_entry *pstr_codec = codec_registry_get((u8)pstr_options->enu_block_codec);
+
+    return ((FILE_FORMAT_RLE == pstr_options->enu_format) || (NULL == pstr_codec)) ? gapc_format_names[FILE_FORMAT_RLE] : pstr_codec->pc_name;
+}
+
+/**
+ * @brief Mark the cases named in a comma separated list, rle for the text format and registry codec names
+ * 
+ * @param[in] pc_list List of names
+ * @param[in out] pb_selected Selection of the cases, 0 is the text format, k is registry entry k - 1
+ * @param[in] u32_case_count Number of cases
+ * @return bool true if every name is known, false otherwise 
+ */
+static bool b_bench_select_codecs(const char *pc_list, bool *pb_selected, const u32 u32_case_count)
+{
+    bool b_known = true;
+
+    while ((true == b_known) && ('\0' != *pc_list))
+    {
+        char ac_name[32];
+        size_t size_name = strcspn(pc_list, ",");
+
+        b_known = false;
+
+        if (size_name < sizeof(ac_name))
+        {
+            memcpy(ac_name, pc_list, size_name);
+            ac_name[size_name] = '\0';
+
+            for (u32 k = 0; k < u32_case_count; k++)
+            {
+                const char *pc_name = (0 == k) ? gapc_format_names[FILE_FORMAT_RLE] : codec_registry_at(k - 1u)->pc_name;
+
+                if (0 == strcmp(ac_name, pc_name))
+                {
+                    pb_selected[k] = true;
+                    b_known = true;
+                }
+            }
+        }
+
+        pc_list += size_name + (',' == pc_list[size_name] ? 1u : 0u);
+    }
+
+    return b_known;
+}
+
+/**
+ * @brief Throughput of one repetition
+ * 
+ * @param[in] u64_size Number of bytes coded
+ * @param[in] u64_ns Time taken
+ * @return f64 Throughput in MB/s
+ */
+static f64 f64_bench_mbps(const u64 u64_size, const u64 u64_ns)
+{
+    return (0 == u64_ns) ? 0 : (((f64)u64_size / (1024.0 * 1024.0)) / ((f64)u64_ns / 1e9));
+}
+
+/**
+ * @brief Run one corpus/format/mode case u32_repeat_count times and keep the best throughput
+ * 
+ * @param[in] enu_corpus Corpus to code
+ * @param[in] enu_mode How the data reaches the codec
+ * @param[in] u64_corpus_size Size of the corpus
+ * @param[in] u32_repeat_count Number of repetitions
+ * @param[in] pc_dir Directory of the corpus files, file mode only
+ * @param[in] pstr_options Format and thread count
+ * @param[in out] pstr_result Pointer to hold the result
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_case(const tenu_bench_corpus enu_corpus, const tenu_bench_mode enu_mode, const u64 u64_corpus_size, const u32 u32_repeat_count,
+                          const char *pc_dir, const tstr_codec_options *pstr_options, tstr_bench_result *pstr_result)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_codec_context str_compressor;
+    tstr_codec_context str_decompressor;
+    tstr_byte_buffer str_packed;
+    char *pc_chunk = (char *)malloc(BENCH_CHUNK_SIZE_BYTES);
+    char *pc_decoded = (char *)malloc(BENCH_CHUNK_SIZE_BYTES);
+
+    codec_context_init(&str_compressor, pstr_options->enu_format);
+    codec_context_init(&str_decompressor, pstr_options->enu_format);
+    codec_context_set_block_codec(&str_compressor, pstr_options->enu_block_codec);
+    byte_buffer_init(&str_packed);
+
+    memset(pstr_result, 0, sizeof(*pstr_result));
+    snprintf(pstr_result->ac_corpus, sizeof(pstr_result->ac_corpus), "%s", gapc_corpus_names[enu_corpus]);
+    snprintf(pstr_result->ac_format, sizeof(pstr_result->ac_format), "%s", pc_bench_codec_name(pstr_options));
+    snprintf(pstr_result->ac_mode, sizeof(pstr_result->ac_mode), "%s", gapc_mode_names[enu_mode]);
+
+    bench_reset_peak_rss();
+
+    do
+    {
+        if (NULL == pc_chunk || NULL == pc_decoded)
+        {
+            LOG_ERROR("Error allocating benchmark buffers.");
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        }
+
+        for (u32 r = 0; r < u32_repeat_count; r++)
+        {
+            tstr_bench_sample str_sample;
+            u64 u64_allocs_before = __atomic_load_n(&gu64_alloc_count, __ATOMIC_RELAXED);
+
+            if (BENCH_MODE_STREAM == enu_mode)
+            {
+                s32_ret_val = s32_bench_stream(enu_corpus, u64_corpus_size, &str_compressor, &str_decompressor, pc_chunk, &str_sample);
+            }
+            else if (BENCH_MODE_MESSAGES == enu_mode)
+            {
+                s32_ret_val = s32_bench_messages(enu_corpus, u64_corpus_size, &str_compressor, pc_chunk, &str_packed, pc_decoded, &str_sample);
+            }
+            else
+            {
+                s32_ret_val = s32_bench_file(pc_dir, enu_corpus, pstr_options, pc_chunk, &str_sample);
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            // The stream case allocates its pull buffers per repetition, they are part of the cost
+            pstr_result->u64_allocs_warm = __atomic_load_n(&gu64_alloc_count, __ATOMIC_RELAXED) - u64_allocs_before;
+
+            if (0 == r)
+            {
+                pstr_result->u64_allocs_cold = pstr_result->u64_allocs_warm;
+            }
+
+            pstr_result->u64_input_size = str_sample.u64_input_size;
+            pstr_result->u64_output_size = str_sample.u64_output_size;
+
+            if (f64_bench_mbps(str_sample.u64_input_size, str_sample.u64_compress_ns) > pstr_result->f64_compress_mbps)
+            {
+                pstr_result->f64_compress_mbps = f64_bench_mbps(str_sample.u64_input_size, str_sample.u64_compress_ns);
+            }
+
+            if (f64_bench_mbps(str_sample.u64_input_size, str_sample.u64_decompress_ns) > pstr_result->f64_decompress_mbps)
+            {
+                pstr_result->f64_decompress_mbps = f64_bench_mbps(str_sample.u64_input_size, str_sample.u64_decompress_ns);
+            }
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        pstr_result->f64_ratio = (0 == pstr_result->u64_output_size) ? 0 : ((f64)pstr_result->u64_input_size / (f64)pstr_result->u64_output_size);
+        pstr_result->u64_peak_rss_kib = u64_bench_peak_rss_kib();
+
+    } while (0);
+
+    codec_context_free(&str_compressor);
+    codec_context_free(&str_decompressor);
+    byte_buffer_free(&str_packed);
+    free(pc_chunk);
+    free(pc_decoded);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Print the results as a table
+ * 
+ * @param[in] pstr_results Results to print
+ * @param[in] u32_result_count Number of results
+ * @return void
+ */
+static void bench_print_table(const tstr_bench_result *pstr_results, const u32 u32_result_count)
+{
+    printf("%-8s %-8s %-9s %10s %8s %11s %11s %8s %8s %9s\n",
+           "corpus", "format", "mode", "input MiB", "ratio", "comp MB/s", "decomp MB/s", "allocs", "warm", "peak MiB");
+
+    for (u32 i = 0; i < u32_result_count; i++)
+    {
+        const tstr_bench_result *pstr_result = &pstr_results[i];
+
+        printf("%-8s %-8s %-9s %10.1f %8.2f %11.0f %11.0f %8lu %8lu %9.1f\n", pstr_result->ac_corpus, pstr_result->ac_format, pstr_result->ac_mode,
+               (f64)pstr_result->u64_input_size / (1024.0 * 1024.0), pstr_result->f64_ratio, pstr_result->f64_compress_mbps,
+               pstr_result->f64_decompress_mbps, pstr_result->u64_allocs_cold, pstr_result->u64_allocs_warm, (f64)pstr_result->u64_peak_rss_kib / 1024.0);
+    }
+}
+
+/**
+ * @brief Write the results as JSON, one result object per line
+ * 
+ * @param[in] pc_path Path of the JSON file
+ * @param[in] pstr_results Results to write
+ * @param[in] u32_result_count Number of results
+ * @param[in] u64_corpus_size Size of every corpus
+ * @param[in] u32_repeat_count Number of repetitions
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_write_json(const char *pc_path, const tstr_bench_result *pstr_results, const u32 u32_result_count, const u64 u64_corpus_size,
+                                const u32 u32_repeat_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    FILE *pf_json = NULL;
+
+    do
+    {
+        s32_ret_val = open_file(pc_path, "w", &pf_json);
+        ERROR_BREAK(s32_ret_val);
+
+        fprintf(pf_json, "{\n  \"benchmark\": \"bench_codec\",\n  \"corpus_size\": %lu,\n  \"repeat\": %u,\n  \"results\": [\n", u64_corpus_size, u32_repeat_count);
+
+        for (u32 i = 0; i < u32_result_count; i++)
+        {
+            const tstr_bench_result *pstr_result = &pstr_results[i];
+
+            fprintf(pf_json, "    {\"corpus\": \"%s\", \"format\": \"%s\", \"mode\": \"%s\", \"input_bytes\": %lu, \"output_bytes\": %lu, \"ratio\": %.4f, "
+                    "\"compress_mbps\": %.1f, \"decompress_mbps\": %.1f, \"allocations\": %lu, \"allocations_warm\": %lu, \"peak_rss_kib\": %lu}%s\n",
+                    pstr_result->ac_corpus, pstr_result->ac_format, pstr_result->ac_mode, pstr_result->u64_input_size, pstr_result->u64_output_size,
+                    pstr_result->f64_ratio, pstr_result->f64_compress_mbps, pstr_result->f64_decompress_mbps, pstr_result->u64_allocs_cold,
+                    pstr_result->u64_allocs_warm, pstr_result->u64_peak_rss_kib, ((i + 1) < u32_result_count) ? "," : "");
+        }
+
+        fprintf(pf_json, "  ]\n}\n");
+
+        s32_ret_val = close_file(&pf_json);
+        ERROR_BREAK(s32_ret_val);
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Find the value of a key in one result line of a JSON file written by this benchmark
+ * 
+ * @param[in] pc_line Result line
+ * @param[in] pc_key Key to look up
+ * @return const char* Start of the value, NULL when the key is missing
+ */
+static const char *pc_bench_json_value(const char *pc_line, const char *pc_key)
+{
+    char ac_pattern[64];
+    const char *pc_value = NULL;
+
+    snprintf(ac_pattern, sizeof(ac_pattern), "\"%s\": ", pc_key);
+    pc_value = strstr(pc_line, ac_pattern);
+
+    return (NULL == pc_value) ? NULL : (pc_value + strlen(ac_pattern));
+}
+
+/**
+ * @brief Load the results of a JSON file written by this benchmark
+ * 
+ * @param[in] pc_path Path of the JSON file
+ * @param[in out] pstr_results Array to hold the results (BENCH_MAX_RESULTS entries)
+ * @param[in out] pu32_result_count Pointer to hold the number of results
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_read_json(const char *pc_path, tstr_bench_result *pstr_results, u32 *pu32_result_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    FILE *pf_json = NULL;
+    char ac_line[BENCH_JSON_LINE_SIZE];
+
+    *pu32_result_count = 0;
+
+    do
+    {
+        s32_ret_val = open_file(pc_path, "r", &pf_json);
+        ERROR_BREAK(s32_ret_val);
+
+        while ((NULL != fgets(ac_line, sizeof(ac_line), pf_json)) && (*pu32_result_count < BENCH_MAX_RESULTS))
+        {
+            tstr_bench_result *pstr_result = &pstr_results[*pu32_result_count];
+            const char *pc_corpus = pc_bench_json_value(ac_line, "corpus");
+            const char *pc_format = pc_bench_json_value(ac_line, "format");
+            const char *pc_mode = pc_bench_json_value(ac_line, "mode");
+            const char *pc_ratio = pc_bench_json_value(ac_line, "ratio");
+            const char *pc_compress = pc_bench_json_value(ac_line, "compress_mbps");
+            const char *pc_decompress = pc_bench_json_value(ac_line, "decompress_mbps");
+            const char *pc_allocs = pc_bench_json_value(ac_line, "allocations");
+            const char *pc_peak = pc_bench_json_value(ac_line, "peak_rss_kib");
+
+            if (NULL == pc_corpus || NULL == pc_format || NULL == pc_mode || NULL == pc_ratio || NULL == pc_compress || NULL == pc_decompress ||
+                NULL == pc_allocs || NULL == pc_peak)
+            {
+                continue;
+            }
+
+            memset(pstr_result, 0, sizeof(*pstr_result));
+
+            if ((1 != sscanf(pc_corpus, "\"%15[^\"]\"", pstr_result->ac_corpus)) || (1 != sscanf(pc_format, "\"%15[^\"]\"", pstr_result->ac_format)) ||
+                (1 != sscanf(pc_mode, "\"%15[^\"]\"", pstr_result->ac_mode)))
+            {
+                continue;
+            }
+
+            pstr_result->f64_ratio = strtod(pc_ratio, NULL);
+            pstr_result->f64_compress_mbps = strtod(pc_compress, NULL);
+            pstr_result->f64_decompress_mbps = strtod(pc_decompress, NULL);
+            pstr_result->u64_allocs_cold = strtoul(pc_allocs, NULL, 10);
+            pstr_result->u64_peak_rss_kib = strtoul(pc_peak, NULL, 10);
+
+            (*pu32_result_count)++;
+        }
+
+        close_file(&pf_json);
+
+        if (0 == *pu32_result_count)
+        {
+            LOG_ERROR("No benchmark results in %s.", pc_path);
+            s32_ret_val = ERROR_INVALID_ARGUMENTS;
+            break;
+        }
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Relative change from an old to a new value
+ * 
+ * @param[in] f64_old Old value
+ * @param[in] f64_new New value
+ * @return f64 Change in percent of the old value
+ */
+static f64 f64_bench_change(const f64 f64_old, const f64 f64_new)
+{
+    return (0 == f64_old) ? 0 : (100.0 * (f64_new - f64_old) / f64_old);
+}
+
+/**
+ * @brief Print the change of every case present in both result files and flag regressions
+ * 
+ * A case regresses when its compression or decompression throughput or its ratio drops
+ * by more than the threshold.
+ * 
+ * @param[in] pc_old_path JSON file of the baseline
+ * @param[in] pc_new_path JSON file to check against it
+ * @param[in] f64_threshold Drop in percent reported as a regression
+ * @param[in out] pu32_regression_count Pointer to hold the number of regressed cases
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_bench_compare(const char *pc_old_path, const char *pc_new_path, const f64 f64_threshold, u32 *pu32_regression_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    static tstr_bench_result astr_old[BENCH_MAX_RESULTS];
+    static tstr_bench_result astr_new[BENCH_MAX_RESULTS];
+    u32 u32_old_count = 0;
+    u32 u32_new_count = 0;
+
+    *pu32_regression_count = 0;
+
+    do
+    {
+        s32_ret_val = s32_bench_read_json(pc_old_path, astr_old, &u32_old_count);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = s32_bench_read_json(pc_new_path, astr_new, &u32_new_count);
+        ERROR_BREAK(s32_ret_val);
+
+        printf("%-8s %-8s %-9s %11s %11s %8s %11s %11s %8s %8s %8s %8s\n", "corpus", "format", "mode", "comp old", "comp new", "change",
+               "decomp old", "decomp new", "change", "ratio", "allocs", "peak");
+
+        for (u32 i = 0; i < u32_new_count; i++)
+        {
+            const tstr_bench_result *pstr_new = &astr_new[i];
+            const tstr_bench_result *pstr_old = NULL;
+
+            for (u32 j = 0; j < u32_old_count; j++)
+            {
+                if ((0 == strcmp(astr_old[j].ac_corpus, pstr_new->ac_corpus)) && (0 == strcmp(astr_old[j].ac_format, pstr_new->ac_format)) &&
+                    (0 == strcmp(astr_old[j].ac_mode, pstr_new->ac_mode)))
+                {
+                    pstr_old = &astr_old[j];
+                    break;
+                }
+            }
+
+            if (NULL == pstr_old)
+            {
+                printf("%-8s %-8s %-9s (new case)\n", pstr_new->ac_corpus, pstr_new->ac_format, pstr_new->ac_mode);
+                continue;
+            }
+
+            f64 f64_compress_change = f64_bench_change(pstr_old->f64_compress_mbps, pstr_new->f64_compress_mbps);
+            f64 f64_decompress_change = f64_bench_change(pstr_old->f64_decompress_mbps, pstr_new->f64_decompress_mbps);
+            f64 f64_ratio_change = f64_bench_change(pstr_old->f64_ratio, pstr_new->f64_ratio);
+            f64 f64_peak_change = f64_bench_change((f64)pstr_old->u64_peak_rss_kib, (f64)pstr_new->u64_peak_rss_kib);
+            bool b_regression = (f64_compress_change < -f64_threshold) || (f64_decompress_change < -f64_threshold) || (f64_ratio_change < -f64_threshold);
+
+            printf("%-8s %-8s %-9s %11.0f %11.0f %+7.1f%% %11.0f %11.0f %+7.1f%% %+7.1f%% %+8ld %+7.1f%%%s\n", pstr_new->ac_corpus, pstr_new->ac_format,
+                   pstr_new->ac_mode, pstr_old->f64_compress_mbps, pstr_new->f64_compress_mbps, f64_compress_change, pstr_old->f64_decompress_mbps,
+                   pstr_new->f64_decompress_mbps, f64_decompress_change, f64_ratio_change, (s64)pstr_new->u64_allocs_cold - (s64)pstr_old->u64_allocs_cold,
+                   f64_peak_change, b_regression ? "  REGRESSION" : "");
+
+            if (true == b_regression)
+            {
+                (*pu32_regression_count)++;
+            }
+        }
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decode a corrupted message and check that it is rejected with the expected error
+ * 
+ * @param[in out] pstr_context Context the message is decoded with
+ * @param[in] pc_packed Corrupted message
+ * @param[in] u64_packed_size Size of the message
+ * @param[in out] pc_output_data Buffer the message is decoded into
+ * @param[in] u64_output_capacity Size of the buffer
+ * @param[in] s32_expected Error the decoder must return
+ * @param[in] pc_case_name Name of the check, for the error message
+ * @return s32 SUCCESS_STATUS when the message is rejected as expected, FAILURE_STATUS otherwise 
+ */
+static s32 s32_bench_expect_rejected(tstr_codec_context *pstr_context, const char *pc_packed, const u64 u64_packed_size, char *pc_output_data,
+                                     const u64 u64_output_capacity, const s32 s32_expected, const char *pc_case_name)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+    u64 u64_output_size = 0;
+    const tenu_log_level enu_log_level = log_get_level();
+
+    // The decoder errors are expected, they are not logged
+    log_set_level(LOG_LEVEL_NONE);
+
+    s32 s32_decode_ret_val = codec_decompress_buffer(pstr_context, pc_packed, u64_packed_size, pc_output_data, u64_output_capacity, &u64_output_size);
+
+    log_set_level(enu_log_level);
+
+    if (s32_expected != s32_decode_ret_val)
+    {
+        LOG_ERROR("Check %s: decoding returned %d, expected %d.", pc_case_name, s32_decode_ret_val, s32_expected);
+        s32_ret_val = FAILURE_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check that the decoders reject corrupted messages instead of decoding them
+ * 
+ * @return s32 SUCCESS_STATUS when every corrupted message is rejected, error code otherwise 
+ */
+static s32 s32_bench_check_corrupt(void)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    const u64 u64_packed_capacity = codec_compress_bound(FILE_FORMAT_RLE2, BENCH_CHECK_SIZE_BYTES);
+    char *pc_message = (char *)malloc(BENCH_CHECK_SIZE_BYTES);
+    char *pc_packed = (char *)malloc(u64_packed_capacity);
+    tstr_codec_context str_context;
+    u64 u64_packed_size = 0;
+
+    codec_context_init(&str_context, FILE_FORMAT_RLE2);
+
+    do
+    {
+        if (NULL == pc_message || NULL == pc_packed)
+        {
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        }
+
+        // Runs of 37 bytes, short enough for every codec to code them
+        for (u64 i = 0; i < BENCH_CHECK_SIZE_BYTES; i++)
+        {
+            pc_message[i] = (char)('a' + ((i / 37u) % 7u));
+        }
+
+        // Huffman code lengths are stored as nibbles, 13 to 15 bits are out of range
+        codec_context_set_block_codec(&str_context, BLOCK_CODEC_HUFFMAN);
+
+        s32_ret_val = codec_compress_buffer(&str_context, pc_message, BENCH_CHECK_SIZE_BYTES, pc_packed, u64_packed_capacity, &u64_packed_size);
+        ERROR_BREAK(s32_ret_val);
+
+        if (BLOCK_TYPE_HUFFMAN != (u8)pc_packed[RLE2_HEADER_SIZE])
+        {
+            LOG_ERROR("Check huffman-lengths: the message was not Huffman coded.");
+            s32_ret_val = FAILURE_STATUS;
+            break;
+        }
+
+        pc_packed[RLE2_HEADER_SIZE + CONTAINER_BLOCK_HEADER_SIZE + CONTAINER_BLOCK_CHECKSUM_SIZE + 4u] = (char)0xFF;
+
+        s32_ret_val = s32_bench_expect_rejected(&str_context, pc_packed, u64_packed_size, pc_message, BENCH_CHECK_SIZE_BYTES, ERROR_DECOMPRESSION_FAILED,
+                                                "huffman-lengths");
+        ERROR_BREAK(s32_ret_val);
+
+        // A text run of 8 GiB must stop at the end of the output buffer instead of being decoded whole
+        u64_packed_size = (u64)snprintf(pc_packed, u64_packed_capacity, "x%lu", 8ul * 1024u * 1024u * 1024u);
+
+        s32_ret_val = s32_bench_expect_rejected(&str_context, pc_packed, u64_packed_size, pc_message, BENCH_CHECK_SIZE_BYTES, ERROR_INVALID_LENGTH,
+                                                "rle-run-length");
+        ERROR_BREAK(s32_ret_val);
+
+        // The same run pushed as a stream must stop at the output limit of the context, the runs after it complete its count
+        u64_packed_size = (u64)snprintf(pc_packed, u64_packed_capacity, "x%luy1z1w1", 8ul * 1024u * 1024u * 1024u);
+        codec_context_set_output_limit(&str_context, BENCH_CHECK_SIZE_BYTES);
+
+        if (ERROR_INVALID_LENGTH != codec_decompress_push(&str_context, pc_packed, u64_packed_size))
+        {
+            LOG_ERROR("Check rle-push-limit: the run was not stopped at the output limit.");
+            s32_ret_val = FAILURE_STATUS;
+            break;
+        }
+
+        codec_context_set_output_limit(&str_context, 0);
+        codec_context_reset(&str_context);
+
+    } while (0);
+
+    codec_context_free(&str_context);
+    free_allocated_memory(pc_message);
+    free_allocated_memory(pc_packed);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Print the usage of the benchmark
+ * 
+ * @param[in] pc_prog_name Name of the program
+ * @return void
+ */
+static void bench_print_usage(const char *pc_prog_name)
+{
+    printf("Usage:\n");
+    printf("  %s [--size <MiB>] [--repeat <n>] [--corpus runs,random,english,digits] [--codec rle,<codec>,...]\n", pc_prog_name);
+    printf("     [--dir <path>] [-j <threads>] [--json <file>]\n");
+    printf("  %s --compare <old.json> <new.json> [--threshold <percent>]\n\n", pc_prog_name);
+    printf("  --size       Size of every corpus, default %u MiB. Corpora are generated chunk by chunk, any size fits in memory.\n", BENCH_DEFAULT_SIZE_MIB);
+    printf("  --repeat     Repetitions of every case, the best throughput is kept, default %u\n", BENCH_DEFAULT_REPEAT_COUNT);
+    printf("  --corpus     Corpora to run, default all\n");
+    printf("  --codec      Text rle and registry codecs to run, default all (see rle --list-codecs)\n");
+    printf("  --dir        Also run compress()/decompress() on corpus files written to this directory\n");
+    printf("  -j           Threads of the file case, default 1\n");
+    printf("  --json       Write the results as JSON\n");
+    printf("  --compare    Print the change from old.json to new.json, exit code 1 on a regression\n");
+    printf("  --threshold  Drop in percent counted as a regression, default %.0f\n", BENCH_DEFAULT_THRESHOLD);
+}
+
+int main(int argc, const char *argv[])
+{
+    static tstr_bench_result astr_results[BENCH_MAX_RESULTS];
+    u32 u32_result_count = 0;
+    u64 u64_corpus_size = (u64)BENCH_DEFAULT_SIZE_MIB * 1024u * 1024u;
+    u32 u32_repeat_count = BENCH_DEFAULT_REPEAT_COUNT;
+    bool ab_corpus_selected[BENCH_CORPUS_COUNT] = {true, true, true, true};
+    bool ab_codec_selected[BENCH_MAX_CODECS] = {false};
+    u32 u32_codec_count = 1u + codec_registry_count();
+    const char *pc_dir = NULL;
+    const char *pc_json_path = NULL;
+    const char *pc_compare_old = NULL;
+    const char *pc_compare_new = NULL;
+    f64 f64_threshold = BENCH_DEFAULT_THRESHOLD;
+    tstr_codec_options str_options = {FILE_FORMAT_RLE, BLOCK_CODEC_RLE2, 0, 1, IO_BACKEND_AUTO, FLUSH_POLICY_NONE, 0, STATS_OUTPUT_NONE, false};
+    FILE *pf_log_sink = NULL;
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool b_has_value = ((i + 1) < argc);
+
+        if ((0 == strcmp(argv[i], "--size")) && (true == b_has_value))
+        {
+            u64_corpus_size = strtoul(argv[++i], NULL, 10) * 1024u * 1024u;
+        }
+        else if ((0 == strcmp(argv[i], "--repeat")) && (true == b_has_value))
+        {
+            u32_repeat_count = (u32)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--corpus")) && (true == b_has_value))
+        {
+            i++;
+
+            for (u32 c = 0; c < BENCH_CORPUS_COUNT; c++)
+            {
+                ab_corpus_selected[c] = (NULL != strstr(argv[i], gapc_corpus_names[c]));
+            }
+        }
+        else if ((0 == strcmp(argv[i], "--codec") || 0 == strcmp(argv[i], "--format")) && (true == b_has_value))
+        {
+            i++;
+
+            if (false == b_bench_select_codecs(argv[i], ab_codec_selected, u32_codec_count))
+            {
+                bench_print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if ((0 == strcmp(argv[i], "--dir")) && (true == b_has_value))
+        {
+            pc_dir = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "-j")) && (true == b_has_value))
+        {
+            str_options.u32_thread_count = (u32)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--json")) && (true == b_has_value))
+        {
+            pc_json_path = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--compare")) && ((i + 2) < argc))
+        {
+            pc_compare_old = argv[++i];
+            pc_compare_new = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--threshold")) && (true == b_has_value))
+        {
+            f64_threshold = strtod(argv[++i], NULL);
+        }
+        else
+        {
+            bench_print_usage(argv[0]);
+            return (0 == strcmp(argv[i], "-h") || 0 == strcmp(argv[i], "--help")) ? 0 : 1;
+        }
+    }
+
+    if ((0 == u32_repeat_count) || (0 == str_options.u32_thread_count) || (THREAD_POOL_MAX_THREADS < str_options.u32_thread_count) ||
+        (BENCH_MAX_CODECS < u32_codec_count))
+    {
+        bench_print_usage(argv[0]);
+        return 1;
+    }
+
+    checksum_init();
+
+    if (NULL != pc_compare_old)
+    {
+        u32 u32_regression_count = 0;
+
+        s32_ret_val = s32_bench_compare(pc_compare_old, pc_compare_new, f64_threshold, &u32_regression_count);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            printf("%u regression(s) beyond %.1f%%\n", u32_regression_count, f64_threshold);
+        }
+
+        return ((SUCCESS_STATUS != s32_ret_val) || (0 != u32_regression_count)) ? 1 : 0;
+    }
+
+    // Every codec runs unless some were named
+    if (NULL == memchr(ab_codec_selected, true, sizeof(ab_codec_selected)))
+    {
+        memset(ab_codec_selected, true, sizeof(ab_codec_selected));
+    }
+
+    // The file commands log every file, only errors are interesting here
+    pf_log_sink = fopen("/dev/null", "w");
+
+    // Decoders must reject corrupted input before anything is measured
+    s32_ret_val = s32_bench_check_corrupt();
+
+    if (SUCCESS_STATUS != s32_ret_val)
+    {
+        LOG_ERROR("Corrupt input checks failed with error code: %d", s32_ret_val);
+    }
+
+    for (u32 c = 0; (c < BENCH_CORPUS_COUNT) && (SUCCESS_STATUS == s32_ret_val); c++)
+    {
+        char ac_corpus_path[BENCH_PATH_SIZE];
+        char *pc_chunk = NULL;
+
+        if (false == ab_corpus_selected[c])
+        {
+            continue;
+        }
+
+        if (NULL != pc_dir)
+        {
+            pc_chunk = (char *)malloc(BENCH_CHUNK_SIZE_BYTES);
+            snprintf(ac_corpus_path, sizeof(ac_corpus_path), "%s/bench_%s.txt", pc_dir, gapc_corpus_names[c]);
+
+            s32_ret_val = (NULL == pc_chunk) ? ERROR_MEMORY_ALLOCATION_FAILED : s32_bench_write_corpus((tenu_bench_corpus)c, u64_corpus_size, ac_corpus_path, pc_chunk);
+            free(pc_chunk);
+        }
+
+        for (u32 k = 0; (k < u32_codec_count) && (SUCCESS_STATUS == s32_ret_val); k++)
+        {
+            if (false == ab_codec_selected[k])
+            {
+                continue;
+            }
+
+            // Case 0 is the text format, the others are the block codecs of .rle2 files
+            str_options.enu_format = (0 == k) ? FILE_FORMAT_RLE : FILE_FORMAT_RLE2;
+            str_options.enu_block_codec = (0 == k) ? BLOCK_CODEC_RLE2 : (tenu_block_codec)codec_registry_at(k - 1u)->u8_id;
+
+            for (u32 m = 0; (m < BENCH_MODE_COUNT) && (SUCCESS_STATUS == s32_ret_val) && (u32_result_count < BENCH_MAX_RESULTS); m++)
+            {
+                if ((BENCH_MODE_FILE == m) && (NULL == pc_dir))
+                {
+                    continue;
+                }
+
+                log_set_output(pf_log_sink);
+                s32_ret_val = s32_bench_case((tenu_bench_corpus)c, (tenu_bench_mode)m, u64_corpus_size, u32_repeat_count, pc_dir, &str_options,
+                                             &astr_results[u32_result_count]);
+                log_set_output(stderr);
+
+                if (SUCCESS_STATUS != s32_ret_val)
+                {
+                    LOG_ERROR("Case %s/%s/%s failed with error code: %d", gapc_corpus_names[c], pc_bench_codec_name(&str_options), gapc_mode_names[m], s32_ret_val);
+                    break;
+                }
+
+                u32_result_count++;
+            }
+        }
+
+        if (NULL != pc_dir)
+        {
+            remove(ac_corpus_path);
+        }
+    }
+
+    bench_print_table(astr_results, u32_result_count);
+
+    if ((SUCCESS_STATUS == s32_ret_val) && (NULL != pc_json_path))
+    {
+        s32_ret_val = s32_bench_write_json(pc_json_path, astr_results, u32_result_count, u64_corpus_size, u32_repeat_count);
+    }
+
+    if (NULL != pf_log_sink)
+    {
+        fclose(pf_log_sink);
+    }
+
+    return (SUCCESS_STATUS == s32_ret_val) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+
+
+#define BENCH_OUTPUT_SIZE_BYTES    (64u * 1024u * 1024u)
+#define BENCH_RUNS_COUNT           (1u << 20)
+#define BENCH_REPEAT_COUNT         (5u)
+
+// Run length distributions exercised by the benchmark
+typedef enum {
+    BENCH_DIST_SINGLE,       // Every run has length 1 (incompressible text)
+    BENCH_DIST_SHORT,        // Uniform 1..8
+    BENCH_DIST_MEDIUM,       // Uniform 1..64
+    BENCH_DIST_GEOMETRIC,    // Geometric with mean 16, capped at 4096
+    BENCH_DIST_LONG,         // Uniform 256..4096 (padded fixed-width logs)
+    BENCH_DIST_COUNT
+} tenu_bench_dist;
+
+static const char *gapc_dist_names[BENCH_DIST_COUNT] = {"len=1", "len=1..8", "len=1..64", "geometric(16)", "len=256..4096"};
+
+
+/**
+ * @brief Small deterministic xorshift generator, so every run sees the same data
+ * 
+ * @param[in out] pu64_state Generator state
+ * @return u64 Next pseudo-random number
+ */
+static u64 u64_bench_rand(u64 *pu64_state)
+{
+    *pu64_state ^= *pu64_state << 13;
+    *pu64_state ^= *pu64_state >> 7;
+    *pu64_state ^= *pu64_state << 17;
+
+    return *pu64_state;
+}
+
+/**
+ * @brief Draw one run length from the given distribution
+ * 
+ * @param[in] enu_dist Distribution to draw from
+ * @param[in out] pu64_state Generator state
+ * @return u64 Run length
+ */
+static u64 u64_bench_run_len(const tenu_bench_dist enu_dist, u64 *pu64_state)
+{
+    u64 u64_run_len = 1;
+
+    switch (enu_dist)
+    {
+        case BENCH_DIST_SHORT:  u64_run_len = 1 + (u64_bench_rand(pu64_state) % 8); break;
+        case BENCH_DIST_MEDIUM: u64_run_len = 1 + (u64_bench_rand(pu64_state) % 64); break;
+        case BENCH_DIST_LONG:   u64_run_len = 256 + (u64_bench_rand(pu64_state) % 3841); break;
+        case BENCH_DIST_GEOMETRIC:
+        {
+            while ((u64_run_len < 4096) && (0 != (u64_bench_rand(pu64_state) % 16)))
+            {
+                u64_run_len++;
+            }
+            break;
+        }
+        default: break;
+    }
+
+    return u64_run_len;
+}
+
+/**
+ * @brief Byte-at-a-time expansion, as done by the decoder before run_expand()
+ * 
+ * Loop distribution is disabled so the compiler does not turn it into memset.
+ * 
+ * @param[in out] pc_output_data Output buffer
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @return void
+ */
+__attribute__((noinline, optimize("no-tree-loop-distribute-patterns", "no-tree-vectorize")))
+static void bench_expand_scalar(char *pc_output_data, const char c_run_char, const u64 u64_run_len)
+{
+    for (u64 j = 0; j < u64_run_len; j++)
+    {
+        pc_output_data[j] = c_run_char;
+    }
+}
+
+/**
+ * @brief Plain memset expansion, to isolate the gain of the short-run fast path
+ * 
+ * @param[in out] pc_output_data Output buffer
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @return void
+ */
+__attribute__((noinline))
+static void bench_expand_memset(char *pc_output_data, const char c_run_char, const u64 u64_run_len)
+{
+    memset(pc_output_data, c_run_char, u64_run_len);
+}
+
+/**
+ * @brief Expand all runs into the output buffer with the given kernel and return the best MB/s
+ * 
+ * @param[in] pf_expand Expansion kernel
+ * @param[in] pu64_run_lens Run lengths
+ * @param[in] u64_runs_count Number of runs
+ * @param[in out] pc_output_data Output buffer (BENCH_OUTPUT_SIZE_BYTES + slack)
+ * @return f64 Best throughput in MB/s over BENCH_REPEAT_COUNT repetitions
+ */
+static f64 f64_bench_kernel(void (*pf_expand)(char *, const char, const u64), const u64 *pu64_run_lens, const u64 u64_runs_count, char *pc_output_data)
+{
+    f64 f64_best_mbps = 0;
+
+    for (u32 r = 0; r < BENCH_REPEAT_COUNT; r++)
+    {
+        struct timespec str_start, str_end;
+        u64 u64_write_idx = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &str_start);
+
+        for (u64 i = 0; i < u64_runs_count; i++)
+        {
+            if ((u64_write_idx + pu64_run_lens[i]) > BENCH_OUTPUT_SIZE_BYTES)
+            {
+                u64_write_idx = 0;
+            }
+
+            pf_expand(&pc_output_data[u64_write_idx], (char)('a' + (i & 15)), pu64_run_lens[i]);
+            u64_write_idx += pu64_run_lens[i];
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &str_end);
+
+        u64 u64_total_bytes = 0;
+
+        for (u64 i = 0; i < u64_runs_count; i++)
+        {
+            u64_total_bytes += pu64_run_lens[i];
+        }
+
+        f64 f64_seconds = (f64)(str_end.tv_sec - str_start.tv_sec) + ((f64)(str_end.tv_nsec - str_start.tv_nsec) / 1e9);
+        f64 f64_mbps = ((f64)u64_total_bytes / (1024.0 * 1024.0)) / f64_seconds;
+
+        if (f64_mbps > f64_best_mbps)
+        {
+            f64_best_mbps = f64_mbps;
+        }
+    }
+
+    return f64_best_mbps;
+}
+
+int main(void)
+{
+    u64 *pu64_run_lens = (u64 *)malloc(BENCH_RUNS_COUNT * sizeof(u64));
+    char *pc_output_data = (char *)malloc(BENCH_OUTPUT_SIZE_BYTES + RUN_EXPAND_SLACK_BYTES);
+
+    if (NULL == pu64_run_lens || NULL == pc_output_data)
+    {
+        LOG_ERROR("Error allocating benchmark buffers.");
+        return 1;
+    }
+
+    run_kernels_init();
+
+    printf("%-16s %12s %12s %12s %9s\n", "distribution", "scalar MB/s", "memset MB/s", "expand MB/s", "speedup");
+
+    for (u32 d = 0; d < BENCH_DIST_COUNT; d++)
+    {
+        u64 u64_state = 0x9E3779B97F4A7C15u;
+
+        for (u64 i = 0; i < BENCH_RUNS_COUNT; i++)
+        {
+            pu64_run_lens[i] = u64_bench_run_len((tenu_bench_dist)d, &u64_state);
+        }
+
+        f64 f64_scalar_mbps = f64_bench_kernel(bench_expand_scalar, pu64_run_lens, BENCH_RUNS_COUNT, pc_output_data);
+        f64 f64_memset_mbps = f64_bench_kernel(bench_expand_memset, pu64_run_lens, BENCH_RUNS_COUNT, pc_output_data);
+        f64 f64_expand_mbps = f64_bench_kernel(run_expand, pu64_run_lens, BENCH_RUNS_COUNT, pc_output_data);
+
+        printf("%-16s %12.0f %12.0f %12.0f %8.1fx\n", gapc_dist_names[d], f64_scalar_mbps, f64_memset_mbps, f64_expand_mbps, f64_expand_mbps / f64_scalar_mbps);
+    }
+
+    free(pu64_run_lens);
+    free(pc_output_data);
+
+    return 0;
+}
\ No newline at end of file
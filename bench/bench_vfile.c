@@ -0,0 +1,253 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/checksum.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/vfile.h"
+
+
+#define BENCH_DEFAULT_THREADS       (4u)
+#define BENCH_DEFAULT_READS         (20000u)
+#define BENCH_DEFAULT_READ_SIZE     (4096u)
+#define BENCH_DEFAULT_HOT_MIB       (32u)
+#define BENCH_MAX_THREADS           (64u)
+#define BENCH_CHECK_READ_SIZE       (256u)     // Read of the reopen check, within the first block
+
+// Cache budgets compared by the benchmark, in MiB
+static const u64 gau64_capacities_mib[] = {0, 8, 64, 256};
+
+// Reader thread of the benchmark
+typedef struct {
+    const tstr_vfile *pstr_file;
+    u64 u64_seed;
+    u32 u32_read_count;
+    u32 u32_read_size;
+    u64 u64_hot_size;          // Reads fall in the first u64_hot_size bytes of the data
+    u64 u64_read_bytes;
+    s32 s32_ret_val;
+} tstr_bench_reader;
+
+
+/**
+ * @brief Small deterministic xorshift generator, so every run sees the same offsets
+ * 
+ * @param[in out] pu64_state Generator state
+ * @return u64 Next pseudo-random number
+ */
+static u64 u64_bench_rand(u64 *pu64_state)
+{
+    *pu64_state ^= *pu64_state << 13;
+    *pu64_state ^= *pu64_state >> 7;
+    *pu64_state ^= *pu64_state << 17;
+
+    return *pu64_state;
+}
+
+/**
+ * @brief Make small overlapping reads at random offsets of the hot region
+ * 
+ * @param[in out] pv_reader Reader state
+ * @return void* NULL
+ */
+static void *pv_bench_reader(void *pv_reader)
+{
+    tstr_bench_reader *pstr_reader = (tstr_bench_reader *)pv_reader;
+    char *pc_buffer = (char *)malloc(pstr_reader->u32_read_size);
+    u64 u64_state = pstr_reader->u64_seed;
+
+    pstr_reader->s32_ret_val = (NULL == pc_buffer) ? ERROR_MEMORY_ALLOCATION_FAILED : SUCCESS_STATUS;
+
+    for (u32 i = 0; (SUCCESS_STATUS == pstr_reader->s32_ret_val) && (i < pstr_reader->u32_read_count); i++)
+    {
+        u64 u64_read_size = 0;
+
+        pstr_reader->s32_ret_val = vfile_pread(pstr_reader->pstr_file, pc_buffer, pstr_reader->u32_read_size,
+                                               u64_bench_rand(&u64_state) % pstr_reader->u64_hot_size, &u64_read_size);
+        pstr_reader->u64_read_bytes += u64_read_size;
+    }
+
+    free(pc_buffer);
+
+    return NULL;
+}
+
+/**
+ * @brief Check that a second open of a file reads the blocks the first open cached
+ * 
+ * @param[in] pc_path Path to the compressed file
+ * @return s32 SUCCESS_STATUS when the second open hits the cache, error code otherwise 
+ */
+static s32 s32_bench_check_reopen(const char *pc_path)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    char ac_first[BENCH_CHECK_READ_SIZE];
+    char ac_second[BENCH_CHECK_READ_SIZE];
+    u64 u64_first_size = 0;
+    u64 u64_second_size = 0;
+    tstr_vfile str_file;
+    tstr_vfile_cache_stats str_stats;
+
+    vfile_cache_reset_stats();
+
+    do
+    {
+        s32_ret_val = vfile_open(&str_file, pc_path);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = vfile_pread(&str_file, ac_first, BENCH_CHECK_READ_SIZE, 0, &u64_first_size);
+        vfile_close(&str_file);
+        ERROR_BREAK(s32_ret_val);
+
+        // The blocks outlive the close, the next open of the same file finds them
+        s32_ret_val = vfile_open(&str_file, pc_path);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = vfile_pread(&str_file, ac_second, BENCH_CHECK_READ_SIZE, 0, &u64_second_size);
+        vfile_close(&str_file);
+        ERROR_BREAK(s32_ret_val);
+
+        vfile_cache_get_stats(&str_stats);
+
+        if ((1u != str_stats.u64_misses) || (1u != str_stats.u64_hits))
+        {
+            LOG_ERROR("Check reopen: %lu hits and %lu misses, expected 1 and 1.", str_stats.u64_hits, str_stats.u64_misses);
+            s32_ret_val = FAILURE_STATUS;
+            break;
+        }
+
+        if ((u64_first_size != u64_second_size) || (0 != memcmp(ac_first, ac_second, u64_first_size)))
+        {
+            LOG_ERROR("Check reopen: the second open read other data.");
+            s32_ret_val = FAILURE_STATUS;
+            break;
+        }
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+int main(int argc, char const *argv[])
+{
+    const char *pc_path = NULL;
+    u32 u32_thread_count = BENCH_DEFAULT_THREADS;
+    u32 u32_read_count = BENCH_DEFAULT_READS;
+    u32 u32_read_size = BENCH_DEFAULT_READ_SIZE;
+    u64 u64_hot_mib = BENCH_DEFAULT_HOT_MIB;
+    tstr_vfile str_file;
+
+    for (s32 i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "--threads")) && ((i + 1) < argc))
+        {
+            u32_thread_count = (u32)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--reads")) && ((i + 1) < argc))
+        {
+            u32_read_count = (u32)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--read-size")) && ((i + 1) < argc))
+        {
+            u32_read_size = (u32)strtoul(argv[++i], NULL, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--hot")) && ((i + 1) < argc))
+        {
+            u64_hot_mib = strtoull(argv[++i], NULL, 10);
+        }
+        else
+        {
+            pc_path = argv[i];
+        }
+    }
+
+    if ((NULL == pc_path) || (0 == u32_thread_count) || (u32_thread_count > BENCH_MAX_THREADS) || (0 == u32_read_size) || (0 == u64_hot_mib))
+    {
+        printf("Usage: %s <file.rle2> [--threads 1-%u] [--reads per thread] [--read-size bytes] [--hot MiB]\n", argv[0], BENCH_MAX_THREADS);
+        return 1;
+    }
+
+    run_kernels_init();
+    checksum_init();
+
+    // Opens of one file must share its cached blocks before anything is measured
+    if (SUCCESS_STATUS != s32_bench_check_reopen(pc_path))
+    {
+        return 1;
+    }
+
+    if (SUCCESS_STATUS != vfile_open(&str_file, pc_path))
+    {
+        return 1;
+    }
+
+    u64 u64_hot_size = u64_hot_mib * 1024u * 1024u;
+
+    if (u64_hot_size > vfile_size(&str_file))
+    {
+        u64_hot_size = vfile_size(&str_file);
+    }
+
+    printf("%s: %lu bytes, %u threads x %u reads of %u bytes over the first %lu bytes\n", pc_path, vfile_size(&str_file), u32_thread_count, u32_read_count,
+           u32_read_size, u64_hot_size);
+    printf("%-10s %12s %10s %12s %12s %12s %8s\n", "cache", "reads/s", "MB/s", "hits", "misses", "evictions", "hit %");
+
+    for (u32 c = 0; c < (sizeof(gau64_capacities_mib) / sizeof(gau64_capacities_mib[0])); c++)
+    {
+        tstr_bench_reader astr_readers[BENCH_MAX_THREADS];
+        pthread_t astr_threads[BENCH_MAX_THREADS];
+        tstr_vfile_cache_stats str_stats;
+        struct timespec str_start;
+        struct timespec str_end;
+        u64 u64_read_bytes = 0;
+        s32 s32_ret_val = SUCCESS_STATUS;
+
+        // Every budget starts cold
+        vfile_cache_set_capacity(0);
+        vfile_cache_set_capacity(gau64_capacities_mib[c] * 1024u * 1024u);
+        vfile_cache_reset_stats();
+
+        clock_gettime(CLOCK_MONOTONIC, &str_start);
+
+        for (u32 t = 0; t < u32_thread_count; t++)
+        {
+            astr_readers[t] = (tstr_bench_reader){&str_file, 0x9E3779B97F4A7C15u + t, u32_read_count, u32_read_size, u64_hot_size, 0, SUCCESS_STATUS};
+            pthread_create(&astr_threads[t], NULL, pv_bench_reader, &astr_readers[t]);
+        }
+
+        for (u32 t = 0; t < u32_thread_count; t++)
+        {
+            pthread_join(astr_threads[t], NULL);
+            u64_read_bytes += astr_readers[t].u64_read_bytes;
+
+            if (SUCCESS_STATUS != astr_readers[t].s32_ret_val)
+            {
+                s32_ret_val = astr_readers[t].s32_ret_val;
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &str_end);
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            LOG_ERROR("Reads failed with error code: %d", s32_ret_val);
+            break;
+        }
+
+        vfile_cache_get_stats(&str_stats);
+
+        f64 f64_seconds = (f64)(str_end.tv_sec - str_start.tv_sec) + ((f64)(str_end.tv_nsec - str_start.tv_nsec) / 1e9);
+        f64 f64_lookups = (f64)(str_stats.u64_hits + str_stats.u64_misses);
+
+        printf("%6lu MiB %12.0f %10.1f %12lu %12lu %12lu %7.1f%%\n", gau64_capacities_mib[c], ((f64)u32_thread_count * u32_read_count) / f64_seconds,
+               ((f64)u64_read_bytes / (1024.0 * 1024.0)) / f64_seconds, str_stats.u64_hits, str_stats.u64_misses, str_stats.u64_evictions,
+               (0.0 < f64_lookups) ? (100.0 * (f64)str_stats.u64_hits / f64_lookups) : 0.0);
+    }
+
+    vfile_close(&str_file);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "thread_pool.h"
+#include "input_source.h"
+
+// Layout of .rlea archives:
+//   header | member data ... | central directory | footer
+// The data of one member is a run of container blocks closed by an END block. The central
+// directory lists every member, readers find it through the footer without parsing member data.
+#define ARCHIVE_MAGIC                  "RLEA"
+#define ARCHIVE_VERSION                (1u)
+#define ARCHIVE_HEADER_SIZE            (16u)      // magic[4] version[1] flags[1] reserved[10]
+#define ARCHIVE_FOOTER_SIZE            (16u)      // directory_offset[8] member_count[4] magic[4]
+#define ARCHIVE_FOOTER_MAGIC           "RLAD"
+#define ARCHIVE_ENTRY_FIXED_SIZE       (30u)      // data_offset[8] data_size[8] raw_size[8] crc32c[4] name_size[2], then the name
+#define ARCHIVE_NAME_MAX_SIZE          (4095u)
+#define ARCHIVE_WRITE_CHUNK_BYTES      (1024u * 1024u)   // Output gathered before a write is queued
+
+// One member, as recorded in the central directory
+typedef struct {
+    const char *pc_name;        // Path relative to the archived directory, '/' separated
+    u64 u64_data_offset;        // Archive offset of the first block header of the member
+    u64 u64_data_size;          // Size of the member data, END block included
+    u64 u64_raw_size;
+    u32 u32_crc32c;             // CRC32C of the raw data
+} tstr_archive_member;
+
+// Central directory of an archive, member names are stored back to back in str_names
+typedef struct {
+    tstr_archive_member *pstr_members;
+    u32 u32_member_count;
+    tstr_byte_buffer str_names;
+} tstr_archive_directory;
+
+// One block of the members being archived, coded by a pool thread. Small members share
+// a batch, so tiny files keep every thread busy too.
+typedef struct {
+    tstr_pool_task str_task;          // Pool task node of the job
+    u32 u32_member;                   // Member the block belongs to
+    bool b_member_end;                // Last block of the member, empty for empty members
+    const char *pc_raw;               // Raw block, points into the view of the member
+    u32 u32_raw_size;
+    tenu_block_codec enu_codec;       // Coding of the block
+    u32 u32_search_depth;             // LZ77 match candidates per position, 0 for the default
+    tstr_byte_buffer str_coded;       // Block header and coded payload
+    s32 s32_ret_val;                  // Status of the block coding
+} tstr_archive_block_job;
+
+// Member file being archived, kept open until its last block is written
+typedef struct {
+    FILE *pf_file;
+    tstr_input_source str_source;
+    u64 u64_used_size;                // Bytes of the current view cut into blocks
+    bool b_end_of_file;               // Every byte of the member was cut into blocks
+} tstr_archive_source;
+
+// One member extracted by a pool thread
+typedef struct {
+    tstr_pool_task str_task;                   // Pool task node of the job
+    FILE *pf_archive;                          // Read with positioned reads only, shared by all jobs
+    const tstr_archive_member *pstr_member;
+    const char *pc_out_dir;
+    tenu_io_backend enu_io_backend;
+    s32 s32_ret_val;                           // Status of the member
+} tstr_archive_extract_job;
+
+/**
+ * @brief Load and validate the central directory of an archive
+ * 
+ * @param[in] pf_archive Archive file, read with positioned reads
+ * @param[in] u64_archive_size Size of the archive file
+ * @param[in out] pstr_directory Directory to fill, released with archive_free_directory()
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 archive_load_directory(FILE *pf_archive, const u64 u64_archive_size, tstr_archive_directory *pstr_directory);
+
+/**
+ * @brief Release a central directory
+ * 
+ * @param[in out] pstr_directory Directory to release
+ * @return void
+ */
+void archive_free_directory(tstr_archive_directory *pstr_directory);
+
+/**
+ * @brief Archive every regular file under a directory into <directory>.rlea
+ * 
+ * Members are cut into blocks that are coded in parallel, batches mix the blocks of
+ * several small files. Members are stored in name order, so the archive does not
+ * depend on the thread count.
+ * 
+ * @param[in] pc_dir_path Directory to archive
+ * @param[in] pstr_options Thread count and I/O backend
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 archive_create(const char *pc_dir_path, const tstr_codec_options *pstr_options);
+
+/**
+ * @brief Print the members of an archive: original size, stored size, CRC32C and name
+ * 
+ * @param[in] pc_archive_path Path to the archive
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 archive_list(const char *pc_archive_path);
+
+/**
+ * @brief Extract members of an archive into the directory named after it (<name>.rlea -> <name>/)
+ * 
+ * Only the footer, the central directory and the data of the requested members are read.
+ * Existing files are never overwritten.
+ * 
+ * @param[in] pc_archive_path Path to the archive
+ * @param[in] ppc_member_names Names of the members to extract
+ * @param[in] u32_member_name_count Number of names, 0 to extract every member
+ * @param[in] pstr_options Thread count and I/O backend
+ * @return s32 SUCCESS_STATUS if every requested member was extracted, error code otherwise 
+ */
+s32 archive_extract(const char *pc_archive_path, const char **ppc_member_names, const u32 u32_member_name_count, const tstr_codec_options *pstr_options);
+
+#endif // ARCHIVE_H
\ No newline at end of file
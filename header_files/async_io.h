@@ -0,0 +1,148 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <linux/io_uring.h>
+
+#include "utils.h"
+#include "buffer.h"
+
+// Maximum number of operations in flight on one queue
+#define ASYNC_IO_QUEUE_DEPTH    (8u)
+
+// Enum for async operation types
+typedef enum {
+    ASYNC_IO_OP_READ,
+    ASYNC_IO_OP_WRITE
+} tenu_async_io_op;
+
+// Result of one finished operation
+typedef struct {
+    s64 s64_result;     // Bytes transferred, -errno on failure
+    u64 u64_tag;        // Tag given at submission
+} tstr_async_io_completion;
+
+// Queue of positioned reads and writes. Runs on io_uring when the kernel offers it,
+// otherwise every operation is done with pread/pwrite when it is submitted.
+typedef struct {
+    bool b_uring;
+    s32  s32_ring_fd;
+    void *pv_sq_ring;
+    u64  u64_sq_ring_size;
+    void *pv_cq_ring;                   // Same mapping as the SQ ring with IORING_FEAT_SINGLE_MMAP
+    u64  u64_cq_ring_size;
+    struct io_uring_sqe *pstr_sqes;
+    u64  u64_sqes_size;
+    u32 *pu32_sq_tail;
+    u32 *pu32_sq_mask;
+    u32 *pu32_sq_array;
+    u32 *pu32_cq_head;
+    u32 *pu32_cq_tail;
+    u32 *pu32_cq_mask;
+    struct io_uring_cqe *pstr_cqes;
+    u32  u32_unsubmitted_count;         // Queued in the SQ ring, not taken by the kernel yet
+    u32  u32_in_flight_count;           // Submitted and not reaped yet
+    tstr_async_io_completion astr_sync_done[ASYNC_IO_QUEUE_DEPTH];   // Fallback: finished, not reaped yet
+} tstr_async_io;
+
+// Buffers handed to the writer are written in order at increasing file offsets while the
+// caller fills the next one, memory is exchanged instead of copied
+typedef struct tstr_async_writer {
+    tstr_async_io str_io;
+    FILE *pf_file;
+    bool b_positioned;                                  // false for pipes and terminals, written through pf_file
+    u64  u64_offset;                                    // File offset of the next buffer
+    tstr_byte_buffer astr_slots[ASYNC_IO_QUEUE_DEPTH];  // Buffers being written, or free
+    u64  au64_slot_offset[ASYNC_IO_QUEUE_DEPTH];        // File offset of the unwritten part
+    u64  au64_slot_done[ASYNC_IO_QUEUE_DEPTH];          // Bytes of the slot written so far
+    bool ab_slot_busy[ASYNC_IO_QUEUE_DEPTH];
+    s32  s32_error;                                     // First write error
+    u64  u64_busy_ns;                                   // Time spent in write and flush calls, the caller was held up by the output
+} tstr_async_writer;
+
+/**
+ * @brief Set up an async I/O queue
+ * 
+ * @param[in out] pstr_io Queue to set up
+ * @param[in] enu_backend IO_BACKEND_SYNC for the pread/pwrite fallback, io_uring is tried otherwise 
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_io_init(tstr_async_io *pstr_io, const tenu_io_backend enu_backend);
+
+/**
+ * @brief Queue a positioned read or write and hand it to the kernel
+ * 
+ * @param[in out] pstr_io Queue
+ * @param[in] enu_op Operation
+ * @param[in] s32_fd File descriptor
+ * @param[in] pv_data Buffer to read into or write from, must stay valid until the operation is reaped
+ * @param[in] u32_size Number of bytes
+ * @param[in] u64_offset File offset
+ * @param[in] u64_tag Tag returned with the completion
+ * @return s32 SUCCESS_STATUS on success, ERROR_INVALID_LENGTH if the queue is full, error code otherwise 
+ */
+s32 async_io_submit(tstr_async_io *pstr_io, const tenu_async_io_op enu_op, const s32 s32_fd, void *pv_data, const u32 u32_size, const u64 u64_offset, const u64 u64_tag);
+
+/**
+ * @brief Wait for one queued operation to finish, operations the kernel did not take at submit are passed on first
+ * 
+ * @param[in out] pstr_io Queue
+ * @param[in out] pstr_completion Pointer to hold the finished operation
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_io_wait(tstr_async_io *pstr_io, tstr_async_io_completion *pstr_completion);
+
+/**
+ * @brief Get the number of operations not reaped yet
+ * 
+ * @param[in] pstr_io Queue
+ * @return u32 Number of operations in flight
+ */
+u32 async_io_pending_count(const tstr_async_io *pstr_io);
+
+/**
+ * @brief Release the queue, every operation must have been reaped
+ * 
+ * @param[in out] pstr_io Queue
+ * @return void
+ */
+void async_io_free(tstr_async_io *pstr_io);
+
+/**
+ * @brief Attach a writer to a file, writes start at the current file position
+ * 
+ * @param[in out] pstr_writer Writer to set up
+ * @param[in] pf_file File to write to
+ * @param[in] enu_backend I/O backend
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_writer_open(tstr_async_writer *pstr_writer, FILE *pf_file, const tenu_io_backend enu_backend);
+
+/**
+ * @brief Queue the content of a buffer for writing
+ * 
+ * The buffer memory is taken over by the writer, the caller gets back an empty buffer
+ * of at least the same capacity.
+ * 
+ * @param[in out] pstr_writer Writer
+ * @param[in out] pstr_buffer Filled buffer, empty on return
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_writer_write(tstr_async_writer *pstr_writer, tstr_byte_buffer *pstr_buffer);
+
+/**
+ * @brief Wait for every queued write and move the file position past the written data, pipes are flushed
+ * 
+ * @param[in out] pstr_writer Writer
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_writer_flush(tstr_async_writer *pstr_writer);
+
+/**
+ * @brief Wait for the queued writes and release the writer, the file stays open
+ * 
+ * @param[in out] pstr_writer Writer
+ * @return void
+ */
+void async_writer_free(tstr_async_writer *pstr_writer);
+
+#endif // ASYNC_IO_H
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "thread_pool.h"
+
+// One input file of a batch, run as one pool task. Large .rle2 files split further
+// into block jobs on the same pool.
+typedef struct {
+    tstr_pool_task str_task;              // Pool task node of the job
+    const char *pc_input_file;
+    const tstr_input_args *pstr_args;     // Operation and codec options shared by all files
+    tstr_thread_pool *pstr_pool;          // Pool the file hands its block jobs to
+    s32 s32_ret_val;                      // Status of the file
+} tstr_batch_job;
+
+/**
+ * @brief Read the input paths of a file list, one per line, empty lines are skipped
+ * 
+ * @param[in] pc_list_path Path to the list, "-" for stdin
+ * @param[in out] pstr_names Buffer to hold the paths, each one NUL terminated
+ * @param[in out] pu32_name_count Pointer to hold the number of paths read
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 batch_read_file_list(const char *pc_list_path, tstr_byte_buffer *pstr_names, u32 *pu32_name_count);
+
+/**
+ * @brief Compress or decompress many files concurrently on one work-stealing pool
+ * 
+ * Every file is one task, tasks of large .rle2 files split into block jobs that idle
+ * threads steal. The status of every file is reported once all of them are done.
+ * 
+ * @param[in] pstr_args Parsed arguments: operation, input files, file list and codec options
+ * @return s32 SUCCESS_STATUS if every file succeeded, error code otherwise 
+ */
+s32 batch_run(const tstr_input_args *pstr_args);
+
+#endif // BATCH_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include "utils.h"
+
+// Smallest capacity allocated for a byte buffer
+#define BYTE_BUFFER_MIN_CAPACITY    (DATA_CHUNK_SIZE_BYTES)
+
+// Growable byte buffer, capacity grows geometrically so appends are amortized O(1)
+typedef struct {
+    char *pc_data;
+    u64   u64_size;        // Number of bytes in use
+    u64   u64_capacity;    // Number of bytes allocated
+} tstr_byte_buffer;
+
+// Byte buffer memory of the threads attached with byte_buffer_stats_attach(), updated atomically
+typedef struct {
+    u64 u64_realloc_count;  // Allocations and reallocations made by the buffer functions
+    u64 u64_live_bytes;     // Capacity allocated while attached and not freed yet
+    u64 u64_peak_bytes;     // Highest u64_live_bytes
+} tstr_buffer_stats;
+
+// Fixed-size write buffer the decoders expand runs into, flushed to a file or a sink buffer when full
+typedef struct tstr_output_window {
+    tstr_byte_buffer str_buffer;   // Reserved once with slack for the wide run stores, never grown
+    u64   u64_window_size;         // Bytes buffered before the window is flushed
+    u64   u64_total_size;          // Total number of bytes flushed so far
+    FILE *pf_file;                           // NULL with no writer or sink to discard the data (integrity test)
+    struct tstr_async_writer *pstr_writer;   // Writer the window is flushed through, NULL to write pf_file directly
+    tstr_byte_buffer *pstr_sink;             // Buffer the window is appended to instead of a file, NULL to write a file
+    u64   u64_total_limit;                   // Flushes past this total fail with ERROR_INVALID_LENGTH, 0 for no limit
+    struct tstr_output_window *pstr_range_output;  // Window only the bytes in [u64_range_start, u64_range_end) are copied to, NULL for all bytes
+    u64   u64_range_start;                   // First byte of the range copied to pstr_range_output
+    u64   u64_range_end;                     // End of the range copied to pstr_range_output, exclusive
+} tstr_output_window;
+
+/**
+ * @brief Initialize an empty byte buffer without allocating memory
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer to initialize
+ * @return void
+ */
+void byte_buffer_init(tstr_byte_buffer *pstr_buffer);
+
+/**
+ * @brief Make sure the buffer can hold at least the requested number of bytes
+ * 
+ * The capacity is at least doubled on every reallocation, so growing a buffer to n
+ * bytes through repeated reserves costs O(log n) reallocations.
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @param[in] u64_min_capacity Minimum capacity required
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 byte_buffer_reserve(tstr_byte_buffer *pstr_buffer, const u64 u64_min_capacity);
+
+/**
+ * @brief Append data at the end of the buffer, growing it if needed
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @param[in] pc_data Data to append
+ * @param[in] u64_data_size Size of the data to append
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 byte_buffer_append(tstr_byte_buffer *pstr_buffer, const char *pc_data, const u64 u64_data_size);
+
+/**
+ * @brief Release the unused capacity of the buffer
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 byte_buffer_shrink_to_fit(tstr_byte_buffer *pstr_buffer);
+
+/**
+ * @brief Hand the buffer memory over to the caller and leave the buffer empty
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @param[in out] pu64_data_size Pointer to hold the number of bytes in use (may be NULL)
+ * @return char* Pointer to the data, to be freed by the caller
+ */
+char *byte_buffer_release(tstr_byte_buffer *pstr_buffer, u64 *pu64_data_size);
+
+/**
+ * @brief Free the buffer memory and leave the buffer empty
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @return void
+ */
+void byte_buffer_free(tstr_byte_buffer *pstr_buffer);
+
+/**
+ * @brief Count the byte buffer memory of the calling thread into a statistics record
+ * 
+ * Buffers freed while attached that were allocated before do not lower the live bytes
+ * below zero. Several threads may count into one record, pool tasks count into the
+ * record of the thread that submitted them.
+ * 
+ * @param[in out] pstr_stats Record to count into, NULL to stop counting
+ * @return tstr_buffer_stats* Record attached before, to attach again when done
+ */
+tstr_buffer_stats *byte_buffer_stats_attach(tstr_buffer_stats *pstr_stats);
+
+/**
+ * @brief Get the statistics record the calling thread counts into
+ * 
+ * @return tstr_buffer_stats* Attached record, NULL when not counted
+ */
+tstr_buffer_stats *byte_buffer_stats_attached(void);
+
+/**
+ * @brief Allocate the output window memory, including the slack needed by run_expand()
+ * 
+ * @param[in out] pstr_window Output window to allocate
+ * @param[in] u64_window_size Bytes buffered before the window is flushed
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_reserve(tstr_output_window *pstr_window, const u64 u64_window_size);
+
+/**
+ * @brief Write the filled part of the output window to its file or sink and reset the window
+ * 
+ * A window without a file, writer or sink drops its data, only the total size is kept. A window
+ * with a total limit keeps its data and fails instead of flushing past the limit. A window with a
+ * range output copies only the bytes of its range there.
+ * 
+ * @param[in out] pstr_window Output window to flush
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_flush(tstr_output_window *pstr_window);
+
+/**
+ * @brief Expand one run into the output window, flushing it as many times as needed
+ * 
+ * A window with a range output counts the part of a run longer than the window that falls
+ * outside its range without expanding it.
+ * 
+ * @param[in out] pstr_window Output window to expand the run into
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_append_run(tstr_output_window *pstr_window, const char c_run_char, u64 u64_run_len);
+
+/**
+ * @brief Copy raw bytes into the output window, flushing it as many times as needed
+ * 
+ * @param[in out] pstr_window Output window to copy the bytes into
+ * @param[in] pc_data Bytes to copy
+ * @param[in] u64_data_size Number of bytes to copy
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_append(tstr_output_window *pstr_window, const char *pc_data, u64 u64_data_size);
+
+#endif // BUFFER_H
\ No newline at end of file
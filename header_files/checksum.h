@@ -0,0 +1,30 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include "utils.h"
+
+// CRC32C (Castagnoli) of an empty input, start value of crc32c_update()
+#define CRC32C_INITIAL_VALUE    (0u)
+
+/**
+ * @brief Build the CRC32C lookup tables, called once at startup
+ * 
+ * Calling it is optional, the tables are built on first use otherwise.
+ * 
+ * @return void
+ */
+void checksum_init(void);
+
+/**
+ * @brief Extend a CRC32C with more data
+ * 
+ * crc32c_update(crc32c_update(CRC32C_INITIAL_VALUE, a), b) equals the CRC32C of a followed by b.
+ * 
+ * @param[in] u32_crc CRC32C of the data before pc_data, CRC32C_INITIAL_VALUE to start
+ * @param[in] pc_data Data to add
+ * @param[in] u64_data_size Size of the data
+ * @return u32 CRC32C of the data seen so far
+ */
+u32 crc32c_update(u32 u32_crc, const char *pc_data, const u64 u64_data_size);
+
+#endif // CHECKSUM_H
\ No newline at end of file
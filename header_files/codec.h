@@ -0,0 +1,278 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "rle.h"
+#include "rle2.h"
+#include "container.h"
+
+// In-memory codec API, the file commands of the CLI are built on it.
+// A context keeps its scratch buffers from one message to the next, once they have grown
+// to the size of the largest message, coding more messages does not allocate.
+
+// State of the sequential decoder, the format is detected from the first bytes of the input
+typedef struct {
+    tenu_file_format enu_format;
+    tstr_rle_decoder str_rle_decoder;
+    tstr_rle2_decoder str_rle2_decoder;
+    tstr_rle2_header str_rle2_header;
+    tstr_block_reader str_block_reader;
+    u64 u64_input_size;                            // Compressed bytes decoded so far
+} tstr_stream_decoder;
+
+// Reusable coding state, one message or stream at a time, must not be copied once initialized
+typedef struct {
+    tenu_file_format enu_format;                   // Format written by the compressor, the decompressor detects it
+    tenu_block_codec enu_block_codec;              // Coding of the .rle2 blocks written by the compressor
+    u32 u32_search_depth;                          // LZ77 match candidates per position, 0 for the default
+    tstr_rle_encoder str_encoder;                  // Pending text run
+    tstr_byte_buffer str_raw;                      // .rle2 input not cut into a block yet, or the first bytes of a compressed stream
+    tstr_byte_buffer str_index;                    // Serialized index entries of the .rle2 blocks coded so far
+    u64 u64_raw_offset;                            // Raw bytes coded into .rle2 blocks so far
+    u64 u64_compressed_offset;                     // Stream offset of the next .rle2 block
+    bool b_header_written;
+    tstr_stream_decoder str_decoder;
+    tstr_output_window str_window;                 // Decoded data, flushed into str_output or the writer of codec_context_set_writer()
+    tstr_byte_buffer str_output;                   // Coded or decoded data not pulled yet
+    u64 u64_output_limit;                          // Decoded bytes held for codec_pull() before the decompression calls fail, 0 for no limit
+} tstr_codec_context;
+
+/**
+ * @brief Initialize a sequential decoder without allocating memory
+ * 
+ * @param[in out] pstr_decoder Decoder to initialize
+ * @return void
+ */
+void stream_decoder_init(tstr_stream_decoder *pstr_decoder);
+
+/**
+ * @brief Return a decoder to its initial state for the next stream, its buffers are kept
+ * 
+ * @param[in out] pstr_decoder Decoder to reset
+ * @return void
+ */
+void stream_decoder_reset(tstr_stream_decoder *pstr_decoder);
+
+/**
+ * @brief Decode the next chunk of a compressed stream
+ * 
+ * The first chunk selects the format from the magic number, it must hold the whole
+ * .rle2 header unless the input is shorter.
+ * 
+ * @param[in out] pstr_decoder Sequential decoder state
+ * @param[in] pc_input_data Compressed data
+ * @param[in] u64_input_data_size Size of the compressed data
+ * @param[in out] pstr_window Output window the decompressed data is written through, reserved on the first chunk
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 stream_decoder_update(tstr_stream_decoder *pstr_decoder, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window);
+
+/**
+ * @brief Check the end of a compressed stream and flush the rest of the output
+ * 
+ * @param[in out] pstr_decoder Sequential decoder state
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 stream_decoder_finish(tstr_stream_decoder *pstr_decoder, tstr_output_window *pstr_window);
+
+/**
+ * @brief Release the decoder memory
+ * 
+ * @param[in out] pstr_decoder Decoder to release
+ * @return void
+ */
+void stream_decoder_free(tstr_stream_decoder *pstr_decoder);
+
+/**
+ * @brief Initialize a codec context without allocating memory
+ * 
+ * @param[in out] pstr_context Context to initialize
+ * @param[in] enu_format Format written by the compression calls
+ * @return void
+ */
+void codec_context_init(tstr_codec_context *pstr_context, const tenu_file_format enu_format);
+
+/**
+ * @brief Select the coding of the .rle2 blocks written by the compression calls
+ * 
+ * @param[in out] pstr_context Context to configure, takes effect from the next block
+ * @param[in] enu_codec Coding of the blocks (BLOCK_CODEC_RLE2 after codec_context_init())
+ * @return void
+ */
+void codec_context_set_block_codec(tstr_codec_context *pstr_context, const tenu_block_codec enu_codec);
+
+/**
+ * @brief Select how many LZ77 match candidates the compression calls compare per position
+ * 
+ * @param[in out] pstr_context Context to configure, takes effect from the next block
+ * @param[in] u32_search_depth Candidates per position, 0 for the codec default (after codec_context_init())
+ * @return void
+ */
+void codec_context_set_search_depth(tstr_codec_context *pstr_context, const u32 u32_search_depth);
+
+/**
+ * @brief Send the data decoded by the decompression calls to a writer instead of codec_pull()
+ * 
+ * The window is handed to the writer whenever it fills up, so memory stays bounded however
+ * far a chunk expands. codec_decompress_flush() hands over the rest.
+ * 
+ * @param[in out] pstr_context Context to configure, set before the first chunk of a stream
+ * @param[in out] pstr_writer Writer of the decoded data, NULL to collect it with codec_pull() again
+ * @return void
+ */
+void codec_context_set_writer(tstr_codec_context *pstr_context, struct tstr_async_writer *pstr_writer);
+
+/**
+ * @brief Bound the decoded data the decompression calls hold until it is collected with codec_pull()
+ * 
+ * A call that would take the data held past the limit fails with ERROR_INVALID_LENGTH, the stream
+ * cannot be continued afterwards. The limit does not apply to a context with a writer.
+ * 
+ * @param[in out] pstr_context Context to configure
+ * @param[in] u64_output_limit Decoded bytes held at most besides the output window, 0 for no limit (after codec_context_init())
+ * @return void
+ */
+void codec_context_set_output_limit(tstr_codec_context *pstr_context, const u64 u64_output_limit);
+
+/**
+ * @brief Drop the stream in progress so the context can start a new one, its buffers are kept
+ * 
+ * @param[in out] pstr_context Context to reset
+ * @return void
+ */
+void codec_context_reset(tstr_codec_context *pstr_context);
+
+/**
+ * @brief Release the context memory
+ * 
+ * @param[in out] pstr_context Context to release
+ * @return void
+ */
+void codec_context_free(tstr_codec_context *pstr_context);
+
+/**
+ * @brief Worst case size of the output of codec_compress_buffer()
+ * 
+ * @param[in] enu_format Format of the output
+ * @param[in] u64_input_data_size Size of the input data
+ * @return u64 Output buffer size that holds any input of that size
+ */
+u64 codec_compress_bound(const tenu_file_format enu_format, const u64 u64_input_data_size);
+
+/**
+ * @brief Compress one message from buffer to buffer
+ * 
+ * The output is coded in place, .rle2 output carries the original size in its header.
+ * An empty message compresses to an empty .rle stream or to an .rle2 stream without blocks.
+ * 
+ * @param[in out] pstr_context Context lending its scratch buffers, any stream in progress is dropped
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the compressed data
+ * @param[in] u64_output_capacity Size of the output buffer, at least codec_compress_bound()
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data, or the required capacity on ERROR_INVALID_LENGTH
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_buffer(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size,
+                          char *pc_output_data, const u64 u64_output_capacity, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decompress one message from buffer to buffer, the format is detected
+ * 
+ * Decoding stops as soon as the output outgrows the buffer, so corrupt run lengths cannot
+ * make the context allocate more than the buffer size.
+ * 
+ * @param[in out] pstr_context Context lending its scratch buffers, any stream in progress is dropped
+ * @param[in] pc_input_data Compressed data
+ * @param[in] u64_input_data_size Size of the compressed data, 0 for an empty message
+ * @param[in out] pc_output_data Buffer to hold the decompressed data
+ * @param[in] u64_output_capacity Size of the output buffer
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the decompressed data, or the size decoded before stopping on ERROR_INVALID_LENGTH
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_buffer(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size,
+                            char *pc_output_data, const u64 u64_output_capacity, u64 *pu64_output_data_size);
+
+/**
+ * @brief Feed the next chunk of a stream to the compressor, the coded data is collected with codec_pull()
+ * 
+ * .rle2 data is coded a block at a time, a partial block waits for more input or a flush.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_push(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size);
+
+/**
+ * @brief Code everything pushed so far, the stream can be continued afterwards
+ * 
+ * The pending text run is emitted and .rle2 data is closed in a short block. Runs split
+ * by a flush decode to the same data.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_flush(tstr_codec_context *pstr_context);
+
+/**
+ * @brief End the stream, .rle2 streams get their END block, block index and footer
+ * 
+ * The header of an .rle2 stream keeps the size unknown flag. The context can start a
+ * new stream once the output is pulled.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_finish(tstr_codec_context *pstr_context);
+
+/**
+ * @brief Feed the next chunk of a compressed stream to the decompressor, the decoded data is collected with codec_pull()
+ * 
+ * Chunks may be cut anywhere, tokens and blocks straddling them are completed by the next chunk.
+ * All the data a chunk decodes to is held until codec_pull(), a few bytes of input can expand to
+ * gigabytes. Set an output limit with codec_context_set_output_limit() or a writer with
+ * codec_context_set_writer() for input that is not trusted.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in] pc_input_data Compressed data
+ * @param[in] u64_input_data_size Size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_push(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size);
+
+/**
+ * @brief Hand out the part of the last text run known so far, for live streams
+ * 
+ * The text format cannot tell that a count is complete before the next symbol, so
+ * codec_pull() alone holds the last run back. The rest of it follows with the next chunks.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_flush(tstr_codec_context *pstr_context);
+
+/**
+ * @brief Check the end of the compressed stream and decode what is left of it
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_finish(tstr_codec_context *pstr_context);
+
+/**
+ * @brief Take the output produced so far
+ * 
+ * The output buffer is exchanged with the one of the context instead of copied, the
+ * previous content of pstr_output is dropped and its memory is reused for later output.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in out] pstr_output Buffer to hold the output
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_pull(tstr_codec_context *pstr_context, tstr_byte_buffer *pstr_output);
+
+#endif // CODEC_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef CODEC_REGISTRY_H
+#define CODEC_REGISTRY_H
+
+#include <stdio.h>
+
+#include "utils.h"
+#include "buffer.h"
+
+// Registry of the payload codings of .rle2 blocks. A codec is keyed by its ID, the block type
+// byte of every block it codes, and the compressor records the selected ID in the file header.
+// Decoders dispatch on the block headers, so files keep decoding when new codecs are added.
+typedef struct {
+    u8 u8_id;                                  // Block type of the payloads (tenu_block_codec value)
+    const char *pc_name;                       // Name accepted by -f and --codec
+    const char *pc_description;                // One line shown by --list-codecs
+
+    // Worst case payload size of a block of raw data
+    u64 (*pf_bound)(const u64 u64_raw_size);
+
+    // Code one block, a payload of at least the raw size means the block should be stored raw
+    s32 (*pf_encode)(const char *pc_input_data, const u32 u32_input_data_size, const u32 u32_search_depth, char *pc_payload, u64 *pu64_payload_size);
+
+    // Decode one payload into the output window, exactly u32_raw_size bytes must come out
+    s32 (*pf_decode)(const char *pc_payload, const u32 u32_payload_size, const u32 u32_raw_size, tstr_output_window *pstr_window);
+} tstr_codec_entry;
+
+/**
+ * @brief Look a codec up by ID
+ * 
+ * @param[in] u8_id Codec ID, the block type of its payloads
+ * @return const tstr_codec_entry* Registry entry, NULL for unknown IDs
+ */
+const tstr_codec_entry *codec_registry_get(const u8 u8_id);
+
+/**
+ * @brief Look a codec up by name
+ * 
+ * @param[in] pc_name Name of the codec
+ * @return const tstr_codec_entry* Registry entry, NULL for unknown names
+ */
+const tstr_codec_entry *codec_registry_find(const char *pc_name);
+
+/**
+ * @brief Number of registered codecs
+ * 
+ * @return u32 Number of entries, codec_registry_at() takes 0 to this count minus 1
+ */
+u32 codec_registry_count(void);
+
+/**
+ * @brief Registered codec by position, in ID order
+ * 
+ * @param[in] u32_index Position in the registry
+ * @return const tstr_codec_entry* Registry entry, NULL past the end
+ */
+const tstr_codec_entry *codec_registry_at(const u32 u32_index);
+
+/**
+ * @brief Print the registered codecs, one per line, after the text format that has no ID
+ * 
+ * @param[in out] pf_stream Stream to print to
+ * @return void
+ */
+void codec_registry_print(FILE *pf_stream);
+
+#endif // CODEC_REGISTRY_H
\ No newline at end of file
@@ -2,7 +2,23 @@
 #define COMPRESS_H
 
 #include "utils.h"
+#include "buffer.h"
+#include "thread_pool.h"
+#include "stats.h"
 
-s32 compress(const char *input_file_name);
+// One block of the input coded by a pool thread, jobs are reused batch after batch
+typedef struct {
+    tstr_pool_task str_task;          // Pool task node of the job
+    const char *pc_raw;               // Raw block, cut at a run boundary, points into the input view
+    u32 u32_raw_size;
+    tenu_block_codec enu_codec;       // Coding of the block
+    u32 u32_search_depth;             // LZ77 match candidates per position, 0 for the default
+    tstr_byte_buffer str_coded;       // Block header and coded payload
+    s32 s32_ret_val;                  // Status of the block coding
+    u64 u64_busy_ns;                  // Time the coding took
+    u32 u32_slot;                     // Pool slot of the thread that coded the block
+} tstr_block_job;
+
+s32 compress(const char *input_file_name, const tstr_codec_options *pstr_options, tstr_thread_pool *pstr_pool, tstr_codec_stats *pstr_stats);
 
 #endif // COMPRESS_H
\ No newline at end of file
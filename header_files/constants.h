@@ -5,6 +5,7 @@
 
 
 #define DATA_CHUNK_SIZE_BYTES    (512u)
+#define DATA_WINDOW_SIZE_BYTES   (64u * 1024u) // Fixed window used by the streaming codecs
 
 // enumeration for error codes
 typedef enum 
@@ -26,6 +27,9 @@ typedef enum
     ERROR_MEMORY_ALLOCATION_FAILED,
     ERROR_COMPRESSION_FAILED,
     ERROR_DECOMPRESSION_FAILED,
+    ERROR_BATCH_FILES_FAILED,
+    ERROR_FILE_EXISTS,
+    ERROR_CHECKSUM_MISMATCH,
 } enu_error_codes;
 
 #endif // CONSTANTS_H
\ No newline at end of file
@@ -0,0 +1,274 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "rle2.h"
+
+// Block framing of .rle2 version 2 files:
+//   file header | block header + payload ... | END block header | index entries | footer
+// Every block is coded independently, the index at the end lets readers locate blocks without parsing them.
+#define CONTAINER_BLOCK_SIZE_BYTES      (1024u * 1024u)
+#define CONTAINER_BLOCK_HEADER_SIZE     (12u)
+#define CONTAINER_INDEX_ENTRY_SIZE      (24u)
+#define CONTAINER_FOOTER_SIZE           (16u)
+#define CONTAINER_FOOTER_MAGIC          "RLEI"
+#define CONTAINER_BLOCK_CHECKSUM_SIZE   (4u)       // CRC32C of the raw data in front of the payload of BLOCK_FLAG_CRC32C blocks
+
+// Block header flags
+#define BLOCK_FLAG_CRC32C               (0x01u)    // The payload starts with the CRC32C of the raw data, counted in compressed_size
+#define BLOCK_FLAGS_KNOWN               (BLOCK_FLAG_CRC32C)
+
+// Run density sample taken before coding a block: stretches of raw data spread over the block
+#define CONTAINER_SAMPLE_COUNT          (16u)
+#define CONTAINER_SAMPLE_SIZE_BYTES     (256u)
+
+// Worst case size of one coded block, header included
+#define CONTAINER_BLOCK_BOUND(size)     (CONTAINER_BLOCK_HEADER_SIZE + CONTAINER_BLOCK_CHECKSUM_SIZE + RLE2_COMPRESS_WINDOW_BOUND(size))
+
+// Size of the END block, the block index and the footer that close a block stream
+#define CONTAINER_TRAILER_SIZE(count)   (CONTAINER_BLOCK_HEADER_SIZE + ((u64)(count) * CONTAINER_INDEX_ENTRY_SIZE) + CONTAINER_FOOTER_SIZE)
+
+// Enum for block payload types, every type but END is the ID of a registered codec (codec_registry.h)
+typedef enum {
+    BLOCK_TYPE_RLE2     = 0x00, // RLE2 tokens, <byte><varint count>
+    BLOCK_TYPE_STORED   = 0x01, // Raw data when tokens would not be smaller, the payload is the raw data
+    BLOCK_TYPE_PACKBITS = 0x02, // Literal segments and run tokens, see packbits.h
+    BLOCK_TYPE_HUFFMAN  = 0x03, // Runs coded with per-block canonical Huffman codes, see huffman.h
+    BLOCK_TYPE_LZ77     = 0x04, // Literals and back references within the block, see lz77.h
+    BLOCK_TYPE_END      = 0xFF  // Last block marker, no payload
+} tenu_block_type;
+
+// Block header, stored little-endian as type[1] flags[1] reserved[2] raw_size[4] compressed_size[4]
+typedef struct {
+    u8  u8_block_type;
+    u8  u8_flags;
+    u32 u32_raw_size;
+    u32 u32_compressed_size;      // Payload size, header excluded, checksum included
+} tstr_block_header;
+
+// Block index entry, stored little-endian as compressed_offset[8] raw_offset[8] compressed_size[4] raw_size[4]
+typedef struct {
+    u64 u64_compressed_offset;    // File offset of the block header
+    u64 u64_raw_offset;           // Offset of the block data in the original file
+    u32 u32_compressed_size;      // Payload size, header excluded
+    u32 u32_raw_size;
+} tstr_block_index_entry;
+
+// Parser state of the sequential block reader
+typedef enum {
+    BLOCK_READER_STATE_HEADER,    // Collecting the bytes of a block header
+    BLOCK_READER_STATE_PAYLOAD,   // Collecting the payload of the current block
+    BLOCK_READER_STATE_DONE       // END block seen, the index and footer are skipped
+} tenu_block_reader_state;
+
+// Sequential reader state, blocks may straddle read boundaries
+typedef struct {
+    tenu_block_reader_state enu_state;
+    tstr_byte_buffer  str_block;        // Header or payload bytes of the current block
+    tstr_block_header str_header;
+    u64 u64_block_count;
+} tstr_block_reader;
+
+/**
+ * @brief Serialize a block header
+ * 
+ * @param[in] pstr_header Header to serialize
+ * @param[in out] pc_output_data Buffer to hold the header (at least CONTAINER_BLOCK_HEADER_SIZE bytes)
+ * @return void
+ */
+void container_write_block_header(const tstr_block_header *pstr_header, char *pc_output_data);
+
+/**
+ * @brief Parse and validate a block header
+ * 
+ * @param[in] pc_input_data CONTAINER_BLOCK_HEADER_SIZE bytes of header
+ * @param[in out] pstr_header Pointer to hold the parsed header
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_read_block_header(const char *pc_input_data, tstr_block_header *pstr_header);
+
+/**
+ * @brief Find the end of the next block to cut out of a span of raw data
+ * 
+ * Blocks end before a run that may continue past their end, so runs only get split
+ * when a single run fills a whole block.
+ * 
+ * @param[in] pc_span Raw data
+ * @param[in] u64_block_start Offset of the block in the span
+ * @param[in] u64_span_size Size of the span
+ * @param[in] b_span_is_final The span ends at the end of the input, its last run cannot continue
+ * @return u64 Offset of the end of the block, greater than u64_block_start when the span has data left
+ */
+u64 container_cut_block(const char *pc_span, const u64 u64_block_start, const u64 u64_span_size, const bool b_span_is_final);
+
+/**
+ * @brief Code one block of raw data, header included
+ * 
+ * The block is coded by the registered codec of that ID, blocks that the codec would not
+ * shrink are stored raw. Every block carries the CRC32C of its raw data.
+ * 
+ * @param[in] enu_codec Coding of the block
+ * @param[in] u32_search_depth LZ77 match candidates per position, 0 for the default
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data (at most CONTAINER_BLOCK_SIZE_BYTES)
+ * @param[in out] pc_output_data Buffer to hold the block (at least CONTAINER_BLOCK_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the block, header included
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_encode_block(const tenu_block_codec enu_codec, const u32 u32_search_depth, const char *pc_input_data, const u32 u32_input_data_size,
+                           char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decode the payload of one block into the output window
+ * 
+ * Blocks with a CRC32C are decoded whole into the window, flushing it first when the block
+ * does not fit, and their data is checked against it.
+ * 
+ * @param[in] pstr_header Header of the block
+ * @param[in] pc_payload Payload of the block
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_decode_block(const tstr_block_header *pstr_header, const char *pc_payload, tstr_output_window *pstr_window);
+
+/**
+ * @brief Serialize one block index entry
+ * 
+ * @param[in] pstr_entry Entry to serialize
+ * @param[in out] pc_output_data Buffer to hold the entry (at least CONTAINER_INDEX_ENTRY_SIZE bytes)
+ * @return void
+ */
+void container_write_index_entry(const tstr_block_index_entry *pstr_entry, char *pc_output_data);
+
+/**
+ * @brief Serialize the footer that locates the block index
+ * 
+ * @param[in] u64_index_offset File offset of the first index entry
+ * @param[in] u32_block_count Number of index entries
+ * @param[in out] pc_output_data Buffer to hold the footer (at least CONTAINER_FOOTER_SIZE bytes)
+ * @return void
+ */
+void container_write_footer(const u64 u64_index_offset, const u32 u32_block_count, char *pc_output_data);
+
+/**
+ * @brief Write the END block, the block index and the footer that close a block stream
+ * 
+ * @param[in] pc_index Serialized index entries of the blocks
+ * @param[in] u32_block_count Number of index entries
+ * @param[in] u64_end_offset Stream offset of the END block
+ * @param[in out] pc_output_data Buffer to hold the trailer (at least CONTAINER_TRAILER_SIZE bytes)
+ * @return u64 Size of the trailer
+ */
+u64 container_write_trailer(const char *pc_index, const u32 u32_block_count, const u64 u64_end_offset, char *pc_output_data);
+
+/**
+ * @brief Parse one block index entry
+ * 
+ * @param[in] pc_input_data CONTAINER_INDEX_ENTRY_SIZE bytes of entry
+ * @param[in out] pstr_entry Pointer to hold the parsed entry
+ * @return void
+ */
+void container_read_index_entry(const char *pc_input_data, tstr_block_index_entry *pstr_entry);
+
+/**
+ * @brief Parse and validate the footer that locates the block index
+ * 
+ * @param[in] pc_input_data CONTAINER_FOOTER_SIZE bytes of footer
+ * @param[in] u64_file_size Size of the whole compressed file
+ * @param[in out] pu64_index_offset Pointer to hold the file offset of the first index entry
+ * @param[in out] pu32_block_count Pointer to hold the number of index entries
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_read_footer(const char *pc_input_data, const u64 u64_file_size, u64 *pu64_index_offset, u32 *pu32_block_count);
+
+/**
+ * @brief Load and validate the block index of a seekable .rle2 version 2 file
+ * 
+ * The entries must describe contiguous blocks covering the file from the end of the
+ * file header to the END block, and the original data from offset 0. A file of empty
+ * data has no entries.
+ * 
+ * @param[in] pf_file Compressed file, read with positioned reads
+ * @param[in] u64_file_size Size of the compressed file
+ * @param[in out] ppstr_entries Pointer to hold the heap allocated entries, freed by the caller, NULL without entries
+ * @param[in out] pu32_block_count Pointer to hold the number of entries
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_load_index(FILE *pf_file, const u64 u64_file_size, tstr_block_index_entry **ppstr_entries, u32 *pu32_block_count);
+
+/**
+ * @brief Get the size of the original data covered by a block index
+ * 
+ * @param[in] pstr_entries Validated block index, covering the data from offset 0
+ * @param[in] u32_block_count Number of index entries
+ * @return u64 End of the last block in the original data, 0 without entries
+ */
+u64 container_index_raw_size(const tstr_block_index_entry *pstr_entries, const u32 u32_block_count);
+
+/**
+ * @brief Find the block holding one offset of the original data
+ * 
+ * @param[in] pstr_entries Validated block index, covering the data from offset 0
+ * @param[in] u32_block_count Number of index entries
+ * @param[in] u64_raw_offset Offset in the original data
+ * @return u32 Index of the last block starting at or before the offset, 0 without entries
+ */
+u32 container_find_block(const tstr_block_index_entry *pstr_entries, const u32 u32_block_count, const u64 u64_raw_offset);
+
+/**
+ * @brief Read the header and payload of one indexed block and check them against the index
+ * 
+ * @param[in] pf_file Compressed file, read with positioned reads
+ * @param[in] pstr_entry Index entry of the block
+ * @param[in out] pc_output_data Buffer to hold the block, header included (at least CONTAINER_BLOCK_BOUND bytes)
+ * @param[in out] pstr_header Pointer to hold the parsed header, the payload follows it in pc_output_data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_read_indexed_block(FILE *pf_file, const tstr_block_index_entry *pstr_entry, char *pc_output_data, tstr_block_header *pstr_header);
+
+/**
+ * @brief Initialize a sequential block reader
+ * 
+ * @param[in out] pstr_reader Reader to initialize
+ * @return void
+ */
+void container_reader_init(tstr_block_reader *pstr_reader);
+
+/**
+ * @brief Return a reader to its initial state, its block buffer is kept for the next stream
+ * 
+ * @param[in out] pstr_reader Reader to reset
+ * @return void
+ */
+void container_reader_reset(tstr_block_reader *pstr_reader);
+
+/**
+ * @brief Feed one chunk of the block section to the reader, decoding every completed block
+ * 
+ * @param[in out] pstr_reader Reader state carried across chunks
+ * @param[in] pc_input_data Input data, starting right after the file header on the first call
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_reader_update(tstr_block_reader *pstr_reader, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window);
+
+/**
+ * @brief Check that the END block was reached and flush the output
+ * 
+ * @param[in out] pstr_reader Reader state carried across chunks
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_reader_finish(tstr_block_reader *pstr_reader, tstr_output_window *pstr_window);
+
+/**
+ * @brief Release the reader memory
+ * 
+ * @param[in out] pstr_reader Reader to release
+ * @return void
+ */
+void container_reader_free(tstr_block_reader *pstr_reader);
+
+#endif // CONTAINER_H
\ No newline at end of file
@@ -2,7 +2,48 @@
 #define DECOMPRESS_H
 
 #include "utils.h"
+#include "buffer.h"
+#include "thread_pool.h"
+#include "container.h"
+#include "stats.h"
 
-s32 decompress(const char *input_file_name);
+// Blocks decoded by one pool thread, the thread takes every u32_block_stride-th block of the index
+typedef struct {
+    tstr_pool_task str_task;                       // Pool task node of the job
+    const tstr_block_index_entry *pstr_entries;    // Block index shared by all jobs
+    u32 u32_block_count;
+    u32 u32_first_block;
+    u32 u32_block_stride;
+    FILE *pf_in_file;                              // Read with positioned reads when not mapped
+    const char *pc_in_map;                         // Mapped compressed file, NULL when not mapped
+    FILE *pf_out_file;                             // Written with positioned writes, pre-sized
+    tstr_byte_buffer str_coded;                    // Block header and payload of the current block, not mapped only
+    tstr_output_window str_window;                 // Decoded block, never flushed
+    s32 s32_ret_val;                               // First error of the job
+    u64 u64_busy_ns;                               // Time the job took, reads and writes included
+    u64 u64_raw_size;                              // Decoded bytes written by the job
+    u32 u32_slot;                                  // Pool slot of the thread that ran the job
+} tstr_block_decode_job;
+
+s32 decompress(const char *input_file_name, const tstr_codec_options *pstr_options, tstr_thread_pool *pstr_pool, tstr_codec_stats *pstr_stats);
+
+/**
+ * @brief Decompress one byte range of a compressed file
+ * 
+ * Seekable .rle2 block files are cut into blocks that start at known offsets of the
+ * original data, only the blocks covering the range are read and decoded. Files without
+ * block index (text .rle, version 1 .rle2 streams) are decoded from their start up to the
+ * end of the range.
+ * 
+ * @param[in] input_file_name Path to the compressed file
+ * @param[in] s64_offset First byte of the range, negative to count back from the end (block files and sized streams only)
+ * @param[in] u64_length Length of the range, cut at the end of the data
+ * @param[in] pf_output_file File to write the range to, NULL to append it to pstr_output_buffer
+ * @param[in out] pstr_output_buffer Buffer to append the range to when there is no output file
+ * @param[in out] pu64_range_size Pointer to hold the size of the range written, NULL if not needed
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 decompress_range(const char *input_file_name, const s64 s64_offset, const u64 u64_length, FILE *pf_output_file, tstr_byte_buffer *pstr_output_buffer,
+                     u64 *pu64_range_size);
 
 #endif // DECOMPRESS_H
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include "utils.h"
+#include "buffer.h"
+
+// Entropy coded runs (--level 2): the runs of a block are coded with two canonical Huffman codes,
+// one for the run bytes and one for the run lengths. Payload layout:
+//   run count[4] | byte code lengths[128] | length code lengths[16] | bit stream
+// Code lengths are stored as nibbles, low nibble first, 0 for unused symbols. Every run is
+// <byte code><length code><extra bits>, bits are packed LSB first.
+// Length codes 0..15 stand for runs of 1 to 16 bytes, code HUFFMAN_LENGTH_CODE_BIAS + b (12 + b)
+// stands for the lengths 1 + v where v has its highest bit at position b (b = 4..19), the b bits
+// below follow.
+#define HUFFMAN_MAX_CODE_LENGTH       (12u)
+#define HUFFMAN_TABLE_SIZE            (1u << HUFFMAN_MAX_CODE_LENGTH)
+#define HUFFMAN_BYTE_SYMBOL_COUNT     (256u)
+#define HUFFMAN_LENGTH_SYMBOL_COUNT   (32u)
+#define HUFFMAN_DIRECT_LENGTH_BITS    (4u)
+#define HUFFMAN_DIRECT_LENGTH_COUNT   (1u << HUFFMAN_DIRECT_LENGTH_BITS)
+// Longer lengths start at bit HUFFMAN_DIRECT_LENGTH_BITS, their codes follow the direct ones
+#define HUFFMAN_LENGTH_CODE_BIAS      (HUFFMAN_DIRECT_LENGTH_COUNT - HUFFMAN_DIRECT_LENGTH_BITS)
+#define HUFFMAN_HEADER_SIZE           (4u + (HUFFMAN_BYTE_SYMBOL_COUNT / 2u) + (HUFFMAN_LENGTH_SYMBOL_COUNT / 2u))
+
+// Entry of the run decoding table, one lookup of HUFFMAN_MAX_CODE_LENGTH bits gives the run
+// byte and, when both codes fit in the lookup and the length needs no extra bits, its length
+typedef struct {
+    u8 u8_symbol;                 // Run byte
+    u8 u8_bit_count;              // Bits used by the entry, 0 for bit patterns no code starts with
+    u8 u8_run_len;                // Run length decoded along with the byte, 0 when the length code follows
+    u8 u8_reserved;
+} tstr_huffman_run_entry;
+
+// Entry of the length decoding table
+typedef struct {
+    u8 u8_symbol;                 // Length code
+    u8 u8_bit_count;              // Bits of the code, 0 for bit patterns no code starts with
+} tstr_huffman_length_entry;
+
+/**
+ * @brief Code the runs of a block with per-block canonical Huffman codes
+ * 
+ * The exact coded size is known before anything is written, the block is only coded when
+ * it comes out smaller than the raw data.
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u64_input_data_size Size of the raw data (at most 1 MiB)
+ * @param[in out] pc_output_data Buffer to hold the payload (at least u64_input_data_size bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the payload, the raw size when coding did not pay off
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 huffman_compress_runs(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decode a block of Huffman coded runs
+ * 
+ * @param[in] pc_input_data Payload of the block
+ * @param[in] u64_input_data_size Size of the payload
+ * @param[in] u64_raw_size Size of the block once decoded, the runs may not add up to more
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 huffman_decompress_runs(const char *pc_input_data, const u64 u64_input_data_size, const u64 u64_raw_size, tstr_output_window *pstr_window);
+
+#endif // HUFFMAN_H
\ No newline at end of file
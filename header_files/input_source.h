@@ -0,0 +1,87 @@
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "async_io.h"
+
+// Distance the kernel is asked to read ahead of the consumed part of a mapped file
+#define INPUT_SOURCE_READAHEAD_BYTES    (4u * 1024u * 1024u)
+
+// Reads kept in flight ahead of the consumer for unmapped regular files, and their size
+#define INPUT_SOURCE_READ_DEPTH         (4u)
+#define INPUT_SOURCE_CHUNK_SIZE_BYTES   (256u * 1024u)
+
+// Read-only view of an input file. Regular files are memory mapped and handed out
+// without copies, or read ahead through an async I/O queue. Pipes and other files
+// are read through a buffered window.
+typedef struct {
+    FILE *pf_file;
+    const char *pc_map;             // Mapped file, NULL in buffered mode
+    u64 u64_map_size;
+    u64 u64_advised_offset;         // End of the range already advised with MADV_WILLNEED
+    u64 u64_offset;                 // Number of bytes consumed so far
+    tstr_byte_buffer str_window;    // Buffered mode: unconsumed bytes read from the file
+    u64 u64_window_offset;          // Buffered mode: first unconsumed byte of the window
+    bool b_end_of_file;             // Buffered mode: the file was read to its end
+    bool b_read_ahead;              // Buffered mode: regular file read through str_io
+    tstr_async_io str_io;
+    u64 u64_file_size;
+    u64 u64_read_offset;                                        // File offset of the next read to queue
+    u32 u32_next_chunk;                                         // Chunk holding the next bytes in file order
+    tstr_byte_buffer astr_chunks[INPUT_SOURCE_READ_DEPTH];
+    u64 au64_chunk_offset[INPUT_SOURCE_READ_DEPTH];
+    u64 au64_chunk_size[INPUT_SOURCE_READ_DEPTH];               // Bytes requested, 0 when the chunk is idle
+    u64 au64_chunk_filled[INPUT_SOURCE_READ_DEPTH];             // Bytes read so far
+} tstr_input_source;
+
+/**
+ * @brief Attach an input source to an open file
+ * 
+ * @param[in out] pstr_source Source to initialize
+ * @param[in] pf_file File to read, must stay open until the source is closed
+ * @param[in] enu_backend IO_BACKEND_AUTO maps regular files, IO_BACKEND_URING reads them ahead, IO_BACKEND_SYNC reads on demand
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 input_source_open(tstr_input_source *pstr_source, FILE *pf_file, const tenu_io_backend enu_backend);
+
+/**
+ * @brief Get a contiguous view of the next unconsumed bytes
+ * 
+ * The view holds u64_min_size bytes, or every remaining byte when fewer are left.
+ * It stays valid until the next call to input_source_view or input_source_close.
+ * 
+ * @param[in out] pstr_source Input source
+ * @param[in] u64_min_size Number of bytes wanted
+ * @param[in out] ppc_data Pointer to hold the start of the view
+ * @param[in out] pu64_size Pointer to hold the size of the view, 0 at end of file
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 input_source_view(tstr_input_source *pstr_source, const u64 u64_min_size, const char **ppc_data, u64 *pu64_size);
+
+/**
+ * @brief Mark the first bytes of the last view as consumed
+ * 
+ * @param[in out] pstr_source Input source
+ * @param[in] u64_size Number of bytes consumed, at most the size of the last view
+ * @return void
+ */
+void input_source_consume(tstr_input_source *pstr_source, const u64 u64_size);
+
+/**
+ * @brief Check whether a source is memory mapped
+ * 
+ * @param[in] pstr_source Input source
+ * @return true if the file is mapped, false in buffered mode
+ */
+bool input_source_is_mapped(const tstr_input_source *pstr_source);
+
+/**
+ * @brief Unmap the file and release the window, the file itself stays open
+ * 
+ * @param[in out] pstr_source Input source
+ * @return void
+ */
+void input_source_close(tstr_input_source *pstr_source);
+
+#endif // INPUT_SOURCE_H
\ No newline at end of file
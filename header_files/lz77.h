@@ -0,0 +1,60 @@
+#ifndef LZ77_H
+#define LZ77_H
+
+#include "utils.h"
+
+// LZ77 block coding (-f lz77), a block is a list of sequences:
+//   token[1] | extra literal length | literals | offset[2] | extra match length
+// The token holds the literal length in its high nibble and the match length minus
+// LZ77_MIN_MATCH in its low nibble, 15 in a nibble means a varint follows with the rest.
+// Offsets are little-endian, 1 to LZ77_MAX_OFFSET bytes back into the block, they may be
+// shorter than the match (overlapping copy, runs are matches at offset 1).
+// The last sequence of a block has literals only, it ends with the payload.
+#define LZ77_MIN_MATCH                (4u)
+#define LZ77_MAX_OFFSET               (65535u)
+#define LZ77_NIBBLE_MAX               (15u)
+#define LZ77_HASH_LOG                 (16u)
+#define LZ77_HASH_SIZE                (1u << LZ77_HASH_LOG)
+#define LZ77_CHAIN_SIZE               (LZ77_MAX_OFFSET + 1u)
+
+// Candidates compared per position, --level 1 to 9 selects 1 << (level - 1)
+#define LZ77_DEFAULT_SEARCH_DEPTH     (8u)
+#define LZ77_MAX_SEARCH_DEPTH         (256u)
+
+// Bytes the decoder may write past the end of a sequence, output buffers must reserve them
+#define LZ77_COPY_SLACK_BYTES         (16u)
+
+// Worst case size of the sequences of a block of raw data
+#define LZ77_COMPRESS_BOUND(size)     ((size) + ((size) / 255u) + 16u)
+
+/**
+ * @brief Compress a whole block into LZ77 sequences
+ * 
+ * Matches are found through a hash table of the last position of every 4-byte prefix,
+ * chained to the previous positions with the same hash within LZ77_MAX_OFFSET bytes.
+ * The tables are kept per thread, so only the first block of a thread allocates.
+ * 
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in] u32_search_depth Chain candidates compared per position, 0 for LZ77_DEFAULT_SEARCH_DEPTH
+ * @param[in out] pc_output_data Buffer to hold the sequences (at least LZ77_COMPRESS_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 lz77_compress(const char *pc_input_data, const u64 u64_input_data_size, const u32 u32_search_depth, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decompress a whole block of LZ77 sequences into a flat buffer
+ * 
+ * Literals and matches are copied 16 bytes at a time, the buffer must have
+ * LZ77_COPY_SLACK_BYTES writable bytes past u64_raw_size.
+ * 
+ * @param[in] pc_input_data Input sequences, the block must end on a sequence boundary
+ * @param[in] u64_input_data_size Size of the input sequences
+ * @param[in out] pc_output_data Buffer to hold the block
+ * @param[in] u64_raw_size Size of the block once decoded, the sequences must add up to it exactly
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 lz77_decompress(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, const u64 u64_raw_size);
+
+#endif // LZ77_H
\ No newline at end of file
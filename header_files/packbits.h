@@ -0,0 +1,42 @@
+#ifndef PACKBITS_H
+#define PACKBITS_H
+
+#include "utils.h"
+#include "buffer.h"
+
+// PackBits style block payload: a control byte followed by its data
+//   0x00..0x7F  literal segment of control + 1 bytes, copied as they are
+//   0x80..0xFE  run of control - 0x80 + PACKBITS_RUN_MIN_SIZE copies of the next byte
+//   0xFF        run of the next byte, its length follows as a LEB128 varint
+// Runs shorter than PACKBITS_RUN_MIN_SIZE stay in the literal segments.
+#define PACKBITS_LITERAL_MAX_SIZE      (128u)
+#define PACKBITS_RUN_MIN_SIZE          (3u)
+#define PACKBITS_SHORT_RUN_MAX_SIZE    (0xFEu - 0x80u + PACKBITS_RUN_MIN_SIZE)
+#define PACKBITS_CONTROL_RUN           (0x80u)
+#define PACKBITS_CONTROL_LONG_RUN      (0xFFu)
+
+// Worst case encoded size: one control byte per full literal segment
+#define PACKBITS_COMPRESS_BOUND(size)  ((size) + (((size) + PACKBITS_LITERAL_MAX_SIZE - 1u) / PACKBITS_LITERAL_MAX_SIZE))
+
+/**
+ * @brief Compress a whole block into literal segments and run tokens
+ * 
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the tokens (at least PACKBITS_COMPRESS_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 packbits_compress(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decompress a whole block of literal segments and run tokens
+ * 
+ * @param[in] pc_input_data Input tokens, the block must end on a token boundary
+ * @param[in] u64_input_data_size Size of the input tokens
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 packbits_decompress(const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window);
+
+#endif // PACKBITS_H
\ No newline at end of file
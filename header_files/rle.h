@@ -0,0 +1,94 @@
+#ifndef RLE_H
+#define RLE_H
+
+#include "utils.h"
+#include "buffer.h"
+
+// Text RLE format: <char><decimal count> tokens, digits, backslashes and new lines are escaped
+
+// Worst case encoded size of one input window: every byte is an escaped single-byte run ("\\51"),
+// plus one carried-over run from the previous window with a full 20-digit count
+#define RLE_COMPRESS_WINDOW_BOUND(size)    ((3u * (size)) + 22u)
+
+// Run state carried across window boundaries by the streaming RLE encoder
+typedef struct {
+    char c_run_char;     // Character of the pending run
+    u64  u64_run_len;    // Length of the pending run, 0 when no run is pending
+} tstr_rle_encoder;
+
+// Parser state of the streaming RLE decoder
+typedef enum {
+    RLE_DECODER_STATE_SYMBOL,  // Expecting a run character
+    RLE_DECODER_STATE_ESCAPE,  // Got a backslash, expecting the escaped character
+    RLE_DECODER_STATE_COUNT    // Got the run character, collecting count digits
+} tenu_rle_decoder_state;
+
+// Token state carried across read boundaries by the streaming RLE decoder
+typedef struct {
+    tenu_rle_decoder_state enu_state;
+    char c_run_char;           // Character of the run being parsed
+    u64  u64_run_len;          // Count parsed so far for the current run
+    u8   u8_count_digits;      // Number of count digits parsed so far
+    u64  u64_written_len;      // Part of the current run already written by a live flush
+} tstr_rle_decoder;
+
+/**
+ * @brief Compress one window of data using Run-Length Encoding (RLE)
+ * 
+ * The run that is still open at the end of the window is kept in the encoder state,
+ * so a run crossing a window boundary is encoded exactly as in a single pass.
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the compressed output data (at least RLE_COMPRESS_WINDOW_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_compress(tstr_rle_encoder *pstr_encoder, const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Emit the run still pending in the encoder state at the end of the input
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in out] pc_output_data Buffer to hold the compressed output data (at least 22 bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_compress_flush(tstr_rle_encoder *pstr_encoder, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decompress one chunk of Run-Length Encoded (RLE) data
+ * 
+ * Escape sequences and count digits may straddle chunk boundaries, the partial
+ * token is kept in the decoder state until the next chunk completes it.
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in] pc_input_data Input data to be decompressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_decompress(tstr_rle_decoder *pstr_decoder, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window);
+
+/**
+ * @brief Complete the token still pending in the decoder state at the end of the input
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_decompress_flush(tstr_rle_decoder *pstr_decoder, tstr_output_window *pstr_window);
+
+/**
+ * @brief Write the part of the pending run that is known already, for live streams
+ * 
+ * More count digits can only make the run longer, the rest is written when they arrive.
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_decompress_drain(tstr_rle_decoder *pstr_decoder, tstr_output_window *pstr_window);
+
+#endif // RLE_H
\ No newline at end of file
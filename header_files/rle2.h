@@ -0,0 +1,117 @@
+#ifndef RLE2_H
+#define RLE2_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "rle.h"
+
+// Binary RLE container: a fixed header followed by <byte><LEB128 count> tokens (version 1)
+// or by independently coded blocks and a block index (version 2, see container.h)
+#define RLE2_MAGIC                  "RLE2"
+#define RLE2_MAGIC_SIZE             (4u)
+#define RLE2_VERSION_STREAM         (1u)
+#define RLE2_VERSION_BLOCKS         (2u)
+#define RLE2_VERSION                (RLE2_VERSION_BLOCKS)
+#define RLE2_HEADER_SIZE            (16u)
+#define RLE2_VARINT_MAX_SIZE        (10u)
+
+// Header flags
+#define RLE2_FLAG_SIZE_UNKNOWN      (0x01u)   // Original size field is not filled in
+
+// Worst case encoded size of one input window: every byte is a single-byte run,
+// plus one carried-over run from the previous window with a full-width count
+#define RLE2_COMPRESS_WINDOW_BOUND(size)    ((2u * (size)) + 1u + RLE2_VARINT_MAX_SIZE)
+
+// Header of an .rle2 file, stored little-endian as magic[4] version[1] flags[1] codec[1] reserved[1] size[8]
+typedef struct {
+    u8  u8_version;
+    u8  u8_flags;
+    u64 u64_original_size;
+    u8  u8_codec;               // ID of the codec selected by the compressor (0, rle2, in files written before it was recorded)
+} tstr_rle2_header;
+
+// Parser state of the streaming RLE2 decoder
+typedef enum {
+    RLE2_DECODER_STATE_SYMBOL,  // Expecting a run byte
+    RLE2_DECODER_STATE_COUNT    // Got the run byte, collecting varint count bytes
+} tenu_rle2_decoder_state;
+
+// Token state carried across read boundaries by the streaming RLE2 decoder
+typedef struct {
+    tenu_rle2_decoder_state enu_state;
+    char c_run_char;            // Byte of the run being parsed
+    u64  u64_run_len;           // Count bits parsed so far
+    u8   u8_count_shift;        // Bit position of the next varint group
+} tstr_rle2_decoder;
+
+/**
+ * @brief Serialize an RLE2 header
+ * 
+ * @param[in] pstr_header Header to serialize
+ * @param[in out] pc_output_data Buffer to hold the header (at least RLE2_HEADER_SIZE bytes)
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_write_header(const tstr_rle2_header *pstr_header, char *pc_output_data);
+
+/**
+ * @brief Parse and validate an RLE2 header
+ * 
+ * @param[in] pc_input_data Data starting with the header
+ * @param[in] u64_input_data_size Size of the data
+ * @param[in out] pstr_header Pointer to hold the parsed header
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_read_header(const char *pc_input_data, const u64 u64_input_data_size, tstr_rle2_header *pstr_header);
+
+/**
+ * @brief Check whether the data starts with the RLE2 magic number
+ * 
+ * @param[in] pc_input_data Data to check
+ * @param[in] u64_input_data_size Size of the data
+ * @return true if the magic number matches, false otherwise
+ */
+bool rle2_has_magic(const char *pc_input_data, const u64 u64_input_data_size);
+
+/**
+ * @brief Compress one window of data into RLE2 tokens
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the tokens (at least RLE2_COMPRESS_WINDOW_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_compress(tstr_rle_encoder *pstr_encoder, const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Emit the run still pending in the encoder state at the end of the input
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in out] pc_output_data Buffer to hold the token (at least 1 + RLE2_VARINT_MAX_SIZE bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_compress_flush(tstr_rle_encoder *pstr_encoder, char *pc_output_data, u64 *pu64_output_data_size);
+
+/**
+ * @brief Decompress one chunk of RLE2 tokens, tokens may straddle chunk boundaries
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in] pc_input_data Input tokens
+ * @param[in] u64_input_data_size Size of the input tokens
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_decompress(tstr_rle2_decoder *pstr_decoder, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window);
+
+/**
+ * @brief Check that no token is left incomplete at the end of the input and flush the output
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_decompress_flush(tstr_rle2_decoder *pstr_decoder, tstr_output_window *pstr_window);
+
+#endif // RLE2_H
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef RUN_KERNELS_H
+#define RUN_KERNELS_H
+
+#include "utils.h"
+
+// Bytes that run_expand() may write past the end of the run, output buffers must reserve them
+#define RUN_EXPAND_SLACK_BYTES    (32u)
+
+/**
+ * @brief Select the fastest run kernels supported by the CPU (cpuid), called once at startup
+ * 
+ * Calling it is optional, the kernels resolve themselves on first use otherwise. Threads
+ * calling it at the same time wait for one selection.
+ * 
+ * @return void
+ */
+void run_kernels_init(void);
+
+/**
+ * @brief Count how many bytes at the start of the data are equal to the run character
+ * 
+ * Never reads past pc_data[u64_data_size - 1].
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data (0 to u64_data_size)
+ */
+u64 run_scan_length(const char *pc_data, const u64 u64_data_size, const char c_run_char);
+
+/**
+ * @brief Fill the output with a run of the same character using wide stores
+ * 
+ * Runs up to RUN_EXPAND_SLACK_BYTES long are written with one fixed-width broadcast store
+ * that may touch up to RUN_EXPAND_SLACK_BYTES bytes past the end of the run, longer runs
+ * go to memset.
+ * 
+ * @param[in out] pc_output_data Output buffer with at least RUN_EXPAND_SLACK_BYTES bytes of slack
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @return void
+ */
+void run_expand(char *pc_output_data, const char c_run_char, const u64 u64_run_len);
+
+#endif // RUN_KERNELS_H
\ No newline at end of file
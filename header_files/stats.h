@@ -0,0 +1,117 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+#include "utils.h"
+#include "buffer.h"
+#include "thread_pool.h"
+
+// Phases of one file, timed with the monotonic clock
+typedef enum {
+    STATS_PHASE_OPEN,        // Checking the input, creating the output path, opening the files and the I/O queues
+    STATS_PHASE_READ,        // Reading or mapping input windows and the block index
+    STATS_PHASE_CODE,        // Encoding or decoding, wall time of the block batches with -j
+    STATS_PHASE_WRITE,       // Held up by output writes and flushes
+    STATS_PHASE_CLOSE,       // Rewriting the .rle2 header and closing the files
+    STATS_PHASE_COUNT
+} tenu_stats_phase;
+
+// Work of one pool slot, slot 0 is the calling thread
+typedef struct {
+    u64 u64_busy_ns;         // Time spent coding
+    u64 u64_raw_size;        // Uncompressed bytes coded
+} tstr_thread_stats;
+
+// Statistics of one compressed or decompressed file, filled by compress() and decompress()
+typedef struct {
+    u64 u64_start_ns;
+    u64 u64_total_ns;
+    u64 au64_phase_ns[STATS_PHASE_COUNT];
+    u64 u64_input_size;
+    u64 u64_output_size;
+    tstr_buffer_stats str_buffers;                           // Byte buffers of the file, pool tasks it submits included
+    tstr_buffer_stats *pstr_outer_buffers;                   // Record the thread counted into before the file, attached again at the end
+    u32 u32_thread_count;                                    // Slots used in astr_threads
+    tstr_thread_stats astr_threads[THREAD_POOL_MAX_THREADS];
+} tstr_codec_stats;
+
+/**
+ * @brief Clear the statistics and start the clock, byte buffers of the calling thread and its pool tasks are counted from now on
+ * 
+ * @param[in out] pstr_stats Statistics to start, NULL to record nothing
+ * @return void
+ */
+void stats_begin(tstr_codec_stats *pstr_stats);
+
+/**
+ * @brief Add the time since a mark to a phase
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] enu_phase Phase the time went to
+ * @param[in] u64_mark_ns Start of the phase
+ * @return u64 Current time, the mark of the next phase, 0 when pstr_stats is NULL
+ */
+u64 stats_phase_end(tstr_codec_stats *pstr_stats, const tenu_stats_phase enu_phase, const u64 u64_mark_ns);
+
+/**
+ * @brief Read the clock for a phase mark
+ * 
+ * @param[in] pstr_stats Statistics, NULL to record nothing
+ * @return u64 Current time, 0 when pstr_stats is NULL
+ */
+u64 stats_mark(const tstr_codec_stats *pstr_stats);
+
+/**
+ * @brief Move time measured elsewhere into a phase, taking it from another one
+ * 
+ * Decoders write through their output window while decoding, the time the writer spent
+ * is moved from the code phase to the write phase.
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] enu_from Phase the time was counted in
+ * @param[in] enu_to Phase the time belongs to
+ * @param[in] u64_time_ns Time to move
+ * @return void
+ */
+void stats_phase_move(tstr_codec_stats *pstr_stats, const tenu_stats_phase enu_from, const tenu_stats_phase enu_to, const u64 u64_time_ns);
+
+/**
+ * @brief Add coding work done by one pool slot
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] u32_slot Pool slot of the thread, see thread_pool_current_slot()
+ * @param[in] u64_raw_size Uncompressed bytes coded
+ * @param[in] u64_busy_ns Time spent coding them
+ * @return void
+ */
+void stats_thread_add(tstr_codec_stats *pstr_stats, const u32 u32_slot, const u64 u64_raw_size, const u64 u64_busy_ns);
+
+/**
+ * @brief Stop the clock and the buffer counting
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] u64_input_size Bytes read from the input
+ * @param[in] u64_output_size Bytes written to the output
+ * @return void
+ */
+void stats_end(tstr_codec_stats *pstr_stats, const u64 u64_input_size, const u64 u64_output_size);
+
+/**
+ * @brief Print the statistics of one file as a single line
+ * 
+ * The line is written with one call, so lines of files finishing together do not mix.
+ * The ratio is the raw size over the compressed size, whatever the operation.
+ * 
+ * @param[in out] pf_output Stream to print to
+ * @param[in] enu_output STATS_OUTPUT_TEXT for a readable line, STATS_OUTPUT_JSON for a JSON object
+ * @param[in] pc_operation "compress", "decompress" or "test"
+ * @param[in] pc_file_name Input file of the operation
+ * @param[in] s32_status Status of the operation
+ * @param[in] pstr_stats Statistics to print
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 stats_report(FILE *pf_output, const tenu_stats_output enu_output, const char *pc_operation, const char *pc_file_name, const s32 s32_status,
+                 const tstr_codec_stats *pstr_stats);
+
+#endif // STATS_H
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+
+#include "utils.h"
+#include "buffer.h"
+
+// Upper bound for the -j option
+#define THREAD_POOL_MAX_THREADS    (256u)
+
+// Function run by a pool task
+typedef void (*tpf_pool_task_fn)(void *pv_arg);
+
+// Set of tasks a caller can wait on
+typedef struct {
+    u32 u32_pending_count;     // Tasks submitted and not finished yet, updated atomically
+} tstr_task_group;
+
+// Task node, embedded in the caller's job so submitting never allocates
+typedef struct tstr_pool_task {
+    tpf_pool_task_fn pf_task_fn;
+    void *pv_arg;
+    tstr_task_group *pstr_group;
+    tstr_buffer_stats *pstr_buffer_stats;          // Buffer record of the submitting thread, the task counts into it
+    struct tstr_pool_task *pstr_prev;
+    struct tstr_pool_task *pstr_next;
+} tstr_pool_task;
+
+// Task deque of one pool thread: the owner pushes and pops at the tail, thieves take from the head
+typedef struct {
+    pthread_mutex_t str_mutex;
+    tstr_pool_task *pstr_head;
+    tstr_pool_task *pstr_tail;
+} tstr_pool_deque;
+
+struct tstr_thread_pool;
+
+// Worker thread and the deque slot it owns
+typedef struct {
+    pthread_t str_thread;
+    struct tstr_thread_pool *pstr_pool;
+    u32 u32_slot;
+} tstr_pool_worker;
+
+// Fixed-size work-stealing pool, one deque per thread. Slot 0 belongs to the threads
+// outside the pool, slots 1 to N - 1 to the workers.
+typedef struct tstr_thread_pool {
+    pthread_mutex_t str_mutex;         // Only guards sleeping and waking up
+    pthread_cond_t  str_task_cond;     // Signaled when a task is queued or the pool stops
+    pthread_cond_t  str_done_cond;     // Signaled when a group finishes
+    tstr_pool_deque *pstr_deques;
+    tstr_pool_worker *pstr_workers;
+    u32  u32_slot_count;
+    u32  u32_worker_count;
+    u32  u32_queued_count;             // Tasks sitting in any deque, updated atomically
+    u32  u32_idle_count;               // Workers sleeping on str_task_cond, updated atomically
+    u32  u32_waiter_count;             // Waiters sleeping on str_done_cond, updated atomically
+    bool b_stopping;
+} tstr_thread_pool;
+
+/**
+ * @brief Start a thread pool
+ * 
+ * The thread that waits on a task group also runs the tasks it queued, so a pool for
+ * N-way parallelism only starts N - 1 worker threads.
+ * 
+ * @param[in out] pstr_pool Pool to start
+ * @param[in] u32_thread_count Total number of threads working on tasks, including the waiting caller
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 thread_pool_create(tstr_thread_pool *pstr_pool, const u32 u32_thread_count);
+
+/**
+ * @brief Queue a task on the deque of the calling thread
+ * 
+ * Tasks may submit and wait on their own sub-tasks, idle workers steal them.
+ * 
+ * @param[in out] pstr_pool Pool to run the task on
+ * @param[in out] pstr_task Task node, must stay valid until the task has run
+ * @param[in] pf_task_fn Function to run
+ * @param[in] pv_arg Argument passed to the function
+ * @param[in out] pstr_group Group the task belongs to
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 thread_pool_submit(tstr_thread_pool *pstr_pool, tstr_pool_task *pstr_task, tpf_pool_task_fn pf_task_fn, void *pv_arg, tstr_task_group *pstr_group);
+
+/**
+ * @brief Wait until all tasks of a group have finished, running the group tasks still queued by the caller meanwhile
+ * 
+ * The caller never runs tasks of other groups while waiting, so nested waits cannot pile up
+ * unrelated work on its stack. Group tasks taken by thieves are waited for.
+ * 
+ * @param[in out] pstr_pool Pool the tasks were submitted to
+ * @param[in out] pstr_group Group to wait for
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 thread_pool_wait(tstr_thread_pool *pstr_pool, tstr_task_group *pstr_group);
+
+/**
+ * @brief Get the slot of the calling thread in the pool it works for, to attribute work to threads
+ * 
+ * @return u32 Slot of the worker, 0 for threads outside any pool
+ */
+u32 thread_pool_current_slot(void);
+
+/**
+ * @brief Stop the worker threads and release the pool resources
+ * 
+ * @param[in out] pstr_pool Pool to destroy, queued tasks must have been waited for
+ * @return void
+ */
+void thread_pool_destroy(tstr_thread_pool *pstr_pool);
+
+#endif // THREAD_POOL_H
\ No newline at end of file
@@ -24,14 +24,61 @@ typedef enum {
     OP_NONE,
     OP_COMPRESS,
     OP_DECOMPRESS,
+    OP_ARCHIVE,        // Archive a directory into one .rlea file
+    OP_LIST,           // List the members of an archive
+    OP_EXTRACT,        // Extract members of an archive
+    OP_LIST_CODECS,    // Print the codec registry
     OP_HELP
 } tenu_operation;
 
-// Struct to hold parsed arguments
+// Enum for compressed file format
+typedef enum {
+    FILE_FORMAT_RLE,     // Text RLE, <char><decimal count> with escapes
+    FILE_FORMAT_RLE2     // Binary RLE, header + <byte><varint count>
+} tenu_file_format;
+
+// Enum for the coding of .rle2 blocks, values are the codec IDs of the registry (codec_registry.h)
+typedef enum {
+    BLOCK_CODEC_RLE2     = 0x00,    // <byte><varint count> tokens
+    BLOCK_CODEC_STORED   = 0x01,    // Raw data
+    BLOCK_CODEC_PACKBITS = 0x02,    // Literal segments and runs of three or more, PackBits style
+    BLOCK_CODEC_HUFFMAN  = 0x03,    // Runs entropy coded with per-block canonical Huffman codes (--level 2)
+    BLOCK_CODEC_LZ77     = 0x04     // Literals and matches found through hash chains
+} tenu_block_codec;
+
+// Enum for the file I/O backend
+typedef enum {
+    IO_BACKEND_AUTO,     // Mapped input when possible, io_uring writes with a pwrite fallback
+    IO_BACKEND_URING,    // io_uring reads and writes with a pread/pwrite fallback, no mapping
+    IO_BACKEND_SYNC      // Buffered reads and plain pwrite, nothing in flight
+} tenu_io_backend;
+
+// Enum for the output flush policy of stdin/stdout streams
+typedef enum {
+    FLUSH_POLICY_NONE,       // Output is written when the windows fill up
+    FLUSH_POLICY_LINE,       // Output is flushed as soon as a new line arrives
+    FLUSH_POLICY_INTERVAL    // Output is flushed at most u32_flush_ms after its input arrived
+} tenu_flush_policy;
+
+// Enum for the per-file statistics report
+typedef enum {
+    STATS_OUTPUT_NONE,       // No report
+    STATS_OUTPUT_TEXT,       // One readable line per file on stderr
+    STATS_OUTPUT_JSON        // One JSON object per line per file on stderr, for log collectors
+} tenu_stats_output;
+
+// Options shared by the compression and decompression paths
 typedef struct {
-    tenu_operation enu_operation;
-    const char *pc_input_file;
-} tstr_input_args;
+    tenu_file_format enu_format;     // Format of the compressed file
+    tenu_block_codec enu_block_codec;     // Coding of the blocks of .rle2 files
+    u32 u32_search_depth;                 // LZ77 match candidates per position (--level), 0 for the codec default
+    u32 u32_thread_count;            // Threads coding blocks (-j), .rle2 only
+    tenu_io_backend enu_io_backend;  // File I/O backend (--io)
+    tenu_flush_policy enu_flush_policy;   // Flush policy of "-" streams (--flush)
+    u32 u32_flush_ms;                     // Flush interval, FLUSH_POLICY_INTERVAL only
+    tenu_stats_output enu_stats_output;   // Per-file statistics report (--stats)
+    bool b_test_only;                     // Decode and check the blocks without writing any output (-t)
+} tstr_codec_options;
 
 // Log level enum, including NONE
 typedef enum {
@@ -41,25 +88,88 @@ typedef enum {
     LOG_LEVEL_DEBUG       // Debug, info, and errors
 } tenu_log_level;
 
+// Struct to hold parsed arguments
+typedef struct {
+    tenu_operation enu_operation;
+    const char **ppc_input_files;    // Input files given on the command line, points into argv
+    u32 u32_input_count;
+    const char *pc_file_list;        // File listing more input files, one per line, "-" for stdin (--files-from)
+    tstr_codec_options str_options;
+    tenu_log_level enu_log_level;    // Runtime log level (--log), cannot bring back levels stripped at compile time
+    bool b_log_async;                // Log through the ring buffer drained by a background thread (--log-async)
+    bool b_range;                    // Decompress one byte range to stdout (-x)
+    s64 s64_range_offset;            // First byte of the range, negative to count back from the end
+    u64 u64_range_length;            // Length of the range, UINT64_MAX for the rest of the data
+} tstr_input_args;
+
+// Set the global log level here, messages above it compile to nothing, arguments included:
+// -DLOG_LEVEL=0 no logs, 1 errors, 2 info and errors, 3 debug, info and errors
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 2
+#endif
+
+// Number of messages the asynchronous log ring holds, a power of two
+#define LOG_RING_SLOT_COUNT      (1024u)
+// Longest message kept by the asynchronous log ring, longer ones are cut
+#define LOG_RING_MESSAGE_SIZE    (512u)
+
+// Message slot of the asynchronous log ring
+typedef struct {
+    u64 u64_sequence;                          // Ring position the slot can be filled or read at, published last
+    tenu_log_level enu_level;
+    char ac_message[LOG_RING_MESSAGE_SIZE];
+} tstr_log_slot;
+
+// Runtime log level, messages above it are skipped before their arguments are evaluated, accessed atomically
+extern tenu_log_level genu_log_level;
+
 // Logging macros
-#define LOG(fm, ...)       log_message(LOG_LEVEL_DEBUG, fm, ##__VA_ARGS__)
-#define LOG_INFO(fm, ...)  log_message(LOG_LEVEL_INFO,  fm, ##__VA_ARGS__)
-#define LOG_ERROR(fm, ...) log_message(LOG_LEVEL_ERROR, fm, ##__VA_ARGS__)
+#define LOG_AT(enu_level, fm, ...)                                                        \
+    do                                                                                    \
+    {                                                                                     \
+        if ((enu_level) <= __atomic_load_n(&genu_log_level, __ATOMIC_RELAXED))            \
+        {                                                                                 \
+            log_message(enu_level, fm, ##__VA_ARGS__);                                    \
+        }                                                                                 \
+    } while (0)
 
-// Error break macro
+// Stripped messages keep their format checked but never run
+#define LOG_STRIPPED(fm, ...)                                                             \
+    do                                                                                    \
+    {                                                                                     \
+        if (0)                                                                            \
+        {                                                                                 \
+            log_message(LOG_LEVEL_NONE, fm, ##__VA_ARGS__);                               \
+        }                                                                                 \
+    } while (0)
+
+#if LOG_LEVEL >= 3
+#define LOG(fm, ...)       LOG_AT(LOG_LEVEL_DEBUG, fm, ##__VA_ARGS__)
+#else
+#define LOG(fm, ...)       LOG_STRIPPED(fm, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= 2
+#define LOG_INFO(fm, ...)  LOG_AT(LOG_LEVEL_INFO, fm, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fm, ...)  LOG_STRIPPED(fm, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= 1
+#define LOG_ERROR(fm, ...) LOG_AT(LOG_LEVEL_ERROR, fm, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fm, ...) LOG_STRIPPED(fm, ##__VA_ARGS__)
+#endif
+
+// Error break macro, logged as an error so it follows the log level, stripping and sink
 #define ERROR_BREAK(value)                                                                \
     if (SUCCESS_STATUS != value)                                                          \
     {                                                                                     \
-        fprintf(stderr, "Error: %d, at File: %s, Line: %d\n", value, __FILE__, __LINE__); \
+        LOG_ERROR("Error: %d, at File: %s, Line: %d", value, __FILE__, __LINE__);         \
         break;                                                                            \
     }
 \
 
-// Set the global log level here
-#ifndef LOG_LEVEL
-#define LOG_LEVEL LOG_LEVEL_INFO
-#endif
-
 // Function prototypes
 
 /**
@@ -72,13 +182,53 @@ typedef enum {
  */
 void log_message(tenu_log_level enu_log_level, const char *pc_formatted_msg, ...);
 
+/**
+ * @brief Select the stream debug and info messages go to, errors always go to stderr
+ * 
+ * @param[in] pf_output Stream for debug and info messages (stdout by default)
+ * @return void
+ */
+void log_set_output(FILE *pf_output);
+
+/**
+ * @brief Select the runtime log level, levels stripped at compile time stay off
+ * 
+ * @param[in] enu_log_level Most verbose level to print
+ * @return void
+ */
+void log_set_level(const tenu_log_level enu_log_level);
+
+/**
+ * @brief Get the runtime log level
+ * 
+ * @return tenu_log_level Most verbose level printed
+ */
+tenu_log_level log_get_level(void);
+
+/**
+ * @brief Send messages through a lock-free ring drained by a background thread
+ * 
+ * Logging threads format their message into a ring slot and return, they never wait for the
+ * output stream. Messages are dropped and counted when the ring is full.
+ * 
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 log_async_start(void);
+
+/**
+ * @brief Print the messages left in the ring, stop the background thread and log synchronously again
+ * 
+ * @return void
+ */
+void log_async_stop(void);
+
 /**
  * @brief Open a file with the specified mode
  * 
  * @param[in] pc_ile_name file name to open
  * @param[in] mode  mode to open the file in (e.g., "r", "w", "rb", "wb")
  * @param[in out] ppf_input_file pointer to the opened file pointer
- * @return s32 SUCCESS_STATUS on success, error code otherwise
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
  */
 s32 open_file(const char *pc_ile_name, const char *mode, FILE **ppf_input_file);
 
@@ -91,7 +241,7 @@ s32 open_file(const char *pc_ile_name, const char *mode, FILE **ppf_input_file);
 s32 close_file(FILE **pp_file);
 
 /**
- * @brief 
+ * @brief Read the whole content of a file into a heap buffer
  * 
  * @param[in] p_file Pointer to the file to read from
  * @param[in out] ppc_read_data_buff Pointer to the buffer that will hold the read data
@@ -100,6 +250,32 @@ s32 close_file(FILE **pp_file);
  */
 s32 read_file(FILE *p_file, char **ppc_read_data_buff, u64 *pu64_read_data_size);
 
+/**
+ * @brief Read up to one window of data from a file into a caller-owned buffer
+ * 
+ * @param[in] p_file Pointer to the file to read from
+ * @param[in out] pc_window_buff Buffer that will hold the read data
+ * @param[in] u64_window_size Capacity of the window buffer
+ * @param[in out] pu64_read_data_size Pointer to the variable that will hold the number of bytes read (0 at end of file)
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 read_file_window(FILE *p_file, char *pc_window_buff, const u64 u64_window_size, u64 *pu64_read_data_size);
+
+/**
+ * @brief Read the data already available on a file, waiting at most s32_timeout_ms for some to arrive
+ * 
+ * Reads the file descriptor directly, the file must not be read through stdio as well.
+ * 
+ * @param[in] p_file Pointer to the file to read from
+ * @param[in out] pc_read_buff Buffer that will hold the read data
+ * @param[in] u64_read_size Capacity of the buffer
+ * @param[in] s32_timeout_ms Longest wait for data, negative to wait until data or the end of file arrives
+ * @param[in out] pu64_read_data_size Pointer to hold the number of bytes read (0 on timeout or at end of file)
+ * @param[in out] pb_end_of_file Pointer to hold whether the end of file was reached
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 read_file_available(FILE *p_file, char *pc_read_buff, const u64 u64_read_size, const s32 s32_timeout_ms, u64 *pu64_read_data_size, bool *pb_end_of_file);
+
 /**
  * @brief 
  * 
@@ -110,11 +286,51 @@ s32 read_file(FILE *p_file, char **ppc_read_data_buff, u64 *pu64_read_data_size)
  */
 s32 write_file(FILE *p_file, const char *pc_write_buffer, const u64 u64_write_size);
 
+/**
+ * @brief Read exactly u64_read_size bytes at a file offset, without moving the file position
+ * 
+ * @param[in] p_file Pointer to the file to read from
+ * @param[in out] pc_read_buff Buffer that will hold the read data
+ * @param[in] u64_read_size Number of bytes to read
+ * @param[in] u64_offset File offset to read from
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 read_file_at(FILE *p_file, char *pc_read_buff, const u64 u64_read_size, const u64 u64_offset);
+
+/**
+ * @brief Write a buffer at a file offset, without moving the file position
+ * 
+ * @param[in] p_file Pointer to the file to write to
+ * @param[in] pc_write_buffer Pointer to the buffer containing data to write
+ * @param[in] u64_write_size Size of the data to write
+ * @param[in] u64_offset File offset to write at
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 write_file_at(FILE *p_file, const char *pc_write_buffer, const u64 u64_write_size, const u64 u64_offset);
+
+/**
+ * @brief Set the size of a file, extending it with zeros or truncating it
+ * 
+ * @param[in] p_file Pointer to the file to resize
+ * @param[in] u64_file_size New size of the file
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 resize_file(FILE *p_file, const u64 u64_file_size);
+
+/**
+ * @brief Check whether a file is a regular file and get its size
+ * 
+ * @param[in] p_file Pointer to the file to check
+ * @param[in out] pu64_file_size Pointer to hold the file size, set only for regular files
+ * @return true if the file is a regular file, false otherwise (pipe, terminal, error)
+ */
+bool is_regular_file(FILE *p_file, u64 *pu64_file_size);
+
 /**
  * @brief Check the existence of a file
  * 
  * @param[in] pc_file_name Path to the file to check its existence
- * @return true if file exists, false otherwise
+ * @return true if file exists, false otherwise 
  */
 bool check_file_exists(const char *pc_file_name);
 
@@ -122,7 +338,7 @@ bool check_file_exists(const char *pc_file_name);
  * @brief  Delete the specified file
  * 
  * @param[in] pc_file_name Path to the file to delete
- * @return true if file exists, false otherwise
+ * @return true if file exists, false otherwise 
  */
 s32 delete_file(const char *pc_file_name);
 
@@ -172,6 +388,20 @@ s32 create_output_file(const char *pc_input_file_path, char *pc_output_file_exte
  */
 void free_allocated_memory(void *pv_data);
 
+/**
+ * @brief Get the time of a monotonic clock in milliseconds
+ * 
+ * @return u64 Milliseconds since an arbitrary fixed point
+ */
+u64 get_monotonic_time_ms(void);
+
+/**
+ * @brief Get the time of a monotonic clock in nanoseconds
+ * 
+ * @return u64 Nanoseconds since an arbitrary fixed point
+ */
+u64 get_monotonic_time_ns(void);
+
 /**
  * @brief Print the program usage instructions
  * 
@@ -190,4 +420,12 @@ void print_prog_usage(const char *pc_prog_name);
  */
 void parse_input_args(int argc, const char *argv[], tstr_input_args *pstr_args) ;
 
+/**
+ * @brief Release the memory held by parsed arguments
+ * 
+ * @param[in out] pstr_args Parsed arguments
+ * @return void
+ */
+void free_input_args(tstr_input_args *pstr_args);
+
 #endif // UTILS_H
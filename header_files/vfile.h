@@ -0,0 +1,109 @@
+#ifndef VFILE_H
+#define VFILE_H
+
+#include "utils.h"
+#include "container.h"
+
+// Default budget of the decoded block cache shared by every open virtual file
+#define VFILE_CACHE_DEFAULT_CAPACITY_BYTES    (64u * 1024u * 1024u)
+
+// Buckets of the cache hash table, a power of two
+#define VFILE_CACHE_BUCKET_COUNT              (4096u)
+
+// Identity of a compressed file in the shared cache, its blocks are reused only while the size and mtime match
+typedef struct {
+    u64 u64_device;
+    u64 u64_inode;
+    u64 u64_file_size;
+    u64 u64_mtime_ns;
+} tstr_vfile_key;
+
+// Read-only view of a seekable .rle2 file as its original data, safe to read from several threads
+typedef struct {
+    FILE *pf_file;                             // Compressed file, read with positioned reads
+    tstr_block_index_entry *pstr_entries;      // Block index loaded at open
+    u32 u32_block_count;
+    tstr_vfile_key str_key;                    // Key of the file blocks in the shared cache, shared by every open of the file
+    u64 u64_size;                              // Size of the original data
+} tstr_vfile;
+
+// Counters of the shared block cache
+typedef struct {
+    u64 u64_hits;               // Block lookups served from the cache
+    u64 u64_misses;             // Block lookups that decoded the block
+    u64 u64_evictions;          // Blocks dropped to stay within the capacity
+    u64 u64_cached_bytes;       // Memory held by the cached blocks
+    u64 u64_capacity_bytes;
+    u32 u32_cached_blocks;
+} tstr_vfile_cache_stats;
+
+/**
+ * @brief Open a seekable .rle2 block file for random-access reads of its original data
+ * 
+ * Only the file header and the block index are read, blocks are decoded on demand by
+ * vfile_pread() and kept in the block cache shared by all open files. Opens of the same
+ * file share its cached blocks, also after a close, as long as the file keeps its size and mtime.
+ * 
+ * @param[in out] pstr_file Virtual file to open
+ * @param[in] pc_path Path to the compressed file
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 vfile_open(tstr_vfile *pstr_file, const char *pc_path);
+
+/**
+ * @brief Read bytes of the original data at an offset, like pread()
+ * 
+ * Reads stop at the end of the data, so fewer bytes than requested are read only there.
+ * Any number of threads may read the same file at the same time.
+ * 
+ * @param[in] pstr_file Open virtual file
+ * @param[in out] pc_buffer Buffer to hold the data (at least u64_size bytes)
+ * @param[in] u64_size Number of bytes to read
+ * @param[in] u64_offset Offset of the first byte in the original data
+ * @param[in out] pu64_read_size Pointer to hold the number of bytes read, 0 at or past the end
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 vfile_pread(const tstr_vfile *pstr_file, char *pc_buffer, const u64 u64_size, const u64 u64_offset, u64 *pu64_read_size);
+
+/**
+ * @brief Get the size of the original data of an open virtual file
+ * 
+ * @param[in] pstr_file Open virtual file
+ * @return u64 Size of the original data
+ */
+u64 vfile_size(const tstr_vfile *pstr_file);
+
+/**
+ * @brief Close a virtual file
+ * 
+ * Its blocks stay in the shared cache for the next open of the file until the LRU evicts them.
+ * 
+ * @param[in out] pstr_file Virtual file to close, no read may be running on it
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 vfile_close(tstr_vfile *pstr_file);
+
+/**
+ * @brief Set the memory budget of the shared block cache, evicting blocks down to it
+ * 
+ * @param[in] u64_capacity_bytes Budget in bytes, 0 to disable caching
+ * @return void
+ */
+void vfile_cache_set_capacity(const u64 u64_capacity_bytes);
+
+/**
+ * @brief Get a snapshot of the shared block cache counters
+ * 
+ * @param[in out] pstr_stats Pointer to hold the counters
+ * @return void
+ */
+void vfile_cache_get_stats(tstr_vfile_cache_stats *pstr_stats);
+
+/**
+ * @brief Reset the hit, miss and eviction counters of the shared block cache
+ * 
+ * @return void
+ */
+void vfile_cache_reset_stats(void);
+
+#endif // VFILE_H
\ No newline at end of file
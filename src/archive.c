@@ -0,0 +1,1347 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <stdint.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/archive.h"
+#include "../header_files/container.h"
+#include "../header_files/checksum.h"
+#include "../header_files/async_io.h"
+
+
+/**
+ * @brief Store an unsigned value as little-endian bytes
+ *
+ * @param[in out] pc_output_data Buffer to hold the bytes
+ * @param[in] u64_value Value to store
+ * @param[in] u8_bytes_count Number of bytes to store
+ * @return void
+ */
+static void archive_put_le(char *pc_output_data, const u64 u64_value, const u8 u8_bytes_count)
+{
+    for (u8 i = 0; i < u8_bytes_count; i++)
+    {
+        pc_output_data[i] = (char)(u64_value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Load an unsigned value from little-endian bytes
+ *
+ * @param[in] pc_input_data Buffer holding the bytes
+ * @param[in] u8_bytes_count Number of bytes to load
+ * @return u64 Loaded value
+ */
+static u64 u64_archive_get_le(const char *pc_input_data, const u8 u8_bytes_count)
+{
+    u64 u64_value = 0;
+
+    for (u8 i = 0; i < u8_bytes_count; i++)
+    {
+        u64_value |= ((u64)(u8)pc_input_data[i]) << (8 * i);
+    }
+
+    return u64_value;
+}
+
+/**
+ * @brief Join two path parts with a '/' into a heap allocated string
+ *
+ * @param[in] pc_left First part
+ * @param[in] pc_right Second part
+ * @param[in out] ppc_path Pointer to hold the joined path, freed by the caller
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+static s32 s32_archive_join_path(const char *pc_left, const char *pc_right, char **ppc_path)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+    size_t sz_path_size = strlen(pc_left) + strlen(pc_right) + 2;
+
+    *ppc_path = (char *)malloc(sz_path_size);
+
+    if (NULL == *ppc_path)
+    {
+        LOG_ERROR("Error allocating memory for a path: %s", strerror(errno));
+        s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+    else
+    {
+        snprintf(*ppc_path, sz_path_size, "%s/%s", pc_left, pc_right);
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Collect the regular files under a directory, recursively
+ *
+ * Symbolic links and special files are skipped.
+ *
+ * @param[in] pc_root_path Directory being archived
+ * @param[in] pc_relative_path Directory to walk, relative to the root, NULL for the root itself
+ * @param[in out] pstr_names Buffer to hold the relative file paths, each one NUL terminated
+ * @param[in out] pu32_name_count Pointer to the number of paths collected so far
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+static s32 s32_archive_walk(const char *pc_root_path, const char *pc_relative_path, tstr_byte_buffer *pstr_names, u32 *pu32_name_count)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+    char *pc_dir_path = NULL;
+    DIR *pstr_dir = NULL;
+    struct dirent *pstr_entry = NULL;
+
+    do
+    {
+        if (NULL == pc_relative_path)
+        {
+            pstr_dir = opendir(pc_root_path);
+        }
+        else
+        {
+            s32_ret_val = s32_archive_join_path(pc_root_path, pc_relative_path, &pc_dir_path);
+            ERROR_BREAK(s32_ret_val);
+
+            pstr_dir = opendir(pc_dir_path);
+        }
+
+        if (NULL == pstr_dir)
+        {
+            LOG_ERROR("Error opening directory %s: %s", (NULL == pc_dir_path) ? pc_root_path : pc_dir_path, strerror(errno));
+            s32_ret_val = ERROR_FILE_NOT_OPENED;
+            break;
+        }
+
+        while ((SUCCESS_STATUS == s32_ret_val) && (NULL != (pstr_entry = readdir(pstr_dir))))
+        {
+            char *pc_child_relative = NULL;
+            char *pc_child_path = NULL;
+            struct stat str_stat;
+
+            if ((0 == strcmp(pstr_entry->d_name, ".")) || (0 == strcmp(pstr_entry->d_name, "..")))
+            {
+                continue;
+            }
+
+            if (NULL == pc_relative_path)
+            {
+                pc_child_relative = strdup(pstr_entry->d_name);
+                s32_ret_val = (NULL == pc_child_relative) ? ERROR_MEMORY_ALLOCATION_FAILED : SUCCESS_STATUS;
+            }
+            else
+            {
+                s32_ret_val = s32_archive_join_path(pc_relative_path, pstr_entry->d_name, &pc_child_relative);
+            }
+
+            if (SUCCESS_STATUS == s32_ret_val)
+            {
+                s32_ret_val = s32_archive_join_path(pc_root_path, pc_child_relative, &pc_child_path);
+            }
+
+            if (SUCCESS_STATUS == s32_ret_val)
+            {
+                if (0 != lstat(pc_child_path, &str_stat))
+                {
+                    LOG_ERROR("Error reading the status of %s: %s", pc_child_path, strerror(errno));
+                    s32_ret_val = ERROR_FILE_NOT_FOUND;
+                }
+                else if (S_ISDIR(str_stat.st_mode))
+                {
+                    s32_ret_val = s32_archive_walk(pc_root_path, pc_child_relative, pstr_names, pu32_name_count);
+                }
+                else if (!S_ISREG(str_stat.st_mode))
+                {
+                    LOG("Skipping %s, not a regular file.", pc_child_path);
+                }
+                else if (strlen(pc_child_relative) > ARCHIVE_NAME_MAX_SIZE)
+                {
+                    LOG_ERROR("Path is too long to be archived: %s", pc_child_relative);
+                    s32_ret_val = ERROR_INVALID_LENGTH;
+                }
+                else
+                {
+                    s32_ret_val = byte_buffer_append(pstr_names, pc_child_relative, strlen(pc_child_relative) + 1);
+                    (*pu32_name_count)++;
+                }
+            }
+
+            free_allocated_memory(pc_child_relative);
+            free_allocated_memory(pc_child_path);
+        }
+
+    } while (0);
+
+    if (NULL != pstr_dir)
+    {
+        closedir(pstr_dir);
+    }
+
+    free_allocated_memory(pc_dir_path);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Order members by name, qsort() callback
+ *
+ * @param[in] pv_left First member
+ * @param[in] pv_right Second member
+ * @return int Negative, zero or positive like strcmp()
+ */
+static int archive_compare_members(const void *pv_left, const void *pv_right)
+{
+    return strcmp(((const tstr_archive_member *)pv_left)->pc_name, ((const tstr_archive_member *)pv_right)->pc_name);
+}
+
+/**
+ * @brief Compress one block of an archive member, run on the thread pool
+ *
+ * @param[in out] pv_job Block job (tstr_archive_block_job)
+ * @return void
+ */
+static void archive_block_job_compress(void *pv_job)
+{
+    tstr_archive_block_job *pstr_job = (tstr_archive_block_job *)pv_job;
+
+    if (0 == pstr_job->u32_raw_size)
+    {
+        pstr_job->str_coded.u64_size = 0;
+        pstr_job->s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        pstr_job->s32_ret_val = container_encode_block(pstr_job->enu_codec, pstr_job->u32_search_depth, pstr_job->pc_raw, pstr_job->u32_raw_size, pstr_job->str_coded.pc_data, &pstr_job->str_coded.u64_size);
+    }
+}
+
+/**
+ * @brief Gather archive output, a write is queued every ARCHIVE_WRITE_CHUNK_BYTES
+ *
+ * @param[in out] pstr_writer Writer of the archive
+ * @param[in out] pstr_pending Output gathered and not written yet
+ * @param[in] pc_data Data to add
+ * @param[in] u64_data_size Size of the data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+static s32 s32_archive_output(tstr_async_writer *pstr_writer, tstr_byte_buffer *pstr_pending, const char *pc_data, const u64 u64_data_size)
+{
+    s32 s32_ret_val = byte_buffer_append(pstr_pending, pc_data, u64_data_size);
+
+    if ((SUCCESS_STATUS == s32_ret_val) && (pstr_pending->u64_size >= ARCHIVE_WRITE_CHUNK_BYTES))
+    {
+        s32_ret_val = async_writer_write(pstr_writer, pstr_pending);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Release an archive source
+ *
+ * @param[in out] pstr_source Source to close
+ * @return void
+ */
+static void archive_source_close(tstr_archive_source *pstr_source)
+{
+    input_source_close(&pstr_source->str_source);
+
+    if (NULL != pstr_source->pf_file)
+    {
+        close_file(&pstr_source->pf_file);
+    }
+}
+
+/**
+ * @brief Code the members of an archive batch after batch and write their data
+ *
+ * @param[in] pc_dir_path Directory being archived
+ * @param[in out] pstr_directory Members to archive, offsets, sizes and checksums are filled in
+ * @param[in] pstr_options Thread count, I/O backend and block coding
+ * @param[in out] pstr_writer Writer of the archive
+ * @param[in out] pstr_pending Output gathered and not written yet
+ * @param[in out] pu64_archive_offset Pointer to the archive offset of the next byte written
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+static s32 s32_archive_write_members(const char *pc_dir_path, tstr_archive_directory *pstr_directory, const tstr_codec_options *pstr_options,
+                                     tstr_async_writer *pstr_writer, tstr_byte_buffer *pstr_pending, u64 *pu64_archive_offset)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+    const u32 u32_thread_count = pstr_options->u32_thread_count;
+
+    tstr_thread_pool str_pool;
+    bool b_pool_started = false;
+    tstr_archive_block_job *pstr_jobs = NULL;
+    tstr_archive_source *pstr_sources = NULL;     // Members with blocks in the current batch, at most one per job
+    u32 u32_open_count = 0;
+    u32 u32_next_member = 0;
+    bool *pb_member_started = NULL;
+
+    do
+    {
+        pstr_jobs = (tstr_archive_block_job *)calloc(u32_thread_count, sizeof(tstr_archive_block_job));
+        pstr_sources = (tstr_archive_source *)calloc(u32_thread_count, sizeof(tstr_archive_source));
+        pb_member_started = (bool *)calloc(pstr_directory->u32_member_count, sizeof(bool));
+
+        if (NULL == pstr_jobs || NULL == pstr_sources || NULL == pb_member_started)
+        {
+            LOG_ERROR("Error allocating memory for archive jobs: %s", strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_thread_count); i++)
+        {
+            pstr_jobs[i].enu_codec = pstr_options->enu_block_codec;
+            pstr_jobs[i].u32_search_depth = pstr_options->u32_search_depth;
+            s32_ret_val = byte_buffer_reserve(&pstr_jobs[i].str_coded, CONTAINER_BLOCK_BOUND(CONTAINER_BLOCK_SIZE_BYTES));
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = thread_pool_create(&str_pool, u32_thread_count);
+        ERROR_BREAK(s32_ret_val);
+
+        b_pool_started = true;
+
+        while ((u32_next_member < pstr_directory->u32_member_count) || (0 != u32_open_count))
+        {
+            tstr_task_group str_group = {0};
+            u32 u32_jobs_count = 0;
+
+            // Fill the batch with the blocks of the unfinished member, then of the next members
+            while ((SUCCESS_STATUS == s32_ret_val) && (u32_jobs_count < u32_thread_count))
+            {
+                tstr_archive_source *pstr_source = NULL;
+                u32 u32_member = 0;
+                const char *pc_span = NULL;
+                u64 u64_span_size = 0;
+                u64 u64_block_start = 0;
+                u64 u64_span_capacity = (u64)(u32_thread_count - u32_jobs_count) * CONTAINER_BLOCK_SIZE_BYTES;
+                bool b_end_of_file = false;
+
+                if ((0 != u32_open_count) && (false == pstr_sources[u32_open_count - 1].b_end_of_file))
+                {
+                    pstr_source = &pstr_sources[u32_open_count - 1];
+                }
+                else if (u32_next_member < pstr_directory->u32_member_count)
+                {
+                    char *pc_member_path = NULL;
+
+                    pstr_source = &pstr_sources[u32_open_count];
+                    memset(pstr_source, 0, sizeof(*pstr_source));
+                    u32_open_count++;
+
+                    s32_ret_val = s32_archive_join_path(pc_dir_path, pstr_directory->pstr_members[u32_next_member].pc_name, &pc_member_path);
+
+                    if (SUCCESS_STATUS == s32_ret_val)
+                    {
+                        s32_ret_val = open_file(pc_member_path, "rb", &pstr_source->pf_file);
+                    }
+
+                    if (SUCCESS_STATUS == s32_ret_val)
+                    {
+                        s32_ret_val = input_source_open(&pstr_source->str_source, pstr_source->pf_file, pstr_options->enu_io_backend);
+                    }
+
+                    free_allocated_memory(pc_member_path);
+                    ERROR_BREAK(s32_ret_val);
+
+                    u32_next_member++;
+                }
+                else
+                {
+                    break;
+                }
+
+                u32_member = (u32)(u32_next_member - 1);
+
+                s32_ret_val = input_source_view(&pstr_source->str_source, u64_span_capacity, &pc_span, &u64_span_size);
+                ERROR_BREAK(s32_ret_val);
+
+                b_end_of_file = (u64_span_size < u64_span_capacity);
+
+                do
+                {
+                    tstr_archive_block_job *pstr_job = &pstr_jobs[u32_jobs_count];
+                    u64 u64_block_end = (u64_span_size == 0) ? 0 : container_cut_block(pc_span, u64_block_start, u64_span_size, b_end_of_file);
+
+                    pstr_job->u32_member = u32_member;
+                    pstr_job->pc_raw = &pc_span[u64_block_start];
+                    pstr_job->u32_raw_size = (u32)(u64_block_end - u64_block_start);
+                    pstr_job->b_member_end = b_end_of_file && (u64_block_end == u64_span_size);
+
+                    s32_ret_val = thread_pool_submit(&str_pool, &pstr_job->str_task, archive_block_job_compress, pstr_job, &str_group);
+                    ERROR_BREAK(s32_ret_val);
+
+                    u64_block_start = u64_block_end;
+                    u32_jobs_count++;
+
+                } while ((u32_jobs_count < u32_thread_count) && (u64_block_start < u64_span_size));
+
+                pstr_source->u64_used_size = u64_block_start;
+                pstr_source->b_end_of_file = b_end_of_file && (u64_block_start == u64_span_size);
+            }
+
+            // Always wait, submitted jobs reference the job buffers and the member views
+            thread_pool_wait(&str_pool, &str_group);
+            ERROR_BREAK(s32_ret_val);
+
+            // Write the coded blocks in member order
+            for (u32 i = 0; i < u32_jobs_count; i++)
+            {
+                tstr_archive_block_job *pstr_job = &pstr_jobs[i];
+                tstr_archive_member *pstr_member = &pstr_directory->pstr_members[pstr_job->u32_member];
+
+                s32_ret_val = pstr_job->s32_ret_val;
+                ERROR_BREAK(s32_ret_val);
+
+                if (false == pb_member_started[pstr_job->u32_member])
+                {
+                    pb_member_started[pstr_job->u32_member] = true;
+                    pstr_member->u64_data_offset = *pu64_archive_offset;
+                    pstr_member->u32_crc32c = CRC32C_INITIAL_VALUE;
+                }
+
+                if (0 != pstr_job->u32_raw_size)
+                {
+                    s32_ret_val = s32_archive_output(pstr_writer, pstr_pending, pstr_job->str_coded.pc_data, pstr_job->str_coded.u64_size);
+                    ERROR_BREAK(s32_ret_val);
+
+                    pstr_member->u64_data_size += pstr_job->str_coded.u64_size;
+                    pstr_member->u64_raw_size += pstr_job->u32_raw_size;
+                    pstr_member->u32_crc32c = crc32c_update(pstr_member->u32_crc32c, pstr_job->pc_raw, pstr_job->u32_raw_size);
+                    *pu64_archive_offset += pstr_job->str_coded.u64_size;
+                }
+
+                if (true == pstr_job->b_member_end)
+                {
+                    tstr_block_header str_end_header = {BLOCK_TYPE_END, 0, 0, 0};
+                    char ac_end_header[CONTAINER_BLOCK_HEADER_SIZE];
+
+                    container_write_block_header(&str_end_header, ac_end_header);
+
+                    s32_ret_val = s32_archive_output(pstr_writer, pstr_pending, ac_end_header, CONTAINER_BLOCK_HEADER_SIZE);
+                    ERROR_BREAK(s32_ret_val);
+
+                    pstr_member->u64_data_size += CONTAINER_BLOCK_HEADER_SIZE;
+                    *pu64_archive_offset += CONTAINER_BLOCK_HEADER_SIZE;
+                }
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            // Finished members are closed, the unfinished one (always the last) moves to the front
+            for (u32 i = 0; i < u32_open_count; i++)
+            {
+                if (true == pstr_sources[i].b_end_of_file)
+                {
+                    archive_source_close(&pstr_sources[i]);
+                }
+                else
+                {
+                    input_source_consume(&pstr_sources[i].str_source, pstr_sources[i].u64_used_size);
+                    pstr_sources[0] = pstr_sources[i];
+                }
+            }
+
+            u32_open_count = (false == pstr_sources[u32_open_count - 1].b_end_of_file) ? 1 : 0;
+        }
+
+    } while (0);
+
+    if (true == b_pool_started)
+    {
+        thread_pool_destroy(&str_pool);
+    }
+
+    if (NULL != pstr_sources)
+    {
+        for (u32 i = 0; i < u32_open_count; i++)
+        {
+            archive_source_close(&pstr_sources[i]);
+        }
+
+        free_allocated_memory(pstr_sources);
+    }
+
+    if (NULL != pstr_jobs)
+    {
+        for (u32 i = 0; i < u32_thread_count; i++)
+        {
+            byte_buffer_free(&pstr_jobs[i].str_coded);
+        }
+
+        free_allocated_memory(pstr_jobs);
+    }
+
+    free_allocated_memory(pb_member_started);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Load and validate the central directory of an archive
+ *
+ * @param[in] pf_archive Archive file, read with positioned reads
+ * @param[in] u64_archive_size Size of the archive file
+ * @param[in out] pstr_directory Directory to fill, released with archive_free_directory()
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+s32 archive_load_directory(FILE *pf_archive, const u64 u64_archive_size, tstr_archive_directory *pstr_directory)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pf_archive || NULL == pstr_directory)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        char ac_header[ARCHIVE_HEADER_SIZE];
+        char ac_footer[ARCHIVE_FOOTER_SIZE];
+        char *pc_entries = NULL;
+        u64 u64_directory_offset = 0;
+        u64 u64_directory_size = 0;
+        u64 u64_entry_offset = 0;
+
+        memset(pstr_directory, 0, sizeof(*pstr_directory));
+        byte_buffer_init(&pstr_directory->str_names);
+
+        do
+        {
+            if (u64_archive_size < (ARCHIVE_HEADER_SIZE + ARCHIVE_FOOTER_SIZE))
+            {
+                LOG_ERROR("File is too small to be an archive.");
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            s32_ret_val = read_file_at(pf_archive, ac_header, ARCHIVE_HEADER_SIZE, 0);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = read_file_at(pf_archive, ac_footer, ARCHIVE_FOOTER_SIZE, u64_archive_size - ARCHIVE_FOOTER_SIZE);
+            ERROR_BREAK(s32_ret_val);
+
+            if ((0 != memcmp(ac_header, ARCHIVE_MAGIC, 4)) || (0 != memcmp(&ac_footer[12], ARCHIVE_FOOTER_MAGIC, 4)))
+            {
+                LOG_ERROR("Not an archive, or the archive is truncated.");
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            if (ARCHIVE_VERSION != (u8)ac_header[4])
+            {
+                LOG_ERROR("Unsupported archive version: %u", (u8)ac_header[4]);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            u64_directory_offset = u64_archive_get_le(&ac_footer[0], 8);
+            pstr_directory->u32_member_count = (u32)u64_archive_get_le(&ac_footer[8], 4);
+
+            if ((u64_directory_offset < ARCHIVE_HEADER_SIZE) || (u64_directory_offset > (u64_archive_size - ARCHIVE_FOOTER_SIZE)))
+            {
+                LOG_ERROR("Invalid central directory offset: %lu", u64_directory_offset);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            u64_directory_size = u64_archive_size - ARCHIVE_FOOTER_SIZE - u64_directory_offset;
+
+            if (((u64)pstr_directory->u32_member_count * ARCHIVE_ENTRY_FIXED_SIZE) > u64_directory_size)
+            {
+                LOG_ERROR("Central directory is too small for %u members.", pstr_directory->u32_member_count);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            pc_entries = (char *)malloc(u64_directory_size + 1);
+            pstr_directory->pstr_members = (tstr_archive_member *)calloc((0 == pstr_directory->u32_member_count) ? 1 : pstr_directory->u32_member_count,
+                                                                         sizeof(tstr_archive_member));
+
+            if (NULL == pc_entries || NULL == pstr_directory->pstr_members)
+            {
+                LOG_ERROR("Error allocating memory for the central directory: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            s32_ret_val = read_file_at(pf_archive, pc_entries, u64_directory_size, u64_directory_offset);
+            ERROR_BREAK(s32_ret_val);
+
+            // Names are NUL terminated back to back, offsets are turned into pointers once all are in
+            s32_ret_val = byte_buffer_reserve(&pstr_directory->str_names, u64_directory_size);
+            ERROR_BREAK(s32_ret_val);
+
+            for (u32 i = 0; i < pstr_directory->u32_member_count; i++)
+            {
+                tstr_archive_member *pstr_member = &pstr_directory->pstr_members[i];
+                const char *pc_entry = &pc_entries[u64_entry_offset];
+                u16 u16_name_size = 0;
+
+                if ((u64_entry_offset + ARCHIVE_ENTRY_FIXED_SIZE) > u64_directory_size)
+                {
+                    LOG_ERROR("Central directory entry %u is truncated.", i);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                pstr_member->u64_data_offset = u64_archive_get_le(&pc_entry[0], 8);
+                pstr_member->u64_data_size = u64_archive_get_le(&pc_entry[8], 8);
+                pstr_member->u64_raw_size = u64_archive_get_le(&pc_entry[16], 8);
+                pstr_member->u32_crc32c = (u32)u64_archive_get_le(&pc_entry[24], 4);
+                u16_name_size = (u16)u64_archive_get_le(&pc_entry[28], 2);
+
+                if ((0 == u16_name_size) || (u16_name_size > ARCHIVE_NAME_MAX_SIZE) ||
+                    ((u64_entry_offset + ARCHIVE_ENTRY_FIXED_SIZE + u16_name_size) > u64_directory_size))
+                {
+                    LOG_ERROR("Central directory entry %u has an invalid name size: %u", i, u16_name_size);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                if ((pstr_member->u64_data_offset < ARCHIVE_HEADER_SIZE) || (pstr_member->u64_data_size < CONTAINER_BLOCK_HEADER_SIZE) ||
+                    (pstr_member->u64_data_offset > u64_directory_offset) || (pstr_member->u64_data_size > (u64_directory_offset - pstr_member->u64_data_offset)))
+                {
+                    LOG_ERROR("Central directory entry %u points outside the member data.", i);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                const char *pc_name = &pc_entry[ARCHIVE_ENTRY_FIXED_SIZE];
+
+                // Extraction joins the name to the output directory, it must stay inside it
+                if ((NULL != memchr(pc_name, '\0', u16_name_size)) || ('/' == pc_name[0]) ||
+                    ((u16_name_size >= 2) && (0 == memcmp(pc_name, "..", 2)) && ((2 == u16_name_size) || ('/' == pc_name[2]))))
+                {
+                    LOG_ERROR("Central directory entry %u has an unsafe name.", i);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                for (u16 j = 0; (SUCCESS_STATUS == s32_ret_val) && ((j + 3) < u16_name_size); j++)
+                {
+                    if ((0 == memcmp(&pc_name[j], "/../", 4)) || (((j + 3) == (u16_name_size - 1)) && (0 == memcmp(&pc_name[j + 1], "/..", 3))))
+                    {
+                        LOG_ERROR("Central directory entry %u has an unsafe name.", i);
+                        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    }
+                }
+                ERROR_BREAK(s32_ret_val);
+
+                pstr_member->pc_name = (const char *)(uintptr_t)pstr_directory->str_names.u64_size;
+
+                s32_ret_val = byte_buffer_append(&pstr_directory->str_names, pc_name, u16_name_size);
+
+                if (SUCCESS_STATUS == s32_ret_val)
+                {
+                    s32_ret_val = byte_buffer_append(&pstr_directory->str_names, "", 1);
+                }
+                ERROR_BREAK(s32_ret_val);
+
+                u64_entry_offset += ARCHIVE_ENTRY_FIXED_SIZE + u16_name_size;
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            if (u64_entry_offset != u64_directory_size)
+            {
+                LOG_ERROR("Central directory has %lu trailing bytes.", u64_directory_size - u64_entry_offset);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            for (u32 i = 0; i < pstr_directory->u32_member_count; i++)
+            {
+                pstr_directory->pstr_members[i].pc_name = &pstr_directory->str_names.pc_data[(uintptr_t)pstr_directory->pstr_members[i].pc_name];
+            }
+
+        } while (0);
+
+        free_allocated_memory(pc_entries);
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            archive_free_directory(pstr_directory);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Release a central directory
+ *
+ * @param[in out] pstr_directory Directory to release
+ * @return void
+ */
+void archive_free_directory(tstr_archive_directory *pstr_directory)
+{
+    if (NULL != pstr_directory)
+    {
+        free_allocated_memory(pstr_directory->pstr_members);
+        pstr_directory->pstr_members = NULL;
+        pstr_directory->u32_member_count = 0;
+        byte_buffer_free(&pstr_directory->str_names);
+    }
+}
+
+/**
+ * @brief Archive every regular file under a directory into <directory>.rlea
+ *
+ * Members are cut into blocks that are coded in parallel, batches mix the blocks of
+ * several small files. Members are stored in name order, so the archive does not
+ * depend on the thread count.
+ *
+ * @param[in] pc_dir_path Directory to archive
+ * @param[in] pstr_options Thread count, I/O backend and block coding
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+s32 archive_create(const char *pc_dir_path, const tstr_codec_options *pstr_options)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_dir_path || NULL == pstr_options)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if ((0 == pstr_options->u32_thread_count) || (THREAD_POOL_MAX_THREADS < pstr_options->u32_thread_count))
+    {
+        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+    }
+    else
+    {
+        LOG_INFO("Archiving directory: %s", pc_dir_path);
+
+        char *pc_root_path = strdup(pc_dir_path);
+        char *pc_out_file_path = NULL;
+        FILE *pf_out_file = NULL;
+        tstr_archive_directory str_directory;
+        tstr_async_writer str_writer;
+        bool b_writer_open = false;
+        tstr_byte_buffer str_pending;
+        u64 u64_archive_offset = ARCHIVE_HEADER_SIZE;
+        u64 u64_raw_total_size = 0;
+
+        memset(&str_directory, 0, sizeof(str_directory));
+        byte_buffer_init(&str_directory.str_names);
+        byte_buffer_init(&str_pending);
+
+        do
+        {
+            struct stat str_stat;
+            u64 u64_name_offset = 0;
+
+            if (NULL == pc_root_path)
+            {
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            // "logs/" and "logs" name the same archive
+            for (size_t sz_len = strlen(pc_root_path); (sz_len > 1) && ('/' == pc_root_path[sz_len - 1]); sz_len--)
+            {
+                pc_root_path[sz_len - 1] = '\0';
+            }
+
+            if ((0 != stat(pc_root_path, &str_stat)) || !S_ISDIR(str_stat.st_mode))
+            {
+                LOG_ERROR("Not a directory: %s", pc_root_path);
+                s32_ret_val = ERROR_FILE_NOT_FOUND;
+                break;
+            }
+
+            s32_ret_val = s32_archive_walk(pc_root_path, NULL, &str_directory.str_names, &str_directory.u32_member_count);
+            ERROR_BREAK(s32_ret_val);
+
+            if (0 == str_directory.u32_member_count)
+            {
+                LOG_ERROR("No files to archive in %s", pc_root_path);
+                s32_ret_val = ERROR_EMPTY_FILE;
+                break;
+            }
+
+            str_directory.pstr_members = (tstr_archive_member *)calloc(str_directory.u32_member_count, sizeof(tstr_archive_member));
+
+            if (NULL == str_directory.pstr_members)
+            {
+                LOG_ERROR("Error allocating memory for the central directory: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            for (u32 i = 0; i < str_directory.u32_member_count; i++)
+            {
+                str_directory.pstr_members[i].pc_name = &str_directory.str_names.pc_data[u64_name_offset];
+                u64_name_offset += strlen(str_directory.pstr_members[i].pc_name) + 1;
+            }
+
+            qsort(str_directory.pstr_members, str_directory.u32_member_count, sizeof(tstr_archive_member), archive_compare_members);
+
+            pc_out_file_path = (char *)malloc(strlen(pc_root_path) + sizeof(".rlea"));
+
+            if (NULL == pc_out_file_path)
+            {
+                LOG_ERROR("Error allocating memory for the archive path: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            sprintf(pc_out_file_path, "%s.rlea", pc_root_path);
+
+            if (true == check_file_exists(pc_out_file_path))
+            {
+                LOG_ERROR("Not overwriting existing archive: %s", pc_out_file_path);
+                s32_ret_val = ERROR_FILE_EXISTS;
+                free_allocated_memory(pc_out_file_path);
+                pc_out_file_path = NULL;
+                break;
+            }
+
+            s32_ret_val = open_file(pc_out_file_path, "wb", &pf_out_file);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = async_writer_open(&str_writer, pf_out_file, pstr_options->enu_io_backend);
+            ERROR_BREAK(s32_ret_val);
+
+            b_writer_open = true;
+
+            {
+                char ac_header[ARCHIVE_HEADER_SIZE] = {0};
+
+                memcpy(ac_header, ARCHIVE_MAGIC, 4);
+                ac_header[4] = (char)ARCHIVE_VERSION;
+
+                s32_ret_val = s32_archive_output(&str_writer, &str_pending, ac_header, ARCHIVE_HEADER_SIZE);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            s32_ret_val = s32_archive_write_members(pc_root_path, &str_directory, pstr_options, &str_writer, &str_pending, &u64_archive_offset);
+            ERROR_BREAK(s32_ret_val);
+
+            // Central directory, then the footer pointing back at it
+            for (u32 i = 0; i < str_directory.u32_member_count; i++)
+            {
+                const tstr_archive_member *pstr_member = &str_directory.pstr_members[i];
+                char ac_entry[ARCHIVE_ENTRY_FIXED_SIZE];
+                u16 u16_name_size = (u16)strlen(pstr_member->pc_name);
+
+                archive_put_le(&ac_entry[0], pstr_member->u64_data_offset, 8);
+                archive_put_le(&ac_entry[8], pstr_member->u64_data_size, 8);
+                archive_put_le(&ac_entry[16], pstr_member->u64_raw_size, 8);
+                archive_put_le(&ac_entry[24], pstr_member->u32_crc32c, 4);
+                archive_put_le(&ac_entry[28], u16_name_size, 2);
+
+                s32_ret_val = s32_archive_output(&str_writer, &str_pending, ac_entry, ARCHIVE_ENTRY_FIXED_SIZE);
+
+                if (SUCCESS_STATUS == s32_ret_val)
+                {
+                    s32_ret_val = s32_archive_output(&str_writer, &str_pending, pstr_member->pc_name, u16_name_size);
+                }
+                ERROR_BREAK(s32_ret_val);
+
+                u64_raw_total_size += pstr_member->u64_raw_size;
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            {
+                char ac_footer[ARCHIVE_FOOTER_SIZE];
+
+                archive_put_le(&ac_footer[0], u64_archive_offset, 8);
+                archive_put_le(&ac_footer[8], str_directory.u32_member_count, 4);
+                memcpy(&ac_footer[12], ARCHIVE_FOOTER_MAGIC, 4);
+
+                s32_ret_val = s32_archive_output(&str_writer, &str_pending, ac_footer, ARCHIVE_FOOTER_SIZE);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            s32_ret_val = async_writer_write(&str_writer, &str_pending);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = async_writer_flush(&str_writer);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = close_file(&pf_out_file);
+            ERROR_BREAK(s32_ret_val);
+
+            LOG_INFO("Archived %u files (%lu bytes in) to: %s", str_directory.u32_member_count, u64_raw_total_size, pc_out_file_path);
+
+        } while (0);
+
+        // Writes still in flight after an error are waited for before the file is closed
+        if (true == b_writer_open)
+        {
+            async_writer_free(&str_writer);
+        }
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            LOG_ERROR("Exit archiving loop with error code: %d", s32_ret_val);
+
+            if (NULL != pf_out_file)
+            {
+                close_file(&pf_out_file);
+            }
+
+            if ((NULL != pc_out_file_path) && (true == check_file_exists(pc_out_file_path)))
+            {
+                delete_file(pc_out_file_path);
+            }
+        }
+
+        archive_free_directory(&str_directory);
+        byte_buffer_free(&str_pending);
+        free_allocated_memory(pc_out_file_path);
+        free_allocated_memory(pc_root_path);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Open an archive and load its central directory
+ *
+ * @param[in] pc_archive_path Path to the archive
+ * @param[in out] ppf_archive Pointer to hold the opened archive
+ * @param[in out] pstr_directory Directory to fill
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+static s32 s32_archive_open(const char *pc_archive_path, FILE **ppf_archive, tstr_archive_directory *pstr_directory)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+    u64 u64_archive_size = 0;
+
+    do
+    {
+        s32_ret_val = open_file(pc_archive_path, "rb", ppf_archive);
+        ERROR_BREAK(s32_ret_val);
+
+        if (false == is_regular_file(*ppf_archive, &u64_archive_size))
+        {
+            LOG_ERROR("Archives must be regular files: %s", pc_archive_path);
+            s32_ret_val = ERROR_INVALID_ARGUMENTS;
+            break;
+        }
+
+        s32_ret_val = archive_load_directory(*ppf_archive, u64_archive_size, pstr_directory);
+        ERROR_BREAK(s32_ret_val);
+
+    } while (0);
+
+    if ((SUCCESS_STATUS != s32_ret_val) && (NULL != *ppf_archive))
+    {
+        close_file(ppf_archive);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Print the members of an archive: original size, stored size, CRC32C and name
+ *
+ * @param[in] pc_archive_path Path to the archive
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+s32 archive_list(const char *pc_archive_path)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_archive_path)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        FILE *pf_archive = NULL;
+        tstr_archive_directory str_directory;
+        u64 u64_raw_total_size = 0;
+        u64 u64_data_total_size = 0;
+
+        s32_ret_val = s32_archive_open(pc_archive_path, &pf_archive, &str_directory);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            printf("%14s %14s %8s  %s\n", "Original", "Stored", "CRC32C", "Name");
+
+            for (u32 i = 0; i < str_directory.u32_member_count; i++)
+            {
+                const tstr_archive_member *pstr_member = &str_directory.pstr_members[i];
+
+                printf("%14lu %14lu %08x  %s\n", pstr_member->u64_raw_size, pstr_member->u64_data_size, pstr_member->u32_crc32c, pstr_member->pc_name);
+
+                u64_raw_total_size += pstr_member->u64_raw_size;
+                u64_data_total_size += pstr_member->u64_data_size;
+            }
+
+            printf("%14lu %14lu %8s  %u files\n", u64_raw_total_size, u64_data_total_size, "", str_directory.u32_member_count);
+
+            archive_free_directory(&str_directory);
+            close_file(&pf_archive);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Create the missing parent directories of a path
+ *
+ * @param[in out] pc_path Path of the file, restored before returning
+ * @return s32 SUCCESS_STATUS on success, error code otherwise
+ */
+static s32 s32_archive_make_parents(char *pc_path)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    for (char *pc_slash = strchr(pc_path + 1, '/'); (SUCCESS_STATUS == s32_ret_val) && (NULL != pc_slash); pc_slash = strchr(pc_slash + 1, '/'))
+    {
+        *pc_slash = '\0';
+
+        if ((0 != mkdir(pc_path, 0755)) && (EEXIST != errno))
+        {
+            LOG_ERROR("Error creating directory %s: %s", pc_path, strerror(errno));
+            s32_ret_val = ERROR_FILE_NOT_OPENED;
+        }
+
+        *pc_slash = '/';
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Extract one member: decode its blocks and check its size and CRC32C
+ *
+ * @param[in out] pv_job Extract job (tstr_archive_extract_job)
+ * @return void
+ */
+static void archive_extract_job_run(void *pv_job)
+{
+    tstr_archive_extract_job *pstr_job = (tstr_archive_extract_job *)pv_job;
+    const tstr_archive_member *pstr_member = pstr_job->pstr_member;
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    char *pc_out_file_path = NULL;
+    FILE *pf_out_file = NULL;
+    tstr_byte_buffer str_coded;
+    tstr_output_window str_window = {{NULL, 0, 0}, 0, 0, NULL, NULL, NULL, 0};
+    tstr_async_writer str_writer;
+    bool b_writer_open = false;
+    bool b_created = false;
+    u64 u64_offset = pstr_member->u64_data_offset;
+    const u64 u64_data_end = pstr_member->u64_data_offset + pstr_member->u64_data_size;
+    u32 u32_crc32c = CRC32C_INITIAL_VALUE;
+
+    byte_buffer_init(&str_coded);
+
+    do
+    {
+        s32_ret_val = s32_archive_join_path(pstr_job->pc_out_dir, pstr_member->pc_name, &pc_out_file_path);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = s32_archive_make_parents(pc_out_file_path);
+        ERROR_BREAK(s32_ret_val);
+
+        if (true == check_file_exists(pc_out_file_path))
+        {
+            LOG_ERROR("Not overwriting existing file: %s", pc_out_file_path);
+            s32_ret_val = ERROR_FILE_EXISTS;
+            break;
+        }
+
+        s32_ret_val = open_file(pc_out_file_path, "wb", &pf_out_file);
+        ERROR_BREAK(s32_ret_val);
+
+        b_created = true;
+
+        // Twice the block size, a block never triggers a flush halfway and is checksummed whole
+        s32_ret_val = output_window_reserve(&str_window, 2u * CONTAINER_BLOCK_SIZE_BYTES);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = async_writer_open(&str_writer, pf_out_file, pstr_job->enu_io_backend);
+        ERROR_BREAK(s32_ret_val);
+
+        b_writer_open = true;
+        str_window.pf_file = pf_out_file;
+        str_window.pstr_writer = &str_writer;
+
+        while (1)
+        {
+            tstr_block_header str_header;
+            char ac_header[CONTAINER_BLOCK_HEADER_SIZE];
+
+            if ((u64_data_end - u64_offset) < CONTAINER_BLOCK_HEADER_SIZE)
+            {
+                LOG_ERROR("Member %s ends without an END block.", pstr_member->pc_name);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            s32_ret_val = read_file_at(pstr_job->pf_archive, ac_header, CONTAINER_BLOCK_HEADER_SIZE, u64_offset);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = container_read_block_header(ac_header, &str_header);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_offset += CONTAINER_BLOCK_HEADER_SIZE;
+
+            if (BLOCK_TYPE_END == str_header.u8_block_type)
+            {
+                if (u64_offset != u64_data_end)
+                {
+                    LOG_ERROR("Member %s has data after its END block.", pstr_member->pc_name);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                }
+                break;
+            }
+
+            if ((u64_data_end - u64_offset) < str_header.u32_compressed_size)
+            {
+                LOG_ERROR("Block of member %s overruns the member data.", pstr_member->pc_name);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            s32_ret_val = byte_buffer_reserve(&str_coded, str_header.u32_compressed_size);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = read_file_at(pstr_job->pf_archive, str_coded.pc_data, str_header.u32_compressed_size, u64_offset);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_offset += str_header.u32_compressed_size;
+
+            s32_ret_val = container_decode_block(&str_header, str_coded.pc_data, &str_window);
+            ERROR_BREAK(s32_ret_val);
+
+            u32_crc32c = crc32c_update(u32_crc32c, str_window.str_buffer.pc_data, str_window.str_buffer.u64_size);
+
+            s32_ret_val = output_window_flush(&str_window);
+            ERROR_BREAK(s32_ret_val);
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        if ((str_window.u64_total_size != pstr_member->u64_raw_size) || (u32_crc32c != pstr_member->u32_crc32c))
+        {
+            LOG_ERROR("Member %s is corrupted: %lu bytes, CRC32C %08x, expected %lu bytes, CRC32C %08x.", pstr_member->pc_name,
+                      str_window.u64_total_size, u32_crc32c, pstr_member->u64_raw_size, pstr_member->u32_crc32c);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+        s32_ret_val = async_writer_flush(&str_writer);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = close_file(&pf_out_file);
+        ERROR_BREAK(s32_ret_val);
+
+    } while (0);
+
+    if (true == b_writer_open)
+    {
+        async_writer_free(&str_writer);
+    }
+
+    if (NULL != pf_out_file)
+    {
+        close_file(&pf_out_file);
+    }
+
+    if ((SUCCESS_STATUS != s32_ret_val) && (true == b_created))
+    {
+        delete_file(pc_out_file_path);
+    }
+
+    byte_buffer_free(&str_coded);
+    byte_buffer_free(&str_window.str_buffer);
+    free_allocated_memory(pc_out_file_path);
+
+    pstr_job->s32_ret_val = s32_ret_val;
+}
+
+/**
+ * @brief Order member pointers by name, qsort() and bsearch() callback
+ *
+ * @param[in] pv_left First member pointer
+ * @param[in] pv_right Second member pointer
+ * @return int Negative, zero or positive like strcmp()
+ */
+static int archive_compare_member_refs(const void *pv_left, const void *pv_right)
+{
+    return strcmp((*(const tstr_archive_member *const *)pv_left)->pc_name, (*(const tstr_archive_member *const *)pv_right)->pc_name);
+}
+
+/**
+ * @brief Extract members of an archive into the directory named after it (<name>.rlea -> <name>/)
+ *
+ * Only the footer, the central directory and the data of the requested members are read.
+ * Existing files are never overwritten.
+ *
+ * @param[in] pc_archive_path Path to the archive
+ * @param[in] ppc_member_names Names of the members to extract
+ * @param[in] u32_member_name_count Number of names, 0 to extract every member
+ * @param[in] pstr_options Thread count and I/O backend
+ * @return s32 SUCCESS_STATUS if every requested member was extracted, error code otherwise
+ */
+s32 archive_extract(const char *pc_archive_path, const char **ppc_member_names, const u32 u32_member_name_count, const tstr_codec_options *pstr_options)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_archive_path || NULL == pstr_options || ((0 != u32_member_name_count) && (NULL == ppc_member_names)))
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if ((0 == pstr_options->u32_thread_count) || (THREAD_POOL_MAX_THREADS < pstr_options->u32_thread_count))
+    {
+        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+    }
+    else
+    {
+        FILE *pf_archive = NULL;
+        tstr_archive_directory str_directory = {NULL, 0, {NULL, 0, 0}};
+        const tstr_archive_member **ppstr_sorted = NULL;
+        tstr_archive_extract_job *pstr_jobs = NULL;
+        u32 u32_job_count = 0;
+        u32 u32_failed_count = 0;
+        char *pc_out_dir = strdup(pc_archive_path);
+        tstr_thread_pool str_pool;
+        bool b_pool_started = false;
+
+        do
+        {
+            size_t sz_path_len = 0;
+
+            if (NULL == pc_out_dir)
+            {
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            sz_path_len = strlen(pc_out_dir);
+
+            if ((sz_path_len <= 5) || (0 != strcmp(&pc_out_dir[sz_path_len - 5], ".rlea")))
+            {
+                LOG_ERROR("Invalid file extension for extraction. Expected .rlea");
+                s32_ret_val = ERROR_FILE_EXTENSION;
+                break;
+            }
+
+            pc_out_dir[sz_path_len - 5] = '\0';
+
+            s32_ret_val = s32_archive_open(pc_archive_path, &pf_archive, &str_directory);
+            ERROR_BREAK(s32_ret_val);
+
+            u32_job_count = (0 == u32_member_name_count) ? str_directory.u32_member_count : u32_member_name_count;
+
+            if (0 == u32_job_count)
+            {
+                LOG_INFO("Archive is empty.");
+                break;
+            }
+
+            pstr_jobs = (tstr_archive_extract_job *)calloc(u32_job_count, sizeof(tstr_archive_extract_job));
+            ppstr_sorted = (const tstr_archive_member **)calloc((0 == str_directory.u32_member_count) ? 1 : str_directory.u32_member_count,
+                                                                sizeof(tstr_archive_member *));
+
+            if (NULL == pstr_jobs || NULL == ppstr_sorted)
+            {
+                LOG_ERROR("Error allocating memory for extract jobs: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            for (u32 i = 0; i < str_directory.u32_member_count; i++)
+            {
+                ppstr_sorted[i] = &str_directory.pstr_members[i];
+            }
+
+            qsort(ppstr_sorted, str_directory.u32_member_count, sizeof(tstr_archive_member *), archive_compare_member_refs);
+
+            // Look every requested name up before anything is written
+            for (u32 i = 0; i < u32_job_count; i++)
+            {
+                if (0 == u32_member_name_count)
+                {
+                    pstr_jobs[i].pstr_member = ppstr_sorted[i];
+                }
+                else
+                {
+                    tstr_archive_member str_key = {ppc_member_names[i], 0, 0, 0, 0};
+                    const tstr_archive_member *pstr_key = &str_key;
+                    const tstr_archive_member **ppstr_found = (const tstr_archive_member **)bsearch(&pstr_key, ppstr_sorted, str_directory.u32_member_count,
+                                                                                                   sizeof(tstr_archive_member *), archive_compare_member_refs);
+
+                    if (NULL == ppstr_found)
+                    {
+                        LOG_ERROR("No member named %s in %s", ppc_member_names[i], pc_archive_path);
+                        s32_ret_val = ERROR_FILE_NOT_FOUND;
+                        break;
+                    }
+
+                    pstr_jobs[i].pstr_member = *ppstr_found;
+                }
+
+                pstr_jobs[i].pf_archive = pf_archive;
+                pstr_jobs[i].pc_out_dir = pc_out_dir;
+                pstr_jobs[i].enu_io_backend = pstr_options->enu_io_backend;
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            if ((0 != mkdir(pc_out_dir, 0755)) && (EEXIST != errno))
+            {
+                LOG_ERROR("Error creating directory %s: %s", pc_out_dir, strerror(errno));
+                s32_ret_val = ERROR_FILE_NOT_OPENED;
+                break;
+            }
+
+            s32_ret_val = thread_pool_create(&str_pool, pstr_options->u32_thread_count);
+            ERROR_BREAK(s32_ret_val);
+
+            b_pool_started = true;
+
+            tstr_task_group str_group = {0};
+
+            for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_job_count); i++)
+            {
+                s32_ret_val = thread_pool_submit(&str_pool, &pstr_jobs[i].str_task, archive_extract_job_run, &pstr_jobs[i], &str_group);
+            }
+
+            // Always wait, submitted jobs reference the job array
+            thread_pool_wait(&str_pool, &str_group);
+            ERROR_BREAK(s32_ret_val);
+
+            for (u32 i = 0; i < u32_job_count; i++)
+            {
+                if (SUCCESS_STATUS != pstr_jobs[i].s32_ret_val)
+                {
+                    LOG_ERROR("FAILED %s (error code: %d)", pstr_jobs[i].pstr_member->pc_name, pstr_jobs[i].s32_ret_val);
+                    u32_failed_count++;
+                }
+            }
+
+            LOG_INFO("Extracted %u of %u members to: %s", u32_job_count - u32_failed_count, u32_job_count, pc_out_dir);
+
+            s32_ret_val = (0 == u32_failed_count) ? SUCCESS_STATUS : ERROR_BATCH_FILES_FAILED;
+
+        } while (0);
+
+        if (true == b_pool_started)
+        {
+            thread_pool_destroy(&str_pool);
+        }
+
+        if (NULL != pf_archive)
+        {
+            close_file(&pf_archive);
+        }
+
+        archive_free_directory(&str_directory);
+        free_allocated_memory((void *)ppstr_sorted);
+        free_allocated_memory(pstr_jobs);
+        free_allocated_memory(pc_out_dir);
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,662 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/async_io.h"
+
+
+/**
+ * @brief Unmap the rings and close the io_uring instance
+ * 
+ * @param[in out] pstr_io Queue
+ * @return void
+ */
+static void async_io_release_ring(tstr_async_io *pstr_io)
+{
+    if ((NULL != pstr_io->pv_cq_ring) && (pstr_io->pv_cq_ring != pstr_io->pv_sq_ring))
+    {
+        munmap(pstr_io->pv_cq_ring, pstr_io->u64_cq_ring_size);
+    }
+
+    if (NULL != pstr_io->pv_sq_ring)
+    {
+        munmap(pstr_io->pv_sq_ring, pstr_io->u64_sq_ring_size);
+    }
+
+    if (NULL != pstr_io->pstr_sqes)
+    {
+        munmap(pstr_io->pstr_sqes, pstr_io->u64_sqes_size);
+    }
+
+    if (pstr_io->s32_ring_fd >= 0)
+    {
+        close(pstr_io->s32_ring_fd);
+    }
+
+    pstr_io->pv_sq_ring = NULL;
+    pstr_io->pv_cq_ring = NULL;
+    pstr_io->pstr_sqes = NULL;
+    pstr_io->s32_ring_fd = -1;
+    pstr_io->b_uring = false;
+}
+
+/**
+ * @brief Create an io_uring instance and map its rings, without liburing
+ * 
+ * @param[in out] pstr_io Queue
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_async_io_setup_ring(tstr_async_io *pstr_io)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    struct io_uring_params str_params;
+
+    memset(&str_params, 0, sizeof(str_params));
+
+    do
+    {
+        pstr_io->s32_ring_fd = (s32)syscall(__NR_io_uring_setup, ASYNC_IO_QUEUE_DEPTH, &str_params);
+
+        if (pstr_io->s32_ring_fd < 0)
+        {
+            LOG("io_uring is not available: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_NOT_OPENED;
+            break;
+        }
+
+        pstr_io->u64_sq_ring_size = str_params.sq_off.array + (str_params.sq_entries * sizeof(u32));
+        pstr_io->u64_cq_ring_size = str_params.cq_off.cqes + (str_params.cq_entries * sizeof(struct io_uring_cqe));
+
+        if (0 != (str_params.features & IORING_FEAT_SINGLE_MMAP))
+        {
+            if (pstr_io->u64_cq_ring_size > pstr_io->u64_sq_ring_size)
+            {
+                pstr_io->u64_sq_ring_size = pstr_io->u64_cq_ring_size;
+            }
+
+            pstr_io->u64_cq_ring_size = pstr_io->u64_sq_ring_size;
+        }
+
+        void *pv_map = mmap(NULL, pstr_io->u64_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pstr_io->s32_ring_fd, IORING_OFF_SQ_RING);
+
+        if (MAP_FAILED == pv_map)
+        {
+            LOG("Mapping the io_uring SQ ring failed: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_NOT_OPENED;
+            break;
+        }
+
+        pstr_io->pv_sq_ring = pv_map;
+
+        if (0 != (str_params.features & IORING_FEAT_SINGLE_MMAP))
+        {
+            pstr_io->pv_cq_ring = pstr_io->pv_sq_ring;
+        }
+        else
+        {
+            pv_map = mmap(NULL, pstr_io->u64_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pstr_io->s32_ring_fd, IORING_OFF_CQ_RING);
+
+            if (MAP_FAILED == pv_map)
+            {
+                LOG("Mapping the io_uring CQ ring failed: %s", strerror(errno));
+                s32_ret_val = ERROR_FILE_NOT_OPENED;
+                break;
+            }
+
+            pstr_io->pv_cq_ring = pv_map;
+        }
+
+        pstr_io->u64_sqes_size = str_params.sq_entries * sizeof(struct io_uring_sqe);
+        pv_map = mmap(NULL, pstr_io->u64_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pstr_io->s32_ring_fd, IORING_OFF_SQES);
+
+        if (MAP_FAILED == pv_map)
+        {
+            LOG("Mapping the io_uring SQEs failed: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_NOT_OPENED;
+            break;
+        }
+
+        pstr_io->pstr_sqes = (struct io_uring_sqe *)pv_map;
+
+        char *pc_sq_ring = (char *)pstr_io->pv_sq_ring;
+        char *pc_cq_ring = (char *)pstr_io->pv_cq_ring;
+
+        pstr_io->pu32_sq_tail = (u32 *)&pc_sq_ring[str_params.sq_off.tail];
+        pstr_io->pu32_sq_mask = (u32 *)&pc_sq_ring[str_params.sq_off.ring_mask];
+        pstr_io->pu32_sq_array = (u32 *)&pc_sq_ring[str_params.sq_off.array];
+        pstr_io->pu32_cq_head = (u32 *)&pc_cq_ring[str_params.cq_off.head];
+        pstr_io->pu32_cq_tail = (u32 *)&pc_cq_ring[str_params.cq_off.tail];
+        pstr_io->pu32_cq_mask = (u32 *)&pc_cq_ring[str_params.cq_off.ring_mask];
+        pstr_io->pstr_cqes = (struct io_uring_cqe *)&pc_cq_ring[str_params.cq_off.cqes];
+        pstr_io->b_uring = true;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+    } while (0);
+
+    if (SUCCESS_STATUS != s32_ret_val)
+    {
+        async_io_release_ring(pstr_io);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Set up an async I/O queue
+ * 
+ * @param[in out] pstr_io Queue to set up
+ * @param[in] enu_backend IO_BACKEND_SYNC for the pread/pwrite fallback, io_uring is tried otherwise 
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_io_init(tstr_async_io *pstr_io, const tenu_io_backend enu_backend)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_io)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        memset(pstr_io, 0, sizeof(*pstr_io));
+        pstr_io->s32_ring_fd = -1;
+
+        // Without io_uring the queue still works, operations just complete at submission
+        if (IO_BACKEND_SYNC != enu_backend)
+        {
+            s32_async_io_setup_ring(pstr_io);
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Queue a positioned read or write and hand it to the kernel
+ * 
+ * @param[in out] pstr_io Queue
+ * @param[in] enu_op Operation
+ * @param[in] s32_fd File descriptor
+ * @param[in] pv_data Buffer to read into or write from, must stay valid until the operation is reaped
+ * @param[in] u32_size Number of bytes
+ * @param[in] u64_offset File offset
+ * @param[in] u64_tag Tag returned with the completion
+ * @return s32 SUCCESS_STATUS on success, ERROR_INVALID_LENGTH if the queue is full, error code otherwise 
+ */
+s32 async_io_submit(tstr_async_io *pstr_io, const tenu_async_io_op enu_op, const s32 s32_fd, void *pv_data, const u32 u32_size, const u64 u64_offset, const u64 u64_tag)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_io || NULL == pv_data)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (ASYNC_IO_QUEUE_DEPTH <= pstr_io->u32_in_flight_count)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else if (true == pstr_io->b_uring)
+    {
+        u32 u32_tail = *pstr_io->pu32_sq_tail;
+        u32 u32_index = u32_tail & *pstr_io->pu32_sq_mask;
+        struct io_uring_sqe *pstr_sqe = &pstr_io->pstr_sqes[u32_index];
+
+        memset(pstr_sqe, 0, sizeof(*pstr_sqe));
+        pstr_sqe->opcode = (ASYNC_IO_OP_READ == enu_op) ? IORING_OP_READ : IORING_OP_WRITE;
+        pstr_sqe->fd = s32_fd;
+        pstr_sqe->addr = (u64)(uintptr_t)pv_data;
+        pstr_sqe->len = u32_size;
+        pstr_sqe->off = u64_offset;
+        pstr_sqe->user_data = u64_tag;
+
+        pstr_io->pu32_sq_array[u32_index] = u32_index;
+
+        // The kernel must see the SQE before the new tail
+        __atomic_store_n(pstr_io->pu32_sq_tail, u32_tail + 1, __ATOMIC_RELEASE);
+
+        pstr_io->u32_unsubmitted_count++;
+        pstr_io->u32_in_flight_count++;
+        s32_ret_val = SUCCESS_STATUS;
+
+        // Start the operation now so it overlaps with the caller's coding, an SQE the kernel
+        // does not take here stays queued and async_io_wait() passes it on
+        while (0 != pstr_io->u32_unsubmitted_count)
+        {
+            long s64_entered = syscall(__NR_io_uring_enter, pstr_io->s32_ring_fd, pstr_io->u32_unsubmitted_count, 0, 0, NULL, 0);
+
+            if ((s64_entered < 0) && (EINTR == errno))
+            {
+                continue;
+            }
+
+            if (s64_entered <= 0)
+            {
+                break;
+            }
+
+            pstr_io->u32_unsubmitted_count -= (u32)s64_entered;
+        }
+    }
+    else
+    {
+        tstr_async_io_completion *pstr_done = &pstr_io->astr_sync_done[pstr_io->u32_in_flight_count];
+        ssize_t s64_result = 0;
+
+        do
+        {
+            s64_result = (ASYNC_IO_OP_READ == enu_op) ? pread(s32_fd, pv_data, u32_size, (off_t)u64_offset)
+                                                      : pwrite(s32_fd, pv_data, u32_size, (off_t)u64_offset);
+        } while ((s64_result < 0) && (EINTR == errno));
+
+        pstr_done->s64_result = (s64_result < 0) ? -(s64)errno : (s64)s64_result;
+        pstr_done->u64_tag = u64_tag;
+
+        pstr_io->u32_in_flight_count++;
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Wait for one queued operation to finish, operations the kernel did not take at submit are passed on first
+ * 
+ * @param[in out] pstr_io Queue
+ * @param[in out] pstr_completion Pointer to hold the finished operation
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_io_wait(tstr_async_io *pstr_io, tstr_async_io_completion *pstr_completion)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_io || NULL == pstr_completion)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == pstr_io->u32_in_flight_count)
+    {
+        LOG_ERROR("Waiting on an empty I/O queue.");
+        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+    }
+    else if (true == pstr_io->b_uring)
+    {
+        u32 u32_head = *pstr_io->pu32_cq_head;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        while (u32_head == __atomic_load_n(pstr_io->pu32_cq_tail, __ATOMIC_ACQUIRE))
+        {
+            long s64_entered = syscall(__NR_io_uring_enter, pstr_io->s32_ring_fd, pstr_io->u32_unsubmitted_count, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+            if (s64_entered < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+
+                LOG_ERROR("io_uring_enter failed: %s", strerror(errno));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+                break;
+            }
+
+            pstr_io->u32_unsubmitted_count -= (u32)s64_entered;
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            struct io_uring_cqe *pstr_cqe = &pstr_io->pstr_cqes[u32_head & *pstr_io->pu32_cq_mask];
+
+            pstr_completion->s64_result = pstr_cqe->res;
+            pstr_completion->u64_tag = pstr_cqe->user_data;
+
+            __atomic_store_n(pstr_io->pu32_cq_head, u32_head + 1, __ATOMIC_RELEASE);
+            pstr_io->u32_in_flight_count--;
+        }
+    }
+    else
+    {
+        // Completions of the fallback are handed back oldest first
+        *pstr_completion = pstr_io->astr_sync_done[0];
+        pstr_io->u32_in_flight_count--;
+        memmove(&pstr_io->astr_sync_done[0], &pstr_io->astr_sync_done[1], pstr_io->u32_in_flight_count * sizeof(tstr_async_io_completion));
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Get the number of operations not reaped yet
+ * 
+ * @param[in] pstr_io Queue
+ * @return u32 Number of operations in flight
+ */
+u32 async_io_pending_count(const tstr_async_io *pstr_io)
+{
+    return (NULL == pstr_io) ? 0 : pstr_io->u32_in_flight_count;
+}
+
+/**
+ * @brief Release the queue, every operation must have been reaped
+ * 
+ * @param[in out] pstr_io Queue
+ * @return void
+ */
+void async_io_free(tstr_async_io *pstr_io)
+{
+    if ((NULL != pstr_io) && (true == pstr_io->b_uring))
+    {
+        async_io_release_ring(pstr_io);
+    }
+}
+
+/**
+ * @brief Reap one finished write, requeueing the rest of a short write
+ * 
+ * @param[in out] pstr_writer Writer
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_async_writer_reap(tstr_async_writer *pstr_writer)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_async_io_completion str_completion = {0};
+
+    do
+    {
+        s32_ret_val = async_io_wait(&pstr_writer->str_io, &str_completion);
+        ERROR_BREAK(s32_ret_val);
+
+        u32 u32_slot = (u32)str_completion.u64_tag;
+        tstr_byte_buffer *pstr_slot = &pstr_writer->astr_slots[u32_slot];
+
+        if (str_completion.s64_result <= 0)
+        {
+            LOG_ERROR("Error writing to file: %s", (0 == str_completion.s64_result) ? "no progress" : strerror((int)-str_completion.s64_result));
+            pstr_writer->ab_slot_busy[u32_slot] = false;
+            s32_ret_val = ERROR_FILE_WRITE_FAILED;
+            break;
+        }
+
+        pstr_writer->au64_slot_done[u32_slot] += (u64)str_completion.s64_result;
+        pstr_writer->au64_slot_offset[u32_slot] += (u64)str_completion.s64_result;
+
+        if (pstr_writer->au64_slot_done[u32_slot] < pstr_slot->u64_size)
+        {
+            s32_ret_val = async_io_submit(&pstr_writer->str_io, ASYNC_IO_OP_WRITE, fileno(pstr_writer->pf_file),
+                                          &pstr_slot->pc_data[pstr_writer->au64_slot_done[u32_slot]],
+                                          (u32)(pstr_slot->u64_size - pstr_writer->au64_slot_done[u32_slot]),
+                                          pstr_writer->au64_slot_offset[u32_slot], u32_slot);
+            ERROR_BREAK(s32_ret_val);
+        }
+        else
+        {
+            pstr_writer->ab_slot_busy[u32_slot] = false;
+        }
+
+    } while (0);
+
+    if ((SUCCESS_STATUS != s32_ret_val) && (SUCCESS_STATUS == pstr_writer->s32_error))
+    {
+        pstr_writer->s32_error = s32_ret_val;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Attach a writer to a file, writes start at the current file position
+ * 
+ * @param[in out] pstr_writer Writer to set up
+ * @param[in] pf_file File to write to
+ * @param[in] enu_backend I/O backend
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_writer_open(tstr_async_writer *pstr_writer, FILE *pf_file, const tenu_io_backend enu_backend)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_writer || NULL == pf_file)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 u64_file_size = 0;
+
+        memset(pstr_writer, 0, sizeof(*pstr_writer));
+        pstr_writer->pf_file = pf_file;
+        pstr_writer->s32_error = SUCCESS_STATUS;
+
+        for (u32 i = 0; i < ASYNC_IO_QUEUE_DEPTH; i++)
+        {
+            byte_buffer_init(&pstr_writer->astr_slots[i]);
+        }
+
+        do
+        {
+            if (0 != fflush(pf_file))
+            {
+                LOG_ERROR("Error flushing file: %s", strerror(errno));
+                s32_ret_val = ERROR_FILE_WRITE_FAILED;
+                break;
+            }
+
+            pstr_writer->b_positioned = is_regular_file(pf_file, &u64_file_size);
+
+            if (true == pstr_writer->b_positioned)
+            {
+                long s64_position = ftell(pf_file);
+
+                if (s64_position < 0)
+                {
+                    LOG_ERROR("Error getting the file position: %s", strerror(errno));
+                    s32_ret_val = ERROR_FILE_WRITE_FAILED;
+                    break;
+                }
+
+                pstr_writer->u64_offset = (u64)s64_position;
+            }
+
+            s32_ret_val = async_io_init(&pstr_writer->str_io, enu_backend);
+            ERROR_BREAK(s32_ret_val);
+
+        } while (0);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Queue the content of a buffer for writing
+ * 
+ * The buffer memory is taken over by the writer, the caller gets back an empty buffer
+ * of at least the same capacity.
+ * 
+ * @param[in out] pstr_writer Writer
+ * @param[in out] pstr_buffer Filled buffer, empty on return
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_writer_write(tstr_async_writer *pstr_writer, tstr_byte_buffer *pstr_buffer)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    u64 u64_start_ns = get_monotonic_time_ns();
+
+    if (NULL == pstr_writer || NULL == pstr_buffer)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (SUCCESS_STATUS != pstr_writer->s32_error)
+    {
+        s32_ret_val = pstr_writer->s32_error;
+    }
+    else if (0 == pstr_buffer->u64_size)
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else if ((false == pstr_writer->b_positioned) || (pstr_buffer->u64_size > UINT32_MAX))
+    {
+        s32_ret_val = write_file(pstr_writer->pf_file, pstr_buffer->pc_data, pstr_buffer->u64_size);
+        pstr_writer->u64_offset += pstr_buffer->u64_size;
+        pstr_buffer->u64_size = 0;
+    }
+    else
+    {
+        u32 u32_slot = ASYNC_IO_QUEUE_DEPTH;
+
+        do
+        {
+            // Take a free slot, waiting for the oldest write when all of them are busy
+            while (ASYNC_IO_QUEUE_DEPTH == u32_slot)
+            {
+                for (u32 i = 0; i < ASYNC_IO_QUEUE_DEPTH; i++)
+                {
+                    if (false == pstr_writer->ab_slot_busy[i])
+                    {
+                        u32_slot = i;
+                        break;
+                    }
+                }
+
+                if (ASYNC_IO_QUEUE_DEPTH == u32_slot)
+                {
+                    s32_ret_val = s32_async_writer_reap(pstr_writer);
+                    ERROR_BREAK(s32_ret_val);
+                }
+            }
+
+            if (ASYNC_IO_QUEUE_DEPTH == u32_slot)
+            {
+                break;
+            }
+
+            // Exchange the filled buffer with the free slot buffer
+            tstr_byte_buffer str_free_buffer = pstr_writer->astr_slots[u32_slot];
+
+            pstr_writer->astr_slots[u32_slot] = *pstr_buffer;
+            *pstr_buffer = str_free_buffer;
+            pstr_buffer->u64_size = 0;
+
+            pstr_writer->ab_slot_busy[u32_slot] = true;
+            pstr_writer->au64_slot_done[u32_slot] = 0;
+            pstr_writer->au64_slot_offset[u32_slot] = pstr_writer->u64_offset;
+            pstr_writer->u64_offset += pstr_writer->astr_slots[u32_slot].u64_size;
+
+            s32_ret_val = async_io_submit(&pstr_writer->str_io, ASYNC_IO_OP_WRITE, fileno(pstr_writer->pf_file),
+                                          pstr_writer->astr_slots[u32_slot].pc_data, (u32)pstr_writer->astr_slots[u32_slot].u64_size,
+                                          pstr_writer->au64_slot_offset[u32_slot], u32_slot);
+
+            if (SUCCESS_STATUS != s32_ret_val)
+            {
+                pstr_writer->ab_slot_busy[u32_slot] = false;
+                break;
+            }
+
+            s32_ret_val = byte_buffer_reserve(pstr_buffer, pstr_writer->astr_slots[u32_slot].u64_capacity);
+            ERROR_BREAK(s32_ret_val);
+
+        } while (0);
+
+        if ((SUCCESS_STATUS != s32_ret_val) && (SUCCESS_STATUS == pstr_writer->s32_error))
+        {
+            pstr_writer->s32_error = s32_ret_val;
+        }
+    }
+
+    if (NULL != pstr_writer)
+    {
+        pstr_writer->u64_busy_ns += get_monotonic_time_ns() - u64_start_ns;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Wait for every queued write and move the file position past the written data, pipes are flushed
+ * 
+ * @param[in out] pstr_writer Writer
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 async_writer_flush(tstr_async_writer *pstr_writer)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_writer)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 u64_start_ns = get_monotonic_time_ns();
+
+        // A failed wait leaves the count where it was, stop instead of retrying forever
+        while (0 != async_io_pending_count(&pstr_writer->str_io))
+        {
+            if (SUCCESS_STATUS != s32_async_writer_reap(pstr_writer))
+            {
+                break;
+            }
+        }
+
+        s32_ret_val = pstr_writer->s32_error;
+
+        if ((SUCCESS_STATUS == s32_ret_val) && (true == pstr_writer->b_positioned) &&
+            (0 != fseek(pstr_writer->pf_file, (long)pstr_writer->u64_offset, SEEK_SET)))
+        {
+            LOG_ERROR("Error moving the file position: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_WRITE_FAILED;
+        }
+
+        // Pipes are written through stdio, hand what it buffered to the reader
+        if ((SUCCESS_STATUS == s32_ret_val) && (false == pstr_writer->b_positioned) && (0 != fflush(pstr_writer->pf_file)))
+        {
+            LOG_ERROR("Error flushing file: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_WRITE_FAILED;
+        }
+
+        pstr_writer->u64_busy_ns += get_monotonic_time_ns() - u64_start_ns;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Wait for the queued writes and release the writer, the file stays open
+ * 
+ * @param[in out] pstr_writer Writer
+ * @return void
+ */
+void async_writer_free(tstr_async_writer *pstr_writer)
+{
+    if (NULL != pstr_writer)
+    {
+        // The kernel may still be reading the slot buffers
+        while (0 != async_io_pending_count(&pstr_writer->str_io))
+        {
+            tstr_async_io_completion str_completion;
+
+            if (SUCCESS_STATUS != async_io_wait(&pstr_writer->str_io, &str_completion))
+            {
+                break;
+            }
+        }
+
+        async_io_free(&pstr_writer->str_io);
+
+        for (u32 i = 0; i < ASYNC_IO_QUEUE_DEPTH; i++)
+        {
+            byte_buffer_free(&pstr_writer->astr_slots[i]);
+        }
+    }
+}
\ No newline at end of file
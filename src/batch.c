@@ -0,0 +1,244 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/batch.h"
+#include "../header_files/compress.h"
+#include "../header_files/decompress.h"
+
+
+/**
+ * @brief Pool task: compress or decompress one file of the batch
+ * 
+ * @param[in out] pv_job Batch job of the file
+ * @return void
+ */
+static void batch_job_run(void *pv_job)
+{
+    tstr_batch_job *pstr_job = (tstr_batch_job *)pv_job;
+    const tstr_codec_options *pstr_options = &pstr_job->pstr_args->str_options;
+    const bool b_compress = (OP_COMPRESS == pstr_job->pstr_args->enu_operation);
+    tstr_codec_stats str_stats;
+    tstr_codec_stats *pstr_stats = (STATS_OUTPUT_NONE != pstr_options->enu_stats_output) ? &str_stats : NULL;
+
+    if (true == b_compress)
+    {
+        pstr_job->s32_ret_val = compress(pstr_job->pc_input_file, pstr_options, pstr_job->pstr_pool, pstr_stats);
+    }
+    else
+    {
+        pstr_job->s32_ret_val = decompress(pstr_job->pc_input_file, pstr_options, pstr_job->pstr_pool, pstr_stats);
+    }
+
+    // Lines come in the order the files finish
+    if (NULL != pstr_stats)
+    {
+        stats_report(stderr, pstr_options->enu_stats_output, (true == b_compress) ? "compress" : ((true == pstr_options->b_test_only) ? "test" : "decompress"),
+                     pstr_job->pc_input_file, pstr_job->s32_ret_val, pstr_stats);
+    }
+}
+
+/**
+ * @brief Read the input paths of a file list, one per line, empty lines are skipped
+ * 
+ * @param[in] pc_list_path Path to the list, "-" for stdin
+ * @param[in out] pstr_names Buffer to hold the paths, each one NUL terminated
+ * @param[in out] pu32_name_count Pointer to hold the number of paths read
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 batch_read_file_list(const char *pc_list_path, tstr_byte_buffer *pstr_names, u32 *pu32_name_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_list_path || NULL == pstr_names || NULL == pu32_name_count)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        FILE *pf_list_file = NULL;
+        char *pc_line = NULL;
+        size_t sz_line_capacity = 0;
+        ssize_t sz_line_size = 0;
+
+        *pu32_name_count = 0;
+
+        do
+        {
+            if (0 == strcmp(pc_list_path, "-"))
+            {
+                pf_list_file = stdin;
+            }
+            else
+            {
+                s32_ret_val = open_file(pc_list_path, "r", &pf_list_file);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            s32_ret_val = SUCCESS_STATUS;
+
+            while (-1 != (sz_line_size = getline(&pc_line, &sz_line_capacity, pf_list_file)))
+            {
+                while ((sz_line_size > 0) && (('\n' == pc_line[sz_line_size - 1]) || ('\r' == pc_line[sz_line_size - 1])))
+                {
+                    sz_line_size--;
+                }
+
+                if (0 == sz_line_size)
+                {
+                    continue;
+                }
+
+                pc_line[sz_line_size] = '\0';
+
+                s32_ret_val = byte_buffer_append(pstr_names, pc_line, (u64)sz_line_size + 1);
+                ERROR_BREAK(s32_ret_val);
+
+                (*pu32_name_count)++;
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            if (0 != ferror(pf_list_file))
+            {
+                LOG_ERROR("Error reading the file list %s: %s", pc_list_path, strerror(errno));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+                break;
+            }
+
+        } while (0);
+
+        if ((NULL != pf_list_file) && (stdin != pf_list_file))
+        {
+            close_file(&pf_list_file);
+        }
+
+        free_allocated_memory(pc_line);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Compress or decompress many files concurrently on one work-stealing pool
+ * 
+ * Every file is one task, tasks of large .rle2 files split into block jobs that idle
+ * threads steal. The status of every file is reported once all of them are done.
+ * 
+ * @param[in] pstr_args Parsed arguments: operation, input files, file list and codec options
+ * @return s32 SUCCESS_STATUS if every file succeeded, error code otherwise 
+ */
+s32 batch_run(const tstr_input_args *pstr_args)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_args)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        tstr_byte_buffer str_list_names;
+        u32 u32_list_count = 0;
+        tstr_batch_job *pstr_jobs = NULL;
+        u32 u32_job_count = 0;
+        u32 u32_failed_count = 0;
+        tstr_thread_pool str_pool;
+        bool b_pool_started = false;
+
+        byte_buffer_init(&str_list_names);
+
+        do
+        {
+            if (NULL != pstr_args->pc_file_list)
+            {
+                s32_ret_val = batch_read_file_list(pstr_args->pc_file_list, &str_list_names, &u32_list_count);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            u32_job_count = pstr_args->u32_input_count + u32_list_count;
+
+            if (0 == u32_job_count)
+            {
+                LOG_ERROR("No input files given.");
+                s32_ret_val = ERROR_INVALID_ARGUMENTS;
+                break;
+            }
+
+            pstr_jobs = (tstr_batch_job *)calloc(u32_job_count, sizeof(tstr_batch_job));
+
+            if (NULL == pstr_jobs)
+            {
+                LOG_ERROR("Error allocating memory for batch jobs: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            // Command line files first, then the list, the names stay in str_list_names
+            {
+                const char *pc_list_name = str_list_names.pc_data;
+
+                for (u32 i = 0; i < u32_job_count; i++)
+                {
+                    if (i < pstr_args->u32_input_count)
+                    {
+                        pstr_jobs[i].pc_input_file = pstr_args->ppc_input_files[i];
+                    }
+                    else
+                    {
+                        pstr_jobs[i].pc_input_file = pc_list_name;
+                        pc_list_name += strlen(pc_list_name) + 1;
+                    }
+
+                    pstr_jobs[i].pstr_args = pstr_args;
+                    pstr_jobs[i].pstr_pool = &str_pool;
+                }
+            }
+
+            s32_ret_val = thread_pool_create(&str_pool, pstr_args->str_options.u32_thread_count);
+            ERROR_BREAK(s32_ret_val);
+
+            b_pool_started = true;
+
+            tstr_task_group str_group = {0};
+
+            for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_job_count); i++)
+            {
+                s32_ret_val = thread_pool_submit(&str_pool, &pstr_jobs[i].str_task, batch_job_run, &pstr_jobs[i], &str_group);
+            }
+
+            // Always wait, submitted jobs reference the job array
+            thread_pool_wait(&str_pool, &str_group);
+            ERROR_BREAK(s32_ret_val);
+
+            for (u32 i = 0; i < u32_job_count; i++)
+            {
+                if (SUCCESS_STATUS == pstr_jobs[i].s32_ret_val)
+                {
+                    LOG_INFO("OK     %s", pstr_jobs[i].pc_input_file);
+                }
+                else
+                {
+                    LOG_ERROR("FAILED %s (error code: %d)", pstr_jobs[i].pc_input_file, pstr_jobs[i].s32_ret_val);
+                    u32_failed_count++;
+                }
+            }
+
+            LOG_INFO("Batch done: %u of %u files succeeded.", u32_job_count - u32_failed_count, u32_job_count);
+
+            s32_ret_val = (0 == u32_failed_count) ? SUCCESS_STATUS : ERROR_BATCH_FILES_FAILED;
+
+        } while (0);
+
+        if (true == b_pool_started)
+        {
+            thread_pool_destroy(&str_pool);
+        }
+
+        free_allocated_memory(pstr_jobs);
+        byte_buffer_free(&str_list_names);
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,515 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include "../header_files/buffer.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/async_io.h"
+
+
+// Statistics record the buffer memory of the calling thread is counted into, NULL when not counted
+static __thread tstr_buffer_stats *tpstr_buffer_stats = NULL;
+
+/**
+ * @brief Count a change of buffer capacity into the statistics record of the calling thread
+ * 
+ * @param[in] u64_old_capacity Capacity before the change
+ * @param[in] u64_new_capacity Capacity after the change
+ * @param[in] b_allocated true when the change took an allocation or reallocation
+ * @return void
+ */
+static void byte_buffer_stats_count(const u64 u64_old_capacity, const u64 u64_new_capacity, const bool b_allocated)
+{
+    tstr_buffer_stats *pstr_stats = tpstr_buffer_stats;
+
+    if (NULL != pstr_stats)
+    {
+        u64 u64_live = __atomic_load_n(&pstr_stats->u64_live_bytes, __ATOMIC_RELAXED);
+        u64 u64_new_live = 0;
+        u64 u64_peak = 0;
+
+        if (true == b_allocated)
+        {
+            __atomic_add_fetch(&pstr_stats->u64_realloc_count, 1, __ATOMIC_RELAXED);
+        }
+
+        // The pool workers of the file count into the same record
+        do
+        {
+            if (u64_new_capacity >= u64_old_capacity)
+            {
+                u64_new_live = u64_live + (u64_new_capacity - u64_old_capacity);
+            }
+            else
+            {
+                u64 u64_freed = u64_old_capacity - u64_new_capacity;
+
+                u64_new_live = (u64_freed < u64_live) ? (u64_live - u64_freed) : 0;
+            }
+        } while (false == __atomic_compare_exchange_n(&pstr_stats->u64_live_bytes, &u64_live, u64_new_live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+        u64_peak = __atomic_load_n(&pstr_stats->u64_peak_bytes, __ATOMIC_RELAXED);
+
+        while ((u64_new_live > u64_peak) &&
+               (false == __atomic_compare_exchange_n(&pstr_stats->u64_peak_bytes, &u64_peak, u64_new_live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)))
+        {
+        }
+    }
+}
+
+/**
+ * @brief Initialize an empty byte buffer without allocating memory
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer to initialize
+ * @return void
+ */
+void byte_buffer_init(tstr_byte_buffer *pstr_buffer)
+{
+    if (NULL != pstr_buffer)
+    {
+        pstr_buffer->pc_data = NULL;
+        pstr_buffer->u64_size = 0;
+        pstr_buffer->u64_capacity = 0;
+    }
+}
+
+/**
+ * @brief Make sure the buffer can hold at least the requested number of bytes
+ * 
+ * The capacity is at least doubled on every reallocation, so growing a buffer to n
+ * bytes through repeated reserves costs O(log n) reallocations.
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @param[in] u64_min_capacity Minimum capacity required
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 byte_buffer_reserve(tstr_byte_buffer *pstr_buffer, const u64 u64_min_capacity)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_buffer)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_min_capacity <= pstr_buffer->u64_capacity)
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        u64 u64_new_capacity = (0 == pstr_buffer->u64_capacity) ? BYTE_BUFFER_MIN_CAPACITY : pstr_buffer->u64_capacity;
+
+        while (u64_new_capacity < u64_min_capacity)
+        {
+            u64_new_capacity = (u64_new_capacity > (UINT64_MAX / 2)) ? u64_min_capacity : (2 * u64_new_capacity);
+        }
+
+        char *pc_new_data = (char *)realloc(pstr_buffer->pc_data, u64_new_capacity);
+
+        if (NULL == pc_new_data)
+        {
+            // The old block is still valid and owned by the buffer
+            LOG_ERROR("Error growing buffer to %lu bytes: %s", u64_new_capacity, strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+        else
+        {
+            LOG("Buffer grown from %lu to %lu bytes.", pstr_buffer->u64_capacity, u64_new_capacity);
+            byte_buffer_stats_count(pstr_buffer->u64_capacity, u64_new_capacity, true);
+            pstr_buffer->pc_data = pc_new_data;
+            pstr_buffer->u64_capacity = u64_new_capacity;
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Append data at the end of the buffer, growing it if needed
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @param[in] pc_data Data to append
+ * @param[in] u64_data_size Size of the data to append
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 byte_buffer_append(tstr_byte_buffer *pstr_buffer, const char *pc_data, const u64 u64_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_buffer || (NULL == pc_data && 0 != u64_data_size))
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        s32_ret_val = byte_buffer_reserve(pstr_buffer, pstr_buffer->u64_size + u64_data_size);
+
+        if (SUCCESS_STATUS == s32_ret_val && 0 != u64_data_size)
+        {
+            memcpy(&pstr_buffer->pc_data[pstr_buffer->u64_size], pc_data, u64_data_size);
+            pstr_buffer->u64_size += u64_data_size;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Release the unused capacity of the buffer
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 byte_buffer_shrink_to_fit(tstr_byte_buffer *pstr_buffer)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_buffer)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if ((0 == pstr_buffer->u64_size) || (pstr_buffer->u64_size == pstr_buffer->u64_capacity))
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        char *pc_new_data = (char *)realloc(pstr_buffer->pc_data, pstr_buffer->u64_size);
+
+        if (NULL == pc_new_data)
+        {
+            LOG_ERROR("Error shrinking buffer to %lu bytes: %s", pstr_buffer->u64_size, strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+        else
+        {
+            byte_buffer_stats_count(pstr_buffer->u64_capacity, pstr_buffer->u64_size, true);
+            pstr_buffer->pc_data = pc_new_data;
+            pstr_buffer->u64_capacity = pstr_buffer->u64_size;
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Hand the buffer memory over to the caller and leave the buffer empty
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @param[in out] pu64_data_size Pointer to hold the number of bytes in use (may be NULL)
+ * @return char* Pointer to the data, to be freed by the caller
+ */
+char *byte_buffer_release(tstr_byte_buffer *pstr_buffer, u64 *pu64_data_size)
+{
+    char *pc_data = NULL;
+
+    if (NULL != pstr_buffer)
+    {
+        pc_data = pstr_buffer->pc_data;
+
+        if (NULL != pu64_data_size)
+        {
+            *pu64_data_size = pstr_buffer->u64_size;
+        }
+
+        // The memory is the caller's from now on
+        byte_buffer_stats_count(pstr_buffer->u64_capacity, 0, false);
+        byte_buffer_init(pstr_buffer);
+    }
+
+    return pc_data;
+}
+
+/**
+ * @brief Free the buffer memory and leave the buffer empty
+ * 
+ * @param[in out] pstr_buffer Pointer to the buffer
+ * @return void
+ */
+void byte_buffer_free(tstr_byte_buffer *pstr_buffer)
+{
+    if (NULL != pstr_buffer)
+    {
+        byte_buffer_stats_count(pstr_buffer->u64_capacity, 0, false);
+        free_allocated_memory(pstr_buffer->pc_data);
+        byte_buffer_init(pstr_buffer);
+    }
+}
+
+/**
+ * @brief Count the byte buffer memory of the calling thread into a statistics record
+ * 
+ * Buffers freed while attached that were allocated before do not lower the live bytes
+ * below zero. Several threads may count into one record, pool tasks count into the
+ * record of the thread that submitted them.
+ * 
+ * @param[in out] pstr_stats Record to count into, NULL to stop counting
+ * @return tstr_buffer_stats* Record attached before, to attach again when done
+ */
+tstr_buffer_stats *byte_buffer_stats_attach(tstr_buffer_stats *pstr_stats)
+{
+    tstr_buffer_stats *pstr_previous = tpstr_buffer_stats;
+
+    tpstr_buffer_stats = pstr_stats;
+
+    return pstr_previous;
+}
+
+/**
+ * @brief Get the statistics record the calling thread counts into
+ * 
+ * @return tstr_buffer_stats* Attached record, NULL when not counted
+ */
+tstr_buffer_stats *byte_buffer_stats_attached(void)
+{
+    return tpstr_buffer_stats;
+}
+
+/**
+ * @brief Allocate the output window memory, including the slack needed by run_expand()
+ * 
+ * @param[in out] pstr_window Output window to allocate
+ * @param[in] u64_window_size Bytes buffered before the window is flushed
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_reserve(tstr_output_window *pstr_window, const u64 u64_window_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_window_size)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        s32_ret_val = byte_buffer_reserve(&pstr_window->str_buffer, u64_window_size + RUN_EXPAND_SLACK_BYTES);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_window->u64_window_size = u64_window_size;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Copy the filled bytes of the output window that fall in its range to its range output
+ * 
+ * @param[in] pstr_window Output window with a range output
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_output_window_clip(const tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    const u64 u64_data_offset = pstr_window->u64_total_size;
+    const u64 u64_data_end = u64_data_offset + pstr_window->str_buffer.u64_size;
+    const u64 u64_start = (pstr_window->u64_range_start > u64_data_offset) ? pstr_window->u64_range_start : u64_data_offset;
+    const u64 u64_end = (pstr_window->u64_range_end < u64_data_end) ? pstr_window->u64_range_end : u64_data_end;
+
+    if (u64_start < u64_end)
+    {
+        s32_ret_val = output_window_append(pstr_window->pstr_range_output, &pstr_window->str_buffer.pc_data[u64_start - u64_data_offset], u64_end - u64_start);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Get how many bytes from the current position of the output window fall outside its range
+ * 
+ * @param[in] pstr_window Output window
+ * @param[in] u64_size Number of bytes about to be added
+ * @return u64 Leading bytes of u64_size outside the range, 0 for a window without range output
+ */
+static u64 u64_output_window_outside_range(const tstr_output_window *pstr_window, const u64 u64_size)
+{
+    u64 u64_outside_size = 0;
+
+    const u64 u64_position = pstr_window->u64_total_size + pstr_window->str_buffer.u64_size;
+
+    if (NULL == pstr_window->pstr_range_output)
+    {
+        u64_outside_size = 0;
+    }
+    else if (u64_position >= pstr_window->u64_range_end)
+    {
+        u64_outside_size = u64_size;
+    }
+    else if (u64_position < pstr_window->u64_range_start)
+    {
+        u64_outside_size = ((pstr_window->u64_range_start - u64_position) < u64_size) ? (pstr_window->u64_range_start - u64_position) : u64_size;
+    }
+
+    return u64_outside_size;
+}
+
+/**
+ * @brief Write the filled part of the output window to its file or sink and reset the window
+ * 
+ * A window without a file, writer or sink drops its data, only the total size is kept. A window
+ * with a total limit keeps its data and fails instead of flushing past the limit. A window with a
+ * range output copies only the bytes of its range there.
+ * 
+ * @param[in out] pstr_window Output window to flush
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_flush(tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == pstr_window->str_buffer.u64_size)
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        u64 u64_flushed_size = pstr_window->str_buffer.u64_size;
+
+        if ((0 != pstr_window->u64_total_limit) && (u64_flushed_size > (pstr_window->u64_total_limit - pstr_window->u64_total_size)))
+        {
+            s32_ret_val = ERROR_INVALID_LENGTH;
+        }
+        else if (NULL != pstr_window->pstr_range_output)
+        {
+            s32_ret_val = s32_output_window_clip(pstr_window);
+        }
+        else if (NULL != pstr_window->pstr_sink)
+        {
+            s32_ret_val = byte_buffer_append(pstr_window->pstr_sink, pstr_window->str_buffer.pc_data, pstr_window->str_buffer.u64_size);
+        }
+        else if (NULL != pstr_window->pstr_writer)
+        {
+            // The writer takes the filled buffer and hands back an empty one of the same capacity
+            s32_ret_val = async_writer_write(pstr_window->pstr_writer, &pstr_window->str_buffer);
+        }
+        else if (NULL != pstr_window->pf_file)
+        {
+            s32_ret_val = write_file(pstr_window->pf_file, pstr_window->str_buffer.pc_data, pstr_window->str_buffer.u64_size);
+        }
+        else
+        {
+            s32_ret_val = SUCCESS_STATUS;
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_window->u64_total_size += u64_flushed_size;
+            pstr_window->str_buffer.u64_size = 0;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Expand one run into the output window, flushing it as many times as needed
+ * 
+ * A window with a range output counts the part of a run longer than the window that falls
+ * outside its range without expanding it.
+ * 
+ * @param[in out] pstr_window Output window to expand the run into
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_append_run(tstr_output_window *pstr_window, const char c_run_char, u64 u64_run_len)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_byte_buffer *pstr_buffer = &pstr_window->str_buffer;
+
+    if (u64_run_len <= (pstr_window->u64_window_size - pstr_buffer->u64_size))
+    {
+        // Fast path, the whole run fits in the window
+        run_expand(&pstr_buffer->pc_data[pstr_buffer->u64_size], c_run_char, u64_run_len);
+        pstr_buffer->u64_size += u64_run_len;
+    }
+    else
+    {
+        while (0 != u64_run_len)
+        {
+            const u64 u64_skip_len = u64_output_window_outside_range(pstr_window, u64_run_len);
+
+            if (0 != u64_skip_len)
+            {
+                // Bytes outside the range are only counted, the window is flushed first to keep the count in order
+                s32_ret_val = output_window_flush(pstr_window);
+                ERROR_BREAK(s32_ret_val);
+
+                pstr_window->u64_total_size += u64_skip_len;
+                u64_run_len -= u64_skip_len;
+                continue;
+            }
+
+            if (pstr_buffer->u64_size == pstr_window->u64_window_size)
+            {
+                s32_ret_val = output_window_flush(pstr_window);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            u64 u64_chunk_len = pstr_window->u64_window_size - pstr_buffer->u64_size;
+
+            if (u64_chunk_len > u64_run_len)
+            {
+                u64_chunk_len = u64_run_len;
+            }
+
+            run_expand(&pstr_buffer->pc_data[pstr_buffer->u64_size], c_run_char, u64_chunk_len);
+            pstr_buffer->u64_size += u64_chunk_len;
+            u64_run_len -= u64_chunk_len;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Copy raw bytes into the output window, flushing it as many times as needed
+ * 
+ * @param[in out] pstr_window Output window to copy the bytes into
+ * @param[in] pc_data Bytes to copy
+ * @param[in] u64_data_size Number of bytes to copy
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 output_window_append(tstr_output_window *pstr_window, const char *pc_data, u64 u64_data_size)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_byte_buffer *pstr_buffer = &pstr_window->str_buffer;
+
+    while (0 != u64_data_size)
+    {
+        if (pstr_buffer->u64_size == pstr_window->u64_window_size)
+        {
+            s32_ret_val = output_window_flush(pstr_window);
+            ERROR_BREAK(s32_ret_val);
+        }
+
+        u64 u64_chunk_size = pstr_window->u64_window_size - pstr_buffer->u64_size;
+
+        if (u64_chunk_size > u64_data_size)
+        {
+            u64_chunk_size = u64_data_size;
+        }
+
+        memcpy(&pstr_buffer->pc_data[pstr_buffer->u64_size], pc_data, u64_chunk_size);
+        pstr_buffer->u64_size += u64_chunk_size;
+        pc_data += u64_chunk_size;
+        u64_data_size -= u64_chunk_size;
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define CHECKSUM_X86
+#endif
+
+#include "../header_files/utils.h"
+#include "../header_files/checksum.h"
+
+
+// Reflected CRC32C polynomial
+#define CRC32C_POLYNOMIAL    (0x82F63B78u)
+
+// Stripe sizes of the three interleaved lanes of the crc32 instruction kernel, powers of two
+#define CRC32C_LONG_BYTES    (8192u)
+#define CRC32C_SHORT_BYTES   (256u)
+
+// Signature shared by the CRC32C kernels, the CRC is pre and post inverted by the caller
+typedef u32 (*tpf_crc32c_kernel)(u32 u32_crc, const u8 *pu8_data, u64 u64_data_size);
+
+static u32 u32_crc32c_slice8(u32 u32_crc, const u8 *pu8_data, u64 u64_data_size);
+
+// Slicing-by-8 tables, gau32_crc32c_table[k][b] is the CRC of byte b followed by k zero bytes
+static u32 gau32_crc32c_table[8][256];
+// Operators that append CRC32C_LONG_BYTES or CRC32C_SHORT_BYTES zero bytes to a CRC register, byte by byte
+static u32 gau32_crc32c_long[4][256];
+static u32 gau32_crc32c_short[4][256];
+static pthread_once_t gstr_crc32c_once = PTHREAD_ONCE_INIT;
+// Selected kernel, set with the tables
+static tpf_crc32c_kernel gpf_crc32c_kernel = u32_crc32c_slice8;
+
+
+/**
+ * @brief Multiply a 32x32 GF(2) matrix by a vector
+ * 
+ * @param[in] pu32_matrix Columns of the matrix
+ * @param[in] u32_vector Vector
+ * @return u32 Product
+ */
+static u32 u32_crc32c_matrix_times(const u32 *pu32_matrix, u32 u32_vector)
+{
+    u32 u32_sum = 0;
+
+    for (; 0 != u32_vector; u32_vector >>= 1, pu32_matrix++)
+    {
+        if (0 != (u32_vector & 1u))
+        {
+            u32_sum ^= *pu32_matrix;
+        }
+    }
+
+    return u32_sum;
+}
+
+/**
+ * @brief Square a 32x32 GF(2) matrix
+ * 
+ * @param[in out] pu32_square Columns of the square
+ * @param[in] pu32_matrix Columns of the matrix
+ * @return void
+ */
+static void crc32c_matrix_square(u32 *pu32_square, const u32 *pu32_matrix)
+{
+    for (u32 n = 0; n < 32; n++)
+    {
+        pu32_square[n] = u32_crc32c_matrix_times(pu32_matrix, pu32_matrix[n]);
+    }
+}
+
+/**
+ * @brief Build the tables of the operator that appends u32_zero_count zero bytes to a CRC register
+ * 
+ * @param[in] u32_zero_count Number of zero bytes, a power of two
+ * @param[in out] au32_table Byte tables of the operator
+ * @return void
+ */
+static void crc32c_build_zeros_table(const u32 u32_zero_count, u32 au32_table[4][256])
+{
+    u32 au32_even[32];
+    u32 au32_odd[32];
+    u32 *pu32_op = au32_even;
+
+    // Operator of one zero bit, then squared to two and four zero bits
+    au32_odd[0] = CRC32C_POLYNOMIAL;
+
+    for (u32 n = 1; n < 32; n++)
+    {
+        au32_odd[n] = 1u << (n - 1);
+    }
+
+    crc32c_matrix_square(au32_even, au32_odd);
+    crc32c_matrix_square(au32_odd, au32_even);
+
+    // Every square doubles the zeros, the first one gives one zero byte
+    for (u32 u32_left = u32_zero_count; 0 != u32_left; u32_left >>= 1)
+    {
+        if (au32_even == pu32_op)
+        {
+            crc32c_matrix_square(au32_even, au32_odd);
+            pu32_op = (1u == u32_left) ? au32_even : au32_odd;
+        }
+        else
+        {
+            crc32c_matrix_square(au32_odd, au32_even);
+            pu32_op = (1u == u32_left) ? au32_odd : au32_even;
+        }
+    }
+
+    for (u32 n = 0; n < 256; n++)
+    {
+        au32_table[0][n] = u32_crc32c_matrix_times(pu32_op, n);
+        au32_table[1][n] = u32_crc32c_matrix_times(pu32_op, n << 8);
+        au32_table[2][n] = u32_crc32c_matrix_times(pu32_op, n << 16);
+        au32_table[3][n] = u32_crc32c_matrix_times(pu32_op, n << 24);
+    }
+}
+
+/**
+ * @brief Append zero bytes to a CRC register with a table of crc32c_build_zeros_table()
+ * 
+ * @param[in] au32_table Byte tables of the operator
+ * @param[in] u32_crc CRC register
+ * @return u32 CRC register after the zero bytes
+ */
+static inline u32 u32_crc32c_shift(u32 au32_table[4][256], const u32 u32_crc)
+{
+    return au32_table[0][u32_crc & 0xFFu] ^ au32_table[1][(u32_crc >> 8) & 0xFFu] ^
+           au32_table[2][(u32_crc >> 16) & 0xFFu] ^ au32_table[3][u32_crc >> 24];
+}
+
+/**
+ * @brief Slicing-by-8 CRC32C kernel, eight bytes per step with little-endian loads
+ * 
+ * @param[in] u32_crc Inverted CRC register
+ * @param[in] pu8_data Data to add
+ * @param[in] u64_data_size Size of the data
+ * @return u32 Inverted CRC register after the data
+ */
+static u32 u32_crc32c_slice8(u32 u32_crc, const u8 *pu8_data, u64 u64_data_size)
+{
+    u64 i = 0;
+
+    for (; (i + 8) <= u64_data_size; i += 8)
+    {
+        u32 u32_low = 0;
+        u32 u32_high = 0;
+
+        memcpy(&u32_low, &pu8_data[i], sizeof(u32_low));
+        memcpy(&u32_high, &pu8_data[i + 4], sizeof(u32_high));
+
+        u32_low ^= u32_crc;
+
+        u32_crc = gau32_crc32c_table[7][u32_low & 0xFFu] ^ gau32_crc32c_table[6][(u32_low >> 8) & 0xFFu] ^
+                  gau32_crc32c_table[5][(u32_low >> 16) & 0xFFu] ^ gau32_crc32c_table[4][u32_low >> 24] ^
+                  gau32_crc32c_table[3][u32_high & 0xFFu] ^ gau32_crc32c_table[2][(u32_high >> 8) & 0xFFu] ^
+                  gau32_crc32c_table[1][(u32_high >> 16) & 0xFFu] ^ gau32_crc32c_table[0][u32_high >> 24];
+    }
+
+    for (; i < u64_data_size; i++)
+    {
+        u32_crc = (u32_crc >> 8) ^ gau32_crc32c_table[0][(u32_crc ^ pu8_data[i]) & 0xFFu];
+    }
+
+    return u32_crc;
+}
+
+#ifdef CHECKSUM_X86
+
+/**
+ * @brief SSE4.2 CRC32C kernel
+ * 
+ * The crc32 instruction has a latency of three cycles and a throughput of one, so long
+ * inputs run three lanes over adjacent stripes and merge them by appending the zeros
+ * of the stripes that follow each lane.
+ * 
+ * @param[in] u32_crc Inverted CRC register
+ * @param[in] pu8_data Data to add
+ * @param[in] u64_data_size Size of the data
+ * @return u32 Inverted CRC register after the data
+ */
+__attribute__((target("sse4.2")))
+static u32 u32_crc32c_sse42(u32 u32_crc, const u8 *pu8_data, u64 u64_data_size)
+{
+    u64 u64_crc0 = u32_crc;
+
+    while (u64_data_size >= (3u * CRC32C_LONG_BYTES))
+    {
+        u64 u64_crc1 = 0;
+        u64 u64_crc2 = 0;
+
+        for (u64 i = 0; i < CRC32C_LONG_BYTES; i += 8)
+        {
+            u64 au64_word[3];
+
+            memcpy(&au64_word[0], &pu8_data[i], sizeof(u64));
+            memcpy(&au64_word[1], &pu8_data[i + CRC32C_LONG_BYTES], sizeof(u64));
+            memcpy(&au64_word[2], &pu8_data[i + (2u * CRC32C_LONG_BYTES)], sizeof(u64));
+
+            u64_crc0 = _mm_crc32_u64(u64_crc0, au64_word[0]);
+            u64_crc1 = _mm_crc32_u64(u64_crc1, au64_word[1]);
+            u64_crc2 = _mm_crc32_u64(u64_crc2, au64_word[2]);
+        }
+
+        u64_crc0 = u32_crc32c_shift(gau32_crc32c_long, (u32)u64_crc0) ^ u64_crc1;
+        u64_crc0 = u32_crc32c_shift(gau32_crc32c_long, (u32)u64_crc0) ^ u64_crc2;
+        pu8_data += 3u * CRC32C_LONG_BYTES;
+        u64_data_size -= 3u * CRC32C_LONG_BYTES;
+    }
+
+    while (u64_data_size >= (3u * CRC32C_SHORT_BYTES))
+    {
+        u64 u64_crc1 = 0;
+        u64 u64_crc2 = 0;
+
+        for (u64 i = 0; i < CRC32C_SHORT_BYTES; i += 8)
+        {
+            u64 au64_word[3];
+
+            memcpy(&au64_word[0], &pu8_data[i], sizeof(u64));
+            memcpy(&au64_word[1], &pu8_data[i + CRC32C_SHORT_BYTES], sizeof(u64));
+            memcpy(&au64_word[2], &pu8_data[i + (2u * CRC32C_SHORT_BYTES)], sizeof(u64));
+
+            u64_crc0 = _mm_crc32_u64(u64_crc0, au64_word[0]);
+            u64_crc1 = _mm_crc32_u64(u64_crc1, au64_word[1]);
+            u64_crc2 = _mm_crc32_u64(u64_crc2, au64_word[2]);
+        }
+
+        u64_crc0 = u32_crc32c_shift(gau32_crc32c_short, (u32)u64_crc0) ^ u64_crc1;
+        u64_crc0 = u32_crc32c_shift(gau32_crc32c_short, (u32)u64_crc0) ^ u64_crc2;
+        pu8_data += 3u * CRC32C_SHORT_BYTES;
+        u64_data_size -= 3u * CRC32C_SHORT_BYTES;
+    }
+
+    for (; u64_data_size >= 8; u64_data_size -= 8, pu8_data += 8)
+    {
+        u64 u64_word = 0;
+
+        memcpy(&u64_word, pu8_data, sizeof(u64_word));
+        u64_crc0 = _mm_crc32_u64(u64_crc0, u64_word);
+    }
+
+    for (; 0 != u64_data_size; u64_data_size--, pu8_data++)
+    {
+        u64_crc0 = _mm_crc32_u8((u32)u64_crc0, *pu8_data);
+    }
+
+    return (u32)u64_crc0;
+}
+
+#endif
+
+/**
+ * @brief Fill the lookup tables and select the CRC32C kernel supported by the CPU (cpuid)
+ * 
+ * @return void
+ */
+static void crc32c_build_tables(void)
+{
+    for (u32 u32_byte = 0; u32_byte < 256; u32_byte++)
+    {
+        u32 u32_crc = u32_byte;
+
+        for (u8 u8_bit = 0; u8_bit < 8; u8_bit++)
+        {
+            u32_crc = (u32_crc >> 1) ^ ((0u - (u32_crc & 1u)) & CRC32C_POLYNOMIAL);
+        }
+
+        gau32_crc32c_table[0][u32_byte] = u32_crc;
+    }
+
+    for (u32 u32_byte = 0; u32_byte < 256; u32_byte++)
+    {
+        for (u8 k = 1; k < 8; k++)
+        {
+            u32 u32_prev = gau32_crc32c_table[k - 1][u32_byte];
+
+            gau32_crc32c_table[k][u32_byte] = (u32_prev >> 8) ^ gau32_crc32c_table[0][u32_prev & 0xFFu];
+        }
+    }
+
+    crc32c_build_zeros_table(CRC32C_LONG_BYTES, gau32_crc32c_long);
+    crc32c_build_zeros_table(CRC32C_SHORT_BYTES, gau32_crc32c_short);
+
+#ifdef CHECKSUM_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        gpf_crc32c_kernel = u32_crc32c_sse42;
+    }
+#endif
+
+    LOG("CRC32C kernel: %s", (u32_crc32c_slice8 == gpf_crc32c_kernel) ? "slicing-by-8" : "sse4.2");
+}
+
+/**
+ * @brief Build the CRC32C lookup tables, called once at startup
+ * 
+ * Calling it is optional, the tables are built on first use otherwise.
+ * 
+ * @return void
+ */
+void checksum_init(void)
+{
+    pthread_once(&gstr_crc32c_once, crc32c_build_tables);
+}
+
+/**
+ * @brief Extend a CRC32C with more data
+ * 
+ * crc32c_update(crc32c_update(CRC32C_INITIAL_VALUE, a), b) equals the CRC32C of a followed by b.
+ * 
+ * @param[in] u32_crc CRC32C of the data before pc_data, CRC32C_INITIAL_VALUE to start
+ * @param[in] pc_data Data to add
+ * @param[in] u64_data_size Size of the data
+ * @return u32 CRC32C of the data seen so far
+ */
+u32 crc32c_update(u32 u32_crc, const char *pc_data, const u64 u64_data_size)
+{
+    checksum_init();
+
+    return ~gpf_crc32c_kernel(~u32_crc, (const u8 *)pc_data, u64_data_size);
+}
\ No newline at end of file
@@ -0,0 +1,975 @@
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/buffer.h"
+#include "../header_files/rle.h"
+#include "../header_files/rle2.h"
+#include "../header_files/container.h"
+#include "../header_files/codec.h"
+#include "../header_files/codec_registry.h"
+
+
+/**
+ * @brief Initialize a sequential decoder without allocating memory
+ * 
+ * @param[in out] pstr_decoder Decoder to initialize
+ * @return void
+ */
+void stream_decoder_init(tstr_stream_decoder *pstr_decoder)
+{
+    if (NULL != pstr_decoder)
+    {
+        // Text format, decoders waiting for a symbol
+        memset(pstr_decoder, 0, sizeof(*pstr_decoder));
+        container_reader_init(&pstr_decoder->str_block_reader);
+    }
+}
+
+/**
+ * @brief Return a decoder to its initial state for the next stream, its buffers are kept
+ * 
+ * @param[in out] pstr_decoder Decoder to reset
+ * @return void
+ */
+void stream_decoder_reset(tstr_stream_decoder *pstr_decoder)
+{
+    if (NULL != pstr_decoder)
+    {
+        tstr_block_reader str_block_reader = pstr_decoder->str_block_reader;
+
+        memset(pstr_decoder, 0, sizeof(*pstr_decoder));
+
+        pstr_decoder->str_block_reader = str_block_reader;
+        container_reader_reset(&pstr_decoder->str_block_reader);
+    }
+}
+
+/**
+ * @brief Decode the next chunk of a compressed stream
+ * 
+ * The first chunk selects the format from the magic number, it must hold the whole
+ * .rle2 header unless the input is shorter.
+ * 
+ * @param[in out] pstr_decoder Sequential decoder state
+ * @param[in] pc_input_data Compressed data
+ * @param[in] u64_input_data_size Size of the compressed data
+ * @param[in out] pstr_window Output window the decompressed data is written through, reserved on the first chunk
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 stream_decoder_update(tstr_stream_decoder *pstr_decoder, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    u64 u64_token_offset = 0;
+
+    if (0 == pstr_decoder->u64_input_size)
+    {
+        u64 u64_out_window_size = DATA_WINDOW_SIZE_BYTES;
+
+        if (true == rle2_has_magic(pc_input_data, u64_input_data_size))
+        {
+            s32_ret_val = rle2_read_header(pc_input_data, u64_input_data_size, &pstr_decoder->str_rle2_header);
+
+            if ((SUCCESS_STATUS == s32_ret_val) && (NULL == codec_registry_get(pstr_decoder->str_rle2_header.u8_codec)))
+            {
+                LOG_ERROR("Stream was written with unknown codec %u.", pstr_decoder->str_rle2_header.u8_codec);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            }
+
+            pstr_decoder->enu_format = FILE_FORMAT_RLE2;
+            u64_token_offset = RLE2_HEADER_SIZE;
+
+            // LZ77 blocks are decoded whole in the window, their matches reach back into the block
+            if (RLE2_VERSION_BLOCKS == pstr_decoder->str_rle2_header.u8_version)
+            {
+                u64_out_window_size = CONTAINER_BLOCK_SIZE_BYTES;
+            }
+
+            // Small files get an output window of exactly their original size
+            if ((0 == (pstr_decoder->str_rle2_header.u8_flags & RLE2_FLAG_SIZE_UNKNOWN)) && (0 != pstr_decoder->str_rle2_header.u64_original_size) &&
+                (pstr_decoder->str_rle2_header.u64_original_size < u64_out_window_size))
+            {
+                u64_out_window_size = pstr_decoder->str_rle2_header.u64_original_size;
+            }
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = output_window_reserve(pstr_window, u64_out_window_size);
+        }
+    }
+
+    if (SUCCESS_STATUS == s32_ret_val)
+    {
+        pstr_decoder->u64_input_size += u64_input_data_size;
+
+        if ((FILE_FORMAT_RLE2 == pstr_decoder->enu_format) && (RLE2_VERSION_BLOCKS == pstr_decoder->str_rle2_header.u8_version))
+        {
+            // A header alone leaves nothing to decode
+            if (u64_token_offset < u64_input_data_size)
+            {
+                s32_ret_val = container_reader_update(&pstr_decoder->str_block_reader, &pc_input_data[u64_token_offset], u64_input_data_size - u64_token_offset, pstr_window);
+            }
+        }
+        else if (FILE_FORMAT_RLE2 == pstr_decoder->enu_format)
+        {
+            if (u64_token_offset < u64_input_data_size)
+            {
+                s32_ret_val = rle2_decompress(&pstr_decoder->str_rle2_decoder, &pc_input_data[u64_token_offset], u64_input_data_size - u64_token_offset, pstr_window);
+            }
+        }
+        else
+        {
+            s32_ret_val = rle_decompress(&pstr_decoder->str_rle_decoder, pc_input_data, u64_input_data_size, pstr_window);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check the end of a compressed stream and flush the rest of the output
+ * 
+ * @param[in out] pstr_decoder Sequential decoder state
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 stream_decoder_finish(tstr_stream_decoder *pstr_decoder, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    do
+    {
+        if (0 == pstr_decoder->u64_input_size)
+        {
+            LOG_ERROR("Input file is empty.");
+            s32_ret_val = ERROR_EMPTY_FILE;
+            break;
+        }
+
+        if (FILE_FORMAT_RLE2 == pstr_decoder->enu_format)
+        {
+            if (RLE2_VERSION_BLOCKS == pstr_decoder->str_rle2_header.u8_version)
+            {
+                s32_ret_val = container_reader_finish(&pstr_decoder->str_block_reader, pstr_window);
+            }
+            else
+            {
+                s32_ret_val = rle2_decompress_flush(&pstr_decoder->str_rle2_decoder, pstr_window);
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            if ((0 == (pstr_decoder->str_rle2_header.u8_flags & RLE2_FLAG_SIZE_UNKNOWN)) &&
+                (pstr_window->u64_total_size != pstr_decoder->str_rle2_header.u64_original_size))
+            {
+                LOG_ERROR("Decompressed size %lu does not match the original size %lu.", pstr_window->u64_total_size, pstr_decoder->str_rle2_header.u64_original_size);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+        }
+        else
+        {
+            s32_ret_val = rle_decompress_flush(&pstr_decoder->str_rle_decoder, pstr_window);
+            ERROR_BREAK(s32_ret_val);
+        }
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Release the decoder memory
+ * 
+ * @param[in out] pstr_decoder Decoder to release
+ * @return void
+ */
+void stream_decoder_free(tstr_stream_decoder *pstr_decoder)
+{
+    if (NULL != pstr_decoder)
+    {
+        container_reader_free(&pstr_decoder->str_block_reader);
+    }
+}
+
+/**
+ * @brief Set the window limit that keeps the decoded data not pulled yet under the output limit
+ * 
+ * @param[in out] pstr_context Context whose output was pulled, or whose stream starts
+ * @return void
+ */
+static void codec_output_limit_apply(tstr_codec_context *pstr_context)
+{
+    tstr_output_window *pstr_window = &pstr_context->str_window;
+
+    pstr_window->u64_total_limit = ((0 != pstr_context->u64_output_limit) && (NULL != pstr_window->pstr_sink)) ?
+                                   (pstr_window->u64_total_size + pstr_context->u64_output_limit) : 0;
+}
+
+/**
+ * @brief Initialize a codec context without allocating memory
+ * 
+ * @param[in out] pstr_context Context to initialize
+ * @param[in] enu_format Format written by the compression calls
+ * @return void
+ */
+void codec_context_init(tstr_codec_context *pstr_context, const tenu_file_format enu_format)
+{
+    if (NULL != pstr_context)
+    {
+        memset(pstr_context, 0, sizeof(*pstr_context));
+
+        pstr_context->enu_format = enu_format;
+        pstr_context->enu_block_codec = BLOCK_CODEC_RLE2;
+        pstr_context->u64_compressed_offset = RLE2_HEADER_SIZE;
+
+        byte_buffer_init(&pstr_context->str_raw);
+        byte_buffer_init(&pstr_context->str_index);
+        byte_buffer_init(&pstr_context->str_output);
+        byte_buffer_init(&pstr_context->str_window.str_buffer);
+        stream_decoder_init(&pstr_context->str_decoder);
+
+        // Decoded data leaves the window into the output buffer instead of a file
+        pstr_context->str_window.pstr_sink = &pstr_context->str_output;
+    }
+}
+
+/**
+ * @brief Select the coding of the .rle2 blocks written by the compression calls
+ * 
+ * @param[in out] pstr_context Context to configure, takes effect from the next block
+ * @param[in] enu_codec Coding of the blocks (BLOCK_CODEC_RLE2 after codec_context_init())
+ * @return void
+ */
+void codec_context_set_block_codec(tstr_codec_context *pstr_context, const tenu_block_codec enu_codec)
+{
+    if (NULL != pstr_context)
+    {
+        pstr_context->enu_block_codec = enu_codec;
+    }
+}
+
+/**
+ * @brief Select how many LZ77 match candidates the compression calls compare per position
+ * 
+ * @param[in out] pstr_context Context to configure, takes effect from the next block
+ * @param[in] u32_search_depth Candidates per position, 0 for the codec default (after codec_context_init())
+ * @return void
+ */
+void codec_context_set_search_depth(tstr_codec_context *pstr_context, const u32 u32_search_depth)
+{
+    if (NULL != pstr_context)
+    {
+        pstr_context->u32_search_depth = u32_search_depth;
+    }
+}
+
+/**
+ * @brief Send the data decoded by the decompression calls to a writer instead of codec_pull()
+ * 
+ * The window is handed to the writer whenever it fills up, so memory stays bounded however
+ * far a chunk expands. codec_decompress_flush() hands over the rest.
+ * 
+ * @param[in out] pstr_context Context to configure, set before the first chunk of a stream
+ * @param[in out] pstr_writer Writer of the decoded data, NULL to collect it with codec_pull() again
+ * @return void
+ */
+void codec_context_set_writer(tstr_codec_context *pstr_context, struct tstr_async_writer *pstr_writer)
+{
+    if (NULL != pstr_context)
+    {
+        pstr_context->str_window.pstr_writer = pstr_writer;
+        pstr_context->str_window.pstr_sink = (NULL == pstr_writer) ? &pstr_context->str_output : NULL;
+
+        codec_output_limit_apply(pstr_context);
+    }
+}
+
+/**
+ * @brief Bound the decoded data the decompression calls hold until it is collected with codec_pull()
+ * 
+ * A call that would take the data held past the limit fails with ERROR_INVALID_LENGTH, the stream
+ * cannot be continued afterwards. The limit does not apply to a context with a writer.
+ * 
+ * @param[in out] pstr_context Context to configure
+ * @param[in] u64_output_limit Decoded bytes held at most besides the output window, 0 for no limit (after codec_context_init())
+ * @return void
+ */
+void codec_context_set_output_limit(tstr_codec_context *pstr_context, const u64 u64_output_limit)
+{
+    if (NULL != pstr_context)
+    {
+        pstr_context->u64_output_limit = u64_output_limit;
+
+        codec_output_limit_apply(pstr_context);
+    }
+}
+
+/**
+ * @brief Drop the stream in progress so the context can start a new one, its buffers are kept
+ * 
+ * @param[in out] pstr_context Context to reset
+ * @return void
+ */
+void codec_context_reset(tstr_codec_context *pstr_context)
+{
+    if (NULL != pstr_context)
+    {
+        pstr_context->str_encoder.u64_run_len = 0;
+        pstr_context->str_raw.u64_size = 0;
+        pstr_context->str_index.u64_size = 0;
+        pstr_context->u64_raw_offset = 0;
+        pstr_context->u64_compressed_offset = RLE2_HEADER_SIZE;
+        pstr_context->b_header_written = false;
+
+        stream_decoder_reset(&pstr_context->str_decoder);
+        pstr_context->str_window.str_buffer.u64_size = 0;
+        pstr_context->str_window.u64_total_size = 0;
+
+        pstr_context->str_output.u64_size = 0;
+        codec_output_limit_apply(pstr_context);
+    }
+}
+
+/**
+ * @brief Release the context memory
+ * 
+ * @param[in out] pstr_context Context to release
+ * @return void
+ */
+void codec_context_free(tstr_codec_context *pstr_context)
+{
+    if (NULL != pstr_context)
+    {
+        byte_buffer_free(&pstr_context->str_raw);
+        byte_buffer_free(&pstr_context->str_index);
+        byte_buffer_free(&pstr_context->str_output);
+        byte_buffer_free(&pstr_context->str_window.str_buffer);
+        stream_decoder_free(&pstr_context->str_decoder);
+    }
+}
+
+/**
+ * @brief Worst case size of the output of codec_compress_buffer()
+ * 
+ * A block shorter than CONTAINER_BLOCK_SIZE_BYTES is always followed by one that ends at
+ * least a full block size after its start, so n bytes are cut into at most 2 * n / size + 2 blocks.
+ * A run of n bytes takes at most 2 * n bytes, split or not.
+ * 
+ * @param[in] enu_format Format of the output
+ * @param[in] u64_input_data_size Size of the input data
+ * @return u64 Output buffer size that holds any input of that size
+ */
+u64 codec_compress_bound(const tenu_file_format enu_format, const u64 u64_input_data_size)
+{
+    u64 u64_bound = RLE_COMPRESS_WINDOW_BOUND(u64_input_data_size);
+
+    if (FILE_FORMAT_RLE2 == enu_format)
+    {
+        u64 u64_max_block_count = (2u * (u64_input_data_size / CONTAINER_BLOCK_SIZE_BYTES)) + 2u;
+
+        // Every block may also carry one token beyond the 2 bytes per byte of its data
+        u64_bound = RLE2_HEADER_SIZE + (2u * u64_input_data_size) + CONTAINER_TRAILER_SIZE(0) +
+                    (u64_max_block_count * (CONTAINER_BLOCK_HEADER_SIZE + CONTAINER_BLOCK_CHECKSUM_SIZE + CONTAINER_INDEX_ENTRY_SIZE + 1u + RLE2_VARINT_MAX_SIZE));
+    }
+
+    return u64_bound;
+}
+
+/**
+ * @brief Code one .rle2 block at the end of the output and record it in the block index
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in] pc_raw Raw data of the block
+ * @param[in] u64_raw_size Size of the raw data (at most CONTAINER_BLOCK_SIZE_BYTES)
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_emit_block(tstr_codec_context *pstr_context, const char *pc_raw, const u64 u64_raw_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_byte_buffer *pstr_output = &pstr_context->str_output;
+    tstr_block_index_entry str_entry = {0};
+    char ac_entry[CONTAINER_INDEX_ENTRY_SIZE];
+    u64 u64_block_size = 0;
+
+    do
+    {
+        s32_ret_val = byte_buffer_reserve(pstr_output, pstr_output->u64_size + CONTAINER_BLOCK_BOUND(u64_raw_size));
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = container_encode_block(pstr_context->enu_block_codec, pstr_context->u32_search_depth, pc_raw, (u32)u64_raw_size, &pstr_output->pc_data[pstr_output->u64_size], &u64_block_size);
+        ERROR_BREAK(s32_ret_val);
+
+        str_entry.u64_compressed_offset = pstr_context->u64_compressed_offset;
+        str_entry.u64_raw_offset = pstr_context->u64_raw_offset;
+        str_entry.u32_compressed_size = (u32)(u64_block_size - CONTAINER_BLOCK_HEADER_SIZE);
+        str_entry.u32_raw_size = (u32)u64_raw_size;
+
+        container_write_index_entry(&str_entry, ac_entry);
+
+        s32_ret_val = byte_buffer_append(&pstr_context->str_index, ac_entry, sizeof(ac_entry));
+        ERROR_BREAK(s32_ret_val);
+
+        pstr_output->u64_size += u64_block_size;
+        pstr_context->u64_compressed_offset += u64_block_size;
+        pstr_context->u64_raw_offset += u64_raw_size;
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Write the .rle2 stream header at the start of the output, once per stream
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_emit_header(tstr_codec_context *pstr_context)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    if (false == pstr_context->b_header_written)
+    {
+        // A stream does not know its size up front
+        tstr_rle2_header str_header = {RLE2_VERSION, RLE2_FLAG_SIZE_UNKNOWN, 0, (u8)pstr_context->enu_block_codec};
+        tstr_byte_buffer *pstr_output = &pstr_context->str_output;
+
+        s32_ret_val = byte_buffer_reserve(pstr_output, pstr_output->u64_size + RLE2_HEADER_SIZE);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = rle2_write_header(&str_header, &pstr_output->pc_data[pstr_output->u64_size]);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_output->u64_size += RLE2_HEADER_SIZE;
+            pstr_context->b_header_written = true;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Compress one message from buffer to buffer
+ * 
+ * The output is coded in place, .rle2 output carries the original size in its header.
+ * An empty message compresses to an empty .rle stream or to an .rle2 stream without blocks.
+ * 
+ * @param[in out] pstr_context Context lending its scratch buffers, any stream in progress is dropped
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the compressed data
+ * @param[in] u64_output_capacity Size of the output buffer, at least codec_compress_bound()
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data, or the required capacity on ERROR_INVALID_LENGTH
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_buffer(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size,
+                          char *pc_output_data, const u64 u64_output_capacity, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context || (NULL == pc_input_data && 0 != u64_input_data_size) || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_output_capacity < codec_compress_bound(pstr_context->enu_format, u64_input_data_size))
+    {
+        *pu64_output_data_size = codec_compress_bound(pstr_context->enu_format, u64_input_data_size);
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        u64 u64_write_idx = 0;
+        u64 u64_coded_size = 0;
+
+        codec_context_reset(pstr_context);
+
+        do
+        {
+            if (FILE_FORMAT_RLE2 == pstr_context->enu_format)
+            {
+                tstr_rle2_header str_header = {RLE2_VERSION, 0, u64_input_data_size, (u8)pstr_context->enu_block_codec};
+                u64 u64_block_start = 0;
+
+                s32_ret_val = rle2_write_header(&str_header, pc_output_data);
+                ERROR_BREAK(s32_ret_val);
+
+                u64_write_idx = RLE2_HEADER_SIZE;
+
+                // The message is the whole input, blocks are cut from it in place
+                while (u64_block_start < u64_input_data_size)
+                {
+                    u64 u64_block_end = container_cut_block(pc_input_data, u64_block_start, u64_input_data_size, true);
+                    tstr_block_index_entry str_entry = {u64_write_idx, u64_block_start, 0, (u32)(u64_block_end - u64_block_start)};
+                    char ac_entry[CONTAINER_INDEX_ENTRY_SIZE];
+
+                    s32_ret_val = container_encode_block(pstr_context->enu_block_codec, pstr_context->u32_search_depth, &pc_input_data[u64_block_start], str_entry.u32_raw_size, &pc_output_data[u64_write_idx], &u64_coded_size);
+                    ERROR_BREAK(s32_ret_val);
+
+                    str_entry.u32_compressed_size = (u32)(u64_coded_size - CONTAINER_BLOCK_HEADER_SIZE);
+                    container_write_index_entry(&str_entry, ac_entry);
+
+                    s32_ret_val = byte_buffer_append(&pstr_context->str_index, ac_entry, sizeof(ac_entry));
+                    ERROR_BREAK(s32_ret_val);
+
+                    u64_write_idx += u64_coded_size;
+                    u64_block_start = u64_block_end;
+                }
+                ERROR_BREAK(s32_ret_val);
+
+                u64_write_idx += container_write_trailer(pstr_context->str_index.pc_data, (u32)(pstr_context->str_index.u64_size / CONTAINER_INDEX_ENTRY_SIZE),
+                                                         u64_write_idx, &pc_output_data[u64_write_idx]);
+            }
+            else if (0 != u64_input_data_size)
+            {
+                s32_ret_val = rle_compress(&pstr_context->str_encoder, pc_input_data, u64_input_data_size, pc_output_data, &u64_write_idx);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = rle_compress_flush(&pstr_context->str_encoder, &pc_output_data[u64_write_idx], &u64_coded_size);
+                ERROR_BREAK(s32_ret_val);
+
+                u64_write_idx += u64_coded_size;
+            }
+
+            *pu64_output_data_size = u64_write_idx;
+            s32_ret_val = SUCCESS_STATUS;
+
+        } while (0);
+
+        // The context is left ready for a stream
+        codec_context_reset(pstr_context);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decompress one message from buffer to buffer, the format is detected
+ * 
+ * Decoding stops as soon as the output outgrows the buffer, so corrupt run lengths cannot
+ * make the context allocate more than the buffer size.
+ * 
+ * @param[in out] pstr_context Context lending its scratch buffers, any stream in progress is dropped
+ * @param[in] pc_input_data Compressed data
+ * @param[in] u64_input_data_size Size of the compressed data, 0 for an empty message
+ * @param[in out] pc_output_data Buffer to hold the decompressed data
+ * @param[in] u64_output_capacity Size of the output buffer
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the decompressed data, or the size decoded before stopping on ERROR_INVALID_LENGTH
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_buffer(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size,
+                            char *pc_output_data, const u64 u64_output_capacity, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context || (NULL == pc_input_data && 0 != u64_input_data_size) || (NULL == pc_output_data && 0 != u64_output_capacity) ||
+        NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_input_data_size)
+    {
+        *pu64_output_data_size = 0;
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        codec_context_reset(pstr_context);
+
+        // The window fails the flush that would take the output past the buffer, an empty buffer is checked after the decode
+        pstr_context->str_window.u64_total_limit = (0 != u64_output_capacity) ? u64_output_capacity : 1u;
+
+        do
+        {
+            s32_ret_val = stream_decoder_update(&pstr_context->str_decoder, pc_input_data, u64_input_data_size, &pstr_context->str_window);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = stream_decoder_finish(&pstr_context->str_decoder, &pstr_context->str_window);
+            ERROR_BREAK(s32_ret_val);
+
+            *pu64_output_data_size = pstr_context->str_output.u64_size;
+
+            if (pstr_context->str_output.u64_size > u64_output_capacity)
+            {
+                s32_ret_val = ERROR_INVALID_LENGTH;
+                break;
+            }
+
+            if (0 != pstr_context->str_output.u64_size)
+            {
+                memcpy(pc_output_data, pstr_context->str_output.pc_data, pstr_context->str_output.u64_size);
+            }
+
+        } while (0);
+
+        if (ERROR_INVALID_LENGTH == s32_ret_val)
+        {
+            *pu64_output_data_size = pstr_context->str_window.u64_total_size + pstr_context->str_window.str_buffer.u64_size;
+        }
+
+        // The context is left ready for a stream, with its own output limit
+        codec_context_reset(pstr_context);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Feed the next chunk of a stream to the compressor, the coded data is collected with codec_pull()
+ * 
+ * .rle2 data is coded a block at a time, a partial block waits for more input or a flush.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_push(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context || NULL == pc_input_data)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_input_data_size)
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else if (FILE_FORMAT_RLE2 == pstr_context->enu_format)
+    {
+        tstr_byte_buffer *pstr_raw = &pstr_context->str_raw;
+        u64 i = 0;
+
+        s32_ret_val = s32_codec_emit_header(pstr_context);
+
+        while ((SUCCESS_STATUS == s32_ret_val) && (i < u64_input_data_size))
+        {
+            u64 u64_copy_size = u64_input_data_size - i;
+
+            if ((0 == pstr_raw->u64_size) && (u64_copy_size >= CONTAINER_BLOCK_SIZE_BYTES))
+            {
+                // Whole blocks are coded straight from the input, only the tail is buffered
+                u64 u64_block_end = container_cut_block(pc_input_data, i, u64_input_data_size, false);
+
+                s32_ret_val = s32_codec_emit_block(pstr_context, &pc_input_data[i], u64_block_end - i);
+                i = u64_block_end;
+                continue;
+            }
+
+            if (u64_copy_size > (CONTAINER_BLOCK_SIZE_BYTES - pstr_raw->u64_size))
+            {
+                u64_copy_size = CONTAINER_BLOCK_SIZE_BYTES - pstr_raw->u64_size;
+            }
+
+            s32_ret_val = byte_buffer_append(pstr_raw, &pc_input_data[i], u64_copy_size);
+            ERROR_BREAK(s32_ret_val);
+
+            i += u64_copy_size;
+
+            if (CONTAINER_BLOCK_SIZE_BYTES == pstr_raw->u64_size)
+            {
+                // The last run of a full buffer may continue in the next chunk
+                u64 u64_block_end = container_cut_block(pstr_raw->pc_data, 0, pstr_raw->u64_size, false);
+
+                s32_ret_val = s32_codec_emit_block(pstr_context, pstr_raw->pc_data, u64_block_end);
+                ERROR_BREAK(s32_ret_val);
+
+                memmove(pstr_raw->pc_data, &pstr_raw->pc_data[u64_block_end], pstr_raw->u64_size - u64_block_end);
+                pstr_raw->u64_size -= u64_block_end;
+            }
+        }
+    }
+    else
+    {
+        tstr_byte_buffer *pstr_output = &pstr_context->str_output;
+        u64 u64_coded_size = 0;
+
+        s32_ret_val = byte_buffer_reserve(pstr_output, pstr_output->u64_size + RLE_COMPRESS_WINDOW_BOUND(u64_input_data_size));
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = rle_compress(&pstr_context->str_encoder, pc_input_data, u64_input_data_size, &pstr_output->pc_data[pstr_output->u64_size], &u64_coded_size);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_output->u64_size += u64_coded_size;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Code everything pushed so far, the stream can be continued afterwards
+ * 
+ * The pending text run is emitted and .rle2 data is closed in a short block. Runs split
+ * by a flush decode to the same data.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_flush(tstr_codec_context *pstr_context)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (FILE_FORMAT_RLE2 == pstr_context->enu_format)
+    {
+        s32_ret_val = SUCCESS_STATUS;
+
+        // The buffer never holds more than a block, it goes out whole
+        if (0 != pstr_context->str_raw.u64_size)
+        {
+            s32_ret_val = s32_codec_emit_block(pstr_context, pstr_context->str_raw.pc_data, pstr_context->str_raw.u64_size);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_context->str_raw.u64_size = 0;
+        }
+    }
+    else
+    {
+        tstr_byte_buffer *pstr_output = &pstr_context->str_output;
+        u64 u64_coded_size = 0;
+
+        s32_ret_val = byte_buffer_reserve(pstr_output, pstr_output->u64_size + RLE_COMPRESS_WINDOW_BOUND(0));
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = rle_compress_flush(&pstr_context->str_encoder, &pstr_output->pc_data[pstr_output->u64_size], &u64_coded_size);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_output->u64_size += u64_coded_size;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief End the stream, .rle2 streams get their END block, block index and footer
+ * 
+ * The header of an .rle2 stream keeps the size unknown flag. The context can start a
+ * new stream once the output is pulled.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_compress_finish(tstr_codec_context *pstr_context)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    do
+    {
+        s32_ret_val = codec_compress_flush(pstr_context);
+        ERROR_BREAK(s32_ret_val);
+
+        if (FILE_FORMAT_RLE2 == pstr_context->enu_format)
+        {
+            tstr_byte_buffer *pstr_output = &pstr_context->str_output;
+            u32 u32_block_count = (u32)(pstr_context->str_index.u64_size / CONTAINER_INDEX_ENTRY_SIZE);
+
+            s32_ret_val = s32_codec_emit_header(pstr_context);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = byte_buffer_reserve(pstr_output, pstr_output->u64_size + CONTAINER_TRAILER_SIZE(u32_block_count));
+            ERROR_BREAK(s32_ret_val);
+
+            pstr_output->u64_size += container_write_trailer(pstr_context->str_index.pc_data, u32_block_count, pstr_context->u64_compressed_offset,
+                                                             &pstr_output->pc_data[pstr_output->u64_size]);
+        }
+
+        // Output not pulled yet stays, the next stream starts from scratch
+        pstr_context->str_encoder.u64_run_len = 0;
+        pstr_context->str_index.u64_size = 0;
+        pstr_context->u64_raw_offset = 0;
+        pstr_context->u64_compressed_offset = RLE2_HEADER_SIZE;
+        pstr_context->b_header_written = false;
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Feed the next chunk of a compressed stream to the decompressor, the decoded data is collected with codec_pull()
+ * 
+ * Chunks may be cut anywhere, tokens and blocks straddling them are completed by the next chunk.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in] pc_input_data Compressed data
+ * @param[in] u64_input_data_size Size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_push(tstr_codec_context *pstr_context, const char *pc_input_data, const u64 u64_input_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context || NULL == pc_input_data)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        tstr_byte_buffer *pstr_raw = &pstr_context->str_raw;
+        u64 u64_offset = 0;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        // The format is detected once the whole .rle2 header is in
+        if (0 == pstr_context->str_decoder.u64_input_size)
+        {
+            // The total of the stream before is kept until the next one starts, for writer contexts
+            if (0 == pstr_raw->u64_size)
+            {
+                pstr_context->str_window.u64_total_size = 0;
+                codec_output_limit_apply(pstr_context);
+            }
+
+            u64_offset = RLE2_HEADER_SIZE - pstr_raw->u64_size;
+
+            if (u64_offset > u64_input_data_size)
+            {
+                u64_offset = u64_input_data_size;
+            }
+
+            s32_ret_val = byte_buffer_append(pstr_raw, pc_input_data, u64_offset);
+
+            if ((SUCCESS_STATUS == s32_ret_val) && (RLE2_HEADER_SIZE == pstr_raw->u64_size))
+            {
+                s32_ret_val = stream_decoder_update(&pstr_context->str_decoder, pstr_raw->pc_data, pstr_raw->u64_size, &pstr_context->str_window);
+                pstr_raw->u64_size = 0;
+            }
+        }
+
+        if ((SUCCESS_STATUS == s32_ret_val) && (u64_offset < u64_input_data_size))
+        {
+            s32_ret_val = stream_decoder_update(&pstr_context->str_decoder, &pc_input_data[u64_offset], u64_input_data_size - u64_offset, &pstr_context->str_window);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Hand out the part of the last text run known so far, for live streams
+ * 
+ * The text format cannot tell that a count is complete before the next symbol, so
+ * codec_pull() alone holds the last run back. The rest of it follows with the next chunks.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_flush(tstr_codec_context *pstr_context)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        s32_ret_val = SUCCESS_STATUS;
+
+        if ((0 != pstr_context->str_decoder.u64_input_size) && (FILE_FORMAT_RLE == pstr_context->str_decoder.enu_format))
+        {
+            s32_ret_val = rle_decompress_drain(&pstr_context->str_decoder.str_rle_decoder, &pstr_context->str_window);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = output_window_flush(&pstr_context->str_window);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check the end of the compressed stream and decode what is left of it
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_decompress_finish(tstr_codec_context *pstr_context)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        s32_ret_val = SUCCESS_STATUS;
+
+        // A stream shorter than an .rle2 header is still waiting in the raw buffer
+        if (0 != pstr_context->str_raw.u64_size)
+        {
+            s32_ret_val = stream_decoder_update(&pstr_context->str_decoder, pstr_context->str_raw.pc_data, pstr_context->str_raw.u64_size, &pstr_context->str_window);
+            pstr_context->str_raw.u64_size = 0;
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = stream_decoder_finish(&pstr_context->str_decoder, &pstr_context->str_window);
+        }
+
+        // Output not pulled yet stays, the next stream starts from scratch with its first chunk
+        stream_decoder_reset(&pstr_context->str_decoder);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Take the output produced so far
+ * 
+ * The output buffer is exchanged with the one of the context instead of copied, the
+ * previous content of pstr_output is dropped and its memory is reused for later output.
+ * 
+ * @param[in out] pstr_context Context of the stream
+ * @param[in out] pstr_output Buffer to hold the output
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 codec_pull(tstr_codec_context *pstr_context, tstr_byte_buffer *pstr_output)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_context || NULL == pstr_output)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        // Decoded data still in the window is complete, it goes out too
+        s32_ret_val = output_window_flush(&pstr_context->str_window);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            tstr_byte_buffer str_swap = *pstr_output;
+
+            *pstr_output = pstr_context->str_output;
+
+            pstr_context->str_output = str_swap;
+            pstr_context->str_output.u64_size = 0;
+
+            codec_output_limit_apply(pstr_context);
+        }
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,434 @@
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/rle2.h"
+#include "../header_files/container.h"
+#include "../header_files/packbits.h"
+#include "../header_files/huffman.h"
+#include "../header_files/lz77.h"
+#include "../header_files/codec_registry.h"
+
+
+/**
+ * @brief Estimate from a few samples whether RLE2 tokens could be smaller than the raw data
+ * 
+ * Every run costs at least two bytes of tokens, so blocks whose samples average fewer than
+ * two bytes per run are not worth coding. The estimate leans towards coding, a wrong guess
+ * only costs the aborted coding attempt.
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data
+ * @return bool true if the block should be coded, false if it should be stored
+ */
+static bool b_codec_block_worth_coding(const char *pc_input_data, const u32 u32_input_data_size)
+{
+    const u32 u32_sample_total = CONTAINER_SAMPLE_COUNT * CONTAINER_SAMPLE_SIZE_BYTES;
+
+    if (u32_input_data_size < (2u * u32_sample_total))
+    {
+        return true;
+    }
+
+    const u32 u32_stride = (u32_input_data_size - CONTAINER_SAMPLE_SIZE_BYTES) / (CONTAINER_SAMPLE_COUNT - 1u);
+    u32 u32_run_count = 0;
+
+    for (u32 i = 0; i < CONTAINER_SAMPLE_COUNT; i++)
+    {
+        const char *pc_sample = &pc_input_data[i * u32_stride];
+
+        u32_run_count++;
+
+        for (u32 j = 1; j < CONTAINER_SAMPLE_SIZE_BYTES; j++)
+        {
+            u32_run_count += (pc_sample[j] != pc_sample[j - 1]) ? 1u : 0u;
+        }
+    }
+
+    // Coding is attempted unless the tokens would take at least 15/16 of the raw size
+    return (32u * u32_run_count) < (15u * u32_sample_total);
+}
+
+/**
+ * @brief Code one block into RLE2 tokens, one window at a time
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data
+ * @param[in] u32_search_depth Unused, RLE2 has no match search
+ * @param[in out] pc_payload Buffer to hold the tokens (at least RLE2_COMPRESS_WINDOW_BOUND bytes)
+ * @param[in out] pu64_payload_size Pointer to hold the size of the tokens, at least the raw size when coding was given up
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_encode_rle2(const char *pc_input_data, const u32 u32_input_data_size, const u32 u32_search_depth, char *pc_payload, u64 *pu64_payload_size)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_rle_encoder str_encoder = {0};
+    u64 u64_payload_size = 0;
+    u64 u64_input_idx = 0;
+
+    (void)u32_search_depth;
+
+    do
+    {
+        if (false == b_codec_block_worth_coding(pc_input_data, u32_input_data_size))
+        {
+            u64_payload_size = u32_input_data_size;
+            break;
+        }
+
+        // Give up once the tokens reach the raw size
+        while ((u64_input_idx < u32_input_data_size) && (u64_payload_size < u32_input_data_size))
+        {
+            u64 u64_window_size = u32_input_data_size - u64_input_idx;
+            u64 u64_coded_size = 0;
+
+            if (u64_window_size > DATA_WINDOW_SIZE_BYTES)
+            {
+                u64_window_size = DATA_WINDOW_SIZE_BYTES;
+            }
+
+            s32_ret_val = rle2_compress(&str_encoder, &pc_input_data[u64_input_idx], u64_window_size, &pc_payload[u64_payload_size], &u64_coded_size);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_input_idx += u64_window_size;
+            u64_payload_size += u64_coded_size;
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        if (u64_payload_size < u32_input_data_size)
+        {
+            u64 u64_tail_size = 0;
+
+            s32_ret_val = rle2_compress_flush(&str_encoder, &pc_payload[u64_payload_size], &u64_tail_size);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_payload_size += u64_tail_size;
+        }
+
+    } while (0);
+
+    *pu64_payload_size = u64_payload_size;
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decode one block of RLE2 tokens
+ * 
+ * @param[in] pc_payload Tokens of the block
+ * @param[in] u32_payload_size Size of the tokens
+ * @param[in] u32_raw_size Size of the block once decoded, checked by the caller
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_decode_rle2(const char *pc_payload, const u32 u32_payload_size, const u32 u32_raw_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_rle2_decoder str_decoder = {RLE2_DECODER_STATE_SYMBOL, 0, 0, 0};
+
+    (void)u32_raw_size;
+
+    s32_ret_val = rle2_decompress(&str_decoder, pc_payload, u32_payload_size, pstr_window);
+
+    if ((SUCCESS_STATUS == s32_ret_val) && (RLE2_DECODER_STATE_SYMBOL != str_decoder.enu_state))
+    {
+        LOG_ERROR("Block payload ends in the middle of a token.");
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Leave a block raw, the container copies it as a stored payload
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data
+ * @param[in] u32_search_depth Unused
+ * @param[in out] pc_payload Unused, the container copies the raw data
+ * @param[in out] pu64_payload_size Pointer to hold the raw size
+ * @return s32 SUCCESS_STATUS
+ */
+static s32 s32_codec_encode_stored(const char *pc_input_data, const u32 u32_input_data_size, const u32 u32_search_depth, char *pc_payload, u64 *pu64_payload_size)
+{
+    (void)pc_input_data;
+    (void)u32_search_depth;
+    (void)pc_payload;
+
+    *pu64_payload_size = u32_input_data_size;
+
+    return SUCCESS_STATUS;
+}
+
+/**
+ * @brief Copy a stored block to the output window
+ * 
+ * @param[in] pc_payload Raw data of the block
+ * @param[in] u32_payload_size Size of the raw data
+ * @param[in] u32_raw_size Same as the payload size, checked when the header is read
+ * @param[in out] pstr_window Output window the data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_decode_stored(const char *pc_payload, const u32 u32_payload_size, const u32 u32_raw_size, tstr_output_window *pstr_window)
+{
+    (void)u32_raw_size;
+
+    return output_window_append(pstr_window, pc_payload, u32_payload_size);
+}
+
+/**
+ * @brief Code one block into PackBits literal segments and runs
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data
+ * @param[in] u32_search_depth Unused, PackBits has no match search
+ * @param[in out] pc_payload Buffer to hold the payload (at least PACKBITS_COMPRESS_BOUND bytes)
+ * @param[in out] pu64_payload_size Pointer to hold the size of the payload
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_encode_packbits(const char *pc_input_data, const u32 u32_input_data_size, const u32 u32_search_depth, char *pc_payload, u64 *pu64_payload_size)
+{
+    (void)u32_search_depth;
+
+    return packbits_compress(pc_input_data, u32_input_data_size, pc_payload, pu64_payload_size);
+}
+
+/**
+ * @brief Decode one block of PackBits literal segments and runs
+ * 
+ * @param[in] pc_payload Payload of the block
+ * @param[in] u32_payload_size Size of the payload
+ * @param[in] u32_raw_size Size of the block once decoded, checked by the caller
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_decode_packbits(const char *pc_payload, const u32 u32_payload_size, const u32 u32_raw_size, tstr_output_window *pstr_window)
+{
+    (void)u32_raw_size;
+
+    return packbits_decompress(pc_payload, u32_payload_size, pstr_window);
+}
+
+/**
+ * @brief Code the runs of one block with Huffman codes
+ * 
+ * No RLE2 sample check here, runs of one to three bytes of a small alphabet cost less than
+ * a byte once entropy coded. The exact size is known after coding, larger blocks are stored.
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data
+ * @param[in] u32_search_depth Unused, the runs are coded as they come
+ * @param[in out] pc_payload Buffer to hold the payload (at least u32_input_data_size bytes)
+ * @param[in out] pu64_payload_size Pointer to hold the size of the payload, the raw size when coding did not pay off
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_encode_huffman(const char *pc_input_data, const u32 u32_input_data_size, const u32 u32_search_depth, char *pc_payload, u64 *pu64_payload_size)
+{
+    (void)u32_search_depth;
+
+    return huffman_compress_runs(pc_input_data, u32_input_data_size, pc_payload, pu64_payload_size);
+}
+
+/**
+ * @brief Decode one block of Huffman coded runs
+ * 
+ * @param[in] pc_payload Payload of the block
+ * @param[in] u32_payload_size Size of the payload
+ * @param[in] u32_raw_size Size of the block once decoded
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_decode_huffman(const char *pc_payload, const u32 u32_payload_size, const u32 u32_raw_size, tstr_output_window *pstr_window)
+{
+    return huffman_decompress_runs(pc_payload, u32_payload_size, u32_raw_size, pstr_window);
+}
+
+/**
+ * @brief Code one block into LZ77 sequences
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data
+ * @param[in] u32_search_depth Match candidates per position, 0 for the default
+ * @param[in out] pc_payload Buffer to hold the payload (at least LZ77_COMPRESS_BOUND bytes)
+ * @param[in out] pu64_payload_size Pointer to hold the size of the payload
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_encode_lz77(const char *pc_input_data, const u32 u32_input_data_size, const u32 u32_search_depth, char *pc_payload, u64 *pu64_payload_size)
+{
+    return lz77_compress(pc_input_data, u32_input_data_size, u32_search_depth, pc_payload, pu64_payload_size);
+}
+
+/**
+ * @brief Decode one block of LZ77 sequences, whole, in the output window
+ * 
+ * Matches reach back into the block, so the window is flushed first when the rest of
+ * it cannot hold the block.
+ * 
+ * @param[in] pc_payload Payload of the block
+ * @param[in] u32_payload_size Size of the payload
+ * @param[in] u32_raw_size Size of the block once decoded
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_codec_decode_lz77(const char *pc_payload, const u32 u32_payload_size, const u32 u32_raw_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_byte_buffer *pstr_buffer = &pstr_window->str_buffer;
+
+    do
+    {
+        if (u32_raw_size > (pstr_window->u64_window_size - pstr_buffer->u64_size))
+        {
+            s32_ret_val = output_window_flush(pstr_window);
+            ERROR_BREAK(s32_ret_val);
+        }
+
+        if (u32_raw_size > pstr_window->u64_window_size)
+        {
+            LOG_ERROR("Output window of %lu bytes cannot hold an LZ77 block of %u bytes.", pstr_window->u64_window_size, u32_raw_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+        s32_ret_val = lz77_decompress(pc_payload, u32_payload_size, &pstr_buffer->pc_data[pstr_buffer->u64_size], u32_raw_size);
+        ERROR_BREAK(s32_ret_val);
+
+        pstr_buffer->u64_size += u32_raw_size;
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Worst case RLE2 payload of a block
+ * 
+ * @param[in] u64_raw_size Size of the raw data
+ * @return u64 Largest payload
+ */
+static u64 u64_codec_bound_rle2(const u64 u64_raw_size)
+{
+    return RLE2_COMPRESS_WINDOW_BOUND(u64_raw_size);
+}
+
+/**
+ * @brief Worst case payload of codecs that never write more than the raw size
+ * 
+ * @param[in] u64_raw_size Size of the raw data
+ * @return u64 Largest payload
+ */
+static u64 u64_codec_bound_raw(const u64 u64_raw_size)
+{
+    return u64_raw_size;
+}
+
+/**
+ * @brief Worst case PackBits payload of a block
+ * 
+ * @param[in] u64_raw_size Size of the raw data
+ * @return u64 Largest payload
+ */
+static u64 u64_codec_bound_packbits(const u64 u64_raw_size)
+{
+    return PACKBITS_COMPRESS_BOUND(u64_raw_size);
+}
+
+/**
+ * @brief Worst case LZ77 payload of a block
+ * 
+ * @param[in] u64_raw_size Size of the raw data
+ * @return u64 Largest payload
+ */
+static u64 u64_codec_bound_lz77(const u64 u64_raw_size)
+{
+    return LZ77_COMPRESS_BOUND(u64_raw_size);
+}
+
+// Registered codecs in ID order, the position of an entry is its ID
+static const tstr_codec_entry gastr_codec_registry[] = {
+    {BLOCK_CODEC_RLE2,     "rle2",     "<byte><varint count> run tokens",
+     u64_codec_bound_rle2,     s32_codec_encode_rle2,     s32_codec_decode_rle2},
+    {BLOCK_CODEC_STORED,   "stored",   "raw data, used for blocks no codec shrinks",
+     u64_codec_bound_raw,      s32_codec_encode_stored,   s32_codec_decode_stored},
+    {BLOCK_CODEC_PACKBITS, "packbits", "literal segments and runs of three or more (PackBits style)",
+     u64_codec_bound_packbits, s32_codec_encode_packbits, s32_codec_decode_packbits},
+    {BLOCK_CODEC_HUFFMAN,  "huffman",  "runs entropy coded with canonical Huffman codes per block (--level 2)",
+     u64_codec_bound_raw,      s32_codec_encode_huffman,  s32_codec_decode_huffman},
+    {BLOCK_CODEC_LZ77,     "lz77",     "literals and matches up to 64 KiB back, hash chain match finder (--level 1-9)",
+     u64_codec_bound_lz77,     s32_codec_encode_lz77,     s32_codec_decode_lz77},
+};
+
+#define CODEC_REGISTRY_COUNT    (sizeof(gastr_codec_registry) / sizeof(gastr_codec_registry[0]))
+
+/**
+ * @brief Look a codec up by ID
+ * 
+ * @param[in] u8_id Codec ID, the block type of its payloads
+ * @return const tstr_codec_entry* Registry entry, NULL for unknown IDs
+ */
+const tstr_codec_entry *codec_registry_get(const u8 u8_id)
+{
+    return (u8_id < CODEC_REGISTRY_COUNT) ? &gastr_codec_registry[u8_id] : NULL;
+}
+
+/**
+ * @brief Look a codec up by name
+ * 
+ * @param[in] pc_name Name of the codec
+ * @return const tstr_codec_entry* Registry entry, NULL for unknown names
+ */
+const tstr_codec_entry *codec_registry_find(const char *pc_name)
+{
+    const tstr_codec_entry *pstr_entry = NULL;
+
+    for (u32 i = 0; (NULL != pc_name) && (i < CODEC_REGISTRY_COUNT); i++)
+    {
+        if (0 == strcmp(pc_name, gastr_codec_registry[i].pc_name))
+        {
+            pstr_entry = &gastr_codec_registry[i];
+            break;
+        }
+    }
+
+    return pstr_entry;
+}
+
+/**
+ * @brief Number of registered codecs
+ * 
+ * @return u32 Number of entries, codec_registry_at() takes 0 to this count minus 1
+ */
+u32 codec_registry_count(void)
+{
+    return (u32)CODEC_REGISTRY_COUNT;
+}
+
+/**
+ * @brief Registered codec by position, in ID order
+ * 
+ * @param[in] u32_index Position in the registry
+ * @return const tstr_codec_entry* Registry entry, NULL past the end
+ */
+const tstr_codec_entry *codec_registry_at(const u32 u32_index)
+{
+    return (u32_index < CODEC_REGISTRY_COUNT) ? &gastr_codec_registry[u32_index] : NULL;
+}
+
+/**
+ * @brief Print the registered codecs, one per line, after the text format that has no ID
+ * 
+ * @param[in out] pf_stream Stream to print to
+ * @return void
+ */
+void codec_registry_print(FILE *pf_stream)
+{
+    fprintf(pf_stream, "ID    NAME      DESCRIPTION\n");
+    fprintf(pf_stream, "-     rle       text .rle format, <byte><decimal count> (-f rle only, no file header)\n");
+
+    for (u32 i = 0; i < CODEC_REGISTRY_COUNT; i++)
+    {
+        fprintf(pf_stream, "0x%02X  %-8s  %s\n", gastr_codec_registry[i].u8_id, gastr_codec_registry[i].pc_name, gastr_codec_registry[i].pc_description);
+    }
+}
\ No newline at end of file
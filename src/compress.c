@@ -4,127 +4,485 @@
 #include <string.h>
 
 #include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/buffer.h"
 #include "../header_files/compress.h"
+#include "../header_files/rle2.h"
+#include "../header_files/container.h"
+#include "../header_files/thread_pool.h"
+#include "../header_files/input_source.h"
+#include "../header_files/async_io.h"
+#include "../header_files/codec.h"
 
 
 /**
- * @brief Compress data using Run-Length Encoding (RLE)
+ * @brief Compress one block of a block job, run on the thread pool
  * 
- * @param[in] pc_input_data Input data to be compressed
- * @param[in] u64_input_data_size Size of the input data
- * @param[in out] pc_output_data Buffer to hold the compressed output data
- * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @param[in out] pv_job Block job (tstr_block_job)
+ * @return void
+ */
+static void block_job_compress(void *pv_job)
+{
+    tstr_block_job *pstr_job = (tstr_block_job *)pv_job;
+    u64 u64_start_ns = get_monotonic_time_ns();
+
+    pstr_job->s32_ret_val = container_encode_block(pstr_job->enu_codec, pstr_job->u32_search_depth, pstr_job->pc_raw, pstr_job->u32_raw_size, pstr_job->str_coded.pc_data, &pstr_job->str_coded.u64_size);
+
+    pstr_job->u64_busy_ns = get_monotonic_time_ns() - u64_start_ns;
+    pstr_job->u32_slot = thread_pool_current_slot();
+}
+
+/**
+ * @brief Stream the input through the text RLE encoder of a codec context
+ * 
+ * @param[in out] pstr_source Input source, mapped files are encoded in place
+ * @param[in out] pstr_writer Writer of the output file, the next window is encoded while the last one is written
+ * @param[in out] pstr_stats Statistics of the file, NULL to record nothing
+ * @param[in out] pu64_total_raw_size Pointer to hold the number of bytes read from the input
  * @return s32 SUCCESS_STATUS on success, error code otherwise 
  */
-static s32 s32_rle_compress(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size)
+static s32 s32_compress_rle_stream(tstr_input_source *pstr_source, tstr_async_writer *pstr_writer, tstr_codec_stats *pstr_stats, u64 *pu64_total_raw_size)
 {
     s32 s32_ret_val = FAILURE_STATUS;
 
-    if (NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    tstr_codec_context str_context;
+    tstr_byte_buffer str_compressed_window;
+    const u32 u32_slot = thread_pool_current_slot();
+    u64 u64_mark_ns = stats_mark(pstr_stats);
+
+    codec_context_init(&str_context, FILE_FORMAT_RLE);
+    byte_buffer_init(&str_compressed_window);
+
+    *pu64_total_raw_size = 0;
+
+    do
     {
-        s32_ret_val = ERROR_NULL_POINTER;
-    }
-    else if (0 == u64_input_data_size)
+        while (1)
+        {
+            const char *pc_raw_window = NULL;
+            u64 u64_raw_window_size = 0;
+            u64 u64_code_start_ns = 0;
+
+            s32_ret_val = input_source_view(pstr_source, DATA_WINDOW_SIZE_BYTES, &pc_raw_window, &u64_raw_window_size);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_READ, u64_mark_ns);
+            u64_code_start_ns = u64_mark_ns;
+
+            if (0 == u64_raw_window_size)
+            {
+                break;
+            }
+
+            *pu64_total_raw_size += u64_raw_window_size;
+
+            s32_ret_val = codec_compress_push(&str_context, pc_raw_window, u64_raw_window_size);
+            ERROR_BREAK(s32_ret_val);
+
+            input_source_consume(pstr_source, u64_raw_window_size);
+
+            // The writer hands back an empty buffer, the context takes it for the next window
+            s32_ret_val = codec_pull(&str_context, &str_compressed_window);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+            stats_thread_add(pstr_stats, u32_slot, u64_raw_window_size, u64_mark_ns - u64_code_start_ns);
+
+            s32_ret_val = async_writer_write(pstr_writer, &str_compressed_window);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        if (0 == *pu64_total_raw_size)
+        {
+            LOG_ERROR("Input file is empty.");
+            s32_ret_val = ERROR_EMPTY_FILE;
+            break;
+        }
+
+        s32_ret_val = codec_compress_finish(&str_context);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = codec_pull(&str_context, &str_compressed_window);
+        ERROR_BREAK(s32_ret_val);
+
+        u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+
+        s32_ret_val = async_writer_write(pstr_writer, &str_compressed_window);
+        ERROR_BREAK(s32_ret_val);
+
+        stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+
+    } while (0);
+
+    codec_context_free(&str_context);
+    byte_buffer_free(&str_compressed_window);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Write the END block, the block index and the footer that close an .rle2 block file
+ * 
+ * @param[in out] pstr_writer Writer of the output file, positioned right after the last block
+ * @param[in] pstr_index Serialized index entries of the blocks
+ * @param[in] u64_compressed_offset File offset of the END block
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_compress_rle2_trailer(tstr_async_writer *pstr_writer, const tstr_byte_buffer *pstr_index, const u64 u64_compressed_offset)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_byte_buffer str_trailer;
+    u32 u32_block_count = (u32)(pstr_index->u64_size / CONTAINER_INDEX_ENTRY_SIZE);
+
+    byte_buffer_init(&str_trailer);
+
+    do
     {
-        s32_ret_val = ERROR_INVALID_LENGTH;
-    }
-    else
+        s32_ret_val = byte_buffer_reserve(&str_trailer, CONTAINER_TRAILER_SIZE(u32_block_count));
+        ERROR_BREAK(s32_ret_val);
+
+        str_trailer.u64_size = container_write_trailer(pstr_index->pc_data, u32_block_count, u64_compressed_offset, str_trailer.pc_data);
+
+        s32_ret_val = async_writer_write(pstr_writer, &str_trailer);
+        ERROR_BREAK(s32_ret_val);
+
+    } while (0);
+
+    byte_buffer_free(&str_trailer);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Split the input into blocks, code them on a thread pool and write them in order
+ * 
+ * Each batch takes one span of up to one block per thread from the input source, mapped
+ * files are coded in place. Blocks end before a run that crosses their end, so runs
+ * only get split when a single run fills a whole block. Writes the blocks, the END block,
+ * the block index and the footer after the file header.
+ * 
+ * @param[in out] pstr_source Input source
+ * @param[in out] pstr_writer Writer of the output file, positioned right after the file header
+ * @param[in] u32_thread_count Number of threads coding blocks
+ * @param[in] enu_codec Coding of the blocks
+ * @param[in] u32_search_depth LZ77 match candidates per position, 0 for the default
+ * @param[in out] pstr_pool Pool to run the block jobs on, NULL to start one for this call
+ * @param[in out] pstr_stats Statistics of the file, NULL to record nothing
+ * @param[in out] pu64_total_raw_size Pointer to hold the number of bytes read from the input
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_compress_rle2_blocks(tstr_input_source *pstr_source, tstr_async_writer *pstr_writer, const u32 u32_thread_count, const tenu_block_codec enu_codec,
+                                    const u32 u32_search_depth, tstr_thread_pool *pstr_pool, tstr_codec_stats *pstr_stats, u64 *pu64_total_raw_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_thread_pool str_local_pool;
+    bool b_pool_started = false;
+    tstr_block_job *pstr_jobs = NULL;
+    tstr_byte_buffer str_index;          // Serialized index entries
+    u64 u64_compressed_offset = RLE2_HEADER_SIZE;
+    u64 u64_raw_offset = 0;
+    bool b_end_of_file = false;
+    u64 u64_mark_ns = 0;
+
+    byte_buffer_init(&str_index);
+
+    *pu64_total_raw_size = 0;
+
+    do
     {
+        pstr_jobs = (tstr_block_job *)calloc(u32_thread_count, sizeof(tstr_block_job));
+
+        if (NULL == pstr_jobs)
+        {
+            LOG_ERROR("Error allocating memory for block jobs: %s", strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        }
+
         s32_ret_val = SUCCESS_STATUS;
 
-        u64 u64_write_idx = 0;
-        u64 u64_char_count = 1;
-        u64 u64_needed_size = 0; // Variable to hold needed size for realloc checks
-        char ac_char_count_str[20] = {0}; // Buffer to hold string representation of count
+        for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_thread_count); i++)
+        {
+            pstr_jobs[i].enu_codec = enu_codec;
+            pstr_jobs[i].u32_search_depth = u32_search_depth;
+            s32_ret_val = byte_buffer_reserve(&pstr_jobs[i].str_coded, CONTAINER_BLOCK_BOUND(CONTAINER_BLOCK_SIZE_BYTES));
+        }
+        ERROR_BREAK(s32_ret_val);
 
-        char *pc_output_data_shadow = pc_output_data; // Shadow pointer to free in case of realloc failure
-        
-        for (u64 i = 0; i < u64_input_data_size; i++)
+        if (NULL == pstr_pool)
         {
-            if (pc_input_data[i + 1] == pc_input_data[i])
+            s32_ret_val = thread_pool_create(&str_local_pool, u32_thread_count);
+            ERROR_BREAK(s32_ret_val);
+
+            b_pool_started = true;
+            pstr_pool = &str_local_pool;
+        }
+
+        u64_mark_ns = stats_mark(pstr_stats);
+
+        while (false == b_end_of_file)
+        {
+            tstr_task_group str_group = {0};
+            u32 u32_jobs_count = 0;
+            const char *pc_span = NULL;
+            u64 u64_span_size = 0;
+            u64 u64_block_start = 0;
+            u64 u64_span_capacity = (u64)u32_thread_count * CONTAINER_BLOCK_SIZE_BYTES;
+
+            s32_ret_val = input_source_view(pstr_source, u64_span_capacity, &pc_span, &u64_span_size);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_READ, u64_mark_ns);
+
+            b_end_of_file = (u64_span_size < u64_span_capacity);
+
+            // Cut one block per thread out of the span
+            while ((u32_jobs_count < u32_thread_count) && (u64_block_start < u64_span_size))
             {
-                u64_char_count++;
+                tstr_block_job *pstr_job = &pstr_jobs[u32_jobs_count];
+                u64 u64_block_end = container_cut_block(pc_span, u64_block_start, u64_span_size, b_end_of_file);
+
+                pstr_job->pc_raw = &pc_span[u64_block_start];
+                pstr_job->u32_raw_size = (u32)(u64_block_end - u64_block_start);
+
+                s32_ret_val = thread_pool_submit(pstr_pool, &pstr_job->str_task, block_job_compress, pstr_job, &str_group);
+                ERROR_BREAK(s32_ret_val);
+
+                u64_block_start = u64_block_end;
+                u32_jobs_count++;
             }
-            else
+
+            // Whatever was not cut into a block is presented again by the next view
+            b_end_of_file = b_end_of_file && (u64_block_start == u64_span_size);
+
+            // Always wait, submitted jobs reference the job buffers
+            thread_pool_wait(pstr_pool, &str_group);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+
+            // Write the coded blocks in input order
+            for (u32 i = 0; i < u32_jobs_count; i++)
             {
-                u64_needed_size = u64_write_idx + 2 + sizeof(ac_char_count_str); // 2 for possible escape characters
+                tstr_block_job *pstr_job = &pstr_jobs[i];
+                tstr_block_index_entry str_entry = {0};
+                char ac_entry[CONTAINER_INDEX_ENTRY_SIZE];
 
-                if ((u64_needed_size / 2) < UINT32_MAX)
-                {
-                    if (u64_needed_size >= *pu64_output_data_size)
-                    {
-                        LOG("Reallocating memory for compression buffer.");
-
-                        *pu64_output_data_size += DATA_CHUNK_SIZE_BYTES;
-                        pc_output_data = (char *)realloc(pc_output_data, *pu64_output_data_size);
-
-                        if (NULL == pc_output_data)
-                        {
-                            LOG_ERROR("Error reallocating memory for compression buffer: %s", strerror(errno));
-                            s32_ret_val == ERROR_MEMORY_ALLOCATION_FAILED;
-                            free(pc_output_data_shadow);
-                            pc_output_data_shadow = NULL;
-                            break;
-                        }
-                    }
-                }
-                else
-                {
-                    LOG_ERROR("Output data size is too large.");
-                    s32_ret_val = ERROR_INVALID_LENGTH;
-                    break;
-                }
+                s32_ret_val = pstr_job->s32_ret_val;
+                ERROR_BREAK(s32_ret_val);
 
-                if ('\n' == pc_input_data[i])
-                {
-                    pc_output_data[u64_write_idx++] = '\\';
-                    pc_output_data[u64_write_idx++] = 'n';
-                }
-                else if (pc_input_data[i] >= '0' && pc_input_data[i] <= '9')
-                {
-                    pc_output_data[u64_write_idx++] = '\\';
-                    pc_output_data[u64_write_idx++] = pc_input_data[i];
-                }
-                else
-                {
-                    pc_output_data[u64_write_idx++] = pc_input_data[i];
-                }
+                stats_thread_add(pstr_stats, pstr_job->u32_slot, pstr_job->u32_raw_size, pstr_job->u64_busy_ns);
 
-                memset(ac_char_count_str, 0, sizeof(ac_char_count_str));
-                snprintf(ac_char_count_str, sizeof(ac_char_count_str), "%lu", u64_char_count);
+                u64 u64_block_size = pstr_job->str_coded.u64_size;
 
-                strncpy(&pc_output_data[u64_write_idx], ac_char_count_str, strlen(ac_char_count_str));
-                u64_write_idx += strlen(ac_char_count_str);
-                pc_output_data[u64_write_idx] = '\0';
+                // The job gets an empty buffer back and can code the next batch while this block is written
+                s32_ret_val = async_writer_write(pstr_writer, &pstr_job->str_coded);
+                ERROR_BREAK(s32_ret_val);
 
-                u64_char_count = 1;
+                str_entry.u64_compressed_offset = u64_compressed_offset;
+                str_entry.u64_raw_offset = u64_raw_offset;
+                str_entry.u32_compressed_size = (u32)(u64_block_size - CONTAINER_BLOCK_HEADER_SIZE);
+                str_entry.u32_raw_size = pstr_job->u32_raw_size;
+
+                container_write_index_entry(&str_entry, ac_entry);
+
+                s32_ret_val = byte_buffer_append(&str_index, ac_entry, sizeof(ac_entry));
+                ERROR_BREAK(s32_ret_val);
+
+                u64_compressed_offset += u64_block_size;
+                u64_raw_offset += pstr_job->u32_raw_size;
             }
+            ERROR_BREAK(s32_ret_val);
+
+            input_source_consume(pstr_source, u64_block_start);
+            *pu64_total_raw_size += u64_block_start;
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
         }
+        ERROR_BREAK(s32_ret_val);
 
-        if (SUCCESS_STATUS != s32_ret_val)
+        // Empty input gets a trailer without index entries
+        s32_ret_val = s32_compress_rle2_trailer(pstr_writer, &str_index, u64_compressed_offset);
+        ERROR_BREAK(s32_ret_val);
+
+        stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+
+    } while (0);
+
+    if (true == b_pool_started)
+    {
+        thread_pool_destroy(&str_local_pool);
+    }
+
+    if (NULL != pstr_jobs)
+    {
+        for (u32 i = 0; i < u32_thread_count; i++)
         {
-            LOG_ERROR("RLE Compression failed with error code: %d", s32_ret_val);
+            byte_buffer_free(&pstr_jobs[i].str_coded);
         }
-        else
+
+        free_allocated_memory(pstr_jobs);
+    }
+
+    byte_buffer_free(&str_index);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Compress a live stream, the output is flushed as the flush policy asks
+ * 
+ * Input is coded as it arrives through a codec context instead of window by window. A
+ * flush codes everything received so far: the pending text run is emitted and .rle2
+ * data is closed in a short block. Runs split by a flush decode to the same data.
+ * 
+ * @param[in] pf_in_file Input stream, read through its file descriptor
+ * @param[in out] pstr_writer Writer of the output stream, the .rle2 header comes from the context
+ * @param[in] pstr_options Format and flush policy
+ * @param[in out] pstr_stats Statistics of the stream, NULL to record nothing, the read phase includes waiting for input
+ * @param[in out] pu64_total_raw_size Pointer to hold the number of bytes read from the input
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_compress_live(FILE *pf_in_file, tstr_async_writer *pstr_writer, const tstr_codec_options *pstr_options, tstr_codec_stats *pstr_stats,
+                             u64 *pu64_total_raw_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_codec_context str_context;
+    tstr_byte_buffer str_raw;            // Input not pushed to the context yet
+    tstr_byte_buffer str_coded;
+    u64 u64_pending_since_ms = 0;        // Arrival time of the oldest input not flushed yet
+    bool b_pending = false;
+    bool b_end_of_file = false;
+    const u32 u32_slot = thread_pool_current_slot();
+    u64 u64_mark_ns = stats_mark(pstr_stats);
+
+    codec_context_init(&str_context, pstr_options->enu_format);
+    codec_context_set_block_codec(&str_context, pstr_options->enu_block_codec);
+    codec_context_set_search_depth(&str_context, pstr_options->u32_search_depth);
+    byte_buffer_init(&str_raw);
+    byte_buffer_init(&str_coded);
+
+    *pu64_total_raw_size = 0;
+
+    do
+    {
+        s32_ret_val = byte_buffer_reserve(&str_raw, DATA_WINDOW_SIZE_BYTES);
+        ERROR_BREAK(s32_ret_val);
+
+        while (false == b_end_of_file)
         {
-            *pu64_output_data_size = u64_write_idx;
+            s32 s32_timeout_ms = -1;
+            u64 u64_read_size = 0;
+            bool b_flush = false;
+
+            if ((true == b_pending) && (FLUSH_POLICY_INTERVAL == pstr_options->enu_flush_policy))
+            {
+                u64 u64_waited_ms = get_monotonic_time_ms() - u64_pending_since_ms;
+
+                s32_timeout_ms = (u64_waited_ms >= pstr_options->u32_flush_ms) ? 0 : (s32)(pstr_options->u32_flush_ms - u64_waited_ms);
+            }
+
+            s32_ret_val = read_file_available(pf_in_file, &str_raw.pc_data[str_raw.u64_size], DATA_WINDOW_SIZE_BYTES - str_raw.u64_size, s32_timeout_ms,
+                                              &u64_read_size, &b_end_of_file);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_READ, u64_mark_ns);
+
+            if (0 != u64_read_size)
+            {
+                if (false == b_pending)
+                {
+                    b_pending = true;
+                    u64_pending_since_ms = get_monotonic_time_ms();
+                }
+
+                if ((FLUSH_POLICY_LINE == pstr_options->enu_flush_policy) && (NULL != memchr(&str_raw.pc_data[str_raw.u64_size], '\n', u64_read_size)))
+                {
+                    b_flush = true;
+                }
 
-            LOG("Reallocating compression buffer to the actual compressed size.");
+                str_raw.u64_size += u64_read_size;
+                *pu64_total_raw_size += u64_read_size;
+            }
 
-            pc_output_data = (char *)realloc(pc_output_data, *pu64_output_data_size);
-            if (NULL == pc_output_data)
+            if ((true == b_pending) && (FLUSH_POLICY_INTERVAL == pstr_options->enu_flush_policy) &&
+                ((get_monotonic_time_ms() - u64_pending_since_ms) >= pstr_options->u32_flush_ms))
             {
-                LOG_ERROR("Error reallocating memory to the actual compressed size: %s", strerror(errno));
-                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
-                free(pc_output_data_shadow);
-                pc_output_data_shadow = NULL;
+                b_flush = true;
             }
-            else
+
+            if ((false == b_flush) && (false == b_end_of_file) && (str_raw.u64_size < DATA_WINDOW_SIZE_BYTES))
+            {
+                continue;
+            }
+
+            u64 u64_code_start_ns = u64_mark_ns;
+
+            s32_ret_val = codec_compress_push(&str_context, str_raw.pc_data, str_raw.u64_size);
+            ERROR_BREAK(s32_ret_val);
+
+            if (true == b_flush)
             {
-                LOG("RLE Compression successful. Compressed size: %lu bytes", *pu64_output_data_size);
+                s32_ret_val = codec_compress_flush(&str_context);
+                ERROR_BREAK(s32_ret_val);
             }
+
+            // .rle2 output only appears once a block is complete
+            s32_ret_val = codec_pull(&str_context, &str_coded);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+            stats_thread_add(pstr_stats, u32_slot, str_raw.u64_size, u64_mark_ns - u64_code_start_ns);
+
+            str_raw.u64_size = 0;
+
+            s32_ret_val = async_writer_write(pstr_writer, &str_coded);
+            ERROR_BREAK(s32_ret_val);
+
+            if (true == b_flush)
+            {
+                s32_ret_val = async_writer_flush(pstr_writer);
+                ERROR_BREAK(s32_ret_val);
+
+                b_pending = false;
+            }
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
         }
-    }
+        ERROR_BREAK(s32_ret_val);
+
+        // Text output is only written once input arrives, an empty .rle2 stream still gets its header and trailer
+        if ((0 == *pu64_total_raw_size) && (FILE_FORMAT_RLE == pstr_options->enu_format))
+        {
+            LOG_ERROR("Input file is empty.");
+            s32_ret_val = ERROR_EMPTY_FILE;
+            break;
+        }
+
+        s32_ret_val = codec_compress_finish(&str_context);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = codec_pull(&str_context, &str_coded);
+        ERROR_BREAK(s32_ret_val);
+
+        u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+
+        s32_ret_val = async_writer_write(pstr_writer, &str_coded);
+        ERROR_BREAK(s32_ret_val);
+
+        stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+
+    } while (0);
+
+    codec_context_free(&str_context);
+    byte_buffer_free(&str_raw);
+    byte_buffer_free(&str_coded);
 
     return s32_ret_val;
 }
@@ -132,123 +490,203 @@ static s32 s32_rle_compress(const char *pc_input_data, const u64 u64_input_data_
 /**
  * @brief Compress the input file using RLE compression
  * 
+ * The text .rle format is streamed through fixed-size windows. The binary .rle2 format
+ * is split into independent blocks coded on u32_thread_count threads. Either way peak
+ * memory does not depend on the input size.
+ * 
  * @param[in] input_file_name Path to the input file to be compressed 
+ * @param[in] pstr_options Format and thread count of the compression
+ * @param[in out] pstr_pool Pool shared with other files to code the blocks on, NULL to start one for this file
+ * @param[in out] pstr_stats Pointer to hold the phase timings, sizes and buffer memory of the file, NULL to record nothing
  * @return s32 SUCCESS_STATUS on success, error code otherwise 
  */
-s32 compress(const char *input_file_name)
+s32 compress(const char *input_file_name, const tstr_codec_options *pstr_options, tstr_thread_pool *pstr_pool, tstr_codec_stats *pstr_stats)
 {
     s32 s32_ret_val = FAILURE_STATUS;
 
-    if (NULL == input_file_name)
+    if (NULL == input_file_name || NULL == pstr_options)
     {
         s32_ret_val = ERROR_NULL_POINTER;
     }
+    else if ((0 == pstr_options->u32_thread_count) || (THREAD_POOL_MAX_THREADS < pstr_options->u32_thread_count))
+    {
+        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+    }
     else
     {
         LOG_INFO("Compressing file: %s", input_file_name);
 
+        stats_begin(pstr_stats);
+
+        u64 u64_mark_ns = stats_mark(pstr_stats);
         FILE *pf_in_file = NULL;
         FILE *pf_out_file = NULL;
         char *pc_out_file_path = NULL;
+        u64 u64_total_raw_size = 0;
+        u64 u64_total_out_size = 0;
+        tstr_input_source str_source = {0};
+        tstr_async_writer str_writer;
+        bool b_writer_open = false;
 
-        char *pc_raw_data_buff = NULL;
-        u64 u64_raw_data_size = 0;
-
-        char *pc_compressed_buff = NULL;
-        u64 u64_max_compressed_size = 0;
-        u64 u64_compressed_size = 0;
+        tstr_rle2_header str_rle2_header = {RLE2_VERSION, RLE2_FLAG_SIZE_UNKNOWN, 0, (u8)pstr_options->enu_block_codec};
+        char ac_rle2_header[RLE2_HEADER_SIZE];
 
         char ac_input_file_extention[5] = {0};
 
+        // "-" streams stdin to stdout, a flush policy makes it code input as it arrives
+        const bool b_stdio = (0 == strcmp(input_file_name, "-"));
+        const bool b_live = (true == b_stdio) && (FLUSH_POLICY_NONE != pstr_options->enu_flush_policy);
+
         do
         {
-            s32_ret_val = get_file_extension(input_file_name, ac_input_file_extention);
-            ERROR_BREAK(s32_ret_val);
-            
-            if (0 != strcmp("txt", ac_input_file_extention))
+            if (true == b_stdio)
             {
-                LOG_ERROR("Only .txt files are supported for compression.");
-                s32_ret_val = ERROR_FILE_EXTENSION;
-                break;
+                pf_in_file = stdin;
+                pf_out_file = stdout;
             }
+            else
+            {
+                s32_ret_val = get_file_extension(input_file_name, ac_input_file_extention);
+                ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = open_file(input_file_name, "r", &pf_in_file);
-            ERROR_BREAK(s32_ret_val);
+                if (0 != strcmp("txt", ac_input_file_extention))
+                {
+                    LOG_ERROR("Only .txt files are supported for compression.");
+                    s32_ret_val = ERROR_FILE_EXTENSION;
+                    break;
+                }
 
-            s32_ret_val = read_file(pf_in_file, &pc_raw_data_buff, &u64_raw_data_size);
-            ERROR_BREAK(s32_ret_val);
+                s32_ret_val = open_file(input_file_name, "rb", &pf_in_file);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = create_output_file(input_file_name, (FILE_FORMAT_RLE2 == pstr_options->enu_format) ? "rle2" : "rle", &pc_out_file_path);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = open_file(pc_out_file_path, "wb", &pf_out_file);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            if (false == b_live)
+            {
+                s32_ret_val = input_source_open(&str_source, pf_in_file, pstr_options->enu_io_backend);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            // A live stream gets its header from the codec context
+            if ((FILE_FORMAT_RLE2 == pstr_options->enu_format) && (false == b_live))
+            {
+                // The original size is not known yet, the header is rewritten once the input is consumed
+                s32_ret_val = rle2_write_header(&str_rle2_header, ac_rle2_header);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = write_file(pf_out_file, ac_rle2_header, RLE2_HEADER_SIZE);
+                ERROR_BREAK(s32_ret_val);
+            }
 
-            s32_ret_val = close_file(&pf_in_file);
+            s32_ret_val = async_writer_open(&str_writer, pf_out_file, pstr_options->enu_io_backend);
             ERROR_BREAK(s32_ret_val);
 
+            b_writer_open = true;
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_OPEN, u64_mark_ns);
 
-            if ((u64_raw_data_size / 2) < UINT32_MAX)
+            if (true == b_live)
             {
-                u64_max_compressed_size = 2 * u64_raw_data_size; // Worst case scenario
+                s32_ret_val = s32_compress_live(pf_in_file, &str_writer, pstr_options, pstr_stats, &u64_total_raw_size);
+            }
+            else if (FILE_FORMAT_RLE == pstr_options->enu_format)
+            {
+                s32_ret_val = s32_compress_rle_stream(&str_source, &str_writer, pstr_stats, &u64_total_raw_size);
             }
             else
             {
-                LOG_ERROR("Input file length is too large to compress.");
-                s32_ret_val = ERROR_INVALID_LENGTH;
-                break;
+                s32_ret_val = s32_compress_rle2_blocks(&str_source, &str_writer, pstr_options->u32_thread_count, pstr_options->enu_block_codec,
+                                                       pstr_options->u32_search_depth, pstr_pool, pstr_stats, &u64_total_raw_size);
             }
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_mark(pstr_stats);
+
+            s32_ret_val = async_writer_flush(&str_writer);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
 
-            pc_compressed_buff = (char *)malloc(u64_max_compressed_size);
+            // The header written before the writer started is not part of its offset on pipes
+            u64_total_out_size = str_writer.u64_offset;
 
-            if (NULL == pc_compressed_buff)
+            if ((FILE_FORMAT_RLE2 == pstr_options->enu_format) && (false == b_live) && (false == str_writer.b_positioned))
             {
-                LOG_ERROR("Error allocating memory for compression buffer: %s", strerror(errno));
-                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
-                break;
+                u64_total_out_size += RLE2_HEADER_SIZE;
             }
 
-            s32_ret_val = s32_rle_compress(pc_raw_data_buff, u64_raw_data_size, pc_compressed_buff, &u64_compressed_size);
-            ERROR_BREAK(s32_ret_val);
+            // A stream cannot be rewound, its header keeps the size unknown flag
+            if ((FILE_FORMAT_RLE2 == pstr_options->enu_format) && (false == b_stdio))
+            {
+                str_rle2_header.u8_flags &= (u8)~RLE2_FLAG_SIZE_UNKNOWN;
+                str_rle2_header.u64_original_size = u64_total_raw_size;
 
+                s32_ret_val = rle2_write_header(&str_rle2_header, ac_rle2_header);
+                ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = create_output_file(input_file_name, "rle", &pc_out_file_path);
-            ERROR_BREAK(s32_ret_val);
+                if (0 != fseek(pf_out_file, 0, SEEK_SET))
+                {
+                    LOG_ERROR("Error seeking back to the RLE2 header: %s", strerror(errno));
+                    s32_ret_val = ERROR_FILE_WRITE_FAILED;
+                    break;
+                }
 
-            s32_ret_val = open_file(pc_out_file_path, "w", &pf_out_file);
-            ERROR_BREAK(s32_ret_val);
+                s32_ret_val = write_file(pf_out_file, ac_rle2_header, RLE2_HEADER_SIZE);
+                ERROR_BREAK(s32_ret_val);
+            }
 
-            s32_ret_val = write_file(pf_out_file, pc_compressed_buff, u64_compressed_size);
-            ERROR_BREAK(s32_ret_val);
+            if (false == b_stdio)
+            {
+                s32_ret_val = close_file(&pf_in_file);
+                ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = close_file(&pf_out_file);
-            ERROR_BREAK(s32_ret_val);
+                s32_ret_val = close_file(&pf_out_file);
+                ERROR_BREAK(s32_ret_val);
+            }
 
-            LOG_INFO("File compressed successfully to: %s", pc_out_file_path);
+            stats_phase_end(pstr_stats, STATS_PHASE_CLOSE, u64_mark_ns);
+
+            LOG_INFO("File compressed successfully to: %s (%lu bytes in)", b_stdio ? "stdout" : pc_out_file_path, u64_total_raw_size);
 
         } while (0);
 
+        // Writes still in flight after an error are waited for before the file is closed
+        if (true == b_writer_open)
+        {
+            async_writer_free(&str_writer);
+        }
+
         // Clean-up
         if (SUCCESS_STATUS != s32_ret_val)
         {
             LOG_ERROR("Exit compression loop with error code: %d", s32_ret_val);
 
-            if (NULL != pf_in_file)
+            // stdin and stdout stay open, there is no output file to delete
+            if ((NULL != pf_in_file) && (false == b_stdio))
             {
-                s32_ret_val = close_file(&pf_in_file);
-                LOG_INFO("Close pf_in_file: %d", s32_ret_val);
+                LOG_INFO("Close pf_in_file: %d", close_file(&pf_in_file));
             }
 
-            if (NULL != pf_out_file)
+            if ((NULL != pf_out_file) && (false == b_stdio))
             {
-                s32_ret_val = close_file(&pf_out_file);
-                LOG_INFO("Close pf_out_file: %d", s32_ret_val);
+                LOG_INFO("Close pf_out_file: %d", close_file(&pf_out_file));
             }
 
-            if (true == check_file_exists(pc_out_file_path))
+            if ((NULL != pc_out_file_path) && (true == check_file_exists(pc_out_file_path)))
             {
-                s32_ret_val = delete_file(pc_out_file_path);
+                delete_file(pc_out_file_path);
             }
         }
 
         // Free allocated memory
-        free_allocated_memory(pc_raw_data_buff);
+        input_source_close(&str_source);
         free_allocated_memory(pc_out_file_path);
-        free_allocated_memory(pc_compressed_buff);
+
+        stats_end(pstr_stats, u64_total_raw_size, u64_total_out_size);
     }
 
     return s32_ret_val;
@@ -0,0 +1,802 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/container.h"
+#include "../header_files/codec_registry.h"
+#include "../header_files/checksum.h"
+
+
+/**
+ * @brief Store an unsigned value as little-endian bytes
+ * 
+ * @param[in out] pc_output_data Buffer to hold the bytes
+ * @param[in] u64_value Value to store
+ * @param[in] u8_bytes_count Number of bytes to store
+ * @return void
+ */
+static void container_put_le(char *pc_output_data, const u64 u64_value, const u8 u8_bytes_count)
+{
+    for (u8 i = 0; i < u8_bytes_count; i++)
+    {
+        pc_output_data[i] = (char)(u64_value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Load an unsigned value from little-endian bytes
+ * 
+ * @param[in] pc_input_data Buffer holding the bytes
+ * @param[in] u8_bytes_count Number of bytes to load
+ * @return u64 Loaded value
+ */
+static u64 u64_container_get_le(const char *pc_input_data, const u8 u8_bytes_count)
+{
+    u64 u64_value = 0;
+
+    for (u8 i = 0; i < u8_bytes_count; i++)
+    {
+        u64_value |= ((u64)(u8)pc_input_data[i]) << (8 * i);
+    }
+
+    return u64_value;
+}
+
+/**
+ * @brief Size of the checksum in front of the payload of a block
+ * 
+ * @param[in] pstr_header Header of the block
+ * @return u32 CONTAINER_BLOCK_CHECKSUM_SIZE for BLOCK_FLAG_CRC32C blocks, 0 otherwise 
+ */
+static u32 u32_container_checksum_size(const tstr_block_header *pstr_header)
+{
+    return (0 != (pstr_header->u8_flags & BLOCK_FLAG_CRC32C)) ? CONTAINER_BLOCK_CHECKSUM_SIZE : 0;
+}
+
+/**
+ * @brief Serialize a block header
+ * 
+ * @param[in] pstr_header Header to serialize
+ * @param[in out] pc_output_data Buffer to hold the header (at least CONTAINER_BLOCK_HEADER_SIZE bytes)
+ * @return void
+ */
+void container_write_block_header(const tstr_block_header *pstr_header, char *pc_output_data)
+{
+    pc_output_data[0] = (char)pstr_header->u8_block_type;
+    pc_output_data[1] = (char)pstr_header->u8_flags;
+    pc_output_data[2] = 0;
+    pc_output_data[3] = 0;
+    container_put_le(&pc_output_data[4], pstr_header->u32_raw_size, 4);
+    container_put_le(&pc_output_data[8], pstr_header->u32_compressed_size, 4);
+}
+
+/**
+ * @brief Parse and validate a block header
+ * 
+ * @param[in] pc_input_data CONTAINER_BLOCK_HEADER_SIZE bytes of header
+ * @param[in out] pstr_header Pointer to hold the parsed header
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_read_block_header(const char *pc_input_data, tstr_block_header *pstr_header)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pstr_header)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        pstr_header->u8_block_type = (u8)pc_input_data[0];
+        pstr_header->u8_flags = (u8)pc_input_data[1];
+        pstr_header->u32_raw_size = (u32)u64_container_get_le(&pc_input_data[4], 4);
+        pstr_header->u32_compressed_size = (u32)u64_container_get_le(&pc_input_data[8], 4);
+
+        // Coded payload size, without the checksum
+        const u32 u32_checksum_size = u32_container_checksum_size(pstr_header);
+        const u32 u32_coded_size = pstr_header->u32_compressed_size - u32_checksum_size;
+
+        if (BLOCK_TYPE_END == pstr_header->u8_block_type)
+        {
+            s32_ret_val = SUCCESS_STATUS;
+        }
+        else if (NULL == codec_registry_get(pstr_header->u8_block_type))
+        {
+            LOG_ERROR("Unknown block type: %u", pstr_header->u8_block_type);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else if (0 != (pstr_header->u8_flags & ~BLOCK_FLAGS_KNOWN))
+        {
+            LOG_ERROR("Unknown block flags: 0x%02X", pstr_header->u8_flags);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else if (pstr_header->u32_compressed_size <= u32_checksum_size)
+        {
+            LOG_ERROR("Block of %u bytes has an empty payload.", pstr_header->u32_raw_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else if ((BLOCK_TYPE_STORED == pstr_header->u8_block_type) && (u32_coded_size != pstr_header->u32_raw_size))
+        {
+            LOG_ERROR("Stored block of %u bytes holds %u bytes.", pstr_header->u32_raw_size, u32_coded_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else if ((0 == pstr_header->u32_raw_size) || (pstr_header->u32_raw_size > CONTAINER_BLOCK_SIZE_BYTES) ||
+                 (u32_coded_size > codec_registry_get(pstr_header->u8_block_type)->pf_bound(pstr_header->u32_raw_size)))
+        {
+            LOG_ERROR("Invalid block sizes: %u raw, %u compressed", pstr_header->u32_raw_size, pstr_header->u32_compressed_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else
+        {
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Find the end of the next block to cut out of a span of raw data
+ * 
+ * Blocks end before a run that may continue past their end, so runs only get split
+ * when a single run fills a whole block.
+ * 
+ * @param[in] pc_span Raw data
+ * @param[in] u64_block_start Offset of the block in the span
+ * @param[in] u64_span_size Size of the span
+ * @param[in] b_span_is_final The span ends at the end of the input, its last run cannot continue
+ * @return u64 Offset of the end of the block, greater than u64_block_start when the span has data left
+ */
+u64 container_cut_block(const char *pc_span, const u64 u64_block_start, const u64 u64_span_size, const bool b_span_is_final)
+{
+    u64 u64_block_end = u64_block_start + CONTAINER_BLOCK_SIZE_BYTES;
+
+    if (u64_block_end > u64_span_size)
+    {
+        u64_block_end = u64_span_size;
+    }
+
+    // Move the end back to the start of a run that may continue past it, unless that run fills the block
+    if (((false == b_span_is_final) || (u64_block_end != u64_span_size)) &&
+        ((u64_block_end == u64_span_size) || (pc_span[u64_block_end - 1] == pc_span[u64_block_end])))
+    {
+        u64 u64_cut_idx = u64_block_end - 1;
+
+        while ((u64_cut_idx > u64_block_start) && (pc_span[u64_cut_idx - 1] == pc_span[u64_cut_idx]))
+        {
+            u64_cut_idx--;
+        }
+
+        if (u64_cut_idx > u64_block_start)
+        {
+            u64_block_end = u64_cut_idx;
+        }
+    }
+
+    return u64_block_end;
+}
+
+/**
+ * @brief Code one block of raw data, header included
+ * 
+ * The block is coded by the registered codec of that ID, blocks that the codec would not
+ * shrink are stored raw. Every block carries the CRC32C of its raw data.
+ * 
+ * @param[in] enu_codec Coding of the block
+ * @param[in] u32_search_depth LZ77 match candidates per position, 0 for the default
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u32_input_data_size Size of the raw data (at most CONTAINER_BLOCK_SIZE_BYTES)
+ * @param[in out] pc_output_data Buffer to hold the block (at least CONTAINER_BLOCK_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the block, header included
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_encode_block(const tenu_block_codec enu_codec, const u32 u32_search_depth, const char *pc_input_data, const u32 u32_input_data_size,
+                           char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u32_input_data_size || u32_input_data_size > CONTAINER_BLOCK_SIZE_BYTES)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        const tstr_codec_entry *pstr_codec = codec_registry_get((u8)enu_codec);
+        tstr_block_header str_header = {(u8)enu_codec, BLOCK_FLAG_CRC32C, u32_input_data_size, 0};
+        char *pc_payload = &pc_output_data[CONTAINER_BLOCK_HEADER_SIZE + CONTAINER_BLOCK_CHECKSUM_SIZE];
+        u64 u64_payload_size = 0;
+
+        do
+        {
+            if (NULL == pstr_codec)
+            {
+                LOG_ERROR("Unknown block codec: %u", (u32)enu_codec);
+                s32_ret_val = ERROR_INVALID_ARGUMENTS;
+                break;
+            }
+
+            s32_ret_val = pstr_codec->pf_encode(pc_input_data, u32_input_data_size, u32_search_depth, pc_payload, &u64_payload_size);
+            ERROR_BREAK(s32_ret_val);
+
+            if (u64_payload_size >= u32_input_data_size)
+            {
+                str_header.u8_block_type = BLOCK_TYPE_STORED;
+                u64_payload_size = u32_input_data_size;
+                memcpy(pc_payload, pc_input_data, u32_input_data_size);
+            }
+
+            container_put_le(&pc_output_data[CONTAINER_BLOCK_HEADER_SIZE], crc32c_update(CRC32C_INITIAL_VALUE, pc_input_data, u32_input_data_size),
+                             CONTAINER_BLOCK_CHECKSUM_SIZE);
+
+            str_header.u32_compressed_size = CONTAINER_BLOCK_CHECKSUM_SIZE + (u32)u64_payload_size;
+            container_write_block_header(&str_header, pc_output_data);
+
+            *pu64_output_data_size = CONTAINER_BLOCK_HEADER_SIZE + str_header.u32_compressed_size;
+
+        } while (0);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decode the payload of one block into the output window
+ * 
+ * Blocks with a CRC32C are decoded whole into the window, flushing it first when the block
+ * does not fit, and their data is checked against it.
+ * 
+ * @param[in] pstr_header Header of the block
+ * @param[in] pc_payload Payload of the block
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_decode_block(const tstr_block_header *pstr_header, const char *pc_payload, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_header || NULL == pc_payload || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        const tstr_codec_entry *pstr_codec = codec_registry_get(pstr_header->u8_block_type);
+        const u32 u32_checksum_size = u32_container_checksum_size(pstr_header);
+        u64 u64_block_start = 0;
+        u64 u64_flushed_size = 0;
+
+        do
+        {
+            if (NULL == pstr_codec)
+            {
+                LOG_ERROR("Unknown block type: %u", pstr_header->u8_block_type);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            // A checked block is decoded whole into the window, so its data can be hashed in one pass
+            if ((0 != u32_checksum_size) && (pstr_header->u32_raw_size > (pstr_window->u64_window_size - pstr_window->str_buffer.u64_size)))
+            {
+                s32_ret_val = output_window_flush(pstr_window);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            u64_block_start = pstr_window->u64_total_size + pstr_window->str_buffer.u64_size;
+            u64_flushed_size = pstr_window->u64_total_size;
+
+            s32_ret_val = pstr_codec->pf_decode(&pc_payload[u32_checksum_size], pstr_header->u32_compressed_size - u32_checksum_size,
+                                                pstr_header->u32_raw_size, pstr_window);
+            ERROR_BREAK(s32_ret_val);
+
+            if ((pstr_window->u64_total_size + pstr_window->str_buffer.u64_size - u64_block_start) != pstr_header->u32_raw_size)
+            {
+                LOG_ERROR("Block decoded to %lu bytes, expected %u.",
+                          pstr_window->u64_total_size + pstr_window->str_buffer.u64_size - u64_block_start, pstr_header->u32_raw_size);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            if (0 != u32_checksum_size)
+            {
+                const u32 u32_expected_crc = (u32)u64_container_get_le(pc_payload, CONTAINER_BLOCK_CHECKSUM_SIZE);
+
+                // Only a window smaller than the block flushes during the decode
+                if (u64_flushed_size != pstr_window->u64_total_size)
+                {
+                    LOG_ERROR("Block of %u bytes does not fit in an output window of %lu bytes.", pstr_header->u32_raw_size, pstr_window->u64_window_size);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                if (crc32c_update(CRC32C_INITIAL_VALUE, &pstr_window->str_buffer.pc_data[u64_block_start - u64_flushed_size], pstr_header->u32_raw_size) !=
+                    u32_expected_crc)
+                {
+                    LOG_ERROR("Block of %u bytes does not match its CRC32C %08x.", pstr_header->u32_raw_size, u32_expected_crc);
+                    s32_ret_val = ERROR_CHECKSUM_MISMATCH;
+                    break;
+                }
+            }
+
+        } while (0);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Serialize one block index entry
+ * 
+ * @param[in] pstr_entry Entry to serialize
+ * @param[in out] pc_output_data Buffer to hold the entry (at least CONTAINER_INDEX_ENTRY_SIZE bytes)
+ * @return void
+ */
+void container_write_index_entry(const tstr_block_index_entry *pstr_entry, char *pc_output_data)
+{
+    container_put_le(&pc_output_data[0], pstr_entry->u64_compressed_offset, 8);
+    container_put_le(&pc_output_data[8], pstr_entry->u64_raw_offset, 8);
+    container_put_le(&pc_output_data[16], pstr_entry->u32_compressed_size, 4);
+    container_put_le(&pc_output_data[20], pstr_entry->u32_raw_size, 4);
+}
+
+/**
+ * @brief Serialize the footer that locates the block index
+ * 
+ * @param[in] u64_index_offset File offset of the first index entry
+ * @param[in] u32_block_count Number of index entries
+ * @param[in out] pc_output_data Buffer to hold the footer (at least CONTAINER_FOOTER_SIZE bytes)
+ * @return void
+ */
+void container_write_footer(const u64 u64_index_offset, const u32 u32_block_count, char *pc_output_data)
+{
+    container_put_le(&pc_output_data[0], u64_index_offset, 8);
+    container_put_le(&pc_output_data[8], u32_block_count, 4);
+    memcpy(&pc_output_data[12], CONTAINER_FOOTER_MAGIC, 4);
+}
+
+/**
+ * @brief Write the END block, the block index and the footer that close a block stream
+ * 
+ * @param[in] pc_index Serialized index entries of the blocks
+ * @param[in] u32_block_count Number of index entries
+ * @param[in] u64_end_offset Stream offset of the END block
+ * @param[in out] pc_output_data Buffer to hold the trailer (at least CONTAINER_TRAILER_SIZE bytes)
+ * @return u64 Size of the trailer
+ */
+u64 container_write_trailer(const char *pc_index, const u32 u32_block_count, const u64 u64_end_offset, char *pc_output_data)
+{
+    tstr_block_header str_end_header = {BLOCK_TYPE_END, 0, 0, 0};
+    u64 u64_index_size = (u64)u32_block_count * CONTAINER_INDEX_ENTRY_SIZE;
+
+    // END block, then the index and the footer pointing back at it
+    container_write_block_header(&str_end_header, pc_output_data);
+
+    if (0 != u64_index_size)
+    {
+        memcpy(&pc_output_data[CONTAINER_BLOCK_HEADER_SIZE], pc_index, u64_index_size);
+    }
+
+    container_write_footer(u64_end_offset + CONTAINER_BLOCK_HEADER_SIZE, u32_block_count, &pc_output_data[CONTAINER_BLOCK_HEADER_SIZE + u64_index_size]);
+
+    return CONTAINER_TRAILER_SIZE(u32_block_count);
+}
+
+/**
+ * @brief Parse one block index entry
+ * 
+ * @param[in] pc_input_data CONTAINER_INDEX_ENTRY_SIZE bytes of entry
+ * @param[in out] pstr_entry Pointer to hold the parsed entry
+ * @return void
+ */
+void container_read_index_entry(const char *pc_input_data, tstr_block_index_entry *pstr_entry)
+{
+    pstr_entry->u64_compressed_offset = u64_container_get_le(&pc_input_data[0], 8);
+    pstr_entry->u64_raw_offset = u64_container_get_le(&pc_input_data[8], 8);
+    pstr_entry->u32_compressed_size = (u32)u64_container_get_le(&pc_input_data[16], 4);
+    pstr_entry->u32_raw_size = (u32)u64_container_get_le(&pc_input_data[20], 4);
+}
+
+/**
+ * @brief Parse and validate the footer that locates the block index
+ * 
+ * @param[in] pc_input_data CONTAINER_FOOTER_SIZE bytes of footer
+ * @param[in] u64_file_size Size of the whole compressed file
+ * @param[in out] pu64_index_offset Pointer to hold the file offset of the first index entry
+ * @param[in out] pu32_block_count Pointer to hold the number of index entries
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_read_footer(const char *pc_input_data, const u64 u64_file_size, u64 *pu64_index_offset, u32 *pu32_block_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pu64_index_offset || NULL == pu32_block_count)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        *pu64_index_offset = u64_container_get_le(&pc_input_data[0], 8);
+        *pu32_block_count = (u32)u64_container_get_le(&pc_input_data[8], 4);
+
+        if (0 != memcmp(&pc_input_data[12], CONTAINER_FOOTER_MAGIC, 4))
+        {
+            LOG_ERROR("Block index footer not found.");
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else if ((*pu64_index_offset < (RLE2_HEADER_SIZE + CONTAINER_BLOCK_HEADER_SIZE)) || (*pu64_index_offset > u64_file_size) ||
+                 ((u64_file_size - *pu64_index_offset) != (((u64)*pu32_block_count * CONTAINER_INDEX_ENTRY_SIZE) + CONTAINER_FOOTER_SIZE)))
+        {
+            LOG_ERROR("Invalid block index: offset %lu, %u blocks, file size %lu.", *pu64_index_offset, *pu32_block_count, u64_file_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else
+        {
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Load and validate the block index of a seekable .rle2 version 2 file
+ * 
+ * The entries must describe contiguous blocks covering the file from the end of the
+ * file header to the END block, and the original data from offset 0. A file of empty
+ * data has no entries.
+ * 
+ * @param[in] pf_file Compressed file, read with positioned reads
+ * @param[in] u64_file_size Size of the compressed file
+ * @param[in out] ppstr_entries Pointer to hold the heap allocated entries, freed by the caller, NULL without entries
+ * @param[in out] pu32_block_count Pointer to hold the number of entries
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_load_index(FILE *pf_file, const u64 u64_file_size, tstr_block_index_entry **ppstr_entries, u32 *pu32_block_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pf_file || NULL == ppstr_entries || NULL == pu32_block_count)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_file_size < (RLE2_HEADER_SIZE + CONTAINER_BLOCK_HEADER_SIZE + CONTAINER_FOOTER_SIZE))
+    {
+        LOG_ERROR("File is too small to hold a block index.");
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+    else
+    {
+        char ac_footer[CONTAINER_FOOTER_SIZE];
+        char *pc_index_data = NULL;
+        tstr_block_index_entry *pstr_entries = NULL;
+        u64 u64_index_offset = 0;
+        u32 u32_block_count = 0;
+
+        do
+        {
+            s32_ret_val = read_file_at(pf_file, ac_footer, CONTAINER_FOOTER_SIZE, u64_file_size - CONTAINER_FOOTER_SIZE);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = container_read_footer(ac_footer, u64_file_size, &u64_index_offset, &u32_block_count);
+            ERROR_BREAK(s32_ret_val);
+
+            // A file without blocks holds empty data, its END block is right after the file header
+            if (0 == u32_block_count)
+            {
+                if ((RLE2_HEADER_SIZE + CONTAINER_BLOCK_HEADER_SIZE) != u64_index_offset)
+                {
+                    LOG_ERROR("Block index does not cover the block section.");
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                *ppstr_entries = NULL;
+                *pu32_block_count = 0;
+                break;
+            }
+
+            pc_index_data = (char *)malloc((u64)u32_block_count * CONTAINER_INDEX_ENTRY_SIZE);
+            pstr_entries = (tstr_block_index_entry *)malloc((u64)u32_block_count * sizeof(tstr_block_index_entry));
+
+            if (NULL == pc_index_data || NULL == pstr_entries)
+            {
+                LOG_ERROR("Error allocating memory for the block index: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+                break;
+            }
+
+            s32_ret_val = read_file_at(pf_file, pc_index_data, (u64)u32_block_count * CONTAINER_INDEX_ENTRY_SIZE, u64_index_offset);
+            ERROR_BREAK(s32_ret_val);
+
+            u64 u64_compressed_offset = RLE2_HEADER_SIZE;
+            u64 u64_raw_offset = 0;
+
+            for (u32 i = 0; i < u32_block_count; i++)
+            {
+                tstr_block_index_entry *pstr_entry = &pstr_entries[i];
+
+                container_read_index_entry(&pc_index_data[(u64)i * CONTAINER_INDEX_ENTRY_SIZE], pstr_entry);
+
+                if ((pstr_entry->u64_compressed_offset != u64_compressed_offset) || (pstr_entry->u64_raw_offset != u64_raw_offset) ||
+                    (0 == pstr_entry->u32_raw_size) || (pstr_entry->u32_raw_size > CONTAINER_BLOCK_SIZE_BYTES) ||
+                    (0 == pstr_entry->u32_compressed_size) ||
+                    (pstr_entry->u32_compressed_size > (CONTAINER_BLOCK_CHECKSUM_SIZE + RLE2_COMPRESS_WINDOW_BOUND(CONTAINER_BLOCK_SIZE_BYTES))))
+                {
+                    LOG_ERROR("Invalid block index entry %u.", i);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                u64_compressed_offset += CONTAINER_BLOCK_HEADER_SIZE + pstr_entry->u32_compressed_size;
+                u64_raw_offset += pstr_entry->u32_raw_size;
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            // The blocks are followed by the END block header, then the index
+            if ((u64_compressed_offset + CONTAINER_BLOCK_HEADER_SIZE) != u64_index_offset)
+            {
+                LOG_ERROR("Block index does not cover the block section.");
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            *ppstr_entries = pstr_entries;
+            *pu32_block_count = u32_block_count;
+            pstr_entries = NULL;
+
+        } while (0);
+
+        free_allocated_memory(pc_index_data);
+        free_allocated_memory(pstr_entries);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Get the size of the original data covered by a block index
+ * 
+ * @param[in] pstr_entries Validated block index, covering the data from offset 0
+ * @param[in] u32_block_count Number of index entries
+ * @return u64 End of the last block in the original data, 0 without entries
+ */
+u64 container_index_raw_size(const tstr_block_index_entry *pstr_entries, const u32 u32_block_count)
+{
+    u64 u64_raw_size = 0;
+
+    if (0 != u32_block_count)
+    {
+        u64_raw_size = pstr_entries[u32_block_count - 1].u64_raw_offset + pstr_entries[u32_block_count - 1].u32_raw_size;
+    }
+
+    return u64_raw_size;
+}
+
+/**
+ * @brief Find the block holding one offset of the original data
+ * 
+ * @param[in] pstr_entries Validated block index, covering the data from offset 0
+ * @param[in] u32_block_count Number of index entries
+ * @param[in] u64_raw_offset Offset in the original data
+ * @return u32 Index of the last block starting at or before the offset, 0 without entries
+ */
+u32 container_find_block(const tstr_block_index_entry *pstr_entries, const u32 u32_block_count, const u64 u64_raw_offset)
+{
+    u32 u32_low = 0;
+    u32 u32_high = (0 == u32_block_count) ? 0 : (u32_block_count - 1);
+
+    while (u32_low < u32_high)
+    {
+        u32 u32_mid = u32_low + ((u32_high - u32_low + 1) / 2);
+
+        if (pstr_entries[u32_mid].u64_raw_offset <= u64_raw_offset)
+        {
+            u32_low = u32_mid;
+        }
+        else
+        {
+            u32_high = u32_mid - 1;
+        }
+    }
+
+    return u32_low;
+}
+
+/**
+ * @brief Read the header and payload of one indexed block and check them against the index
+ * 
+ * @param[in] pf_file Compressed file, read with positioned reads
+ * @param[in] pstr_entry Index entry of the block
+ * @param[in out] pc_output_data Buffer to hold the block, header included (at least CONTAINER_BLOCK_BOUND bytes)
+ * @param[in out] pstr_header Pointer to hold the parsed header, the payload follows it in pc_output_data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_read_indexed_block(FILE *pf_file, const tstr_block_index_entry *pstr_entry, char *pc_output_data, tstr_block_header *pstr_header)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pf_file || NULL == pstr_entry || NULL == pc_output_data || NULL == pstr_header)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        do
+        {
+            s32_ret_val = read_file_at(pf_file, pc_output_data, CONTAINER_BLOCK_HEADER_SIZE + (u64)pstr_entry->u32_compressed_size,
+                                       pstr_entry->u64_compressed_offset);
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = container_read_block_header(pc_output_data, pstr_header);
+            ERROR_BREAK(s32_ret_val);
+
+            if ((BLOCK_TYPE_END == pstr_header->u8_block_type) || (pstr_header->u32_raw_size != pstr_entry->u32_raw_size) ||
+                (pstr_header->u32_compressed_size != pstr_entry->u32_compressed_size))
+            {
+                LOG_ERROR("Block at offset %lu does not match its index entry.", pstr_entry->u64_compressed_offset);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+        } while (0);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Initialize a sequential block reader
+ * 
+ * @param[in out] pstr_reader Reader to initialize
+ * @return void
+ */
+void container_reader_init(tstr_block_reader *pstr_reader)
+{
+    if (NULL != pstr_reader)
+    {
+        memset(pstr_reader, 0, sizeof(*pstr_reader));
+        pstr_reader->enu_state = BLOCK_READER_STATE_HEADER;
+        byte_buffer_init(&pstr_reader->str_block);
+    }
+}
+
+/**
+ * @brief Return a reader to its initial state, its block buffer is kept for the next stream
+ * 
+ * @param[in out] pstr_reader Reader to reset
+ * @return void
+ */
+void container_reader_reset(tstr_block_reader *pstr_reader)
+{
+    if (NULL != pstr_reader)
+    {
+        pstr_reader->enu_state = BLOCK_READER_STATE_HEADER;
+        pstr_reader->str_block.u64_size = 0;
+        pstr_reader->u64_block_count = 0;
+    }
+}
+
+/**
+ * @brief Feed one chunk of the block section to the reader, decoding every completed block
+ * 
+ * @param[in out] pstr_reader Reader state carried across chunks
+ * @param[in] pc_input_data Input data, starting right after the file header on the first call
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_reader_update(tstr_block_reader *pstr_reader, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_reader || NULL == pc_input_data || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 i = 0;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        while ((i < u64_input_data_size) && (BLOCK_READER_STATE_DONE != pstr_reader->enu_state))
+        {
+            u64 u64_item_size = (BLOCK_READER_STATE_HEADER == pstr_reader->enu_state) ? CONTAINER_BLOCK_HEADER_SIZE : pstr_reader->str_header.u32_compressed_size;
+            const char *pc_item = NULL;
+
+            if ((0 == pstr_reader->str_block.u64_size) && ((u64_input_data_size - i) >= u64_item_size))
+            {
+                // The whole item is in this chunk, use it in place
+                pc_item = &pc_input_data[i];
+                i += u64_item_size;
+            }
+            else
+            {
+                u64 u64_copy_size = u64_item_size - pstr_reader->str_block.u64_size;
+
+                if (u64_copy_size > (u64_input_data_size - i))
+                {
+                    u64_copy_size = u64_input_data_size - i;
+                }
+
+                s32_ret_val = byte_buffer_append(&pstr_reader->str_block, &pc_input_data[i], u64_copy_size);
+                ERROR_BREAK(s32_ret_val);
+
+                i += u64_copy_size;
+
+                if (pstr_reader->str_block.u64_size < u64_item_size)
+                {
+                    break;
+                }
+
+                pc_item = pstr_reader->str_block.pc_data;
+                pstr_reader->str_block.u64_size = 0;
+            }
+
+            if (BLOCK_READER_STATE_HEADER == pstr_reader->enu_state)
+            {
+                s32_ret_val = container_read_block_header(pc_item, &pstr_reader->str_header);
+                ERROR_BREAK(s32_ret_val);
+
+                pstr_reader->enu_state = (BLOCK_TYPE_END == pstr_reader->str_header.u8_block_type) ? BLOCK_READER_STATE_DONE : BLOCK_READER_STATE_PAYLOAD;
+            }
+            else
+            {
+                s32_ret_val = container_decode_block(&pstr_reader->str_header, pc_item, pstr_window);
+                ERROR_BREAK(s32_ret_val);
+
+                pstr_reader->u64_block_count++;
+                pstr_reader->enu_state = BLOCK_READER_STATE_HEADER;
+            }
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check that the END block was reached and flush the output
+ * 
+ * @param[in out] pstr_reader Reader state carried across chunks
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 container_reader_finish(tstr_block_reader *pstr_reader, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_reader || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (BLOCK_READER_STATE_DONE != pstr_reader->enu_state)
+    {
+        LOG_ERROR("Block stream is truncated, END block not found.");
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+    else
+    {
+        LOG("Decoded %lu blocks.", pstr_reader->u64_block_count);
+        s32_ret_val = output_window_flush(pstr_window);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Release the reader memory
+ * 
+ * @param[in out] pstr_reader Reader to release
+ * @return void
+ */
+void container_reader_free(tstr_block_reader *pstr_reader)
+{
+    if (NULL != pstr_reader)
+    {
+        byte_buffer_free(&pstr_reader->str_block);
+    }
+}
\ No newline at end of file
@@ -5,248 +5,940 @@
 
 #include "../header_files/utils.h"
 #include "../header_files/decompress.h"
+#include "../header_files/rle2.h"
+#include "../header_files/container.h"
+#include "../header_files/codec_registry.h"
+#include "../header_files/input_source.h"
+#include "../header_files/async_io.h"
+#include "../header_files/codec.h"
 
 
 /**
- * @brief Decompress data using Run-Length Encoding (RLE)
+ * @brief Decode the blocks of one decode job, run on the thread pool
  * 
- * @param[in] pc_input_data Input data to be decompressed
- * @param[in] u64_input_data_size Size of the input data
- * @param[in] pc_output_data Buffer to hold the decompressed output data
- * @param[in out] pu64_output_data_size Pointer to hold the size of the decompressed data
+ * @param[in out] pv_job Decode job (tstr_block_decode_job)
+ * @return void
+ */
+static void block_job_decompress(void *pv_job)
+{
+    tstr_block_decode_job *pstr_job = (tstr_block_decode_job *)pv_job;
+    u64 u64_start_ns = get_monotonic_time_ns();
+
+    pstr_job->s32_ret_val = SUCCESS_STATUS;
+    pstr_job->u64_raw_size = 0;
+
+    for (u32 i = pstr_job->u32_first_block; i < pstr_job->u32_block_count; i += pstr_job->u32_block_stride)
+    {
+        const tstr_block_index_entry *pstr_entry = &pstr_job->pstr_entries[i];
+        tstr_block_header str_header = {0};
+        u64 u64_block_size = CONTAINER_BLOCK_HEADER_SIZE + (u64)pstr_entry->u32_compressed_size;
+        const char *pc_block = NULL;
+
+        if (NULL != pstr_job->pc_in_map)
+        {
+            // The index was checked against the file size, the block is inside the mapping
+            pc_block = &pstr_job->pc_in_map[pstr_entry->u64_compressed_offset];
+        }
+        else
+        {
+            pstr_job->s32_ret_val = read_file_at(pstr_job->pf_in_file, pstr_job->str_coded.pc_data, u64_block_size, pstr_entry->u64_compressed_offset);
+            ERROR_BREAK(pstr_job->s32_ret_val);
+
+            pc_block = pstr_job->str_coded.pc_data;
+        }
+
+        pstr_job->s32_ret_val = container_read_block_header(pc_block, &str_header);
+        ERROR_BREAK(pstr_job->s32_ret_val);
+
+        if ((BLOCK_TYPE_END == str_header.u8_block_type) || (str_header.u32_raw_size != pstr_entry->u32_raw_size) ||
+            (str_header.u32_compressed_size != pstr_entry->u32_compressed_size))
+        {
+            LOG_ERROR("Block %u does not match its index entry.", i);
+            pstr_job->s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+        pstr_job->str_window.str_buffer.u64_size = 0;
+        pstr_job->str_window.u64_total_size = 0;
+
+        pstr_job->s32_ret_val = container_decode_block(&str_header, &pc_block[CONTAINER_BLOCK_HEADER_SIZE], &pstr_job->str_window);
+        ERROR_BREAK(pstr_job->s32_ret_val);
+
+        if (NULL != pstr_job->pf_out_file)
+        {
+            pstr_job->s32_ret_val = write_file_at(pstr_job->pf_out_file, pstr_job->str_window.str_buffer.pc_data, str_header.u32_raw_size, pstr_entry->u64_raw_offset);
+            ERROR_BREAK(pstr_job->s32_ret_val);
+        }
+
+        pstr_job->u64_raw_size += str_header.u32_raw_size;
+    }
+
+    pstr_job->u64_busy_ns = get_monotonic_time_ns() - u64_start_ns;
+    pstr_job->u32_slot = thread_pool_current_slot();
+}
+
+/**
+ * @brief Decode a seekable .rle2 version 2 file block by block on a thread pool
+ * 
+ * The block index gives every block its place in both files, so the output is
+ * pre-sized and each thread writes its blocks straight into their slice of it.
+ * Blocks of a mapped input are decoded in place, otherwise they are read with pread.
+ * 
+ * @param[in] pstr_source Input source of the compressed file
+ * @param[in] u64_in_file_size Size of the compressed file
+ * @param[in] pf_out_file Output file, NULL to only decode and check the blocks
+ * @param[in] pstr_rle2_header File header of the compressed file
+ * @param[in] u32_thread_count Number of threads decoding blocks
+ * @param[in out] pstr_pool Pool to run the block jobs on, NULL to start one for this call
+ * @param[in out] pstr_stats Statistics of the file, NULL to record nothing, the jobs read and write their own blocks
+ * @param[in out] pu64_total_out_size Pointer to hold the size of the decompressed data
  * @return s32 SUCCESS_STATUS on success, error code otherwise 
  */
-static s32 s32_rle_decompress(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size)
+static s32 s32_decompress_rle2_blocks(const tstr_input_source *pstr_source, const u64 u64_in_file_size, FILE *pf_out_file, const tstr_rle2_header *pstr_rle2_header,
+                                      u32 u32_thread_count, tstr_thread_pool *pstr_pool, tstr_codec_stats *pstr_stats, u64 *pu64_total_out_size)
 {
     s32 s32_ret_val = FAILURE_STATUS;
 
-    if (NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    u64 u64_mark_ns = stats_mark(pstr_stats);
+
+    tstr_thread_pool str_local_pool;
+    bool b_pool_started = false;
+    tstr_block_index_entry *pstr_entries = NULL;
+    tstr_block_decode_job *pstr_jobs = NULL;
+    u32 u32_block_count = 0;
+
+    do
     {
-        s32_ret_val = ERROR_NULL_POINTER;
+        s32_ret_val = container_load_index(pstr_source->pf_file, u64_in_file_size, &pstr_entries, &u32_block_count);
+        ERROR_BREAK(s32_ret_val);
+
+        u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_READ, u64_mark_ns);
+
+        const u64 u64_raw_size = container_index_raw_size(pstr_entries, u32_block_count);
+
+        if ((0 == (pstr_rle2_header->u8_flags & RLE2_FLAG_SIZE_UNKNOWN)) && (u64_raw_size != pstr_rle2_header->u64_original_size))
+        {
+            LOG_ERROR("Block index covers %lu bytes, the original size is %lu.", u64_raw_size, pstr_rle2_header->u64_original_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+        if (NULL != pf_out_file)
+        {
+            s32_ret_val = resize_file(pf_out_file, u64_raw_size);
+            ERROR_BREAK(s32_ret_val);
+        }
+
+        *pu64_total_out_size = u64_raw_size;
+
+        // Empty data has no blocks to decode
+        if (0 == u32_block_count)
+        {
+            break;
+        }
+
+        if (u32_thread_count > u32_block_count)
+        {
+            u32_thread_count = u32_block_count;
+        }
+
+        pstr_jobs = (tstr_block_decode_job *)calloc(u32_thread_count, sizeof(tstr_block_decode_job));
+
+        if (NULL == pstr_jobs)
+        {
+            LOG_ERROR("Error allocating memory for block jobs: %s", strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        }
+
+        for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_thread_count); i++)
+        {
+            tstr_block_decode_job *pstr_job = &pstr_jobs[i];
+
+            pstr_job->pstr_entries = pstr_entries;
+            pstr_job->u32_block_count = u32_block_count;
+            pstr_job->u32_first_block = i;
+            pstr_job->u32_block_stride = u32_thread_count;
+            pstr_job->pf_in_file = pstr_source->pf_file;
+            pstr_job->pc_in_map = (u64_in_file_size == pstr_source->u64_map_size) ? pstr_source->pc_map : NULL;
+            pstr_job->pf_out_file = pf_out_file;
+
+            if (NULL == pstr_job->pc_in_map)
+            {
+                s32_ret_val = byte_buffer_reserve(&pstr_job->str_coded, CONTAINER_BLOCK_BOUND(CONTAINER_BLOCK_SIZE_BYTES));
+            }
+
+            if (SUCCESS_STATUS == s32_ret_val)
+            {
+                s32_ret_val = output_window_reserve(&pstr_job->str_window, CONTAINER_BLOCK_SIZE_BYTES);
+            }
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        if (NULL == pstr_pool)
+        {
+            s32_ret_val = thread_pool_create(&str_local_pool, u32_thread_count);
+            ERROR_BREAK(s32_ret_val);
+
+            b_pool_started = true;
+            pstr_pool = &str_local_pool;
+        }
+
+        tstr_task_group str_group = {0};
+
+        for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_thread_count); i++)
+        {
+            s32_ret_val = thread_pool_submit(pstr_pool, &pstr_jobs[i].str_task, block_job_decompress, &pstr_jobs[i], &str_group);
+        }
+
+        // Always wait, submitted jobs reference the job buffers
+        thread_pool_wait(pstr_pool, &str_group);
+        ERROR_BREAK(s32_ret_val);
+
+        stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+
+        for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < u32_thread_count); i++)
+        {
+            s32_ret_val = pstr_jobs[i].s32_ret_val;
+
+            stats_thread_add(pstr_stats, pstr_jobs[i].u32_slot, pstr_jobs[i].u64_raw_size, pstr_jobs[i].u64_busy_ns);
+        }
+        ERROR_BREAK(s32_ret_val);
+
+    } while (0);
+
+    if (true == b_pool_started)
+    {
+        thread_pool_destroy(&str_local_pool);
     }
-    else if (0 == u64_input_data_size)
+
+    if (NULL != pstr_jobs)
     {
-        s32_ret_val = ERROR_INVALID_LENGTH;
+        for (u32 i = 0; i < u32_thread_count; i++)
+        {
+            byte_buffer_free(&pstr_jobs[i].str_coded);
+            byte_buffer_free(&pstr_jobs[i].str_window.str_buffer);
+        }
+
+        free_allocated_memory(pstr_jobs);
     }
-    else
+
+    free_allocated_memory(pstr_entries);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Read the .rle2 header of a compressed file, if it has one
+ * 
+ * Text .rle files may be shorter than a header and pipes cannot be read at an offset, both
+ * are told apart before reading so the probe logs nothing.
+ * 
+ * @param[in] pf_in_file Compressed file, read with a positioned read
+ * @param[in out] pc_rle2_header Buffer of RLE2_HEADER_SIZE bytes to hold the header
+ * @return true if the file starts with the RLE2 magic number, false otherwise 
+ */
+static bool b_rle2_probe(FILE *pf_in_file, char *pc_rle2_header)
+{
+    u64 u64_file_size = 0;
+
+    return (true == is_regular_file(pf_in_file, &u64_file_size)) && (RLE2_HEADER_SIZE <= u64_file_size) &&
+           (SUCCESS_STATUS == read_file_at(pf_in_file, pc_rle2_header, RLE2_HEADER_SIZE, 0)) &&
+           (true == rle2_has_magic(pc_rle2_header, RLE2_HEADER_SIZE));
+}
+
+/**
+ * @brief Decode a compressed file sequentially, window by window
+ * 
+ * Used for text .rle files, version 1 .rle2 streams and block files that cannot be
+ * read with positioned reads. The format is detected from the magic number.
+ * 
+ * @param[in out] pstr_source Input source of the compressed file, mapped files are decoded in place
+ * @param[in out] pstr_window Output window the decompressed data is written through, not reserved yet, without writer to discard it
+ * @param[in out] pstr_stats Statistics of the file, NULL to record nothing
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_decompress_stream(tstr_input_source *pstr_source, tstr_output_window *pstr_window, tstr_codec_stats *pstr_stats)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_stream_decoder str_decoder;
+    u64 u64_mark_ns = stats_mark(pstr_stats);
+    u64 u64_code_ns = 0;                                            // Decoding time, full windows are written from inside the decoder
+    const u64 u64_write_start_ns = (NULL != pstr_window->pstr_writer) ? pstr_window->pstr_writer->u64_busy_ns : 0;
+    u64 u64_write_ns = 0;
+
+    stream_decoder_init(&str_decoder);
+
+    do
     {
-        s32_ret_val = SUCCESS_STATUS;
+        while (1)
+        {
+            const char *pc_raw_window = NULL;
+            u64 u64_raw_window_size = 0;
+            u64 u64_code_start_ns = 0;
+
+            s32_ret_val = input_source_view(pstr_source, DATA_WINDOW_SIZE_BYTES, &pc_raw_window, &u64_raw_window_size);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_READ, u64_mark_ns);
+            u64_code_start_ns = u64_mark_ns;
+
+            if (0 == u64_raw_window_size)
+            {
+                break;
+            }
+
+            s32_ret_val = stream_decoder_update(&str_decoder, pc_raw_window, u64_raw_window_size, pstr_window);
+            ERROR_BREAK(s32_ret_val);
+
+            input_source_consume(pstr_source, u64_raw_window_size);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+            u64_code_ns += u64_mark_ns - u64_code_start_ns;
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = stream_decoder_finish(&str_decoder, pstr_window);
+        ERROR_BREAK(s32_ret_val);
+
+        u64_code_ns += stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns) - u64_mark_ns;
+
+    } while (0);
+
+    u64_write_ns = (NULL != pstr_window->pstr_writer) ? (pstr_window->pstr_writer->u64_busy_ns - u64_write_start_ns) : 0;
+
+    stats_phase_move(pstr_stats, STATS_PHASE_CODE, STATS_PHASE_WRITE, u64_write_ns);
+    stats_thread_add(pstr_stats, thread_pool_current_slot(), pstr_window->u64_total_size, (u64_code_ns > u64_write_ns) ? (u64_code_ns - u64_write_ns) : 0);
+
+    stream_decoder_free(&str_decoder);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decode a live stream, decoded data is flushed as the flush policy asks
+ * 
+ * Compressed data is decoded as it arrives through a codec context. .rle2 blocks come
+ * out whole once their last byte arrives. The text format cannot tell that a count is
+ * complete before the next symbol, the part of its last run known so far is written on
+ * every flush.
+ * 
+ * @param[in] pf_in_file Input stream, read through its file descriptor
+ * @param[in out] pstr_writer Writer of the output stream
+ * @param[in] pstr_options Flush policy
+ * @param[in out] pstr_stats Statistics of the stream, NULL to record nothing, the read phase includes waiting for input
+ * @param[in out] pu64_total_in_size Pointer to hold the number of compressed bytes read
+ * @param[in out] pu64_total_size Pointer to hold the number of decoded bytes
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_decompress_live(FILE *pf_in_file, tstr_async_writer *pstr_writer, const tstr_codec_options *pstr_options, tstr_codec_stats *pstr_stats,
+                               u64 *pu64_total_in_size, u64 *pu64_total_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_codec_context str_context;
+    tstr_byte_buffer str_raw;
+    const tstr_output_window *pstr_window = &str_context.str_window;
+    u64 u64_pending_since_ms = 0;        // Arrival time of the oldest data not flushed yet
+    bool b_pending = false;
+    bool b_end_of_file = false;
+    const u32 u32_slot = thread_pool_current_slot();
+    u64 u64_mark_ns = stats_mark(pstr_stats);
+
+    byte_buffer_init(&str_raw);
+    codec_context_init(&str_context, FILE_FORMAT_RLE);
+
+    // Full windows go to the writer from inside the decoder, so memory stays bounded however far a chunk expands
+    codec_context_set_writer(&str_context, pstr_writer);
 
-        char non_digit_char;
-        char ac_char_cnt_string[20] = {0};
-        u8 u8_char_cnt_str_idx = 0;
-        u64 u64_char_cnt = 0;
-        u64 u64_write_idx = 0;
-        u64 u64_needed_size = 0; // Variable to hold needed size for realloc checks
+    *pu64_total_in_size = 0;
+    *pu64_total_size = 0;
 
-        char *pc_output_data_shadow = pc_output_data; // Shadow pointer to free in case of realloc failure
+    do
+    {
+        s32_ret_val = byte_buffer_reserve(&str_raw, DATA_WINDOW_SIZE_BYTES);
+        ERROR_BREAK(s32_ret_val);
 
-        for (u64 i = 0; i < u64_input_data_size; i++)
+        while (false == b_end_of_file)
         {
-            if ('\\' == pc_input_data[i] && (i + 1) < u64_input_data_size)
+            s32 s32_timeout_ms = -1;
+            u64 u64_read_size = 0;
+            u64 u64_code_start_ns = 0;
+            u64 u64_write_start_ns = 0;
+            u64 u64_decoded_size = 0;
+            bool b_flush = false;
+
+            if ((true == b_pending) && (FLUSH_POLICY_INTERVAL == pstr_options->enu_flush_policy))
             {
-                if ('n' == pc_input_data[i + 1])
-                {
-                    non_digit_char = '\n';
-                }
-                else if ('t' == pc_input_data[i + 1])
-                {
-                    non_digit_char = '\t';
-                }
-                else if (pc_input_data[i + 1] >= '0' && pc_input_data[i + 1] <= '9')
-                {
-                    non_digit_char = pc_input_data[i + 1];
-                }
-                else
+                u64 u64_waited_ms = get_monotonic_time_ms() - u64_pending_since_ms;
+
+                s32_timeout_ms = (u64_waited_ms >= pstr_options->u32_flush_ms) ? 0 : (s32)(pstr_options->u32_flush_ms - u64_waited_ms);
+            }
+
+            s32_ret_val = read_file_available(pf_in_file, str_raw.pc_data, DATA_WINDOW_SIZE_BYTES, s32_timeout_ms, &u64_read_size, &b_end_of_file);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_READ, u64_mark_ns);
+            u64_code_start_ns = u64_mark_ns;
+            u64_write_start_ns = pstr_writer->u64_busy_ns;
+            *pu64_total_in_size += u64_read_size;
+
+            if (0 != u64_read_size)
+            {
+                s32_ret_val = codec_decompress_push(&str_context, str_raw.pc_data, u64_read_size);
+                ERROR_BREAK(s32_ret_val);
+
+                if (false == b_pending)
                 {
-                    non_digit_char = '\\';
+                    b_pending = true;
+                    u64_pending_since_ms = get_monotonic_time_ms();
                 }
-                i++; // Skip the next character as it's part of the escape sequence
             }
-            else
+
+            // Line mode passes decoded data on as soon as it is out
+            b_flush = (true == b_pending) && ((FLUSH_POLICY_LINE == pstr_options->enu_flush_policy) ||
+                                              ((get_monotonic_time_ms() - u64_pending_since_ms) >= pstr_options->u32_flush_ms));
+
+            if (true == b_flush)
             {
-                non_digit_char = pc_input_data[i];
+                s32_ret_val = codec_decompress_flush(&str_context);
+                ERROR_BREAK(s32_ret_val);
             }
 
-            pc_output_data[u64_write_idx++] = non_digit_char;
+            u64_decoded_size = pstr_window->u64_total_size + pstr_window->str_buffer.u64_size - *pu64_total_size;
+            *pu64_total_size += u64_decoded_size;
+
+            // Windows written from inside the decoder count as write time
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+            stats_phase_move(pstr_stats, STATS_PHASE_CODE, STATS_PHASE_WRITE, pstr_writer->u64_busy_ns - u64_write_start_ns);
+            stats_thread_add(pstr_stats, u32_slot, u64_decoded_size, u64_mark_ns - u64_code_start_ns);
 
-            i++;
-            while ((pc_input_data[i] >= '0') && (pc_input_data[i] <= '9'))
+            if (true == b_flush)
             {
-                ac_char_cnt_string[u8_char_cnt_str_idx++] = pc_input_data[i++];
+                s32_ret_val = async_writer_flush(pstr_writer);
+                ERROR_BREAK(s32_ret_val);
+
+                b_pending = false;
             }
-            i--;
 
-            u64_char_cnt = atoi(ac_char_cnt_string);
-            u8_char_cnt_str_idx = 0;
-            memset(ac_char_cnt_string, 0, sizeof(ac_char_cnt_string));
+            u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+        }
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = codec_decompress_finish(&str_context);
+        ERROR_BREAK(s32_ret_val);
+
+        u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_CODE, u64_mark_ns);
+
+        // The decoder is done, this only hands the last window to the writer
+        s32_ret_val = codec_decompress_flush(&str_context);
+        ERROR_BREAK(s32_ret_val);
+
+        *pu64_total_size = pstr_window->u64_total_size;
+
+        stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+
+    } while (0);
+
+    codec_context_free(&str_context);
+    byte_buffer_free(&str_raw);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decompress the input file using RLE compression
+ * 
+ * The compressed file is parsed incrementally and the expanded output goes through
+ * a fixed-size write window, so memory use does not depend on the file sizes.
+ * The format and the block codec are read from the file header, whatever the file is named,
+ * files without a .rle2 header must be text .rle files.
+ * Seekable .rle2 block files are decoded in parallel through their block index.
+ * In test mode the data is decoded and every block checked against its CRC32C, nothing is written.
+ * 
+ * @param[in] input_file_name Path to the input file to be decompressed
+ * @param[in] pstr_options Thread count of the decompression and test mode, the format is detected
+ * @param[in out] pstr_pool Pool shared with other files to decode the blocks on, NULL to start one for this file
+ * @param[in out] pstr_stats Pointer to hold the phase timings, sizes and buffer memory of the file, NULL to record nothing
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 decompress(const char *input_file_name, const tstr_codec_options *pstr_options, tstr_thread_pool *pstr_pool, tstr_codec_stats *pstr_stats)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == input_file_name || NULL == pstr_options)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if ((0 == pstr_options->u32_thread_count) || (THREAD_POOL_MAX_THREADS < pstr_options->u32_thread_count))
+    {
+        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+    }
+    else
+    {
+        LOG_INFO("Decompressing file: %s", input_file_name);
+
+        stats_begin(pstr_stats);
+
+        u64 u64_mark_ns = stats_mark(pstr_stats);
+        FILE *pf_in_file = NULL;
+        char *pc_out_file_path = NULL;
+        u64 u64_in_file_size = 0;
+        u64 u64_total_in_size = 0;
+        tstr_input_source str_source = {0};
+        tstr_async_writer str_writer;
+        bool b_writer_open = false;
+
+        char ac_rle2_header[RLE2_HEADER_SIZE];
+        tstr_rle2_header str_rle2_header = {0};
+        tstr_output_window str_window = {{NULL, 0, 0}, 0, 0, NULL, NULL, NULL, 0};
 
-            u64_needed_size = u64_write_idx + u64_char_cnt + 1; // +1 for the already written character
+        bool b_rle2_magic = false;
 
-            if ((u64_needed_size / 2) < UINT32_MAX)
+        // "-" streams stdin to stdout, a flush policy makes it decode input as it arrives
+        const bool b_stdio = (0 == strcmp(input_file_name, "-"));
+        const bool b_test = pstr_options->b_test_only;
+        const bool b_live = (true == b_stdio) && (false == b_test) && (FLUSH_POLICY_NONE != pstr_options->enu_flush_policy);
+
+        do
+        {
+            if (true == b_stdio)
             {
-                if (u64_needed_size >= *pu64_output_data_size)
+                pf_in_file = stdin;
+                str_window.pf_file = (true == b_test) ? NULL : stdout;
+            }
+            else
+            {
+                const size_t sz_path_len = strlen(input_file_name);
+
+                s32_ret_val = open_file(input_file_name, "rb", &pf_in_file);
+                ERROR_BREAK(s32_ret_val);
+
+                // The content tells the format, only the text format has no magic number and goes by its extension
+                b_rle2_magic = b_rle2_probe(pf_in_file, ac_rle2_header);
+
+                if ((false == b_rle2_magic) && ((sz_path_len <= 4) || (0 != strcmp(&input_file_name[sz_path_len - 4], ".rle"))))
                 {
-                    LOG("Reallocating memory for decompression buffer.");
+                    LOG_ERROR("%s has no RLE2 magic number and is not a text .rle file.", input_file_name);
+                    s32_ret_val = ERROR_FILE_EXTENSION;
+                    break;
+                }
+
+                if (true == b_rle2_magic)
+                {
+                    const tstr_codec_entry *pstr_codec = NULL;
 
-                    *pu64_output_data_size += DATA_CHUNK_SIZE_BYTES;
-                    pc_output_data = (char *)realloc(pc_output_data, *pu64_output_data_size);
+                    s32_ret_val = rle2_read_header(ac_rle2_header, RLE2_HEADER_SIZE, &str_rle2_header);
+                    ERROR_BREAK(s32_ret_val);
 
-                    if (NULL == pc_output_data)
+                    pstr_codec = codec_registry_get(str_rle2_header.u8_codec);
+                    if (NULL == pstr_codec)
                     {
-                        LOG_ERROR("Error reallocating memory for decompression buffer: %s", strerror(errno));
-                        s32_ret_val == ERROR_MEMORY_ALLOCATION_FAILED;
-                        free(pc_output_data_shadow);
-                        pc_output_data_shadow = NULL;
+                        LOG_ERROR("%s was written with unknown codec %u.", input_file_name, str_rle2_header.u8_codec);
+                        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
                         break;
                     }
+                    LOG("Codec: %s", pstr_codec->pc_name);
                 }
+
+                // A test decodes into a window without file, nothing is created
+                if (false == b_test)
+                {
+                    s32_ret_val = create_output_file(input_file_name, "txt", &pc_out_file_path);
+                    ERROR_BREAK(s32_ret_val);
+
+                    s32_ret_val = open_file(pc_out_file_path, "wb", &str_window.pf_file);
+                    ERROR_BREAK(s32_ret_val);
+                }
+            }
+
+            if (false == b_live)
+            {
+                s32_ret_val = input_source_open(&str_source, pf_in_file, pstr_options->enu_io_backend);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            // Block files on seekable storage are decoded in parallel through their index, stdout only takes a stream
+            if ((false == b_stdio) && (true == b_rle2_magic) && (true == is_regular_file(pf_in_file, &u64_in_file_size)) &&
+                (RLE2_VERSION_BLOCKS == str_rle2_header.u8_version))
+            {
+                u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_OPEN, u64_mark_ns);
+                u64_total_in_size = u64_in_file_size;
+
+                s32_ret_val = s32_decompress_rle2_blocks(&str_source, u64_in_file_size, str_window.pf_file, &str_rle2_header,
+                                                         pstr_options->u32_thread_count, pstr_pool, pstr_stats, &str_window.u64_total_size);
+                ERROR_BREAK(s32_ret_val);
+            }
+            else if (true == b_test)
+            {
+                u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_OPEN, u64_mark_ns);
+
+                s32_ret_val = s32_decompress_stream(&str_source, &str_window, pstr_stats);
+                u64_total_in_size = str_source.u64_offset;
+                ERROR_BREAK(s32_ret_val);
             }
             else
             {
-                LOG_ERROR("Output data size is too large.");
-                s32_ret_val = ERROR_INVALID_LENGTH;
-                break;
+                s32_ret_val = async_writer_open(&str_writer, str_window.pf_file, pstr_options->enu_io_backend);
+                ERROR_BREAK(s32_ret_val);
+
+                b_writer_open = true;
+                str_window.pstr_writer = &str_writer;
+                u64_mark_ns = stats_phase_end(pstr_stats, STATS_PHASE_OPEN, u64_mark_ns);
+
+                if (true == b_live)
+                {
+                    s32_ret_val = s32_decompress_live(pf_in_file, &str_writer, pstr_options, pstr_stats, &u64_total_in_size, &str_window.u64_total_size);
+                }
+                else
+                {
+                    s32_ret_val = s32_decompress_stream(&str_source, &str_window, pstr_stats);
+                    u64_total_in_size = str_source.u64_offset;
+                }
+                ERROR_BREAK(s32_ret_val);
+
+                u64_mark_ns = stats_mark(pstr_stats);
+
+                s32_ret_val = async_writer_flush(&str_writer);
+                ERROR_BREAK(s32_ret_val);
+
+                stats_phase_end(pstr_stats, STATS_PHASE_WRITE, u64_mark_ns);
+            }
+
+            u64_mark_ns = stats_mark(pstr_stats);
+
+            if (false == b_stdio)
+            {
+                s32_ret_val = close_file(&pf_in_file);
+                ERROR_BREAK(s32_ret_val);
+
+                if (false == b_test)
+                {
+                    s32_ret_val = close_file(&str_window.pf_file);
+                    ERROR_BREAK(s32_ret_val);
+                }
             }
 
-            for (u64 j = 1; j < u64_char_cnt; j++)
+            stats_phase_end(pstr_stats, STATS_PHASE_CLOSE, u64_mark_ns);
+
+            if (true == b_test)
             {
-                pc_output_data[u64_write_idx++] = non_digit_char;
+                LOG_INFO("File tested successfully: %s (%lu bytes decoded)", input_file_name, str_window.u64_total_size);
+            }
+            else
+            {
+                LOG_INFO("File decompressed successfully to: %s (%lu bytes out)", b_stdio ? "stdout" : pc_out_file_path, str_window.u64_total_size);
             }
-        }
 
-        if (SUCCESS_STATUS != s32_ret_val)
+        } while (0);
+
+        // Writes still in flight after an error are waited for before the file is closed
+        if (true == b_writer_open)
         {
-            LOG_ERROR("RLE Decompression failed with error code: %d", s32_ret_val);
+            async_writer_free(&str_writer);
         }
-        else
+
+        // Clean-up
+        if (SUCCESS_STATUS != s32_ret_val)
         {
-            *pu64_output_data_size = u64_write_idx;
+            LOG_ERROR("Exit decompression loop with error code: %d", s32_ret_val);
 
-            LOG("Reallocating decompression buffer to the actual decompressed size.");
+            // stdin and stdout stay open, there is no output file to delete
+            if ((NULL != pf_in_file) && (false == b_stdio))
+            {
+                close_file(&pf_in_file);
+            }
 
-            pc_output_data = (char *)realloc(pc_output_data, *pu64_output_data_size);
-            if (NULL == pc_output_data)
+            if ((NULL != str_window.pf_file) && (false == b_stdio))
             {
-                LOG_ERROR("Error reallocating memory to the actual decompressed size: %s", strerror(errno));
-                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
-                free(pc_output_data_shadow);
-                pc_output_data_shadow = NULL;
+                close_file(&str_window.pf_file);
             }
-            else
+
+            if ((NULL != pc_out_file_path) && (true == check_file_exists(pc_out_file_path)))
             {
-                LOG("RLE Decompression successful. Decompressed size: %lu bytes", *pu64_output_data_size);
+                delete_file(pc_out_file_path);
             }
         }
+
+        // Free allocated memory
+        input_source_close(&str_source);
+        free_allocated_memory(pc_out_file_path);
+        byte_buffer_free(&str_window.str_buffer);
+
+        stats_end(pstr_stats, u64_total_in_size, str_window.u64_total_size);
     }
 
     return s32_ret_val;
 }
 
 /**
- * @brief Decompress the input file using RLE compression
+ * @brief Resolve a requested range against the size of the original data
  * 
- * @param[in] input_file_name Path to the input file to be decompressed
- * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ * @param[in] s64_offset First byte of the range, negative to count back from the end
+ * @param[in] u64_length Length of the range, cut at the end of the data
+ * @param[in] u64_raw_size Size of the original data
+ * @param[in out] pu64_range_start Pointer to hold the first byte of the range
+ * @param[in out] pu64_range_end Pointer to hold the end of the range, exclusive
+ * @return void
  */
-s32 decompress(const char *input_file_name)
+static void range_resolve(const s64 s64_offset, const u64 u64_length, const u64 u64_raw_size, u64 *pu64_range_start, u64 *pu64_range_end)
 {
-    s32 s32_ret_val = FAILURE_STATUS;
+    u64 u64_start = (u64)s64_offset;
 
-    if (NULL == input_file_name)
+    if (s64_offset < 0)
     {
-        s32_ret_val = ERROR_NULL_POINTER;
+        u64_start = ((u64)(-s64_offset) > u64_raw_size) ? 0 : (u64_raw_size - (u64)(-s64_offset));
     }
-    else
+
+    if (u64_start > u64_raw_size)
     {
-        LOG_INFO("Decompressing file: %s", input_file_name);
+        u64_start = u64_raw_size;
+    }
 
-        FILE *pf_in_file = NULL;
-        FILE *pf_out_file = NULL;
-        char *pc_out_file_path = NULL;
-        char *pc_raw_data_buff = NULL;
-        u64 u64_raw_data_size = 0;
+    *pu64_range_start = u64_start;
+    *pu64_range_end = ((u64_raw_size - u64_start) < u64_length) ? u64_raw_size : (u64_start + u64_length);
+}
 
-        char *pc_decompressed_buff = NULL;
-        u64 u64_decompressed_size = 0;
+/**
+ * @brief Decode a byte range of a seekable .rle2 version 2 file, only the blocks covering it are read
+ * 
+ * @param[in] pf_in_file Compressed file, read with positioned reads
+ * @param[in] u64_in_file_size Size of the compressed file
+ * @param[in] s64_offset First byte of the range, negative to count back from the end
+ * @param[in] u64_length Length of the range, cut at the end of the data
+ * @param[in out] pstr_output Output window of the range
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_decompress_range_blocks(FILE *pf_in_file, const u64 u64_in_file_size, const s64 s64_offset, const u64 u64_length, tstr_output_window *pstr_output)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
 
-        char ac_input_file_extention[5] = {0};
+    tstr_block_index_entry *pstr_entries = NULL;
+    u32 u32_block_count = 0;
+    tstr_byte_buffer str_coded;
+    tstr_output_window str_block_window = {{NULL, 0, 0}, 0, 0, NULL, NULL, NULL, 0, pstr_output, 0, 0};
 
-        do
+    byte_buffer_init(&str_coded);
+
+    do
+    {
+        u64 u64_range_start = 0;
+        u64 u64_range_end = 0;
+
+        s32_ret_val = container_load_index(pf_in_file, u64_in_file_size, &pstr_entries, &u32_block_count);
+        ERROR_BREAK(s32_ret_val);
+
+        range_resolve(s64_offset, u64_length, container_index_raw_size(pstr_entries, u32_block_count), &u64_range_start, &u64_range_end);
+
+        str_block_window.u64_range_start = u64_range_start;
+        str_block_window.u64_range_end = u64_range_end;
+
+        if (u64_range_start == u64_range_end)
         {
-            s32_ret_val = get_file_extension(input_file_name, ac_input_file_extention);
-            ERROR_BREAK(s32_ret_val);
+            break;
+        }
 
-            if (0 != strcmp("rle", ac_input_file_extention))
-            {
-                LOG_ERROR("Invalid file extension for decompression. Expected .rle");
-                s32_ret_val = ERROR_FILE_EXTENSION;
-                break;
-            }
+        s32_ret_val = byte_buffer_reserve(&str_coded, CONTAINER_BLOCK_BOUND(CONTAINER_BLOCK_SIZE_BYTES));
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = output_window_reserve(&str_block_window, CONTAINER_BLOCK_SIZE_BYTES);
+        ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = open_file(input_file_name, "r", &pf_in_file);
+        // The index covers the data from offset 0, the first block is the one holding the range start
+        const u32 u32_first_block = container_find_block(pstr_entries, u32_block_count, u64_range_start);
+
+        for (u32 i = u32_first_block; (i < u32_block_count) && (pstr_entries[i].u64_raw_offset < u64_range_end); i++)
+        {
+            const tstr_block_index_entry *pstr_entry = &pstr_entries[i];
+            tstr_block_header str_header = {0};
+
+            s32_ret_val = container_read_indexed_block(pf_in_file, pstr_entry, str_coded.pc_data, &str_header);
             ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = read_file(pf_in_file, &pc_raw_data_buff, &u64_raw_data_size);
+            // The block is decoded whole into the window, its flush copies the part in the range to the output
+            str_block_window.str_buffer.u64_size = 0;
+            str_block_window.u64_total_size = pstr_entry->u64_raw_offset;
+
+            s32_ret_val = container_decode_block(&str_header, &str_coded.pc_data[CONTAINER_BLOCK_HEADER_SIZE], &str_block_window);
             ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = close_file(&pf_in_file);
+            s32_ret_val = output_window_flush(&str_block_window);
             ERROR_BREAK(s32_ret_val);
+        }
+
+    } while (0);
 
-            u64_decompressed_size = u64_raw_data_size / 2;  // best scenario of size
-            pc_decompressed_buff = (char *)malloc(u64_decompressed_size);
+    free_allocated_memory(pstr_entries);
+    byte_buffer_free(&str_coded);
+    byte_buffer_free(&str_block_window.str_buffer);
 
-            if (NULL == pc_decompressed_buff)
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decode a byte range of a file without block index, from its start up to the end of the range
+ * 
+ * @param[in out] pstr_source Input source of the compressed file
+ * @param[in] u64_range_start First byte of the range
+ * @param[in] u64_range_end End of the range, exclusive
+ * @param[in out] pstr_output Output window of the range
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_decompress_range_stream(tstr_input_source *pstr_source, const u64 u64_range_start, const u64 u64_range_end, tstr_output_window *pstr_output)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_stream_decoder str_decoder;
+    tstr_output_window str_window = {{NULL, 0, 0}, 0, 0, NULL, NULL, NULL, 0, pstr_output, u64_range_start, u64_range_end};
+    bool b_end_of_file = false;
+
+    stream_decoder_init(&str_decoder);
+
+    do
+    {
+        // Every flush of the window copies its part of the range to the output, runs outside the range are only counted
+        s32_ret_val = output_window_reserve(&str_window, DATA_WINDOW_SIZE_BYTES);
+        ERROR_BREAK(s32_ret_val);
+
+        while ((false == b_end_of_file) && (str_window.u64_total_size + str_window.str_buffer.u64_size < u64_range_end))
+        {
+            const char *pc_raw_window = NULL;
+            u64 u64_raw_window_size = 0;
+
+            s32_ret_val = input_source_view(pstr_source, DATA_WINDOW_SIZE_BYTES, &pc_raw_window, &u64_raw_window_size);
+            ERROR_BREAK(s32_ret_val);
+
+            if (0 == u64_raw_window_size)
             {
-                LOG_ERROR("Error allocating memory for decompression buffer: %s", strerror(errno));
-                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
-                break;
+                b_end_of_file = true;
+                s32_ret_val = stream_decoder_finish(&str_decoder, &str_window);
             }
+            else
+            {
+                // Mapped files come as one view, one window at a time stops the decode soon after the range
+                if (u64_raw_window_size > DATA_WINDOW_SIZE_BYTES)
+                {
+                    u64_raw_window_size = DATA_WINDOW_SIZE_BYTES;
+                }
 
-            s32_ret_val = s32_rle_decompress(pc_raw_data_buff, u64_raw_data_size, pc_decompressed_buff, &u64_decompressed_size);
+                s32_ret_val = stream_decoder_update(&str_decoder, pc_raw_window, u64_raw_window_size, &str_window);
+                input_source_consume(pstr_source, u64_raw_window_size);
+            }
             ERROR_BREAK(s32_ret_val);
+        }
+        ERROR_BREAK(s32_ret_val);
 
-            s32_ret_val = create_output_file(input_file_name, "txt", &pc_out_file_path);
-            ERROR_BREAK(s32_ret_val);
+        s32_ret_val = output_window_flush(&str_window);
 
-            s32_ret_val = open_file(pc_out_file_path, "w", &pf_out_file);
-            ERROR_BREAK(s32_ret_val);
+    } while (0);
 
-            s32_ret_val = write_file(pf_out_file, pc_decompressed_buff, u64_decompressed_size);
-            ERROR_BREAK(s32_ret_val);
+    stream_decoder_free(&str_decoder);
+    byte_buffer_free(&str_window.str_buffer);
 
-            s32_ret_val = close_file(&pf_out_file);
-            ERROR_BREAK(s32_ret_val);
+    return s32_ret_val;
+}
 
-            LOG_INFO("File decompressed successfully to: %s", pc_out_file_path);
+/**
+ * @brief Decompress one byte range of a compressed file
+ * 
+ * Seekable .rle2 block files are cut into blocks that start at known offsets of the
+ * original data, only the blocks covering the range are read and decoded. Files without
+ * block index (text .rle, version 1 .rle2 streams) are decoded from their start up to the
+ * end of the range.
+ * 
+ * @param[in] input_file_name Path to the compressed file
+ * @param[in] s64_offset First byte of the range, negative to count back from the end (block files and sized streams only)
+ * @param[in] u64_length Length of the range, cut at the end of the data
+ * @param[in] pf_output_file File to write the range to, NULL to append it to pstr_output_buffer
+ * @param[in out] pstr_output_buffer Buffer to append the range to when there is no output file
+ * @param[in out] pu64_range_size Pointer to hold the size of the range written, NULL if not needed
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 decompress_range(const char *input_file_name, const s64 s64_offset, const u64 u64_length, FILE *pf_output_file, tstr_byte_buffer *pstr_output_buffer,
+                     u64 *pu64_range_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
 
-        } while (0);
+    if ((NULL == input_file_name) || ((NULL == pf_output_file) && (NULL == pstr_output_buffer)))
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        FILE *pf_in_file = NULL;
+        u64 u64_in_file_size = 0;
+        char ac_rle2_header[RLE2_HEADER_SIZE];
+        tstr_rle2_header str_rle2_header = {0};
+        bool b_rle2_magic = false;
+        tstr_input_source str_source = {0};
+        tstr_output_window str_output = {{NULL, 0, 0}, 0, 0, pf_output_file, NULL, (NULL == pf_output_file) ? pstr_output_buffer : NULL, 0};
 
-        // Clean-up
-        if (SUCCESS_STATUS != s32_ret_val)
+        do
         {
-            LOG_ERROR("Exit decompression loop with error code: %d", s32_ret_val);
+            s32_ret_val = open_file(input_file_name, "rb", &pf_in_file);
+            ERROR_BREAK(s32_ret_val);
+
+            b_rle2_magic = b_rle2_probe(pf_in_file, ac_rle2_header);
 
-            if (NULL != pf_in_file)
+            if (true == b_rle2_magic)
             {
-                s32_ret_val = close_file(&pf_in_file);
+                s32_ret_val = rle2_read_header(ac_rle2_header, RLE2_HEADER_SIZE, &str_rle2_header);
+                ERROR_BREAK(s32_ret_val);
             }
 
-            if (NULL != pf_out_file)
+            s32_ret_val = output_window_reserve(&str_output, DATA_WINDOW_SIZE_BYTES);
+            ERROR_BREAK(s32_ret_val);
+
+            if ((true == b_rle2_magic) && (RLE2_VERSION_BLOCKS == str_rle2_header.u8_version) && (true == is_regular_file(pf_in_file, &u64_in_file_size)))
             {
-                s32_ret_val = close_file(&pf_out_file);
+                s32_ret_val = s32_decompress_range_blocks(pf_in_file, u64_in_file_size, s64_offset, u64_length, &str_output);
             }
+            else
+            {
+                u64 u64_range_start = (u64)s64_offset;
+                u64 u64_range_end = ((UINT64_MAX - u64_range_start) < u64_length) ? UINT64_MAX : (u64_range_start + u64_length);
+
+                // Counting from the end needs the size of the original data up front
+                if (s64_offset < 0)
+                {
+                    if ((false == b_rle2_magic) || (0 != (str_rle2_header.u8_flags & RLE2_FLAG_SIZE_UNKNOWN)))
+                    {
+                        LOG_ERROR("%s does not record its original size, offsets from the end need a .rle2 file.", input_file_name);
+                        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+                        break;
+                    }
+
+                    range_resolve(s64_offset, u64_length, str_rle2_header.u64_original_size, &u64_range_start, &u64_range_end);
+                }
 
-            if (true == check_file_exists(pc_out_file_path))
+                LOG("%s has no block index, decoding it from the start.", input_file_name);
+
+                s32_ret_val = input_source_open(&str_source, pf_in_file, IO_BACKEND_AUTO);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = s32_decompress_range_stream(&str_source, u64_range_start, u64_range_end, &str_output);
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = output_window_flush(&str_output);
+            ERROR_BREAK(s32_ret_val);
+
+            if (NULL != pu64_range_size)
             {
-                s32_ret_val = delete_file(pc_out_file_path);
+                *pu64_range_size = str_output.u64_total_size;
             }
+
+        } while (0);
+
+        input_source_close(&str_source);
+
+        if (NULL != pf_in_file)
+        {
+            close_file(&pf_in_file);
         }
 
-        // Free allocated memory
-        free_allocated_memory(pc_raw_data_buff);
-        free_allocated_memory(pc_out_file_path);
-        free_allocated_memory(pc_decompressed_buff);
+        byte_buffer_free(&str_output.str_buffer);
     }
 
     return s32_ret_val;
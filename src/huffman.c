@@ -0,0 +1,660 @@
+#include <string.h>
+#include <endian.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/huffman.h"
+
+// Largest block the length codes can describe, runs are at most 2^20 bytes long
+#define HUFFMAN_MAX_BLOCK_SIZE        (1u << 20)
+
+// Bits kept in the reader accumulator after a refill, enough for one whole run
+#define HUFFMAN_REFILL_BITS           (56u)
+
+// Bit writer, bits are packed LSB first
+typedef struct {
+    u8  *pu8_output;
+    u64  u64_write_idx;
+    u64  u64_bits;
+    u32  u32_bit_count;
+} tstr_huffman_bit_writer;
+
+// Bit reader, bits are consumed LSB first
+typedef struct {
+    const u8 *pu8_input;
+    const u8 *pu8_input_end;
+    u64  u64_bits;
+    u32  u32_bit_count;
+} tstr_huffman_bit_reader;
+
+// Node of the code construction, leaves first then internal nodes in creation order
+typedef struct {
+    u32 u32_weight;
+    u16 u16_parent;
+    u16 u16_symbol;
+} tstr_huffman_node;
+
+
+/**
+ * @brief Map a run length to its length code and extra bits
+ * 
+ * @param[in] u64_run_len Length of the run, 1 to HUFFMAN_MAX_BLOCK_SIZE
+ * @param[in out] pu32_extra_bit_count Pointer to hold the number of extra bits
+ * @return u32 Length code
+ */
+static inline u32 u32_huffman_length_code(const u64 u64_run_len, u32 *pu32_extra_bit_count)
+{
+    const u64 u64_value = u64_run_len - 1u;
+    u32 u32_code = (u32)u64_value;
+
+    *pu32_extra_bit_count = 0;
+
+    if (u64_value >= HUFFMAN_DIRECT_LENGTH_COUNT)
+    {
+        const u32 u32_top_bit = 63u - (u32)__builtin_clzll(u64_value);
+
+        u32_code = HUFFMAN_LENGTH_CODE_BIAS + u32_top_bit;
+        *pu32_extra_bit_count = u32_top_bit;
+    }
+
+    return u32_code;
+}
+
+/**
+ * @brief Reverse the low bits of a code, canonical codes are built MSB first but stored LSB first
+ * 
+ * @param[in] u32_code Code to reverse
+ * @param[in] u32_bit_count Number of bits of the code
+ * @return u32 Reversed code
+ */
+static inline u32 u32_huffman_reverse_bits(u32 u32_code, const u32 u32_bit_count)
+{
+    u32 u32_reversed = 0;
+
+    for (u32 i = 0; i < u32_bit_count; i++)
+    {
+        u32_reversed = (u32_reversed << 1) | (u32_code & 1u);
+        u32_code >>= 1;
+    }
+
+    return u32_reversed;
+}
+
+/**
+ * @brief Compute code lengths of at most HUFFMAN_MAX_CODE_LENGTH bits from symbol frequencies
+ * 
+ * Plain Huffman lengths are computed first. Lengths over the limit are clamped, then the
+ * deepest remaining codes of the least frequent symbols are lengthened until the code is
+ * complete again (Kraft sum back to 1).
+ * 
+ * @param[in] pu32_freq Frequency of every symbol
+ * @param[in] u32_symbol_count Number of symbols (at most 256)
+ * @param[in out] pu8_lengths Pointer to hold the code length of every symbol, 0 for unused symbols
+ * @return void
+ */
+static void huffman_build_lengths(const u32 *pu32_freq, const u32 u32_symbol_count, u8 *pu8_lengths)
+{
+    tstr_huffman_node astr_nodes[2u * HUFFMAN_BYTE_SYMBOL_COUNT];
+    u8  au8_depth[2u * HUFFMAN_BYTE_SYMBOL_COUNT];
+    u32 u32_leaf_count = 0;
+
+    memset(pu8_lengths, 0, u32_symbol_count);
+
+    for (u32 i = 0; i < u32_symbol_count; i++)
+    {
+        if (0 != pu32_freq[i])
+        {
+            // Insertion sort by increasing frequency, the alphabets are small
+            u32 j = u32_leaf_count++;
+
+            while ((0 != j) && (astr_nodes[j - 1u].u32_weight > pu32_freq[i]))
+            {
+                astr_nodes[j] = astr_nodes[j - 1u];
+                j--;
+            }
+            astr_nodes[j].u32_weight = pu32_freq[i];
+            astr_nodes[j].u16_symbol = (u16)i;
+        }
+    }
+
+    if (1u == u32_leaf_count)
+    {
+        pu8_lengths[astr_nodes[0].u16_symbol] = 1u;
+    }
+    else if (u32_leaf_count > 1u)
+    {
+        const u32 u32_root = (2u * u32_leaf_count) - 2u;
+        u32 u32_next_leaf = 0;
+        u32 u32_next_internal = u32_leaf_count;
+        u32 u32_kraft_sum = 0;
+
+        // Two queue construction: sorted leaves and internal nodes created in increasing weight order
+        for (u32 u32_node = u32_leaf_count; u32_node <= u32_root; u32_node++)
+        {
+            u32 au32_child[2];
+
+            for (u32 k = 0; k < 2u; k++)
+            {
+                if ((u32_next_leaf < u32_leaf_count) &&
+                    ((u32_next_internal == u32_node) || (astr_nodes[u32_next_leaf].u32_weight <= astr_nodes[u32_next_internal].u32_weight)))
+                {
+                    au32_child[k] = u32_next_leaf++;
+                }
+                else
+                {
+                    au32_child[k] = u32_next_internal++;
+                }
+            }
+
+            astr_nodes[u32_node].u32_weight = astr_nodes[au32_child[0]].u32_weight + astr_nodes[au32_child[1]].u32_weight;
+            astr_nodes[au32_child[0]].u16_parent = (u16)u32_node;
+            astr_nodes[au32_child[1]].u16_parent = (u16)u32_node;
+        }
+
+        au8_depth[u32_root] = 0;
+        for (u32 u32_node = u32_root; u32_node-- > 0;)
+        {
+            const u32 u32_depth = (u32)au8_depth[astr_nodes[u32_node].u16_parent] + 1u;
+
+            au8_depth[u32_node] = (u8)((u32_depth > 255u) ? 255u : u32_depth);
+        }
+
+        for (u32 i = 0; i < u32_leaf_count; i++)
+        {
+            u8 u8_length = au8_depth[i];
+
+            if (u8_length > HUFFMAN_MAX_CODE_LENGTH)
+            {
+                u8_length = (u8)HUFFMAN_MAX_CODE_LENGTH;
+            }
+            pu8_lengths[astr_nodes[i].u16_symbol] = u8_length;
+            u32_kraft_sum += 1u << (HUFFMAN_MAX_CODE_LENGTH - u8_length);
+        }
+
+        while (u32_kraft_sum > HUFFMAN_TABLE_SIZE)
+        {
+            // Lengthen the least frequent of the longest codes still below the limit
+            u32 u32_pick = u32_leaf_count;
+            u8  u8_pick_length = 0;
+
+            for (u32 i = 0; i < u32_leaf_count; i++)
+            {
+                const u8 u8_length = pu8_lengths[astr_nodes[i].u16_symbol];
+
+                if ((u8_length < HUFFMAN_MAX_CODE_LENGTH) && (u8_length > u8_pick_length))
+                {
+                    u32_pick = i;
+                    u8_pick_length = u8_length;
+                }
+            }
+
+            pu8_lengths[astr_nodes[u32_pick].u16_symbol]++;
+            u32_kraft_sum -= 1u << (HUFFMAN_MAX_CODE_LENGTH - u8_pick_length - 1u);
+        }
+    }
+}
+
+/**
+ * @brief Assign canonical codes from code lengths, stored bit reversed for the LSB first bit stream
+ * 
+ * @param[in] pu8_lengths Code length of every symbol, 0 for unused symbols
+ * @param[in] u32_symbol_count Number of symbols
+ * @param[in out] pu16_codes Pointer to hold the code of every symbol
+ * @return s32 SUCCESS_STATUS on success, ERROR_DECOMPRESSION_FAILED when the lengths over-subscribe the code space
+ */
+static s32 s32_huffman_build_codes(const u8 *pu8_lengths, const u32 u32_symbol_count, u16 *pu16_codes)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+    u32 au32_length_count[HUFFMAN_MAX_CODE_LENGTH + 1u] = {0};
+    u32 au32_next_code[HUFFMAN_MAX_CODE_LENGTH + 1u] = {0};
+    u32 u32_kraft_sum = 0;
+    u32 u32_code = 0;
+
+    for (u32 i = 0; i < u32_symbol_count; i++)
+    {
+        au32_length_count[pu8_lengths[i]]++;
+        if (0 != pu8_lengths[i])
+        {
+            u32_kraft_sum += 1u << (HUFFMAN_MAX_CODE_LENGTH - pu8_lengths[i]);
+        }
+    }
+
+    if (u32_kraft_sum > HUFFMAN_TABLE_SIZE)
+    {
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+    else
+    {
+        au32_length_count[0] = 0;
+        for (u32 u32_length = 1; u32_length <= HUFFMAN_MAX_CODE_LENGTH; u32_length++)
+        {
+            u32_code = (u32_code + au32_length_count[u32_length - 1u]) << 1;
+            au32_next_code[u32_length] = u32_code;
+        }
+
+        for (u32 i = 0; i < u32_symbol_count; i++)
+        {
+            if (0 != pu8_lengths[i])
+            {
+                pu16_codes[i] = (u16)u32_huffman_reverse_bits(au32_next_code[pu8_lengths[i]]++, pu8_lengths[i]);
+            }
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Append bits to the bit stream
+ * 
+ * @param[in out] pstr_writer Bit writer
+ * @param[in] u64_bits Bits to append, LSB first
+ * @param[in] u32_bit_count Number of bits to append (at most 32)
+ * @return void
+ */
+static inline void huffman_put_bits(tstr_huffman_bit_writer *pstr_writer, const u64 u64_bits, const u32 u32_bit_count)
+{
+    pstr_writer->u64_bits |= u64_bits << pstr_writer->u32_bit_count;
+    pstr_writer->u32_bit_count += u32_bit_count;
+
+    if (pstr_writer->u32_bit_count >= 32u)
+    {
+        for (u32 i = 0; i < 4u; i++)
+        {
+            pstr_writer->pu8_output[pstr_writer->u64_write_idx++] = (u8)(pstr_writer->u64_bits >> (8u * i));
+        }
+        pstr_writer->u64_bits >>= 32;
+        pstr_writer->u32_bit_count -= 32u;
+    }
+}
+
+/**
+ * @brief Top the reader accumulator up to HUFFMAN_REFILL_BITS bits, or to the end of the stream
+ * 
+ * @param[in out] pstr_reader Bit reader
+ * @return void
+ */
+static inline void huffman_refill(tstr_huffman_bit_reader *pstr_reader)
+{
+    if ((pstr_reader->pu8_input_end - pstr_reader->pu8_input) >= 8)
+    {
+        // Branchless refill: load 8 bytes, keep the whole ones that fit
+        u64 u64_word = 0;
+
+        memcpy(&u64_word, pstr_reader->pu8_input, sizeof(u64_word));
+        pstr_reader->u64_bits |= le64toh(u64_word) << pstr_reader->u32_bit_count;
+        pstr_reader->pu8_input += (63u - pstr_reader->u32_bit_count) >> 3;
+        pstr_reader->u32_bit_count |= HUFFMAN_REFILL_BITS;
+    }
+    else
+    {
+        while ((pstr_reader->u32_bit_count <= HUFFMAN_REFILL_BITS) && (pstr_reader->pu8_input < pstr_reader->pu8_input_end))
+        {
+            pstr_reader->u64_bits |= (u64)(*pstr_reader->pu8_input++) << pstr_reader->u32_bit_count;
+            pstr_reader->u32_bit_count += 8u;
+        }
+    }
+}
+
+/**
+ * @brief Build the run decoding tables from the code lengths of a block
+ * 
+ * Every byte code is combined with the length code that follows it when both fit in one
+ * lookup and the length needs no extra bits, so short runs decode with a single lookup.
+ * 
+ * @param[in] pu8_byte_lengths Code lengths of the run bytes
+ * @param[in] pu8_length_lengths Code lengths of the length codes
+ * @param[in out] pstr_run_table Table of HUFFMAN_TABLE_SIZE run entries
+ * @param[in out] pstr_length_table Table of HUFFMAN_TABLE_SIZE length entries
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_huffman_build_tables(const u8 *pu8_byte_lengths, const u8 *pu8_length_lengths, tstr_huffman_run_entry *pstr_run_table,
+                                    tstr_huffman_length_entry *pstr_length_table)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+    u16 au16_byte_codes[HUFFMAN_BYTE_SYMBOL_COUNT];
+    u16 au16_length_codes[HUFFMAN_LENGTH_SYMBOL_COUNT];
+
+    do
+    {
+        s32_ret_val = s32_huffman_build_codes(pu8_byte_lengths, HUFFMAN_BYTE_SYMBOL_COUNT, au16_byte_codes);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = s32_huffman_build_codes(pu8_length_lengths, HUFFMAN_LENGTH_SYMBOL_COUNT, au16_length_codes);
+        ERROR_BREAK(s32_ret_val);
+
+        memset(pstr_run_table, 0, HUFFMAN_TABLE_SIZE * sizeof(*pstr_run_table));
+        memset(pstr_length_table, 0, HUFFMAN_TABLE_SIZE * sizeof(*pstr_length_table));
+
+        for (u32 u32_symbol = 0; u32_symbol < HUFFMAN_LENGTH_SYMBOL_COUNT; u32_symbol++)
+        {
+            const u32 u32_length = pu8_length_lengths[u32_symbol];
+
+            if (0 != u32_length)
+            {
+                for (u32 u32_idx = au16_length_codes[u32_symbol]; u32_idx < HUFFMAN_TABLE_SIZE; u32_idx += (1u << u32_length))
+                {
+                    pstr_length_table[u32_idx].u8_symbol = (u8)u32_symbol;
+                    pstr_length_table[u32_idx].u8_bit_count = (u8)u32_length;
+                }
+            }
+        }
+
+        for (u32 u32_symbol = 0; u32_symbol < HUFFMAN_BYTE_SYMBOL_COUNT; u32_symbol++)
+        {
+            const u32 u32_length = pu8_byte_lengths[u32_symbol];
+
+            if (0 != u32_length)
+            {
+                for (u32 u32_idx = au16_byte_codes[u32_symbol]; u32_idx < HUFFMAN_TABLE_SIZE; u32_idx += (1u << u32_length))
+                {
+                    // The bits after the byte code are known up to the end of the lookup
+                    const tstr_huffman_length_entry *pstr_next = &pstr_length_table[u32_idx >> u32_length];
+                    tstr_huffman_run_entry *pstr_entry = &pstr_run_table[u32_idx];
+
+                    pstr_entry->u8_symbol = (u8)u32_symbol;
+                    pstr_entry->u8_bit_count = (u8)u32_length;
+                    pstr_entry->u8_run_len = 0;
+
+                    if ((0 != pstr_next->u8_bit_count) && ((u32_length + pstr_next->u8_bit_count) <= HUFFMAN_MAX_CODE_LENGTH) &&
+                        (pstr_next->u8_symbol < HUFFMAN_DIRECT_LENGTH_COUNT))
+                    {
+                        pstr_entry->u8_bit_count += pstr_next->u8_bit_count;
+                        pstr_entry->u8_run_len = (u8)(pstr_next->u8_symbol + 1u);
+                    }
+                }
+            }
+        }
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Code the runs of a block with per-block canonical Huffman codes
+ * 
+ * The exact coded size is known before anything is written, the block is only coded when
+ * it comes out smaller than the raw data.
+ * 
+ * @param[in] pc_input_data Raw data of the block
+ * @param[in] u64_input_data_size Size of the raw data (at most 1 MiB)
+ * @param[in out] pc_output_data Buffer to hold the payload (at least u64_input_data_size bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the payload, the raw size when coding did not pay off
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 huffman_compress_runs(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_input_data_size > HUFFMAN_MAX_BLOCK_SIZE)
+    {
+        LOG_ERROR("Block of %lu bytes is too large for Huffman coded runs.", u64_input_data_size);
+        s32_ret_val = ERROR_COMPRESSION_FAILED;
+    }
+    else
+    {
+        u32 au32_byte_freq[HUFFMAN_BYTE_SYMBOL_COUNT] = {0};
+        u32 au32_length_freq[HUFFMAN_LENGTH_SYMBOL_COUNT] = {0};
+        u8  au8_byte_lengths[HUFFMAN_BYTE_SYMBOL_COUNT];
+        u8  au8_length_lengths[HUFFMAN_LENGTH_SYMBOL_COUNT];
+        u16 au16_byte_codes[HUFFMAN_BYTE_SYMBOL_COUNT];
+        u16 au16_length_codes[HUFFMAN_LENGTH_SYMBOL_COUNT];
+        u64 u64_bit_total = 0;
+        u64 u64_extra_bit_total = 0;
+        u32 u32_run_count = 0;
+        u64 i = 0;
+
+        // First pass: frequencies of the run bytes and length codes
+        while (i < u64_input_data_size)
+        {
+            const u64 u64_run_len = 1u + run_scan_length(&pc_input_data[i + 1u], u64_input_data_size - i - 1u, pc_input_data[i]);
+            u32 u32_extra_bit_count = 0;
+
+            au32_byte_freq[(u8)pc_input_data[i]]++;
+            au32_length_freq[u32_huffman_length_code(u64_run_len, &u32_extra_bit_count)]++;
+            u64_extra_bit_total += u32_extra_bit_count;
+            u32_run_count++;
+            i += u64_run_len;
+        }
+
+        huffman_build_lengths(au32_byte_freq, HUFFMAN_BYTE_SYMBOL_COUNT, au8_byte_lengths);
+        huffman_build_lengths(au32_length_freq, HUFFMAN_LENGTH_SYMBOL_COUNT, au8_length_lengths);
+
+        u64_bit_total = u64_extra_bit_total;
+        for (u32 u32_symbol = 0; u32_symbol < HUFFMAN_BYTE_SYMBOL_COUNT; u32_symbol++)
+        {
+            u64_bit_total += (u64)au32_byte_freq[u32_symbol] * au8_byte_lengths[u32_symbol];
+        }
+        for (u32 u32_symbol = 0; u32_symbol < HUFFMAN_LENGTH_SYMBOL_COUNT; u32_symbol++)
+        {
+            u64_bit_total += (u64)au32_length_freq[u32_symbol] * au8_length_lengths[u32_symbol];
+        }
+
+        *pu64_output_data_size = HUFFMAN_HEADER_SIZE + ((u64_bit_total + 7u) / 8u);
+
+        if (*pu64_output_data_size >= u64_input_data_size)
+        {
+            // Not worth coding, the caller stores the block raw
+            *pu64_output_data_size = u64_input_data_size;
+            s32_ret_val = SUCCESS_STATUS;
+        }
+        else
+        {
+            tstr_huffman_bit_writer str_writer = {(u8 *)pc_output_data, 0, 0, 0};
+
+            s32_huffman_build_codes(au8_byte_lengths, HUFFMAN_BYTE_SYMBOL_COUNT, au16_byte_codes);
+            s32_huffman_build_codes(au8_length_lengths, HUFFMAN_LENGTH_SYMBOL_COUNT, au16_length_codes);
+
+            huffman_put_bits(&str_writer, u32_run_count, 32u);
+            for (u32 u32_symbol = 0; u32_symbol < HUFFMAN_BYTE_SYMBOL_COUNT; u32_symbol += 2u)
+            {
+                huffman_put_bits(&str_writer, (u64)au8_byte_lengths[u32_symbol] | ((u64)au8_byte_lengths[u32_symbol + 1u] << 4), 8u);
+            }
+            for (u32 u32_symbol = 0; u32_symbol < HUFFMAN_LENGTH_SYMBOL_COUNT; u32_symbol += 2u)
+            {
+                huffman_put_bits(&str_writer, (u64)au8_length_lengths[u32_symbol] | ((u64)au8_length_lengths[u32_symbol + 1u] << 4), 8u);
+            }
+
+            // Second pass: the bit stream
+            i = 0;
+            while (i < u64_input_data_size)
+            {
+                const u8  u8_run_char = (u8)pc_input_data[i];
+                const u64 u64_run_len = 1u + run_scan_length(&pc_input_data[i + 1u], u64_input_data_size - i - 1u, pc_input_data[i]);
+                u32 u32_extra_bit_count = 0;
+                const u32 u32_length_code = u32_huffman_length_code(u64_run_len, &u32_extra_bit_count);
+
+                huffman_put_bits(&str_writer, au16_byte_codes[u8_run_char], au8_byte_lengths[u8_run_char]);
+                huffman_put_bits(&str_writer, au16_length_codes[u32_length_code], au8_length_lengths[u32_length_code]);
+                if (0 != u32_extra_bit_count)
+                {
+                    huffman_put_bits(&str_writer, (u64_run_len - 1u) & ((1ull << u32_extra_bit_count) - 1u), u32_extra_bit_count);
+                }
+                i += u64_run_len;
+            }
+
+            while (0 != str_writer.u32_bit_count)
+            {
+                const u32 u32_flush_bits = (str_writer.u32_bit_count > 8u) ? 8u : str_writer.u32_bit_count;
+
+                str_writer.pu8_output[str_writer.u64_write_idx++] = (u8)str_writer.u64_bits;
+                str_writer.u64_bits >>= 8;
+                str_writer.u32_bit_count -= u32_flush_bits;
+            }
+
+            s32_ret_val = SUCCESS_STATUS;
+            LOG("Huffman block compressed: %u runs, %lu bytes in, %lu bytes out", u32_run_count, u64_input_data_size, str_writer.u64_write_idx);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decode a block of Huffman coded runs
+ * 
+ * @param[in] pc_input_data Payload of the block
+ * @param[in] u64_input_data_size Size of the payload
+ * @param[in] u64_raw_size Size of the block once decoded, the runs may not add up to more
+ * @param[in out] pstr_window Output window the decoded data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 huffman_decompress_runs(const char *pc_input_data, const u64 u64_input_data_size, const u64 u64_raw_size, tstr_output_window *pstr_window)
+{
+    // Per-thread tables, rebuilt for every block
+    static __thread tstr_huffman_run_entry    tastr_run_table[HUFFMAN_TABLE_SIZE];
+    static __thread tstr_huffman_length_entry tastr_length_table[HUFFMAN_TABLE_SIZE];
+
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_input_data_size < HUFFMAN_HEADER_SIZE)
+    {
+        LOG_ERROR("Huffman block header is truncated.");
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+    else
+    {
+        const u8 *pu8_input = (const u8 *)pc_input_data;
+        u8  au8_byte_lengths[HUFFMAN_BYTE_SYMBOL_COUNT];
+        u8  au8_length_lengths[HUFFMAN_LENGTH_SYMBOL_COUNT];
+        u32 u32_run_count = (u32)pu8_input[0] | ((u32)pu8_input[1] << 8) | ((u32)pu8_input[2] << 16) | ((u32)pu8_input[3] << 24);
+        u64 u64_raw_left = u64_raw_size;
+
+        for (u32 i = 0; i < (HUFFMAN_BYTE_SYMBOL_COUNT / 2u); i++)
+        {
+            au8_byte_lengths[2u * i] = pu8_input[4u + i] & 0x0Fu;
+            au8_byte_lengths[(2u * i) + 1u] = pu8_input[4u + i] >> 4;
+        }
+        for (u32 i = 0; i < (HUFFMAN_LENGTH_SYMBOL_COUNT / 2u); i++)
+        {
+            au8_length_lengths[2u * i] = pu8_input[4u + (HUFFMAN_BYTE_SYMBOL_COUNT / 2u) + i] & 0x0Fu;
+            au8_length_lengths[(2u * i) + 1u] = pu8_input[4u + (HUFFMAN_BYTE_SYMBOL_COUNT / 2u) + i] >> 4;
+        }
+
+        do
+        {
+            tstr_huffman_bit_reader str_reader = {pu8_input + HUFFMAN_HEADER_SIZE, pu8_input + u64_input_data_size, 0, 0};
+            tstr_byte_buffer *pstr_buffer = &pstr_window->str_buffer;
+
+            if (u32_run_count > u64_raw_size)
+            {
+                LOG_ERROR("Huffman block holds %u runs for %lu bytes.", u32_run_count, u64_raw_size);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            // Nibbles hold lengths up to 15, the code tables only go up to HUFFMAN_MAX_CODE_LENGTH bits
+            s32_ret_val = SUCCESS_STATUS;
+
+            for (u32 i = 0; i < HUFFMAN_BYTE_SYMBOL_COUNT; i++)
+            {
+                if (au8_byte_lengths[i] > HUFFMAN_MAX_CODE_LENGTH)
+                {
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                }
+            }
+            for (u32 i = 0; i < HUFFMAN_LENGTH_SYMBOL_COUNT; i++)
+            {
+                if (au8_length_lengths[i] > HUFFMAN_MAX_CODE_LENGTH)
+                {
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                }
+            }
+
+            if (SUCCESS_STATUS != s32_ret_val)
+            {
+                LOG_ERROR("Huffman block has code lengths over %u bits.", HUFFMAN_MAX_CODE_LENGTH);
+                break;
+            }
+
+            s32_ret_val = s32_huffman_build_tables(au8_byte_lengths, au8_length_lengths, tastr_run_table, tastr_length_table);
+            if (SUCCESS_STATUS != s32_ret_val)
+            {
+                LOG_ERROR("Huffman block has invalid code lengths.");
+                break;
+            }
+
+            while (0 != u32_run_count)
+            {
+                const tstr_huffman_run_entry *pstr_entry = NULL;
+                u64 u64_run_len = 0;
+
+                huffman_refill(&str_reader);
+
+                pstr_entry = &tastr_run_table[str_reader.u64_bits & (HUFFMAN_TABLE_SIZE - 1u)];
+                if ((0 == pstr_entry->u8_bit_count) || (pstr_entry->u8_bit_count > str_reader.u32_bit_count))
+                {
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+                str_reader.u64_bits >>= pstr_entry->u8_bit_count;
+                str_reader.u32_bit_count -= pstr_entry->u8_bit_count;
+
+                u64_run_len = pstr_entry->u8_run_len;
+                if (0 == u64_run_len)
+                {
+                    const tstr_huffman_length_entry *pstr_length = &tastr_length_table[str_reader.u64_bits & (HUFFMAN_TABLE_SIZE - 1u)];
+                    u32 u32_extra_bit_count = 0;
+
+                    if ((0 == pstr_length->u8_bit_count) || (pstr_length->u8_bit_count > str_reader.u32_bit_count))
+                    {
+                        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                        break;
+                    }
+                    str_reader.u64_bits >>= pstr_length->u8_bit_count;
+                    str_reader.u32_bit_count -= pstr_length->u8_bit_count;
+
+                    u64_run_len = (u64)pstr_length->u8_symbol + 1u;
+                    if (pstr_length->u8_symbol >= HUFFMAN_DIRECT_LENGTH_COUNT)
+                    {
+                        u32_extra_bit_count = pstr_length->u8_symbol - HUFFMAN_LENGTH_CODE_BIAS;
+                        if (u32_extra_bit_count > str_reader.u32_bit_count)
+                        {
+                            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                            break;
+                        }
+                        u64_run_len = 1u + ((1ull << u32_extra_bit_count) | (str_reader.u64_bits & ((1ull << u32_extra_bit_count) - 1u)));
+                        str_reader.u64_bits >>= u32_extra_bit_count;
+                        str_reader.u32_bit_count -= u32_extra_bit_count;
+                    }
+                }
+
+                if (u64_run_len > u64_raw_left)
+                {
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+                u64_raw_left -= u64_run_len;
+
+                if (u64_run_len <= (pstr_window->u64_window_size - pstr_buffer->u64_size))
+                {
+                    // Fast path, the whole run fits in the window
+                    run_expand(&pstr_buffer->pc_data[pstr_buffer->u64_size], (char)pstr_entry->u8_symbol, u64_run_len);
+                    pstr_buffer->u64_size += u64_run_len;
+                }
+                else
+                {
+                    s32_ret_val = output_window_append_run(pstr_window, (char)pstr_entry->u8_symbol, u64_run_len);
+                    ERROR_BREAK(s32_ret_val);
+                }
+
+                u32_run_count--;
+            }
+
+            if (SUCCESS_STATUS != s32_ret_val)
+            {
+                LOG_ERROR("Huffman bit stream is corrupted or truncated.");
+            }
+        } while (0);
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,358 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/input_source.h"
+
+
+/**
+ * @brief Queue the read of the next chunk of the file into a chunk buffer
+ * 
+ * @param[in out] pstr_source Input source in read-ahead mode
+ * @param[in] u32_chunk Chunk to fill, idle on return when the whole file is queued already
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_input_source_queue_chunk(tstr_input_source *pstr_source, const u32 u32_chunk)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    u64 u64_chunk_size = pstr_source->u64_file_size - pstr_source->u64_read_offset;
+
+    if (u64_chunk_size > INPUT_SOURCE_CHUNK_SIZE_BYTES)
+    {
+        u64_chunk_size = INPUT_SOURCE_CHUNK_SIZE_BYTES;
+    }
+
+    pstr_source->au64_chunk_offset[u32_chunk] = pstr_source->u64_read_offset;
+    pstr_source->au64_chunk_size[u32_chunk] = u64_chunk_size;
+    pstr_source->au64_chunk_filled[u32_chunk] = 0;
+
+    if (0 != u64_chunk_size)
+    {
+        s32_ret_val = byte_buffer_reserve(&pstr_source->astr_chunks[u32_chunk], INPUT_SOURCE_CHUNK_SIZE_BYTES);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = async_io_submit(&pstr_source->str_io, ASYNC_IO_OP_READ, fileno(pstr_source->pf_file), pstr_source->astr_chunks[u32_chunk].pc_data,
+                                          (u32)u64_chunk_size, pstr_source->u64_read_offset, u32_chunk);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_source->u64_read_offset += u64_chunk_size;
+        }
+        else
+        {
+            pstr_source->au64_chunk_size[u32_chunk] = 0;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Append data to the window until it holds u64_min_size bytes or the file ends
+ * 
+ * @param[in out] pstr_source Input source in buffered mode
+ * @param[in] u64_min_size Number of bytes wanted in the window
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_input_source_fill(tstr_input_source *pstr_source, const u64 u64_min_size)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_byte_buffer *pstr_window = &pstr_source->str_window;
+
+    while ((SUCCESS_STATUS == s32_ret_val) && (pstr_window->u64_size < u64_min_size) && (false == pstr_source->b_end_of_file))
+    {
+        if (false == pstr_source->b_read_ahead)
+        {
+            u64 u64_read_size = 0;
+
+            s32_ret_val = read_file_window(pstr_source->pf_file, &pstr_window->pc_data[pstr_window->u64_size],
+                                           u64_min_size - pstr_window->u64_size, &u64_read_size);
+
+            pstr_source->b_end_of_file = (0 == u64_read_size);
+            pstr_window->u64_size += u64_read_size;
+            continue;
+        }
+
+        u32 u32_chunk = pstr_source->u32_next_chunk;
+
+        if (0 == pstr_source->au64_chunk_size[u32_chunk])
+        {
+            pstr_source->b_end_of_file = true;
+            break;
+        }
+
+        // Reap reads until the next chunk in file order is complete, requeueing short reads
+        while ((SUCCESS_STATUS == s32_ret_val) && (pstr_source->au64_chunk_filled[u32_chunk] < pstr_source->au64_chunk_size[u32_chunk]))
+        {
+            tstr_async_io_completion str_completion = {0};
+
+            s32_ret_val = async_io_wait(&pstr_source->str_io, &str_completion);
+            ERROR_BREAK(s32_ret_val);
+
+            u32 u32_done_chunk = (u32)str_completion.u64_tag;
+
+            if (str_completion.s64_result <= 0)
+            {
+                LOG_ERROR("Error reading file: %s", (0 == str_completion.s64_result) ? "unexpected end of file" : strerror((int)-str_completion.s64_result));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+                break;
+            }
+
+            pstr_source->au64_chunk_filled[u32_done_chunk] += (u64)str_completion.s64_result;
+
+            if (pstr_source->au64_chunk_filled[u32_done_chunk] < pstr_source->au64_chunk_size[u32_done_chunk])
+            {
+                u64 u64_filled = pstr_source->au64_chunk_filled[u32_done_chunk];
+
+                s32_ret_val = async_io_submit(&pstr_source->str_io, ASYNC_IO_OP_READ, fileno(pstr_source->pf_file),
+                                              &pstr_source->astr_chunks[u32_done_chunk].pc_data[u64_filled],
+                                              (u32)(pstr_source->au64_chunk_size[u32_done_chunk] - u64_filled),
+                                              pstr_source->au64_chunk_offset[u32_done_chunk] + u64_filled, u32_done_chunk);
+            }
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = byte_buffer_append(pstr_window, pstr_source->astr_chunks[u32_chunk].pc_data, pstr_source->au64_chunk_size[u32_chunk]);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = s32_input_source_queue_chunk(pstr_source, u32_chunk);
+            pstr_source->u32_next_chunk = (u32_chunk + 1) % INPUT_SOURCE_READ_DEPTH;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Attach an input source to an open file
+ * 
+ * @param[in out] pstr_source Source to initialize
+ * @param[in] pf_file File to read, must stay open until the source is closed
+ * @param[in] enu_backend IO_BACKEND_AUTO maps regular files, IO_BACKEND_URING reads them ahead, IO_BACKEND_SYNC reads on demand
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 input_source_open(tstr_input_source *pstr_source, FILE *pf_file, const tenu_io_backend enu_backend)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_source || NULL == pf_file)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 u64_file_size = 0;
+
+        memset(pstr_source, 0, sizeof(*pstr_source));
+        pstr_source->pf_file = pf_file;
+        byte_buffer_init(&pstr_source->str_window);
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        // Empty files cannot be mapped, they take the buffered path and read nothing
+        if ((IO_BACKEND_AUTO == enu_backend) && (true == is_regular_file(pf_file, &u64_file_size)) && (0 != u64_file_size))
+        {
+            void *pv_map = mmap(NULL, u64_file_size, PROT_READ, MAP_PRIVATE, fileno(pf_file), 0);
+
+            if (MAP_FAILED == pv_map)
+            {
+                LOG("Mapping the input failed, using buffered reads: %s", strerror(errno));
+            }
+            else
+            {
+                pstr_source->pc_map = (const char *)pv_map;
+                pstr_source->u64_map_size = u64_file_size;
+
+                // Hints only, failures do not matter
+                madvise(pv_map, u64_file_size, MADV_SEQUENTIAL);
+            }
+        }
+
+        // Unmapped regular files keep a few reads in flight while earlier data is coded
+        if ((NULL == pstr_source->pc_map) && (IO_BACKEND_SYNC != enu_backend) && (true == is_regular_file(pf_file, &u64_file_size)) &&
+            (0 == ftell(pf_file)))
+        {
+            s32_ret_val = async_io_init(&pstr_source->str_io, enu_backend);
+
+            pstr_source->b_read_ahead = (SUCCESS_STATUS == s32_ret_val);
+            pstr_source->u64_file_size = u64_file_size;
+
+            for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < INPUT_SOURCE_READ_DEPTH); i++)
+            {
+                s32_ret_val = s32_input_source_queue_chunk(pstr_source, i);
+            }
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Get a contiguous view of the next unconsumed bytes
+ * 
+ * The view holds u64_min_size bytes, or every remaining byte when fewer are left.
+ * It stays valid until the next call to input_source_view or input_source_close.
+ * 
+ * @param[in out] pstr_source Input source
+ * @param[in] u64_min_size Number of bytes wanted
+ * @param[in out] ppc_data Pointer to hold the start of the view
+ * @param[in out] pu64_size Pointer to hold the size of the view, 0 at end of file
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 input_source_view(tstr_input_source *pstr_source, const u64 u64_min_size, const char **ppc_data, u64 *pu64_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_source || NULL == ppc_data || NULL == pu64_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (NULL != pstr_source->pc_map)
+    {
+        u64 u64_view_size = pstr_source->u64_map_size - pstr_source->u64_offset;
+
+        if (u64_view_size > u64_min_size)
+        {
+            u64_view_size = u64_min_size;
+        }
+
+        // Keep the kernel one readahead distance ahead of the consumer
+        if ((pstr_source->u64_advised_offset < pstr_source->u64_map_size) &&
+            ((pstr_source->u64_offset + u64_view_size + INPUT_SOURCE_READAHEAD_BYTES) > pstr_source->u64_advised_offset))
+        {
+            u64 u64_page_size = (u64)sysconf(_SC_PAGESIZE);
+            u64 u64_advise_start = pstr_source->u64_advised_offset & ~(u64_page_size - 1);
+            u64 u64_advise_end = pstr_source->u64_offset + u64_view_size + (2 * INPUT_SOURCE_READAHEAD_BYTES);
+
+            if (u64_advise_end > pstr_source->u64_map_size)
+            {
+                u64_advise_end = pstr_source->u64_map_size;
+            }
+
+            madvise((void *)&pstr_source->pc_map[u64_advise_start], u64_advise_end - u64_advise_start, MADV_WILLNEED);
+            pstr_source->u64_advised_offset = u64_advise_end;
+        }
+
+        *ppc_data = &pstr_source->pc_map[pstr_source->u64_offset];
+        *pu64_size = u64_view_size;
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        tstr_byte_buffer *pstr_window = &pstr_source->str_window;
+        u64 u64_pending_size = pstr_window->u64_size - pstr_source->u64_window_offset;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        if ((u64_pending_size < u64_min_size) && (false == pstr_source->b_end_of_file))
+        {
+            // Move the unconsumed tail to the front, then top the window up from the file
+            if (0 != pstr_source->u64_window_offset)
+            {
+                memmove(pstr_window->pc_data, &pstr_window->pc_data[pstr_source->u64_window_offset], u64_pending_size);
+                pstr_window->u64_size = u64_pending_size;
+                pstr_source->u64_window_offset = 0;
+            }
+
+            s32_ret_val = byte_buffer_reserve(pstr_window, u64_min_size);
+
+            if (SUCCESS_STATUS == s32_ret_val)
+            {
+                s32_ret_val = s32_input_source_fill(pstr_source, u64_min_size);
+            }
+
+            u64_pending_size = pstr_window->u64_size;
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            *ppc_data = &pstr_window->pc_data[pstr_source->u64_window_offset];
+            *pu64_size = (u64_pending_size > u64_min_size) ? u64_min_size : u64_pending_size;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Mark the first bytes of the last view as consumed
+ * 
+ * @param[in out] pstr_source Input source
+ * @param[in] u64_size Number of bytes consumed, at most the size of the last view
+ * @return void
+ */
+void input_source_consume(tstr_input_source *pstr_source, const u64 u64_size)
+{
+    if (NULL != pstr_source)
+    {
+        pstr_source->u64_offset += u64_size;
+
+        if (NULL == pstr_source->pc_map)
+        {
+            pstr_source->u64_window_offset += u64_size;
+        }
+    }
+}
+
+/**
+ * @brief Check whether a source is memory mapped
+ * 
+ * @param[in] pstr_source Input source
+ * @return true if the file is mapped, false in buffered mode
+ */
+bool input_source_is_mapped(const tstr_input_source *pstr_source)
+{
+    return (NULL != pstr_source) && (NULL != pstr_source->pc_map);
+}
+
+/**
+ * @brief Unmap the file and release the window, the file itself stays open
+ * 
+ * @param[in out] pstr_source Input source
+ * @return void
+ */
+void input_source_close(tstr_input_source *pstr_source)
+{
+    if (NULL != pstr_source)
+    {
+        if (NULL != pstr_source->pc_map)
+        {
+            munmap((void *)pstr_source->pc_map, pstr_source->u64_map_size);
+            pstr_source->pc_map = NULL;
+        }
+
+        if (true == pstr_source->b_read_ahead)
+        {
+            // The kernel may still be writing into the chunk buffers
+            while (0 != async_io_pending_count(&pstr_source->str_io))
+            {
+                tstr_async_io_completion str_completion;
+
+                if (SUCCESS_STATUS != async_io_wait(&pstr_source->str_io, &str_completion))
+                {
+                    break;
+                }
+            }
+
+            async_io_free(&pstr_source->str_io);
+            pstr_source->b_read_ahead = false;
+        }
+
+        for (u32 i = 0; i < INPUT_SOURCE_READ_DEPTH; i++)
+        {
+            byte_buffer_free(&pstr_source->astr_chunks[i]);
+        }
+
+        byte_buffer_free(&pstr_source->str_window);
+    }
+}
\ No newline at end of file
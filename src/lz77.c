@@ -0,0 +1,519 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/rle2.h"
+#include "../header_files/lz77.h"
+
+// Chain entries hold the distance to the previous position with the same hash, 0 ends the chain
+#define LZ77_CHAIN_END                (0u)
+#define LZ77_HASH_EMPTY               (UINT32_MAX)
+
+// Positions without a match before the scan starts skipping ahead, then one more byte every 32 misses
+#define LZ77_SKIP_TRIGGER             (5u)
+
+// Match finder state of one thread, heap allocated as it is too large for worker stacks.
+// Positions are stored from u32_base, every block starts past the window of the previous
+// one, so stale entries look out of range and the head table is only cleared on wraparound.
+typedef struct {
+    u32 au32_head[LZ77_HASH_SIZE];    // Last position of every hash, LZ77_HASH_EMPTY when unused
+    u16 au16_chain[LZ77_CHAIN_SIZE];  // Distance to the previous position of the same hash, by position modulo the window
+    u32 u32_base;                     // Position of the first byte of the current block
+    u32 u32_end;                      // Position past the last byte of the current block
+} tstr_lz77_matcher;
+
+static pthread_key_t gstr_lz77_matcher_key;
+static pthread_once_t gstr_lz77_matcher_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * @brief Create the key of the per-thread match finders, freed when their thread exits
+ * 
+ * @return void
+ */
+static void lz77_matcher_key_create(void)
+{
+    pthread_key_create(&gstr_lz77_matcher_key, free);
+}
+
+/**
+ * @brief Get the match finder of the calling thread, set up for a new block
+ * 
+ * The match finder is allocated on the first block of the thread and kept for the next
+ * ones, its head table is cleared then and whenever the positions would wrap around.
+ * 
+ * @param[in] u64_input_data_size Size of the new block
+ * @return tstr_lz77_matcher* Match finder, NULL when it could not be allocated
+ */
+static tstr_lz77_matcher *pstr_lz77_matcher_get(const u64 u64_input_data_size)
+{
+    tstr_lz77_matcher *pstr_matcher = NULL;
+
+    pthread_once(&gstr_lz77_matcher_once, lz77_matcher_key_create);
+
+    pstr_matcher = (tstr_lz77_matcher *)pthread_getspecific(gstr_lz77_matcher_key);
+
+    if (NULL == pstr_matcher)
+    {
+        pstr_matcher = (tstr_lz77_matcher *)malloc(sizeof(*pstr_matcher));
+
+        if ((NULL == pstr_matcher) || (0 != pthread_setspecific(gstr_lz77_matcher_key, pstr_matcher)))
+        {
+            free(pstr_matcher);
+            return NULL;
+        }
+
+        memset(pstr_matcher->au32_head, 0xFF, sizeof(pstr_matcher->au32_head));
+        pstr_matcher->u32_base = 0;
+    }
+    else
+    {
+        // Start a window past the end of the previous block, its positions are then out of range
+        const u64 u64_base = (u64)pstr_matcher->u32_end + LZ77_CHAIN_SIZE;
+
+        if ((u64_base + u64_input_data_size) >= LZ77_HASH_EMPTY)
+        {
+            memset(pstr_matcher->au32_head, 0xFF, sizeof(pstr_matcher->au32_head));
+            pstr_matcher->u32_base = 0;
+        }
+        else
+        {
+            pstr_matcher->u32_base = (u32)u64_base;
+        }
+    }
+
+    pstr_matcher->u32_end = pstr_matcher->u32_base + (u32)u64_input_data_size;
+
+    return pstr_matcher;
+}
+
+/**
+ * @brief Load 4 bytes
+ * 
+ * @param[in] pc_data Bytes to load
+ * @return u32 Loaded value
+ */
+static inline u32 u32_lz77_read32(const char *pc_data)
+{
+    u32 u32_value = 0;
+
+    memcpy(&u32_value, pc_data, sizeof(u32_value));
+
+    return u32_value;
+}
+
+/**
+ * @brief Hash the 4-byte prefix at a position
+ * 
+ * @param[in] pc_data Bytes to hash, 4 readable bytes
+ * @return u32 Hash of LZ77_HASH_LOG bits
+ */
+static inline u32 u32_lz77_hash(const char *pc_data)
+{
+    return (u32_lz77_read32(pc_data) * 2654435761u) >> (32u - LZ77_HASH_LOG);
+}
+
+/**
+ * @brief Insert a position at the head of its hash chain
+ * 
+ * @param[in out] pstr_matcher Match finder state
+ * @param[in] pc_input_data Block being coded
+ * @param[in] u32_idx Index of the position in the block, 4 readable bytes
+ * @return void
+ */
+static inline void lz77_insert(tstr_lz77_matcher *pstr_matcher, const char *pc_input_data, const u32 u32_idx)
+{
+    const u32 u32_pos = pstr_matcher->u32_base + u32_idx;
+    const u32 u32_hash = u32_lz77_hash(&pc_input_data[u32_idx]);
+    const u32 u32_prev = pstr_matcher->au32_head[u32_hash];
+
+    pstr_matcher->au16_chain[u32_pos & LZ77_MAX_OFFSET] =
+        ((LZ77_HASH_EMPTY == u32_prev) || ((u32_pos - u32_prev) > LZ77_MAX_OFFSET)) ? (u16)LZ77_CHAIN_END : (u16)(u32_pos - u32_prev);
+    pstr_matcher->au32_head[u32_hash] = u32_pos;
+}
+
+/**
+ * @brief Count the bytes two positions have in common, 8 bytes at a time
+ * 
+ * @param[in] pc_input_data Block being coded
+ * @param[in] u64_match Earlier position
+ * @param[in] u64_pos Later position
+ * @param[in] u64_input_data_size Size of the block
+ * @return u64 Length of the common prefix
+ */
+static inline u64 u64_lz77_match_length(const char *pc_input_data, const u64 u64_match, const u64 u64_pos, const u64 u64_input_data_size)
+{
+    u64 u64_len = 0;
+
+    while ((u64_pos + u64_len + sizeof(u64)) <= u64_input_data_size)
+    {
+        u64 u64_a = 0;
+        u64 u64_b = 0;
+
+        memcpy(&u64_a, &pc_input_data[u64_match + u64_len], sizeof(u64_a));
+        memcpy(&u64_b, &pc_input_data[u64_pos + u64_len], sizeof(u64_b));
+
+        if (u64_a != u64_b)
+        {
+            return u64_len + ((u64)__builtin_ctzll(u64_a ^ u64_b) >> 3);
+        }
+        u64_len += sizeof(u64);
+    }
+
+    while (((u64_pos + u64_len) < u64_input_data_size) && (pc_input_data[u64_match + u64_len] == pc_input_data[u64_pos + u64_len]))
+    {
+        u64_len++;
+    }
+
+    return u64_len;
+}
+
+/**
+ * @brief Write the rest of a length that did not fit in its token nibble
+ * 
+ * @param[in] u64_value Length minus LZ77_NIBBLE_MAX
+ * @param[in out] pc_output_data Buffer to hold the varint (at least RLE2_VARINT_MAX_SIZE bytes)
+ * @return u64 Number of bytes written
+ */
+static inline u64 u64_lz77_put_varint(u64 u64_value, char *pc_output_data)
+{
+    u64 u64_write_idx = 0;
+
+    while (u64_value >= 0x80u)
+    {
+        pc_output_data[u64_write_idx++] = (char)((u64_value & 0x7Fu) | 0x80u);
+        u64_value >>= 7;
+    }
+    pc_output_data[u64_write_idx++] = (char)u64_value;
+
+    return u64_write_idx;
+}
+
+/**
+ * @brief Emit one sequence
+ * 
+ * @param[in] pc_literal Literal bytes of the sequence
+ * @param[in] u64_literal_size Number of literal bytes, may be 0
+ * @param[in] u64_offset Match offset, 0 for the last sequence of the block
+ * @param[in] u64_match_len Match length, at least LZ77_MIN_MATCH unless last
+ * @param[in out] pc_output_data Buffer to hold the sequence
+ * @return u64 Number of bytes written to the output buffer
+ */
+static u64 u64_lz77_emit_sequence(const char *pc_literal, const u64 u64_literal_size, const u64 u64_offset, const u64 u64_match_len, char *pc_output_data)
+{
+    const u64 u64_match_code = (0 == u64_offset) ? 0 : (u64_match_len - LZ77_MIN_MATCH);
+    u64 u64_write_idx = 1;
+    u8  u8_token = 0;
+
+    u8_token = (u8)(((u64_literal_size < LZ77_NIBBLE_MAX) ? u64_literal_size : LZ77_NIBBLE_MAX) << 4);
+    u8_token |= (u8)((u64_match_code < LZ77_NIBBLE_MAX) ? u64_match_code : LZ77_NIBBLE_MAX);
+    pc_output_data[0] = (char)u8_token;
+
+    if (u64_literal_size >= LZ77_NIBBLE_MAX)
+    {
+        u64_write_idx += u64_lz77_put_varint(u64_literal_size - LZ77_NIBBLE_MAX, &pc_output_data[u64_write_idx]);
+    }
+
+    memcpy(&pc_output_data[u64_write_idx], pc_literal, u64_literal_size);
+    u64_write_idx += u64_literal_size;
+
+    if (0 != u64_offset)
+    {
+        pc_output_data[u64_write_idx++] = (char)(u64_offset & 0xFFu);
+        pc_output_data[u64_write_idx++] = (char)(u64_offset >> 8);
+
+        if (u64_match_code >= LZ77_NIBBLE_MAX)
+        {
+            u64_write_idx += u64_lz77_put_varint(u64_match_code - LZ77_NIBBLE_MAX, &pc_output_data[u64_write_idx]);
+        }
+    }
+
+    return u64_write_idx;
+}
+
+/**
+ * @brief Compress a whole block into LZ77 sequences
+ * 
+ * Matches are found through a hash table of the last position of every 4-byte prefix,
+ * chained to the previous positions with the same hash within LZ77_MAX_OFFSET bytes.
+ * The tables are kept per thread, so only the first block of a thread allocates.
+ * 
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in] u32_search_depth Chain candidates compared per position, 0 for LZ77_DEFAULT_SEARCH_DEPTH
+ * @param[in out] pc_output_data Buffer to hold the sequences (at least LZ77_COMPRESS_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 lz77_compress(const char *pc_input_data, const u64 u64_input_data_size, const u32 u32_search_depth, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    tstr_lz77_matcher *pstr_matcher = NULL;
+
+    if (NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_input_data_size > UINT32_MAX)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else if (NULL == (pstr_matcher = pstr_lz77_matcher_get(u64_input_data_size)))
+    {
+        LOG_ERROR("Error allocating the LZ77 match finder.");
+        s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+    else
+    {
+        const u32 u32_depth = (0 == u32_search_depth) ? LZ77_DEFAULT_SEARCH_DEPTH :
+                              ((u32_search_depth > LZ77_MAX_SEARCH_DEPTH) ? LZ77_MAX_SEARCH_DEPTH : u32_search_depth);
+        u64 u64_write_idx = 0;
+        u64 u64_literal_start = 0;
+        u64 u64_miss_count = 0;
+        u64 i = 0;
+
+        while ((i + LZ77_MIN_MATCH) <= u64_input_data_size)
+        {
+            const u32 u32_pos = pstr_matcher->u32_base + (u32)i;
+            u32 u32_candidate = pstr_matcher->au32_head[u32_lz77_hash(&pc_input_data[i])];
+            u64 u64_best_len = 0;
+            u64 u64_best_offset = 0;
+
+            for (u32 u32_probe = 0; u32_probe < u32_depth; u32_probe++)
+            {
+                u64 u64_len = 0;
+                u64 u64_match = 0;
+                u16 u16_delta = 0;
+
+                // Positions of earlier blocks are always more than a window back
+                if ((LZ77_HASH_EMPTY == u32_candidate) || ((u32_pos - u32_candidate) > LZ77_MAX_OFFSET))
+                {
+                    break;
+                }
+
+                u64_match = u32_candidate - pstr_matcher->u32_base;
+
+                // Cheap reject on the byte that would make the match longer than the best one
+                if ((u64_best_len < (u64_input_data_size - i)) && (pc_input_data[u64_match + u64_best_len] == pc_input_data[i + u64_best_len]))
+                {
+                    u64_len = u64_lz77_match_length(pc_input_data, u64_match, i, u64_input_data_size);
+
+                    if (u64_len > u64_best_len)
+                    {
+                        u64_best_len = u64_len;
+                        u64_best_offset = i - u64_match;
+                    }
+                }
+
+                u16_delta = pstr_matcher->au16_chain[u32_candidate & LZ77_MAX_OFFSET];
+                if (LZ77_CHAIN_END == u16_delta)
+                {
+                    break;
+                }
+                u32_candidate -= u16_delta;
+            }
+
+            if (u64_best_len < LZ77_MIN_MATCH)
+            {
+                // Incompressible stretches are crossed faster the longer they get
+                const u64 u64_step = (u64_miss_count < LZ77_SKIP_TRIGGER) ? 1u : (1u + ((u64_miss_count - LZ77_SKIP_TRIGGER) >> 5));
+
+                lz77_insert(pstr_matcher, pc_input_data, (u32)i);
+                u64_miss_count++;
+                i += u64_step;
+                continue;
+            }
+
+            u64_write_idx += u64_lz77_emit_sequence(&pc_input_data[u64_literal_start], i - u64_literal_start, u64_best_offset, u64_best_len,
+                                                    &pc_output_data[u64_write_idx]);
+
+            // Every position the match covers becomes a candidate for the next ones
+            for (u64 u64_pos = i; (u64_pos < (i + u64_best_len)) && ((u64_pos + LZ77_MIN_MATCH) <= u64_input_data_size); u64_pos++)
+            {
+                lz77_insert(pstr_matcher, pc_input_data, (u32)u64_pos);
+            }
+
+            i += u64_best_len;
+            u64_literal_start = i;
+            u64_miss_count = 0;
+        }
+
+        u64_write_idx += u64_lz77_emit_sequence(&pc_input_data[u64_literal_start], u64_input_data_size - u64_literal_start, 0, 0, &pc_output_data[u64_write_idx]);
+
+        *pu64_output_data_size = u64_write_idx;
+        s32_ret_val = SUCCESS_STATUS;
+
+        LOG("LZ77 block compressed: %lu bytes in, %lu bytes out (depth %u)", u64_input_data_size, *pu64_output_data_size, u32_depth);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Read the rest of a length that did not fit in its token nibble
+ * 
+ * @param[in] pu8_input Sequences
+ * @param[in out] pu64_read_idx Read position, moved past the varint
+ * @param[in] u64_input_data_size Size of the sequences
+ * @param[in out] pu64_value Pointer to hold the decoded value
+ * @return s32 SUCCESS_STATUS on success, ERROR_DECOMPRESSION_FAILED when the varint is truncated or too long
+ */
+static inline s32 s32_lz77_get_varint(const u8 *pu8_input, u64 *pu64_read_idx, const u64 u64_input_data_size, u64 *pu64_value)
+{
+    u64 u64_value = 0;
+    u8  u8_shift = 0;
+    u8  u8_byte = 0x80u;
+
+    while ((0 != (u8_byte & 0x80u)) && (*pu64_read_idx < u64_input_data_size) && (u8_shift < (7u * RLE2_VARINT_MAX_SIZE)))
+    {
+        u8_byte = pu8_input[(*pu64_read_idx)++];
+        u64_value |= ((u64)(u8_byte & 0x7Fu)) << u8_shift;
+        u8_shift += 7u;
+    }
+
+    *pu64_value = u64_value;
+
+    return (0 != (u8_byte & 0x80u)) ? ERROR_DECOMPRESSION_FAILED : SUCCESS_STATUS;
+}
+
+/**
+ * @brief Decompress a whole block of LZ77 sequences into a flat buffer
+ * 
+ * Literals and matches are copied 16 bytes at a time, the buffer must have
+ * LZ77_COPY_SLACK_BYTES writable bytes past u64_raw_size.
+ * 
+ * @param[in] pc_input_data Input sequences, the block must end on a sequence boundary
+ * @param[in] u64_input_data_size Size of the input sequences
+ * @param[in out] pc_output_data Buffer to hold the block
+ * @param[in] u64_raw_size Size of the block once decoded, the sequences must add up to it exactly
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 lz77_decompress(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, const u64 u64_raw_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pc_output_data)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        const u8 *pu8_input = (const u8 *)pc_input_data;
+        u64 u64_read_idx = 0;
+        u64 u64_write_idx = 0;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        while (u64_read_idx < u64_input_data_size)
+        {
+            const u8 u8_token = pu8_input[u64_read_idx++];
+            u64 u64_literal_size = u8_token >> 4;
+            u64 u64_match_len = (u64)(u8_token & 0x0Fu) + LZ77_MIN_MATCH;
+            u64 u64_offset = 0;
+
+            if (LZ77_NIBBLE_MAX == u64_literal_size)
+            {
+                u64 u64_extra = 0;
+
+                s32_ret_val = s32_lz77_get_varint(pu8_input, &u64_read_idx, u64_input_data_size, &u64_extra);
+                ERROR_BREAK(s32_ret_val);
+                u64_literal_size += u64_extra;
+            }
+
+            if ((u64_literal_size > (u64_input_data_size - u64_read_idx)) || (u64_literal_size > (u64_raw_size - u64_write_idx)))
+            {
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            if ((u64_literal_size <= 16u) && ((u64_input_data_size - u64_read_idx) >= 16u))
+            {
+                // Short literals, one wide copy into the slack
+                memcpy(&pc_output_data[u64_write_idx], &pu8_input[u64_read_idx], 16u);
+            }
+            else
+            {
+                memcpy(&pc_output_data[u64_write_idx], &pu8_input[u64_read_idx], u64_literal_size);
+            }
+            u64_read_idx += u64_literal_size;
+            u64_write_idx += u64_literal_size;
+
+            // The last sequence has no match
+            if (u64_read_idx == u64_input_data_size)
+            {
+                break;
+            }
+
+            if (2u > (u64_input_data_size - u64_read_idx))
+            {
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+            u64_offset = (u64)pu8_input[u64_read_idx] | ((u64)pu8_input[u64_read_idx + 1u] << 8);
+            u64_read_idx += 2u;
+
+            if ((LZ77_NIBBLE_MAX + LZ77_MIN_MATCH) == u64_match_len)
+            {
+                u64 u64_extra = 0;
+
+                s32_ret_val = s32_lz77_get_varint(pu8_input, &u64_read_idx, u64_input_data_size, &u64_extra);
+                ERROR_BREAK(s32_ret_val);
+                u64_match_len += u64_extra;
+            }
+
+            if ((0 == u64_offset) || (u64_offset > u64_write_idx) || (u64_match_len > (u64_raw_size - u64_write_idx)))
+            {
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            {
+                char *pc_dst = &pc_output_data[u64_write_idx];
+                const char *pc_src = pc_dst - u64_offset;
+
+                if (u64_offset >= 16u)
+                {
+                    // Chunks never overlap their source, the last one may spill into the slack
+                    for (u64 u64_copied = 0; u64_copied < u64_match_len; u64_copied += 16u)
+                    {
+                        memcpy(&pc_dst[u64_copied], &pc_src[u64_copied], 16u);
+                    }
+                }
+                else if (1u == u64_offset)
+                {
+                    memset(pc_dst, pc_src[0], u64_match_len);
+                }
+                else
+                {
+                    // Overlapping copy: the pattern doubles on every pass, so copies get wide quickly
+                    u64 u64_copied = 0;
+
+                    while (u64_copied < u64_match_len)
+                    {
+                        const u64 u64_distance = (u64)(&pc_dst[u64_copied] - pc_src);
+                        const u64 u64_chunk = ((u64_match_len - u64_copied) < u64_distance) ? (u64_match_len - u64_copied) : u64_distance;
+
+                        memcpy(&pc_dst[u64_copied], pc_src, u64_chunk);
+                        u64_copied += u64_chunk;
+                    }
+                }
+            }
+            u64_write_idx += u64_match_len;
+        }
+
+        if ((SUCCESS_STATUS == s32_ret_val) && (u64_write_idx != u64_raw_size))
+        {
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            LOG_ERROR("LZ77 block is corrupted or truncated (%lu of %lu bytes decoded).", u64_write_idx, u64_raw_size);
+        }
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -1,14 +1,39 @@
+#include <string.h>
+
 #include "../header_files/constants.h"
 #include "../header_files/utils.h"
 #include "../header_files/compress.h"
 #include "../header_files/decompress.h"
+#include "../header_files/batch.h"
+#include "../header_files/archive.h"
+#include "../header_files/checksum.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/codec_registry.h"
 
 
 int main(int argc, char const *argv[])
 {
-    tstr_input_args str_args = {OP_NONE, NULL};
+    tstr_input_args str_args = {OP_NONE, NULL, 0, NULL, {FILE_FORMAT_RLE, BLOCK_CODEC_RLE2, 0, 1, IO_BACKEND_AUTO, FLUSH_POLICY_NONE, 0, STATS_OUTPUT_NONE, false},
+                              (tenu_log_level)LOG_LEVEL, false, false, 0, 0};
+
+    run_kernels_init();
+    checksum_init();
+
     parse_input_args(argc, argv, &str_args);
 
+    log_set_level(str_args.enu_log_level);
+
+    if (true == str_args.b_log_async)
+    {
+        log_async_start();
+    }
+
+    // stdout carries the data of "-" streams and ranges
+    if (((1 == str_args.u32_input_count) && (0 == strcmp(str_args.ppc_input_files[0], "-"))) || (true == str_args.b_range))
+    {
+        log_set_output(stderr);
+    }
+
     s32 s32_ret_val = FAILURE_STATUS;
 
     switch (str_args.enu_operation)
@@ -20,13 +45,67 @@ int main(int argc, char const *argv[])
         break;
     }
     case OP_COMPRESS:
+    case OP_DECOMPRESS:
     {
-        s32_ret_val = compress(str_args.pc_input_file);
+        // Several files share one work-stealing pool, a single file keeps the plain path
+        if (true == str_args.b_range)
+        {
+            u64 u64_range_size = 0;
+
+            s32_ret_val = decompress_range(str_args.ppc_input_files[0], str_args.s64_range_offset, str_args.u64_range_length, stdout, NULL, &u64_range_size);
+
+            if (SUCCESS_STATUS == s32_ret_val)
+            {
+                LOG_INFO("Range of %lu bytes written to stdout", u64_range_size);
+            }
+        }
+        else if ((1 < str_args.u32_input_count) || (NULL != str_args.pc_file_list))
+        {
+            s32_ret_val = batch_run(&str_args);
+        }
+        else
+        {
+            // Holds one slot per pool thread, kept off the stack
+            static tstr_codec_stats gstr_stats;
+            tstr_codec_stats *pstr_stats = (STATS_OUTPUT_NONE != str_args.str_options.enu_stats_output) ? &gstr_stats : NULL;
+            const bool b_compress = (OP_COMPRESS == str_args.enu_operation);
+
+            if (true == b_compress)
+            {
+                s32_ret_val = compress(str_args.ppc_input_files[0], &str_args.str_options, NULL, pstr_stats);
+            }
+            else
+            {
+                s32_ret_val = decompress(str_args.ppc_input_files[0], &str_args.str_options, NULL, pstr_stats);
+            }
+
+            if (NULL != pstr_stats)
+            {
+                stats_report(stderr, str_args.str_options.enu_stats_output, (true == b_compress) ? "compress" : ((true == str_args.str_options.b_test_only) ? "test" : "decompress"),
+                             str_args.ppc_input_files[0], s32_ret_val, pstr_stats);
+            }
+        }
         break;
     }
-    case OP_DECOMPRESS:
+    case OP_ARCHIVE:
     {
-        s32_ret_val = decompress(str_args.pc_input_file);
+        s32_ret_val = archive_create(str_args.ppc_input_files[0], &str_args.str_options);
+        break;
+    }
+    case OP_LIST:
+    {
+        s32_ret_val = archive_list(str_args.ppc_input_files[0]);
+        break;
+    }
+    case OP_LIST_CODECS:
+    {
+        codec_registry_print(stdout);
+        s32_ret_val = SUCCESS_STATUS;
+        break;
+    }
+    case OP_EXTRACT:
+    {
+        s32_ret_val = archive_extract(str_args.ppc_input_files[0], &str_args.ppc_input_files[1], str_args.u32_input_count - 1, &str_args.str_options);
         break;
     }
     default:
@@ -36,9 +115,17 @@ int main(int argc, char const *argv[])
     }
     }
 
+    free_input_args(&str_args);
+
     if (SUCCESS_STATUS != s32_ret_val)
     {
         LOG_ERROR("Operation failed with error code: %d", s32_ret_val);
+    }
+
+    log_async_stop();
+
+    if (SUCCESS_STATUS != s32_ret_val)
+    {
         return 1;
     }
 
@@ -0,0 +1,223 @@
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/rle2.h"
+#include "../header_files/packbits.h"
+
+
+/**
+ * @brief Emit a literal segment, split into control bytes of at most PACKBITS_LITERAL_MAX_SIZE bytes each
+ * 
+ * @param[in] pc_literal Bytes of the segment
+ * @param[in] u64_literal_size Size of the segment, may be 0
+ * @param[in out] pc_output_data Buffer to hold the segment
+ * @return u64 Number of bytes written to the output buffer
+ */
+static u64 u64_packbits_emit_literal(const char *pc_literal, u64 u64_literal_size, char *pc_output_data)
+{
+    u64 u64_write_idx = 0;
+
+    while (0 != u64_literal_size)
+    {
+        u64 u64_chunk_size = (u64_literal_size > PACKBITS_LITERAL_MAX_SIZE) ? PACKBITS_LITERAL_MAX_SIZE : u64_literal_size;
+
+        pc_output_data[u64_write_idx++] = (char)(u64_chunk_size - 1u);
+        memcpy(&pc_output_data[u64_write_idx], pc_literal, u64_chunk_size);
+
+        u64_write_idx += u64_chunk_size;
+        pc_literal += u64_chunk_size;
+        u64_literal_size -= u64_chunk_size;
+    }
+
+    return u64_write_idx;
+}
+
+/**
+ * @brief Emit one run of at least PACKBITS_RUN_MIN_SIZE bytes
+ * 
+ * @param[in] c_run_char Byte of the run
+ * @param[in] u64_run_len Length of the run
+ * @param[in out] pc_output_data Buffer to hold the token (at least 2 + RLE2_VARINT_MAX_SIZE bytes)
+ * @return u64 Number of bytes written to the output buffer
+ */
+static u64 u64_packbits_emit_run(const char c_run_char, u64 u64_run_len, char *pc_output_data)
+{
+    u64 u64_write_idx = 0;
+
+    if (u64_run_len <= PACKBITS_SHORT_RUN_MAX_SIZE)
+    {
+        pc_output_data[u64_write_idx++] = (char)(PACKBITS_CONTROL_RUN + (u64_run_len - PACKBITS_RUN_MIN_SIZE));
+        pc_output_data[u64_write_idx++] = c_run_char;
+    }
+    else
+    {
+        pc_output_data[u64_write_idx++] = (char)PACKBITS_CONTROL_LONG_RUN;
+        pc_output_data[u64_write_idx++] = c_run_char;
+
+        while (u64_run_len >= 0x80u)
+        {
+            pc_output_data[u64_write_idx++] = (char)((u64_run_len & 0x7Fu) | 0x80u);
+            u64_run_len >>= 7;
+        }
+        pc_output_data[u64_write_idx++] = (char)u64_run_len;
+    }
+
+    return u64_write_idx;
+}
+
+/**
+ * @brief Compress a whole block into literal segments and run tokens
+ * 
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the tokens (at least PACKBITS_COMPRESS_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 packbits_compress(const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 u64_write_idx = 0;
+        u64 u64_literal_start = 0;
+        u64 i = 0;
+
+        while ((i + 2u) < u64_input_data_size)
+        {
+            // No run of three can start at i or i + 1 when the two bytes after i differ
+            if (pc_input_data[i + 1] != pc_input_data[i + 2])
+            {
+                i += 2;
+                continue;
+            }
+
+            if (pc_input_data[i] != pc_input_data[i + 1])
+            {
+                i++;
+                continue;
+            }
+
+            u64 u64_run_len = PACKBITS_RUN_MIN_SIZE + run_scan_length(&pc_input_data[i + PACKBITS_RUN_MIN_SIZE],
+                                                                      u64_input_data_size - i - PACKBITS_RUN_MIN_SIZE, pc_input_data[i]);
+
+            u64_write_idx += u64_packbits_emit_literal(&pc_input_data[u64_literal_start], i - u64_literal_start, &pc_output_data[u64_write_idx]);
+            u64_write_idx += u64_packbits_emit_run(pc_input_data[i], u64_run_len, &pc_output_data[u64_write_idx]);
+
+            i += u64_run_len;
+            u64_literal_start = i;
+        }
+
+        u64_write_idx += u64_packbits_emit_literal(&pc_input_data[u64_literal_start], u64_input_data_size - u64_literal_start, &pc_output_data[u64_write_idx]);
+
+        *pu64_output_data_size = u64_write_idx;
+        s32_ret_val = SUCCESS_STATUS;
+
+        LOG("PackBits block compressed: %lu bytes in, %lu bytes out", u64_input_data_size, *pu64_output_data_size);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decompress a whole block of literal segments and run tokens
+ * 
+ * @param[in] pc_input_data Input tokens, the block must end on a token boundary
+ * @param[in] u64_input_data_size Size of the input tokens
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 packbits_decompress(const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        tstr_byte_buffer *pstr_buffer = &pstr_window->str_buffer;
+        u64 i = 0;
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        while (i < u64_input_data_size)
+        {
+            const u8 u8_control = (u8)pc_input_data[i++];
+
+            if (u8_control < PACKBITS_CONTROL_RUN)
+            {
+                const u64 u64_literal_size = (u64)u8_control + 1u;
+
+                if (u64_literal_size > (u64_input_data_size - i))
+                {
+                    LOG_ERROR("PackBits literal of %lu bytes is truncated.", u64_literal_size);
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                if (u64_literal_size <= (pstr_window->u64_window_size - pstr_buffer->u64_size))
+                {
+                    // Fast path, the whole segment fits in the window
+                    memcpy(&pstr_buffer->pc_data[pstr_buffer->u64_size], &pc_input_data[i], u64_literal_size);
+                    pstr_buffer->u64_size += u64_literal_size;
+                }
+                else
+                {
+                    s32_ret_val = output_window_append(pstr_window, &pc_input_data[i], u64_literal_size);
+                    ERROR_BREAK(s32_ret_val);
+                }
+
+                i += u64_literal_size;
+            }
+            else
+            {
+                u64 u64_run_len = (u64)(u8_control - PACKBITS_CONTROL_RUN) + PACKBITS_RUN_MIN_SIZE;
+                char c_run_char = 0;
+
+                if (i == u64_input_data_size)
+                {
+                    LOG_ERROR("PackBits run is truncated.");
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                c_run_char = pc_input_data[i++];
+
+                if (PACKBITS_CONTROL_LONG_RUN == u8_control)
+                {
+                    u8 u8_count_shift = 0;
+                    u8 u8_count_byte = 0x80u;
+
+                    u64_run_len = 0;
+
+                    while ((0 != (u8_count_byte & 0x80u)) && (i < u64_input_data_size) && (u8_count_shift < (7u * RLE2_VARINT_MAX_SIZE)))
+                    {
+                        u8_count_byte = (u8)pc_input_data[i++];
+                        u64_run_len |= ((u64)(u8_count_byte & 0x7Fu)) << u8_count_shift;
+                        u8_count_shift += 7u;
+                    }
+
+                    if ((0 != (u8_count_byte & 0x80u)) || (u64_run_len <= PACKBITS_SHORT_RUN_MAX_SIZE))
+                    {
+                        LOG_ERROR("Invalid PackBits run length.");
+                        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                        break;
+                    }
+                }
+
+                s32_ret_val = output_window_append_run(pstr_window, c_run_char, u64_run_len);
+                ERROR_BREAK(s32_ret_val);
+            }
+        }
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/buffer.h"
+#include "../header_files/rle.h"
+
+
+/**
+ * @brief Encode one run as <char><count>, escaping digits, backslashes and new lines
+ * 
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @param[in out] pc_output_data Buffer to hold the encoded run (at least 22 bytes)
+ * @return u64 Number of bytes written to the output buffer
+ */
+static u64 u64_rle_emit_run(const char c_run_char, u64 u64_run_len, char *pc_output_data)
+{
+    u64 u64_write_idx = 0;
+    char ac_char_count_str[20] = {0}; // Buffer to hold the reversed digits of the count
+    u8 u8_digits_cnt = 0;
+
+    if ('\n' == c_run_char)
+    {
+        pc_output_data[u64_write_idx++] = '\\';
+        pc_output_data[u64_write_idx++] = 'n';
+    }
+    else if ((c_run_char >= '0' && c_run_char <= '9') || '\\' == c_run_char)
+    {
+        pc_output_data[u64_write_idx++] = '\\';
+        pc_output_data[u64_write_idx++] = c_run_char;
+    }
+    else
+    {
+        pc_output_data[u64_write_idx++] = c_run_char;
+    }
+
+    do
+    {
+        ac_char_count_str[u8_digits_cnt++] = (char)('0' + (u64_run_len % 10));
+        u64_run_len /= 10;
+    } while (0 != u64_run_len);
+
+    while (0 != u8_digits_cnt)
+    {
+        pc_output_data[u64_write_idx++] = ac_char_count_str[--u8_digits_cnt];
+    }
+
+    return u64_write_idx;
+}
+
+/**
+ * @brief Compress one window of data using Run-Length Encoding (RLE)
+ * 
+ * The run that is still open at the end of the window is kept in the encoder state,
+ * so a run crossing a window boundary is encoded exactly as in a single pass.
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the compressed output data (at least RLE_COMPRESS_WINDOW_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_compress(tstr_rle_encoder *pstr_encoder, const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_encoder || NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_input_data_size)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        u64 u64_write_idx = 0;
+
+        u64 i = 0;
+
+        while (i < u64_input_data_size)
+        {
+            if (0 != pstr_encoder->u64_run_len)
+            {
+                // Most runs in text are short, only hand real runs to the vector kernel
+                u64 u64_scanned_len = (pc_input_data[i] == pstr_encoder->c_run_char) ?
+                                      run_scan_length(&pc_input_data[i], u64_input_data_size - i, pstr_encoder->c_run_char) : 0;
+
+                pstr_encoder->u64_run_len += u64_scanned_len;
+                i += u64_scanned_len;
+
+                if (i == u64_input_data_size)
+                {
+                    break;
+                }
+
+                u64_write_idx += u64_rle_emit_run(pstr_encoder->c_run_char, pstr_encoder->u64_run_len, &pc_output_data[u64_write_idx]);
+            }
+
+            pstr_encoder->c_run_char = pc_input_data[i++];
+            pstr_encoder->u64_run_len = 1;
+        }
+
+        *pu64_output_data_size = u64_write_idx;
+        s32_ret_val = SUCCESS_STATUS;
+
+        LOG("RLE window compressed: %lu bytes in, %lu bytes out", u64_input_data_size, *pu64_output_data_size);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Emit the run still pending in the encoder state at the end of the input
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in out] pc_output_data Buffer to hold the compressed output data (at least 22 bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_compress_flush(tstr_rle_encoder *pstr_encoder, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_encoder || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        *pu64_output_data_size = 0;
+
+        if (0 != pstr_encoder->u64_run_len)
+        {
+            *pu64_output_data_size = u64_rle_emit_run(pstr_encoder->c_run_char, pstr_encoder->u64_run_len, pc_output_data);
+            pstr_encoder->u64_run_len = 0;
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decompress one chunk of Run-Length Encoded (RLE) data
+ * 
+ * Escape sequences and count digits may straddle chunk boundaries, the partial
+ * token is kept in the decoder state until the next chunk completes it.
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in] pc_input_data Input data to be decompressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_decompress(tstr_rle_decoder *pstr_decoder, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_decoder || NULL == pc_input_data || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_input_data_size)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        s32_ret_val = SUCCESS_STATUS;
+
+        for (u64 i = 0; i < u64_input_data_size; i++)
+        {
+            char c_input_char = pc_input_data[i];
+
+            if (RLE_DECODER_STATE_COUNT == pstr_decoder->enu_state)
+            {
+                if (c_input_char >= '0' && c_input_char <= '9')
+                {
+                    u64 u64_digit = (u64)(c_input_char - '0');
+
+                    if (pstr_decoder->u64_run_len > ((UINT64_MAX - u64_digit) / 10))
+                    {
+                        LOG_ERROR("Run count is too large.");
+                        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                        break;
+                    }
+
+                    pstr_decoder->u64_run_len = (pstr_decoder->u64_run_len * 10) + u64_digit;
+                    pstr_decoder->u8_count_digits++;
+                    continue;
+                }
+
+                // A missing or zero count still yields the run character once
+                s32_ret_val = output_window_append_run(pstr_window, pstr_decoder->c_run_char,
+                                                       ((0 == pstr_decoder->u64_run_len) ? 1 : pstr_decoder->u64_run_len) - pstr_decoder->u64_written_len);
+                ERROR_BREAK(s32_ret_val);
+
+                pstr_decoder->enu_state = RLE_DECODER_STATE_SYMBOL;
+            }
+
+            if (RLE_DECODER_STATE_SYMBOL == pstr_decoder->enu_state)
+            {
+                if ('\\' == c_input_char)
+                {
+                    pstr_decoder->enu_state = RLE_DECODER_STATE_ESCAPE;
+                    continue;
+                }
+
+                pstr_decoder->c_run_char = c_input_char;
+            }
+            else
+            {
+                if ('n' == c_input_char)
+                {
+                    pstr_decoder->c_run_char = '\n';
+                }
+                else if ('t' == c_input_char)
+                {
+                    pstr_decoder->c_run_char = '\t';
+                }
+                else if (c_input_char >= '0' && c_input_char <= '9')
+                {
+                    pstr_decoder->c_run_char = c_input_char;
+                }
+                else
+                {
+                    pstr_decoder->c_run_char = '\\';
+                }
+            }
+
+            pstr_decoder->u64_run_len = 0;
+            pstr_decoder->u8_count_digits = 0;
+            pstr_decoder->u64_written_len = 0;
+            pstr_decoder->enu_state = RLE_DECODER_STATE_COUNT;
+        }
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            LOG_ERROR("RLE Decompression failed with error code: %d", s32_ret_val);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Complete the token still pending in the decoder state at the end of the input
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_decompress_flush(tstr_rle_decoder *pstr_decoder, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_decoder || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        s32_ret_val = SUCCESS_STATUS;
+
+        if (RLE_DECODER_STATE_ESCAPE == pstr_decoder->enu_state)
+        {
+            // A trailing backslash is taken literally
+            s32_ret_val = output_window_append_run(pstr_window, '\\', 1);
+        }
+        else if (RLE_DECODER_STATE_COUNT == pstr_decoder->enu_state)
+        {
+            s32_ret_val = output_window_append_run(pstr_window, pstr_decoder->c_run_char,
+                                                   ((0 == pstr_decoder->u64_run_len) ? 1 : pstr_decoder->u64_run_len) - pstr_decoder->u64_written_len);
+        }
+
+        pstr_decoder->enu_state = RLE_DECODER_STATE_SYMBOL;
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = output_window_flush(pstr_window);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Write the part of the pending run that is known already, for live streams
+ * 
+ * More count digits can only make the run longer, the rest is written when they arrive.
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle_decompress_drain(tstr_rle_decoder *pstr_decoder, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    if (RLE_DECODER_STATE_COUNT == pstr_decoder->enu_state)
+    {
+        u64 u64_known_len = (0 == pstr_decoder->u64_run_len) ? 1 : pstr_decoder->u64_run_len;
+
+        s32_ret_val = output_window_append_run(pstr_window, pstr_decoder->c_run_char, u64_known_len - pstr_decoder->u64_written_len);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            pstr_decoder->u64_written_len = u64_known_len;
+        }
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+#include "../header_files/rle2.h"
+
+
+/**
+ * @brief Encode one run as <byte><LEB128 count>
+ * 
+ * @param[in] c_run_char Byte of the run
+ * @param[in] u64_run_len Length of the run
+ * @param[in out] pc_output_data Buffer to hold the token (at least 1 + RLE2_VARINT_MAX_SIZE bytes)
+ * @return u64 Number of bytes written to the output buffer
+ */
+static u64 u64_rle2_emit_run(const char c_run_char, u64 u64_run_len, char *pc_output_data)
+{
+    u64 u64_write_idx = 0;
+
+    pc_output_data[u64_write_idx++] = c_run_char;
+
+    while (u64_run_len >= 0x80u)
+    {
+        pc_output_data[u64_write_idx++] = (char)((u64_run_len & 0x7Fu) | 0x80u);
+        u64_run_len >>= 7;
+    }
+    pc_output_data[u64_write_idx++] = (char)u64_run_len;
+
+    return u64_write_idx;
+}
+
+/**
+ * @brief Serialize an RLE2 header
+ * 
+ * @param[in] pstr_header Header to serialize
+ * @param[in out] pc_output_data Buffer to hold the header (at least RLE2_HEADER_SIZE bytes)
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_write_header(const tstr_rle2_header *pstr_header, char *pc_output_data)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_header || NULL == pc_output_data)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        memcpy(pc_output_data, RLE2_MAGIC, RLE2_MAGIC_SIZE);
+        pc_output_data[4] = (char)pstr_header->u8_version;
+        pc_output_data[5] = (char)pstr_header->u8_flags;
+        pc_output_data[6] = (char)pstr_header->u8_codec;
+        pc_output_data[7] = 0;
+
+        for (u8 i = 0; i < 8; i++)
+        {
+            pc_output_data[8 + i] = (char)(pstr_header->u64_original_size >> (8 * i));
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Parse and validate an RLE2 header
+ * 
+ * @param[in] pc_input_data Data starting with the header
+ * @param[in] u64_input_data_size Size of the data
+ * @param[in out] pstr_header Pointer to hold the parsed header
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_read_header(const char *pc_input_data, const u64 u64_input_data_size, tstr_rle2_header *pstr_header)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pc_input_data || NULL == pstr_header)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (u64_input_data_size < RLE2_HEADER_SIZE || false == rle2_has_magic(pc_input_data, u64_input_data_size))
+    {
+        LOG_ERROR("Missing or truncated RLE2 header.");
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+    else
+    {
+        pstr_header->u8_version = (u8)pc_input_data[4];
+        pstr_header->u8_flags = (u8)pc_input_data[5];
+        pstr_header->u8_codec = (u8)pc_input_data[6];
+        pstr_header->u64_original_size = 0;
+
+        for (u8 i = 0; i < 8; i++)
+        {
+            pstr_header->u64_original_size |= ((u64)(u8)pc_input_data[8 + i]) << (8 * i);
+        }
+
+        if (RLE2_VERSION_STREAM != pstr_header->u8_version && RLE2_VERSION_BLOCKS != pstr_header->u8_version)
+        {
+            LOG_ERROR("Unsupported RLE2 version: %u", pstr_header->u8_version);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+        }
+        else
+        {
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check whether the data starts with the RLE2 magic number
+ * 
+ * @param[in] pc_input_data Data to check
+ * @param[in] u64_input_data_size Size of the data
+ * @return true if the magic number matches, false otherwise
+ */
+bool rle2_has_magic(const char *pc_input_data, const u64 u64_input_data_size)
+{
+    return (NULL != pc_input_data) && (u64_input_data_size >= RLE2_MAGIC_SIZE) && (0 == memcmp(pc_input_data, RLE2_MAGIC, RLE2_MAGIC_SIZE));
+}
+
+/**
+ * @brief Compress one window of data into RLE2 tokens
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in] pc_input_data Input data to be compressed
+ * @param[in] u64_input_data_size Size of the input data
+ * @param[in out] pc_output_data Buffer to hold the tokens (at least RLE2_COMPRESS_WINDOW_BOUND bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_compress(tstr_rle_encoder *pstr_encoder, const char *pc_input_data, const u64 u64_input_data_size, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_encoder || NULL == pc_input_data || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_input_data_size)
+    {
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        u64 u64_write_idx = 0;
+
+        u64 i = 0;
+
+        while (i < u64_input_data_size)
+        {
+            if (0 != pstr_encoder->u64_run_len)
+            {
+                // Most runs in text are short, only hand real runs to the vector kernel
+                u64 u64_scanned_len = (pc_input_data[i] == pstr_encoder->c_run_char) ?
+                                      run_scan_length(&pc_input_data[i], u64_input_data_size - i, pstr_encoder->c_run_char) : 0;
+
+                pstr_encoder->u64_run_len += u64_scanned_len;
+                i += u64_scanned_len;
+
+                if (i == u64_input_data_size)
+                {
+                    break;
+                }
+
+                u64_write_idx += u64_rle2_emit_run(pstr_encoder->c_run_char, pstr_encoder->u64_run_len, &pc_output_data[u64_write_idx]);
+            }
+
+            pstr_encoder->c_run_char = pc_input_data[i++];
+            pstr_encoder->u64_run_len = 1;
+        }
+
+        *pu64_output_data_size = u64_write_idx;
+        s32_ret_val = SUCCESS_STATUS;
+
+        LOG("RLE2 window compressed: %lu bytes in, %lu bytes out", u64_input_data_size, *pu64_output_data_size);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Emit the run still pending in the encoder state at the end of the input
+ * 
+ * @param[in out] pstr_encoder Encoder state carried across windows
+ * @param[in out] pc_output_data Buffer to hold the token (at least 1 + RLE2_VARINT_MAX_SIZE bytes)
+ * @param[in out] pu64_output_data_size Pointer to hold the size of the compressed data
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_compress_flush(tstr_rle_encoder *pstr_encoder, char *pc_output_data, u64 *pu64_output_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_encoder || NULL == pc_output_data || NULL == pu64_output_data_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        *pu64_output_data_size = 0;
+
+        if (0 != pstr_encoder->u64_run_len)
+        {
+            *pu64_output_data_size = u64_rle2_emit_run(pstr_encoder->c_run_char, pstr_encoder->u64_run_len, pc_output_data);
+            pstr_encoder->u64_run_len = 0;
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Decompress one chunk of RLE2 tokens, tokens may straddle chunk boundaries
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in] pc_input_data Input tokens
+ * @param[in] u64_input_data_size Size of the input tokens
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_decompress(tstr_rle2_decoder *pstr_decoder, const char *pc_input_data, const u64 u64_input_data_size, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_decoder || NULL == pc_input_data || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        s32_ret_val = SUCCESS_STATUS;
+
+        for (u64 i = 0; i < u64_input_data_size; i++)
+        {
+            if (RLE2_DECODER_STATE_SYMBOL == pstr_decoder->enu_state)
+            {
+                pstr_decoder->c_run_char = pc_input_data[i];
+                pstr_decoder->u64_run_len = 0;
+                pstr_decoder->u8_count_shift = 0;
+                pstr_decoder->enu_state = RLE2_DECODER_STATE_COUNT;
+                continue;
+            }
+
+            u8 u8_count_byte = (u8)pc_input_data[i];
+
+            if ((pstr_decoder->u8_count_shift > 63) || ((63 == pstr_decoder->u8_count_shift) && ((u8_count_byte & 0x7Fu) > 1u)))
+            {
+                LOG_ERROR("Run count varint is too long.");
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            pstr_decoder->u64_run_len |= ((u64)(u8_count_byte & 0x7Fu)) << pstr_decoder->u8_count_shift;
+            pstr_decoder->u8_count_shift += 7;
+
+            if (0 == (u8_count_byte & 0x80u))
+            {
+                if (0 == pstr_decoder->u64_run_len)
+                {
+                    LOG_ERROR("Zero-length run in RLE2 stream.");
+                    s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                    break;
+                }
+
+                s32_ret_val = output_window_append_run(pstr_window, pstr_decoder->c_run_char, pstr_decoder->u64_run_len);
+                ERROR_BREAK(s32_ret_val);
+
+                pstr_decoder->enu_state = RLE2_DECODER_STATE_SYMBOL;
+            }
+        }
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            LOG_ERROR("RLE2 Decompression failed with error code: %d", s32_ret_val);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check that no token is left incomplete at the end of the input and flush the output
+ * 
+ * @param[in out] pstr_decoder Decoder state carried across chunks
+ * @param[in out] pstr_window Output window the decompressed data is written through
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 rle2_decompress_flush(tstr_rle2_decoder *pstr_decoder, tstr_output_window *pstr_window)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_decoder || NULL == pstr_window)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (RLE2_DECODER_STATE_SYMBOL != pstr_decoder->enu_state)
+    {
+        LOG_ERROR("RLE2 stream ends in the middle of a token.");
+        s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+    }
+    else
+    {
+        s32_ret_val = output_window_flush(pstr_window);
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
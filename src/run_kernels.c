@@ -0,0 +1,237 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RUN_KERNELS_X86
+#endif
+
+#include "../header_files/utils.h"
+#include "../header_files/run_kernels.h"
+
+
+// Signature shared by all run scanning kernels
+typedef u64 (*tpf_run_scan)(const char *pc_data, const u64 u64_data_size, const char c_run_char);
+
+static u64 u64_run_scan_resolve(const char *pc_data, const u64 u64_data_size, const char c_run_char);
+
+// Selected kernel, resolved on first use unless run_kernels_init() was called, accessed atomically
+static tpf_run_scan gpf_run_scan = u64_run_scan_resolve;
+static pthread_once_t gstr_run_kernels_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * @brief Scalar run scanning kernel, also used for the tail of the vector kernels
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data
+ */
+static u64 u64_run_scan_scalar(const char *pc_data, const u64 u64_data_size, const char c_run_char)
+{
+    u64 i = 0;
+
+    while ((i < u64_data_size) && (pc_data[i] == c_run_char))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+#ifdef RUN_KERNELS_X86
+
+/**
+ * @brief SSE2 run scanning kernel, compares 16 bytes per step
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data
+ */
+__attribute__((target("sse2")))
+static u64 u64_run_scan_sse2(const char *pc_data, const u64 u64_data_size, const char c_run_char)
+{
+    const __m128i x_run = _mm_set1_epi8(c_run_char);
+    u64 i = 0;
+
+    for (; (i + 16) <= u64_data_size; i += 16)
+    {
+        u32 u32_equal_mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)&pc_data[i]), x_run));
+
+        if (0xFFFFu != u32_equal_mask)
+        {
+            return i + (u64)__builtin_ctz(~u32_equal_mask);
+        }
+    }
+
+    return i + u64_run_scan_scalar(&pc_data[i], u64_data_size - i, c_run_char);
+}
+
+/**
+ * @brief AVX2 run scanning kernel, compares 32 bytes per step
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data
+ */
+__attribute__((target("avx2")))
+static u64 u64_run_scan_avx2(const char *pc_data, const u64 u64_data_size, const char c_run_char)
+{
+    const __m256i y_run = _mm256_set1_epi8(c_run_char);
+    u64 i = 0;
+
+    for (; (i + 32) <= u64_data_size; i += 32)
+    {
+        u32 u32_equal_mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)&pc_data[i]), y_run));
+
+        if (0xFFFFFFFFu != u32_equal_mask)
+        {
+            return i + (u64)__builtin_ctz(~u32_equal_mask);
+        }
+    }
+
+    return i + u64_run_scan_scalar(&pc_data[i], u64_data_size - i, c_run_char);
+}
+
+/**
+ * @brief AVX-512BW run scanning kernel, compares 64 bytes per step
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data
+ */
+__attribute__((target("avx512f,avx512bw")))
+static u64 u64_run_scan_avx512(const char *pc_data, const u64 u64_data_size, const char c_run_char)
+{
+    const __m512i z_run = _mm512_set1_epi8(c_run_char);
+    u64 i = 0;
+
+    for (; (i + 64) <= u64_data_size; i += 64)
+    {
+        u64 u64_equal_mask = (u64)_mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void *)&pc_data[i]), z_run);
+
+        if (UINT64_C(0xFFFFFFFFFFFFFFFF) != u64_equal_mask)
+        {
+            return i + (u64)__builtin_ctzll(~u64_equal_mask);
+        }
+    }
+
+    return i + u64_run_scan_scalar(&pc_data[i], u64_data_size - i, c_run_char);
+}
+
+#endif // RUN_KERNELS_X86
+
+/**
+ * @brief Select the fastest run kernels supported by the CPU (cpuid), run once by run_kernels_init()
+ * 
+ * @return void
+ */
+static void run_kernels_select(void)
+{
+    tpf_run_scan pf_run_scan = u64_run_scan_scalar;
+    const char *pc_run_scan_name = "scalar";
+
+#ifdef RUN_KERNELS_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw"))
+    {
+        pf_run_scan = u64_run_scan_avx512;
+        pc_run_scan_name = "avx512bw";
+    }
+    else if (__builtin_cpu_supports("avx2"))
+    {
+        pf_run_scan = u64_run_scan_avx2;
+        pc_run_scan_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        pf_run_scan = u64_run_scan_sse2;
+        pc_run_scan_name = "sse2";
+    }
+#endif
+
+    __atomic_store_n(&gpf_run_scan, pf_run_scan, __ATOMIC_RELEASE);
+
+    LOG("Run scanning kernel: %s", pc_run_scan_name);
+}
+
+/**
+ * @brief Select the fastest run kernels supported by the CPU (cpuid), called once at startup
+ * 
+ * Calling it is optional, the kernels resolve themselves on first use otherwise. Threads
+ * calling it at the same time wait for one selection.
+ * 
+ * @return void
+ */
+void run_kernels_init(void)
+{
+    pthread_once(&gstr_run_kernels_once, run_kernels_select);
+}
+
+/**
+ * @brief Resolve the run scanning kernel on first use and forward the call to it
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data
+ */
+static u64 u64_run_scan_resolve(const char *pc_data, const u64 u64_data_size, const char c_run_char)
+{
+    run_kernels_init();
+
+    return __atomic_load_n(&gpf_run_scan, __ATOMIC_ACQUIRE)(pc_data, u64_data_size, c_run_char);
+}
+
+/**
+ * @brief Count how many bytes at the start of the data are equal to the run character
+ * 
+ * Never reads past pc_data[u64_data_size - 1].
+ * 
+ * @param[in] pc_data Data to scan
+ * @param[in] u64_data_size Size of the data
+ * @param[in] c_run_char Character of the run
+ * @return u64 Length of the run at the start of the data (0 to u64_data_size)
+ */
+u64 run_scan_length(const char *pc_data, const u64 u64_data_size, const char c_run_char)
+{
+    // The kernels share no state, an old pointer only costs one more pass through the resolver
+    return __atomic_load_n(&gpf_run_scan, __ATOMIC_RELAXED)(pc_data, u64_data_size, c_run_char);
+}
+
+/**
+ * @brief Fill the output with a run of the same character using wide stores
+ * 
+ * Runs up to RUN_EXPAND_SLACK_BYTES long are written with one fixed-width broadcast store
+ * that may touch up to RUN_EXPAND_SLACK_BYTES bytes past the end of the run, longer runs
+ * go to memset.
+ * 
+ * @param[in out] pc_output_data Output buffer with at least RUN_EXPAND_SLACK_BYTES bytes of slack
+ * @param[in] c_run_char Character of the run
+ * @param[in] u64_run_len Length of the run
+ * @return void
+ */
+void run_expand(char *pc_output_data, const char c_run_char, const u64 u64_run_len)
+{
+    if (u64_run_len <= RUN_EXPAND_SLACK_BYTES)
+    {
+        // Short runs dominate real data: no length loop, the store overlaps the slack
+        const u64 u64_pattern = UINT64_C(0x0101010101010101) * (u8)c_run_char;
+
+        memcpy(&pc_output_data[0], &u64_pattern, sizeof(u64_pattern));
+        memcpy(&pc_output_data[8], &u64_pattern, sizeof(u64_pattern));
+        memcpy(&pc_output_data[16], &u64_pattern, sizeof(u64_pattern));
+        memcpy(&pc_output_data[24], &u64_pattern, sizeof(u64_pattern));
+    }
+    else
+    {
+        memset(pc_output_data, c_run_char, u64_run_len);
+    }
+}
\ No newline at end of file
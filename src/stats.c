@@ -0,0 +1,345 @@
+#include <stdarg.h>
+#include <string.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/stats.h"
+
+
+// Phase names, in tenu_stats_phase order
+static const char *gapc_stats_phase_names[STATS_PHASE_COUNT] = {"open", "read", "code", "write", "close"};
+
+
+/**
+ * @brief Append formatted text to a buffer
+ * 
+ * @param[in out] pstr_line Buffer to append to
+ * @param[in] pc_format printf format
+ * @param ... Arguments of the format
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_stats_append(tstr_byte_buffer *pstr_line, const char *pc_format, ...)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    va_list args;
+    int s32_size = 0;
+
+    va_start(args, pc_format);
+    s32_size = vsnprintf(NULL, 0, pc_format, args);
+    va_end(args);
+
+    do
+    {
+        if (s32_size < 0)
+        {
+            s32_ret_val = ERROR_INVALID_ARGUMENTS;
+            break;
+        }
+
+        // vsnprintf() writes the terminating NUL past the text
+        s32_ret_val = byte_buffer_reserve(pstr_line, pstr_line->u64_size + (u64)s32_size + 1);
+        ERROR_BREAK(s32_ret_val);
+
+        va_start(args, pc_format);
+        vsnprintf(&pstr_line->pc_data[pstr_line->u64_size], (size_t)s32_size + 1, pc_format, args);
+        va_end(args);
+
+        pstr_line->u64_size += (u64)s32_size;
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Append a file name as a JSON string
+ * 
+ * @param[in out] pstr_line Buffer to append to
+ * @param[in] pc_text Text to quote
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_stats_append_json_string(tstr_byte_buffer *pstr_line, const char *pc_text)
+{
+    s32 s32_ret_val = s32_stats_append(pstr_line, "\"");
+
+    for (const char *pc_char = pc_text; (SUCCESS_STATUS == s32_ret_val) && ('\0' != *pc_char); pc_char++)
+    {
+        u8 u8_char = (u8)*pc_char;
+
+        if (('"' == u8_char) || ('\\' == u8_char))
+        {
+            s32_ret_val = s32_stats_append(pstr_line, "\\%c", u8_char);
+        }
+        else if (u8_char < 0x20)
+        {
+            s32_ret_val = s32_stats_append(pstr_line, "\\u%04x", u8_char);
+        }
+        else
+        {
+            s32_ret_val = byte_buffer_append(pstr_line, pc_char, 1);
+        }
+    }
+
+    if (SUCCESS_STATUS == s32_ret_val)
+    {
+        s32_ret_val = s32_stats_append(pstr_line, "\"");
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Throughput of a piece of work
+ * 
+ * @param[in] u64_size Bytes processed
+ * @param[in] u64_ns Time taken
+ * @return f64 Throughput in MB/s, 0 when no time was measured
+ */
+static f64 f64_stats_mbps(const u64 u64_size, const u64 u64_ns)
+{
+    return (0 == u64_ns) ? 0 : (((f64)u64_size / (1024.0 * 1024.0)) / ((f64)u64_ns / 1e9));
+}
+
+/**
+ * @brief Clear the statistics and start the clock, byte buffers of the calling thread and its pool tasks are counted from now on
+ * 
+ * @param[in out] pstr_stats Statistics to start, NULL to record nothing
+ * @return void
+ */
+void stats_begin(tstr_codec_stats *pstr_stats)
+{
+    if (NULL != pstr_stats)
+    {
+        memset(pstr_stats, 0, sizeof(*pstr_stats));
+        pstr_stats->u64_start_ns = get_monotonic_time_ns();
+
+        pstr_stats->pstr_outer_buffers = byte_buffer_stats_attach(&pstr_stats->str_buffers);
+    }
+}
+
+/**
+ * @brief Add the time since a mark to a phase
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] enu_phase Phase the time went to
+ * @param[in] u64_mark_ns Start of the phase
+ * @return u64 Current time, the mark of the next phase, 0 when pstr_stats is NULL
+ */
+u64 stats_phase_end(tstr_codec_stats *pstr_stats, const tenu_stats_phase enu_phase, const u64 u64_mark_ns)
+{
+    u64 u64_now_ns = 0;
+
+    if ((NULL != pstr_stats) && (enu_phase < STATS_PHASE_COUNT))
+    {
+        u64_now_ns = get_monotonic_time_ns();
+        pstr_stats->au64_phase_ns[enu_phase] += u64_now_ns - u64_mark_ns;
+    }
+
+    return u64_now_ns;
+}
+
+/**
+ * @brief Read the clock for a phase mark
+ * 
+ * @param[in] pstr_stats Statistics, NULL to record nothing
+ * @return u64 Current time, 0 when pstr_stats is NULL
+ */
+u64 stats_mark(const tstr_codec_stats *pstr_stats)
+{
+    return (NULL == pstr_stats) ? 0 : get_monotonic_time_ns();
+}
+
+/**
+ * @brief Move time measured elsewhere into a phase, taking it from another one
+ * 
+ * Decoders write through their output window while decoding, the time the writer spent
+ * is moved from the code phase to the write phase.
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] enu_from Phase the time was counted in
+ * @param[in] enu_to Phase the time belongs to
+ * @param[in] u64_time_ns Time to move
+ * @return void
+ */
+void stats_phase_move(tstr_codec_stats *pstr_stats, const tenu_stats_phase enu_from, const tenu_stats_phase enu_to, const u64 u64_time_ns)
+{
+    if ((NULL != pstr_stats) && (enu_from < STATS_PHASE_COUNT) && (enu_to < STATS_PHASE_COUNT))
+    {
+        u64 u64_moved_ns = (u64_time_ns < pstr_stats->au64_phase_ns[enu_from]) ? u64_time_ns : pstr_stats->au64_phase_ns[enu_from];
+
+        pstr_stats->au64_phase_ns[enu_from] -= u64_moved_ns;
+        pstr_stats->au64_phase_ns[enu_to] += u64_moved_ns;
+    }
+}
+
+/**
+ * @brief Add coding work done by one pool slot
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] u32_slot Pool slot of the thread, see thread_pool_current_slot()
+ * @param[in] u64_raw_size Uncompressed bytes coded
+ * @param[in] u64_busy_ns Time spent coding them
+ * @return void
+ */
+void stats_thread_add(tstr_codec_stats *pstr_stats, const u32 u32_slot, const u64 u64_raw_size, const u64 u64_busy_ns)
+{
+    if ((NULL != pstr_stats) && (u32_slot < THREAD_POOL_MAX_THREADS))
+    {
+        pstr_stats->astr_threads[u32_slot].u64_raw_size += u64_raw_size;
+        pstr_stats->astr_threads[u32_slot].u64_busy_ns += u64_busy_ns;
+
+        if (u32_slot >= pstr_stats->u32_thread_count)
+        {
+            pstr_stats->u32_thread_count = u32_slot + 1;
+        }
+    }
+}
+
+/**
+ * @brief Stop the clock and the buffer counting
+ * 
+ * @param[in out] pstr_stats Statistics, NULL to record nothing
+ * @param[in] u64_input_size Bytes read from the input
+ * @param[in] u64_output_size Bytes written to the output
+ * @return void
+ */
+void stats_end(tstr_codec_stats *pstr_stats, const u64 u64_input_size, const u64 u64_output_size)
+{
+    if (NULL != pstr_stats)
+    {
+        pstr_stats->u64_total_ns = get_monotonic_time_ns() - pstr_stats->u64_start_ns;
+        pstr_stats->u64_input_size = u64_input_size;
+        pstr_stats->u64_output_size = u64_output_size;
+
+        byte_buffer_stats_attach(pstr_stats->pstr_outer_buffers);
+    }
+}
+
+/**
+ * @brief Print the statistics of one file as a single line
+ * 
+ * The line is written with one call, so lines of files finishing together do not mix.
+ * The ratio is the raw size over the compressed size, whatever the operation.
+ * 
+ * @param[in out] pf_output Stream to print to
+ * @param[in] enu_output STATS_OUTPUT_TEXT for a readable line, STATS_OUTPUT_JSON for a JSON object
+ * @param[in] pc_operation "compress", "decompress" or "test"
+ * @param[in] pc_file_name Input file of the operation
+ * @param[in] s32_status Status of the operation
+ * @param[in] pstr_stats Statistics to print
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 stats_report(FILE *pf_output, const tenu_stats_output enu_output, const char *pc_operation, const char *pc_file_name, const s32 s32_status,
+                 const tstr_codec_stats *pstr_stats)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pf_output || NULL == pc_operation || NULL == pc_file_name || NULL == pstr_stats)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (STATS_OUTPUT_NONE == enu_output)
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+    else
+    {
+        tstr_byte_buffer str_line;
+        const bool b_json = (STATS_OUTPUT_JSON == enu_output);
+        // Raw size over compressed size for every operation, decoders read the compressed side
+        const bool b_compress = (0 == strcmp(pc_operation, "compress"));
+        const u64 u64_raw_size = (true == b_compress) ? pstr_stats->u64_input_size : pstr_stats->u64_output_size;
+        const u64 u64_compressed_size = (true == b_compress) ? pstr_stats->u64_output_size : pstr_stats->u64_input_size;
+        const f64 f64_ratio = (0 == u64_compressed_size) ? 0 : ((f64)u64_raw_size / (f64)u64_compressed_size);
+        bool b_first_thread = true;
+
+        byte_buffer_init(&str_line);
+
+        do
+        {
+            if (true == b_json)
+            {
+                s32_ret_val = s32_stats_append(&str_line, "{\"operation\": \"%s\", \"file\": ", pc_operation);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = s32_stats_append_json_string(&str_line, pc_file_name);
+                ERROR_BREAK(s32_ret_val);
+
+                s32_ret_val = s32_stats_append(&str_line, ", \"status\": %d, \"input_bytes\": %lu, \"output_bytes\": %lu, \"ratio\": %.4f, \"total_ns\": %lu",
+                                               s32_status, pstr_stats->u64_input_size, pstr_stats->u64_output_size, f64_ratio, pstr_stats->u64_total_ns);
+            }
+            else
+            {
+                s32_ret_val = s32_stats_append(&str_line, "stats %s %s: status %d, %lu bytes in, %lu bytes out, ratio %.3f, %.3f ms (",
+                                               pc_operation, pc_file_name, s32_status, pstr_stats->u64_input_size, pstr_stats->u64_output_size, f64_ratio,
+                                               (f64)pstr_stats->u64_total_ns / 1e6);
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < STATS_PHASE_COUNT); i++)
+            {
+                if (true == b_json)
+                {
+                    s32_ret_val = s32_stats_append(&str_line, ", \"%s_ns\": %lu", gapc_stats_phase_names[i], pstr_stats->au64_phase_ns[i]);
+                }
+                else
+                {
+                    s32_ret_val = s32_stats_append(&str_line, "%s%s %.3f", (0 == i) ? "" : ", ", gapc_stats_phase_names[i], (f64)pstr_stats->au64_phase_ns[i] / 1e6);
+                }
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            if (true == b_json)
+            {
+                s32_ret_val = s32_stats_append(&str_line, ", \"reallocs\": %lu, \"peak_buffer_bytes\": %lu, \"threads\": [",
+                                               pstr_stats->str_buffers.u64_realloc_count, pstr_stats->str_buffers.u64_peak_bytes);
+            }
+            else
+            {
+                s32_ret_val = s32_stats_append(&str_line, " ms), %lu reallocs, %.2f MiB peak buffers, threads:",
+                                               pstr_stats->str_buffers.u64_realloc_count, (f64)pstr_stats->str_buffers.u64_peak_bytes / (1024.0 * 1024.0));
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            // Slots that coded nothing, e.g. workers busy with other files, are left out
+            for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < pstr_stats->u32_thread_count); i++)
+            {
+                const tstr_thread_stats *pstr_thread = &pstr_stats->astr_threads[i];
+
+                if (0 == pstr_thread->u64_raw_size)
+                {
+                    continue;
+                }
+
+                if (true == b_json)
+                {
+                    s32_ret_val = s32_stats_append(&str_line, "%s{\"slot\": %u, \"raw_bytes\": %lu, \"busy_ns\": %lu, \"mbps\": %.1f}", b_first_thread ? "" : ", ",
+                                                   i, pstr_thread->u64_raw_size, pstr_thread->u64_busy_ns, f64_stats_mbps(pstr_thread->u64_raw_size, pstr_thread->u64_busy_ns));
+                }
+                else
+                {
+                    s32_ret_val = s32_stats_append(&str_line, " [%u] %.1f MB/s", i, f64_stats_mbps(pstr_thread->u64_raw_size, pstr_thread->u64_busy_ns));
+                }
+
+                b_first_thread = false;
+            }
+            ERROR_BREAK(s32_ret_val);
+
+            s32_ret_val = s32_stats_append(&str_line, (true == b_json) ? "]}\n" : "\n");
+            ERROR_BREAK(s32_ret_val);
+
+            if (str_line.u64_size != fwrite(str_line.pc_data, 1, str_line.u64_size, pf_output))
+            {
+                s32_ret_val = ERROR_FILE_WRITE_FAILED;
+                break;
+            }
+
+            fflush(pf_output);
+
+        } while (0);
+
+        byte_buffer_free(&str_line);
+    }
+
+    return s32_ret_val;
+}
\ No newline at end of file
@@ -0,0 +1,450 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/thread_pool.h"
+
+
+// Pool the calling thread works for and the deque slot it owns, unset outside the workers
+static __thread tstr_thread_pool *tpstr_current_pool = NULL;
+static __thread u32 tu32_current_slot = 0;
+
+/**
+ * @brief Get the deque slot of the calling thread
+ * 
+ * @param[in] pstr_pool Pool the caller submits to or waits on
+ * @return u32 Slot of the worker, 0 for threads outside the pool
+ */
+static u32 u32_pool_current_slot(const tstr_thread_pool *pstr_pool)
+{
+    return (pstr_pool == tpstr_current_pool) ? tu32_current_slot : 0;
+}
+
+/**
+ * @brief Push a task at the tail of a deque
+ * 
+ * @param[in out] pstr_pool Pool owning the deque
+ * @param[in out] pstr_deque Deque to push to
+ * @param[in out] pstr_task Task to push
+ * @return void
+ */
+static void pool_deque_push(tstr_thread_pool *pstr_pool, tstr_pool_deque *pstr_deque, tstr_pool_task *pstr_task)
+{
+    pthread_mutex_lock(&pstr_deque->str_mutex);
+
+    pstr_task->pstr_prev = pstr_deque->pstr_tail;
+    pstr_task->pstr_next = NULL;
+
+    if (NULL == pstr_deque->pstr_tail)
+    {
+        pstr_deque->pstr_head = pstr_task;
+    }
+    else
+    {
+        pstr_deque->pstr_tail->pstr_next = pstr_task;
+    }
+
+    pstr_deque->pstr_tail = pstr_task;
+
+    pthread_mutex_unlock(&pstr_deque->str_mutex);
+
+    __atomic_add_fetch(&pstr_pool->u32_queued_count, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Pop the newest task of a deque, used by the deque owner
+ * 
+ * @param[in out] pstr_pool Pool owning the deque
+ * @param[in out] pstr_deque Deque to pop from
+ * @param[in] pstr_group Only pop a task of this group, NULL to pop any task
+ * @return tstr_pool_task* Task, NULL if the deque is empty or its newest task belongs to another group
+ */
+static tstr_pool_task *pstr_pool_deque_pop(tstr_thread_pool *pstr_pool, tstr_pool_deque *pstr_deque, const tstr_task_group *pstr_group)
+{
+    tstr_pool_task *pstr_task = NULL;
+
+    pthread_mutex_lock(&pstr_deque->str_mutex);
+
+    if ((NULL != pstr_deque->pstr_tail) && ((NULL == pstr_group) || (pstr_group == pstr_deque->pstr_tail->pstr_group)))
+    {
+        pstr_task = pstr_deque->pstr_tail;
+        pstr_deque->pstr_tail = pstr_task->pstr_prev;
+
+        if (NULL == pstr_deque->pstr_tail)
+        {
+            pstr_deque->pstr_head = NULL;
+        }
+        else
+        {
+            pstr_deque->pstr_tail->pstr_next = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&pstr_deque->str_mutex);
+
+    if (NULL != pstr_task)
+    {
+        __atomic_sub_fetch(&pstr_pool->u32_queued_count, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return pstr_task;
+}
+
+/**
+ * @brief Take the oldest task of a deque, used by thieves
+ * 
+ * The oldest task is usually the largest one left (a whole file rather than one of its blocks),
+ * so a steal hands over as much work as possible.
+ * 
+ * @param[in out] pstr_pool Pool owning the deque
+ * @param[in out] pstr_deque Deque to steal from
+ * @return tstr_pool_task* Task, NULL if the deque is empty
+ */
+static tstr_pool_task *pstr_pool_deque_steal(tstr_thread_pool *pstr_pool, tstr_pool_deque *pstr_deque)
+{
+    tstr_pool_task *pstr_task = NULL;
+
+    pthread_mutex_lock(&pstr_deque->str_mutex);
+
+    pstr_task = pstr_deque->pstr_head;
+
+    if (NULL != pstr_task)
+    {
+        pstr_deque->pstr_head = pstr_task->pstr_next;
+
+        if (NULL == pstr_deque->pstr_head)
+        {
+            pstr_deque->pstr_tail = NULL;
+        }
+        else
+        {
+            pstr_deque->pstr_head->pstr_prev = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&pstr_deque->str_mutex);
+
+    if (NULL != pstr_task)
+    {
+        __atomic_sub_fetch(&pstr_pool->u32_queued_count, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return pstr_task;
+}
+
+/**
+ * @brief Run one task, then account for its completion
+ * 
+ * @param[in out] pstr_pool Pool the task was taken from
+ * @param[in out] pstr_task Task to run
+ * @return void
+ */
+static void pool_run_task(tstr_thread_pool *pstr_pool, tstr_pool_task *pstr_task)
+{
+    tstr_task_group *pstr_group = pstr_task->pstr_group;
+    tstr_buffer_stats *pstr_outer_stats = byte_buffer_stats_attach(pstr_task->pstr_buffer_stats);
+
+    pstr_task->pf_task_fn(pstr_task->pv_arg);
+
+    // A waiting thread runs tasks of other files, its own record comes back after each one
+    byte_buffer_stats_attach(pstr_outer_stats);
+
+    // The group may live on the waiter's stack, it is not touched once its count reaches 0
+    if ((0 == __atomic_sub_fetch(&pstr_group->u32_pending_count, 1, __ATOMIC_SEQ_CST)) &&
+        (0 != __atomic_load_n(&pstr_pool->u32_waiter_count, __ATOMIC_SEQ_CST)))
+    {
+        pthread_mutex_lock(&pstr_pool->str_mutex);
+        pthread_cond_broadcast(&pstr_pool->str_done_cond);
+        pthread_mutex_unlock(&pstr_pool->str_mutex);
+    }
+}
+
+/**
+ * @brief Worker thread loop: run own tasks newest first, then steal the oldest tasks of the other threads
+ * 
+ * @param[in] pv_worker Worker descriptor
+ * @return void* Always NULL
+ */
+static void *pv_pool_worker(void *pv_worker)
+{
+    tstr_pool_worker *pstr_worker = (tstr_pool_worker *)pv_worker;
+    tstr_thread_pool *pstr_pool = pstr_worker->pstr_pool;
+    const u32 u32_slot = pstr_worker->u32_slot;
+
+    tpstr_current_pool = pstr_pool;
+    tu32_current_slot = u32_slot;
+
+    while (1)
+    {
+        tstr_pool_task *pstr_task = pstr_pool_deque_pop(pstr_pool, &pstr_pool->pstr_deques[u32_slot], NULL);
+
+        for (u32 i = 1; (NULL == pstr_task) && (i < pstr_pool->u32_slot_count); i++)
+        {
+            pstr_task = pstr_pool_deque_steal(pstr_pool, &pstr_pool->pstr_deques[(u32_slot + i) % pstr_pool->u32_slot_count]);
+        }
+
+        if (NULL != pstr_task)
+        {
+            pool_run_task(pstr_pool, pstr_task);
+        }
+        else
+        {
+            bool b_stop = false;
+
+            pthread_mutex_lock(&pstr_pool->str_mutex);
+            __atomic_add_fetch(&pstr_pool->u32_idle_count, 1, __ATOMIC_SEQ_CST);
+
+            while ((0 == __atomic_load_n(&pstr_pool->u32_queued_count, __ATOMIC_SEQ_CST)) && (false == pstr_pool->b_stopping))
+            {
+                pthread_cond_wait(&pstr_pool->str_task_cond, &pstr_pool->str_mutex);
+            }
+
+            __atomic_sub_fetch(&pstr_pool->u32_idle_count, 1, __ATOMIC_SEQ_CST);
+            b_stop = pstr_pool->b_stopping;
+            pthread_mutex_unlock(&pstr_pool->str_mutex);
+
+            if (true == b_stop)
+            {
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Start a thread pool
+ * 
+ * The thread that waits on a task group also runs the tasks it queued, so a pool for
+ * N-way parallelism only starts N - 1 worker threads.
+ * 
+ * @param[in out] pstr_pool Pool to start
+ * @param[in] u32_thread_count Total number of threads working on tasks, including the waiting caller
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 thread_pool_create(tstr_thread_pool *pstr_pool, const u32 u32_thread_count)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_pool)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u32_thread_count || u32_thread_count > THREAD_POOL_MAX_THREADS)
+    {
+        LOG_ERROR("Invalid thread count: %u", u32_thread_count);
+        s32_ret_val = ERROR_INVALID_ARGUMENTS;
+    }
+    else
+    {
+        memset(pstr_pool, 0, sizeof(*pstr_pool));
+        pthread_mutex_init(&pstr_pool->str_mutex, NULL);
+        pthread_cond_init(&pstr_pool->str_task_cond, NULL);
+        pthread_cond_init(&pstr_pool->str_done_cond, NULL);
+
+        s32_ret_val = SUCCESS_STATUS;
+
+        pstr_pool->pstr_deques = (tstr_pool_deque *)calloc(u32_thread_count, sizeof(tstr_pool_deque));
+
+        if (NULL == pstr_pool->pstr_deques)
+        {
+            LOG_ERROR("Error allocating memory for task deques: %s", strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+        else
+        {
+            for (u32 i = 0; i < u32_thread_count; i++)
+            {
+                pthread_mutex_init(&pstr_pool->pstr_deques[i].str_mutex, NULL);
+            }
+
+            pstr_pool->u32_slot_count = u32_thread_count;
+        }
+
+        if ((SUCCESS_STATUS == s32_ret_val) && (u32_thread_count > 1))
+        {
+            pstr_pool->pstr_workers = (tstr_pool_worker *)calloc(u32_thread_count - 1, sizeof(tstr_pool_worker));
+
+            if (NULL == pstr_pool->pstr_workers)
+            {
+                LOG_ERROR("Error allocating memory for worker threads: %s", strerror(errno));
+                s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            }
+        }
+
+        for (u32 i = 0; (SUCCESS_STATUS == s32_ret_val) && (i < (u32_thread_count - 1)); i++)
+        {
+            tstr_pool_worker *pstr_worker = &pstr_pool->pstr_workers[i];
+
+            pstr_worker->pstr_pool = pstr_pool;
+            pstr_worker->u32_slot = i + 1;
+
+            if (0 != pthread_create(&pstr_worker->str_thread, NULL, pv_pool_worker, pstr_worker))
+            {
+                LOG_ERROR("Error creating worker thread %u.", i);
+                s32_ret_val = FAILURE_STATUS;
+                break;
+            }
+
+            pstr_pool->u32_worker_count++;
+        }
+
+        if (SUCCESS_STATUS != s32_ret_val)
+        {
+            thread_pool_destroy(pstr_pool);
+        }
+        else
+        {
+            LOG("Thread pool started with %u worker threads.", pstr_pool->u32_worker_count);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Queue a task on the deque of the calling thread
+ * 
+ * Tasks may submit and wait on their own sub-tasks, idle workers steal them.
+ * 
+ * @param[in out] pstr_pool Pool to run the task on
+ * @param[in out] pstr_task Task node, must stay valid until the task has run
+ * @param[in] pf_task_fn Function to run
+ * @param[in] pv_arg Argument passed to the function
+ * @param[in out] pstr_group Group the task belongs to
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 thread_pool_submit(tstr_thread_pool *pstr_pool, tstr_pool_task *pstr_task, tpf_pool_task_fn pf_task_fn, void *pv_arg, tstr_task_group *pstr_group)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_pool || NULL == pstr_task || NULL == pf_task_fn || NULL == pstr_group)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        pstr_task->pf_task_fn = pf_task_fn;
+        pstr_task->pv_arg = pv_arg;
+        pstr_task->pstr_group = pstr_group;
+        pstr_task->pstr_buffer_stats = byte_buffer_stats_attached();
+
+        // Counted before it is visible, a thief may finish it before the push returns
+        __atomic_add_fetch(&pstr_group->u32_pending_count, 1, __ATOMIC_SEQ_CST);
+
+        pool_deque_push(pstr_pool, &pstr_pool->pstr_deques[u32_pool_current_slot(pstr_pool)], pstr_task);
+
+        if (0 != __atomic_load_n(&pstr_pool->u32_idle_count, __ATOMIC_SEQ_CST))
+        {
+            pthread_mutex_lock(&pstr_pool->str_mutex);
+            pthread_cond_signal(&pstr_pool->str_task_cond);
+            pthread_mutex_unlock(&pstr_pool->str_mutex);
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Wait until all tasks of a group have finished, running the group tasks still queued by the caller meanwhile
+ * 
+ * The caller never runs tasks of other groups while waiting, so nested waits cannot pile up
+ * unrelated work on its stack. Group tasks taken by thieves are waited for.
+ * 
+ * @param[in out] pstr_pool Pool the tasks were submitted to
+ * @param[in out] pstr_group Group to wait for
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 thread_pool_wait(tstr_thread_pool *pstr_pool, tstr_task_group *pstr_group)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_pool || NULL == pstr_group)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        tstr_pool_deque *pstr_deque = &pstr_pool->pstr_deques[u32_pool_current_slot(pstr_pool)];
+
+        while (0 != __atomic_load_n(&pstr_group->u32_pending_count, __ATOMIC_SEQ_CST))
+        {
+            tstr_pool_task *pstr_task = pstr_pool_deque_pop(pstr_pool, pstr_deque, pstr_group);
+
+            if (NULL != pstr_task)
+            {
+                pool_run_task(pstr_pool, pstr_task);
+            }
+            else
+            {
+                // The rest of the group is running on other threads
+                pthread_mutex_lock(&pstr_pool->str_mutex);
+                __atomic_add_fetch(&pstr_pool->u32_waiter_count, 1, __ATOMIC_SEQ_CST);
+
+                while (0 != __atomic_load_n(&pstr_group->u32_pending_count, __ATOMIC_SEQ_CST))
+                {
+                    pthread_cond_wait(&pstr_pool->str_done_cond, &pstr_pool->str_mutex);
+                }
+
+                __atomic_sub_fetch(&pstr_pool->u32_waiter_count, 1, __ATOMIC_SEQ_CST);
+                pthread_mutex_unlock(&pstr_pool->str_mutex);
+            }
+        }
+
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Get the slot of the calling thread in the pool it works for, to attribute work to threads
+ * 
+ * @return u32 Slot of the worker, 0 for threads outside any pool
+ */
+u32 thread_pool_current_slot(void)
+{
+    return (NULL == tpstr_current_pool) ? 0 : tu32_current_slot;
+}
+
+/**
+ * @brief Stop the worker threads and release the pool resources
+ * 
+ * @param[in out] pstr_pool Pool to destroy, queued tasks must have been waited for
+ * @return void
+ */
+void thread_pool_destroy(tstr_thread_pool *pstr_pool)
+{
+    if (NULL != pstr_pool)
+    {
+        pthread_mutex_lock(&pstr_pool->str_mutex);
+        pstr_pool->b_stopping = true;
+        pthread_cond_broadcast(&pstr_pool->str_task_cond);
+        pthread_mutex_unlock(&pstr_pool->str_mutex);
+
+        for (u32 i = 0; i < pstr_pool->u32_worker_count; i++)
+        {
+            pthread_join(pstr_pool->pstr_workers[i].str_thread, NULL);
+        }
+
+        for (u32 i = 0; i < pstr_pool->u32_slot_count; i++)
+        {
+            pthread_mutex_destroy(&pstr_pool->pstr_deques[i].str_mutex);
+        }
+
+        free_allocated_memory(pstr_pool->pstr_workers);
+        free_allocated_memory(pstr_pool->pstr_deques);
+        pstr_pool->pstr_workers = NULL;
+        pstr_pool->pstr_deques = NULL;
+        pstr_pool->u32_worker_count = 0;
+        pstr_pool->u32_slot_count = 0;
+
+        pthread_cond_destroy(&pstr_pool->str_task_cond);
+        pthread_cond_destroy(&pstr_pool->str_done_cond);
+        pthread_mutex_destroy(&pstr_pool->str_mutex);
+    }
+}
\ No newline at end of file
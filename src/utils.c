@@ -1,11 +1,200 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include "../header_files/utils.h"
+#include "../header_files/buffer.h"
+#include "../header_files/thread_pool.h"
+#include "../header_files/codec_registry.h"
 
 
+// Stream of debug and info messages, NULL for stdout
+static FILE *gpf_log_output = NULL;
+
+tenu_log_level genu_log_level = (tenu_log_level)LOG_LEVEL;
+
+// Asynchronous log ring, static so late messages never land in freed memory
+static tstr_log_slot gastr_log_ring[LOG_RING_SLOT_COUNT];
+static u64 gu64_log_ring_head = 0;         // Next position to fill, claimed by the logging threads
+static u64 gu64_log_ring_tail = 0;         // Next position to print, owned by the drain thread
+static u64 gu64_log_dropped_count = 0;     // Messages lost to a full ring, updated atomically
+static u32 gu32_log_drain_sleeping = 0;    // Futex word, 1 while the drain thread waits for messages
+static bool gb_log_async = false;          // Messages go through the ring, read atomically
+static bool gb_log_stopping = false;
+static u32 gu32_log_writer_count = 0;      // Threads between reading gb_log_async and queueing their message
+static pthread_t gstr_log_thread;
+
+/**
+ * @brief Get the stream and the tag of a log level
+ * 
+ * @param[in] enu_log_level Log level of the message
+ * @param[in out] ppc_level_tag Pointer to hold the tag printed before the message
+ * @return FILE* Stream of the message, NULL if the level is not printed
+ */
+static FILE *pf_log_stream(const tenu_log_level enu_log_level, const char **ppc_level_tag)
+{
+    FILE *pf_output = (NULL == gpf_log_output) ? stdout : gpf_log_output;
+
+    switch (enu_log_level) 
+    {
+        case LOG_LEVEL_DEBUG: *ppc_level_tag = "DEBUG"; break;
+        case LOG_LEVEL_INFO:  *ppc_level_tag = "INFO "; break;
+        case LOG_LEVEL_ERROR: *ppc_level_tag = "ERROR"; pf_output = stderr; break;
+        default: pf_output = NULL; break; // Do not log if NONE or unknown
+    }
+
+    return pf_output;
+}
+
+/**
+ * @brief Format a message into the next free slot of the ring, without waiting for anything
+ * 
+ * @param[in] enu_log_level Log level of the message
+ * @param[in] pc_formatted_msg Formatted message string
+ * @param[in] args Arguments of the formatted message
+ * @return bool true if the message was queued, false if the ring was full
+ */
+static bool b_log_ring_push(const tenu_log_level enu_log_level, const char *pc_formatted_msg, va_list args)
+{
+    u64 u64_position = __atomic_load_n(&gu64_log_ring_head, __ATOMIC_RELAXED);
+    tstr_log_slot *pstr_slot = NULL;
+
+    // Bounded multi-producer ring: a slot is free when its sequence equals the position claiming it
+    while (true)
+    {
+        pstr_slot = &gastr_log_ring[u64_position & (LOG_RING_SLOT_COUNT - 1u)];
+
+        s64 s64_lag = (s64)(__atomic_load_n(&pstr_slot->u64_sequence, __ATOMIC_ACQUIRE) - u64_position);
+
+        if (0 == s64_lag)
+        {
+            if (true == __atomic_compare_exchange_n(&gu64_log_ring_head, &u64_position, u64_position + 1u, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (0 > s64_lag)
+        {
+            __atomic_add_fetch(&gu64_log_dropped_count, 1u, __ATOMIC_RELAXED);
+            return false;
+        }
+        else
+        {
+            u64_position = __atomic_load_n(&gu64_log_ring_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    pstr_slot->enu_level = enu_log_level;
+    vsnprintf(pstr_slot->ac_message, sizeof(pstr_slot->ac_message), pc_formatted_msg, args);
+
+    // Sequentially consistent with the sleep flag, so the drain thread either sees the message or gets woken
+    __atomic_store_n(&pstr_slot->u64_sequence, u64_position + 1u, __ATOMIC_SEQ_CST);
+
+    // Only a sleeping drain thread costs a system call
+    if ((0 != __atomic_load_n(&gu32_log_drain_sleeping, __ATOMIC_SEQ_CST)) &&
+        (0 != __atomic_exchange_n(&gu32_log_drain_sleeping, 0, __ATOMIC_SEQ_CST)))
+    {
+        syscall(SYS_futex, &gu32_log_drain_sleeping, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Print every message published in the ring, only one thread drains at a time
+ * 
+ * @return u32 Number of messages printed
+ */
+static u32 u32_log_ring_drain(void)
+{
+    u32 u32_printed_count = 0;
+    u64 u64_dropped_count = __atomic_exchange_n(&gu64_log_dropped_count, 0, __ATOMIC_RELAXED);
+
+    while (true)
+    {
+        tstr_log_slot *pstr_slot = &gastr_log_ring[gu64_log_ring_tail & (LOG_RING_SLOT_COUNT - 1u)];
+        const char *pc_level_tag = "";
+
+        if ((gu64_log_ring_tail + 1u) != __atomic_load_n(&pstr_slot->u64_sequence, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+
+        FILE *pf_output = pf_log_stream(pstr_slot->enu_level, &pc_level_tag);
+
+        if (NULL != pf_output)
+        {
+            fprintf(pf_output, "[%s] %s\n", pc_level_tag, pstr_slot->ac_message);
+        }
+
+        // Hand the slot back to the logging threads for the next lap of the ring
+        __atomic_store_n(&pstr_slot->u64_sequence, gu64_log_ring_tail + LOG_RING_SLOT_COUNT, __ATOMIC_RELEASE);
+        gu64_log_ring_tail++;
+        u32_printed_count++;
+    }
+
+    if (0 != u64_dropped_count)
+    {
+        fprintf(stderr, "[ERROR] %lu log messages dropped, the log ring was full\n", u64_dropped_count);
+    }
+
+    if ((0 != u32_printed_count) || (0 != u64_dropped_count))
+    {
+        fflush(stderr);
+        fflush((NULL == gpf_log_output) ? stdout : gpf_log_output);
+    }
+
+    return u32_printed_count;
+}
+
+/**
+ * @brief Thread routine of the asynchronous log, prints the ring until the log is stopped
+ * 
+ * @param[in] pv_arg Unused
+ * @return void* NULL
+ */
+static void *pv_log_drain_thread(void *pv_arg)
+{
+    (void)pv_arg;
+
+    while (false == __atomic_load_n(&gb_log_stopping, __ATOMIC_ACQUIRE))
+    {
+        if (0 != u32_log_ring_drain())
+        {
+            continue;
+        }
+
+        // Announce the sleep, then look again so a message published in between is not missed
+        __atomic_store_n(&gu32_log_drain_sleeping, 1, __ATOMIC_SEQ_CST);
+
+        tstr_log_slot *pstr_slot = &gastr_log_ring[gu64_log_ring_tail & (LOG_RING_SLOT_COUNT - 1u)];
+
+        if (((gu64_log_ring_tail + 1u) != __atomic_load_n(&pstr_slot->u64_sequence, __ATOMIC_SEQ_CST)) &&
+            (false == __atomic_load_n(&gb_log_stopping, __ATOMIC_ACQUIRE)))
+        {
+            // The timeout only bounds the delay of dropped message counts
+            struct timespec str_timeout = {0, 100000000};
+
+            syscall(SYS_futex, &gu32_log_drain_sleeping, FUTEX_WAIT_PRIVATE, 1, &str_timeout, NULL, 0);
+        }
+
+        __atomic_store_n(&gu32_log_drain_sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+
+    u32_log_ring_drain();
+
+    return NULL;
+}
 
 /**
  * @brief Log message based on the log level
@@ -17,29 +206,142 @@
  */
 void log_message(tenu_log_level enu_log_level, const char *pc_formatted_msg, ...)
 {
-    if (enu_log_level > LOG_LEVEL || LOG_LEVEL == LOG_LEVEL_NONE) return;
+    if (enu_log_level > __atomic_load_n(&genu_log_level, __ATOMIC_RELAXED)) return;
 
     const char *string_log_level = "";
-    FILE *out_file = stdout;
+    FILE *out_file = pf_log_stream(enu_log_level, &string_log_level);
 
-    switch (enu_log_level) 
+    if (NULL == out_file) return;
+
+    va_list args;
+    va_start(args, pc_formatted_msg);
+
+    // Counted before the flag is read, so log_async_stop() can wait for the messages still being queued
+    __atomic_add_fetch(&gu32_log_writer_count, 1u, __ATOMIC_SEQ_CST);
+
+    if (true == __atomic_load_n(&gb_log_async, __ATOMIC_SEQ_CST))
     {
-        case LOG_LEVEL_DEBUG: string_log_level = "DEBUG"; break;
-        case LOG_LEVEL_INFO:  string_log_level = "INFO "; break;
-        case LOG_LEVEL_ERROR: string_log_level = "ERROR"; out_file = stderr; break;
-        default: return; // Do not log if NONE or unknown
+        b_log_ring_push(enu_log_level, pc_formatted_msg, args);
+        __atomic_sub_fetch(&gu32_log_writer_count, 1u, __ATOMIC_RELEASE);
     }
+    else
+    {
+        __atomic_sub_fetch(&gu32_log_writer_count, 1u, __ATOMIC_RELEASE);
 
-    fprintf(out_file, "[%s] ", string_log_level);
+        // One line per message even when several files are processed concurrently
+        flockfile(out_file);
 
-    va_list args;
-    va_start(args, pc_formatted_msg);
+        fprintf(out_file, "[%s] ", string_log_level);
+        vfprintf(out_file, pc_formatted_msg, args);
+        fprintf(out_file, "\n");
 
-    vfprintf(out_file, pc_formatted_msg, args);
+        funlockfile(out_file);
+    }
 
     va_end(args);
+}
+
+/**
+ * @brief Select the stream debug and info messages go to, errors always go to stderr
+ * 
+ * @param[in] pf_output Stream for debug and info messages (stdout by default)
+ * @return void
+ */
+void log_set_output(FILE *pf_output)
+{
+    gpf_log_output = pf_output;
+}
+
+/**
+ * @brief Select the runtime log level, levels stripped at compile time stay off
+ * 
+ * @param[in] enu_log_level Most verbose level to print
+ * @return void
+ */
+void log_set_level(const tenu_log_level enu_log_level)
+{
+    __atomic_store_n(&genu_log_level, enu_log_level, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Get the runtime log level
+ * 
+ * @return tenu_log_level Most verbose level printed
+ */
+tenu_log_level log_get_level(void)
+{
+    return __atomic_load_n(&genu_log_level, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Send messages through a lock-free ring drained by a background thread
+ * 
+ * Logging threads format their message into a ring slot and return, they never wait for the
+ * output stream. Messages are dropped and counted when the ring is full.
+ * 
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 log_async_start(void)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    do
+    {
+        if (true == __atomic_load_n(&gb_log_async, __ATOMIC_ACQUIRE))
+        {
+            s32_ret_val = SUCCESS_STATUS;
+            break;
+        }
+
+        for (u32 i = 0; i < LOG_RING_SLOT_COUNT; i++)
+        {
+            gastr_log_ring[i].u64_sequence = i;
+        }
+
+        gu64_log_ring_head = 0;
+        gu64_log_ring_tail = 0;
+        gb_log_stopping = false;
+
+        if (0 != pthread_create(&gstr_log_thread, NULL, pv_log_drain_thread, NULL))
+        {
+            LOG_ERROR("Error starting the log thread, logging synchronously.");
+            break;
+        }
+
+        __atomic_store_n(&gb_log_async, true, __ATOMIC_RELEASE);
+
+        s32_ret_val = SUCCESS_STATUS;
+
+    } while (0);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Print the messages left in the ring, stop the background thread and log synchronously again
+ * 
+ * @return void
+ */
+void log_async_stop(void)
+{
+    if (true == __atomic_load_n(&gb_log_async, __ATOMIC_ACQUIRE))
+    {
+        __atomic_store_n(&gb_log_async, false, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&gb_log_stopping, true, __ATOMIC_RELEASE);
+
+        __atomic_store_n(&gu32_log_drain_sleeping, 0, __ATOMIC_SEQ_CST);
+        syscall(SYS_futex, &gu32_log_drain_sleeping, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+
+        pthread_join(gstr_log_thread, NULL);
+
+        // Threads that saw the ring just before it closed publish their message before the last drain
+        while (0 != __atomic_load_n(&gu32_log_writer_count, __ATOMIC_ACQUIRE))
+        {
+            sched_yield();
+        }
 
-    fprintf(out_file, "\n");
+        u32_log_ring_drain();
+    }
 }
 
 /**
@@ -48,7 +350,7 @@ void log_message(tenu_log_level enu_log_level, const char *pc_formatted_msg, ...
  * @param[in] pc_ile_name file name to open
  * @param[in] mode  mode to open the file in (e.g., "r", "w", "rb", "wb")
  * @param[in out] ppf_input_file pointer to the opened file pointer
- * @return s32 SUCCESS_STATUS on success, error code otherwise
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
  */
 s32 open_file(const char *pc_ile_name, const char *mode, FILE **ppf_input_file)
 {
@@ -110,7 +412,10 @@ s32 close_file(FILE **pp_file)
 
 
 /**
- * @brief 
+ * @brief Read the whole content of a file into a heap buffer
+ * 
+ * The buffer is sized up-front from fstat() for regular files, other files grow it
+ * geometrically, so reading n bytes takes O(log n) reallocations at most.
  * 
  * @param[in] p_file Pointer to the file to read from
  * @param[in out] ppc_read_data_buff Pointer to the buffer that will hold the read data
@@ -128,109 +433,270 @@ s32 read_file(FILE *p_file, char **ppc_read_data_buff, u64 *pu64_read_data_size)
     }
     else
     {
+        tstr_byte_buffer str_read_buffer;
+        struct stat str_file_stat;
+        u64 u64_expected_size = 0;
+
+        byte_buffer_init(&str_read_buffer);
+
+        if ((0 == fstat(fileno(p_file), &str_file_stat)) && S_ISREG(str_file_stat.st_mode))
+        {
+            u64_expected_size = (u64)str_file_stat.st_size;
+        }
+
+        // One spare byte lets a file of the expected size hit EOF without growing the buffer
+        s32_ret_val = byte_buffer_reserve(&str_read_buffer, u64_expected_size + 1);
+
+        while (SUCCESS_STATUS == s32_ret_val)
+        {
+            if (str_read_buffer.u64_size == str_read_buffer.u64_capacity)
+            {
+                LOG("Read %lu bytes, growing buffer for more data.", str_read_buffer.u64_size);
+
+                s32_ret_val = byte_buffer_reserve(&str_read_buffer, str_read_buffer.u64_size + 1);
+                ERROR_BREAK(s32_ret_val);
+            }
+
+            str_read_buffer.u64_size += fread(&str_read_buffer.pc_data[str_read_buffer.u64_size], sizeof(char),
+                                              str_read_buffer.u64_capacity - str_read_buffer.u64_size, p_file);
+
+            if (ferror(p_file))
+            {
+                LOG_ERROR("Error reading file: %s", strerror(errno));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+            }
+            else if (feof(p_file))
+            {
+                LOG("End of file reached. Read %lu bytes successfully.", str_read_buffer.u64_size);
+                break;
+            }
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            s32_ret_val = byte_buffer_shrink_to_fit(&str_read_buffer);
+        }
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            *ppc_read_data_buff = byte_buffer_release(&str_read_buffer, pu64_read_data_size);
+        }
+        else
+        {
+            LOG_ERROR("Read file failed with error code: %d", s32_ret_val);
+            byte_buffer_free(&str_read_buffer);
+            *ppc_read_data_buff = NULL;
+            *pu64_read_data_size = 0;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Read up to one window of data from a file into a caller-owned buffer
+ * 
+ * @param[in] p_file Pointer to the file to read from
+ * @param[in out] pc_window_buff Buffer that will hold the read data
+ * @param[in] u64_window_size Capacity of the window buffer
+ * @param[in out] pu64_read_data_size Pointer to the variable that will hold the number of bytes read (0 at end of file)
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 read_file_window(FILE *p_file, char *pc_window_buff, const u64 u64_window_size, u64 *pu64_read_data_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == p_file || NULL == pc_window_buff || NULL == pu64_read_data_size)
+    {
+        LOG_ERROR("NULL pointer provided for file or window buffer or read size.");
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        *pu64_read_data_size = fread(pc_window_buff, sizeof(char), u64_window_size, p_file);
+
+        if (ferror(p_file))
+        {
+            LOG_ERROR("Error reading file: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_READ_FAILED;
+        }
+        else
+        {
+            LOG("Read window of %lu bytes.", *pu64_read_data_size);
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Read the data already available on a file, waiting at most s32_timeout_ms for some to arrive
+ * 
+ * Reads the file descriptor directly, the file must not be read through stdio as well.
+ * 
+ * @param[in] p_file Pointer to the file to read from
+ * @param[in out] pc_read_buff Buffer that will hold the read data
+ * @param[in] u64_read_size Capacity of the buffer
+ * @param[in] s32_timeout_ms Longest wait for data, negative to wait until data or the end of file arrives
+ * @param[in out] pu64_read_data_size Pointer to hold the number of bytes read (0 on timeout or at end of file)
+ * @param[in out] pb_end_of_file Pointer to hold whether the end of file was reached
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 read_file_available(FILE *p_file, char *pc_read_buff, const u64 u64_read_size, const s32 s32_timeout_ms, u64 *pu64_read_data_size, bool *pb_end_of_file)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == p_file || NULL == pc_read_buff || NULL == pu64_read_data_size || NULL == pb_end_of_file)
+    {
+        LOG_ERROR("NULL pointer provided for file or read buffer or read size.");
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        struct pollfd str_poll = {fileno(p_file), POLLIN, 0};
+        int s32_ready = 0;
+
         *pu64_read_data_size = 0;
-        size_t read_size = DATA_CHUNK_SIZE_BYTES;
-        *ppc_read_data_buff = (char *)malloc(read_size);
+        *pb_end_of_file = false;
 
-        if (NULL == *ppc_read_data_buff)
+        do
         {
-            LOG_ERROR("Error allocating memory for read data buffer: %s", strerror(errno));
-            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            s32_ready = poll(&str_poll, 1, s32_timeout_ms);
+        } while ((s32_ready < 0) && (EINTR == errno));
+
+        if (s32_ready < 0)
+        {
+            LOG_ERROR("Error waiting for input: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_READ_FAILED;
+        }
+        else if (0 == s32_ready)
+        {
+            s32_ret_val = SUCCESS_STATUS;
         }
         else
         {
-            size_t read_bytes_count = 0;
-            char *pc_read_data_buff_shadow = *ppc_read_data_buff; // Shadow pointer to free in case of realloc failure
+            ssize_t s64_read_size = 0;
 
-            while (1)
+            do
             {
-                if (*pu64_read_data_size < read_size)
-                {
-                    read_bytes_count = fread(*ppc_read_data_buff + (*pu64_read_data_size), sizeof(char), DATA_CHUNK_SIZE_BYTES, p_file);
-                    *pu64_read_data_size += read_bytes_count;
-                }
-                else
-                {
-                    LOG("Read %lu bytes, reallocating buffer for more data.", *pu64_read_data_size);
+                s64_read_size = read(str_poll.fd, pc_read_buff, u64_read_size);
+            } while ((s64_read_size < 0) && (EINTR == errno));
 
-                    read_size += DATA_CHUNK_SIZE_BYTES;
-                    *ppc_read_data_buff = (char *)realloc(*ppc_read_data_buff, read_size);
+            if (s64_read_size < 0)
+            {
+                LOG_ERROR("Error reading file: %s", strerror(errno));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+            }
+            else
+            {
+                *pu64_read_data_size = (u64)s64_read_size;
+                *pb_end_of_file = (0 == s64_read_size);
+                s32_ret_val = SUCCESS_STATUS;
+            }
+        }
+    }
 
-                    if (*ppc_read_data_buff == NULL)
-                    {
-                        LOG_ERROR("Error reallocating memory for read data buffer: %s", strerror(errno));
-                        s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
-                        free(pc_read_data_buff_shadow);
-                        pc_read_data_buff_shadow = NULL;
-                        break;
-                    }
-                    else
-                    {
-                        continue;
-                    }
-                }
+    return s32_ret_val;
+}
 
-                if (ferror(p_file))
-                {
-                    LOG_ERROR("Error reading file: %s", strerror(errno));
-                    s32_ret_val = ERROR_FILE_READ_FAILED;
+/**
+ * @brief 
+ * 
+ * @param[in] p_file Pointer to the file to write to
+ * @param[in] pc_write_buffer Pointer to the buffer containing data to write
+ * @param[in] u64_write_size Size of the data to write
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 write_file(FILE *p_file, const char *pc_write_buffer, const u64 u64_write_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == p_file || NULL == pc_write_buffer)
+    {
+        LOG_ERROR("NULL pointer provided for file or write buffer.");
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if (0 == u64_write_size)
+    {
+        LOG_ERROR("Size of the data to write is zero.");
+        s32_ret_val = ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        size_t written_size = fwrite(pc_write_buffer, sizeof(char), u64_write_size, p_file);
+
+        if (written_size != u64_write_size)
+        {
+            LOG_ERROR("Error writing to file: %s", strerror(errno));
+            s32_ret_val = ERROR_FILE_WRITE_FAILED;
+        }
+        else
+        {
+            LOG("Successfully wrote %zu bytes to file.", written_size);
+            s32_ret_val = SUCCESS_STATUS;
+        }
+    }
+
+    return s32_ret_val;
+}
+/**
+ * @brief Read exactly u64_read_size bytes at a file offset, without moving the file position
+ * 
+ * @param[in] p_file Pointer to the file to read from
+ * @param[in out] pc_read_buff Buffer that will hold the read data
+ * @param[in] u64_read_size Number of bytes to read
+ * @param[in] u64_offset File offset to read from
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 read_file_at(FILE *p_file, char *pc_read_buff, const u64 u64_read_size, const u64 u64_offset)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == p_file || NULL == pc_read_buff)
+    {
+        LOG_ERROR("NULL pointer provided for file or read buffer.");
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 u64_done_size = 0;
 
-                    if (NULL != *ppc_read_data_buff)
-                    {
-                        free(*ppc_read_data_buff);
-                        *ppc_read_data_buff = NULL;
-                    }
+        s32_ret_val = SUCCESS_STATUS;
 
-                    break;
-                }
-                else if (feof(p_file))
-                {
-                    LOG("End of file reached. Read %zu bytes successfully.", *pu64_read_data_size);
-                    s32_ret_val = SUCCESS_STATUS;
-                    break;
-                }
-                else
-                {
-                    LOG("Read %zu bytes successfully.", *pu64_read_data_size);
-                }
-            }
+        while (u64_done_size < u64_read_size)
+        {
+            ssize_t s64_chunk_size = pread(fileno(p_file), &pc_read_buff[u64_done_size], u64_read_size - u64_done_size, (off_t)(u64_offset + u64_done_size));
 
-            if (SUCCESS_STATUS == s32_ret_val)
+            if ((s64_chunk_size < 0) && (EINTR == errno))
             {
-                if ((*pu64_read_data_size < read_size) && (0 != *pu64_read_data_size))
-                {
-                    LOG("Reallocating buffer to the actual size read.");
-                    *ppc_read_data_buff = (char *)realloc(*ppc_read_data_buff, *pu64_read_data_size);
-
-                    if (NULL == *ppc_read_data_buff)
-                    {
-                        LOG_ERROR("Error reallocating memory to the actual size read: %s", strerror(errno));
-                        s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
-                        free(pc_read_data_buff_shadow);
-                        pc_read_data_buff_shadow = NULL;
-                    }
-                }
+                continue;
             }
-            else
+
+            if (s64_chunk_size <= 0)
             {
-                LOG_ERROR("Read file failed with error code: %d", s32_ret_val);
+                LOG_ERROR("Error reading %lu bytes at offset %lu: %s", u64_read_size, u64_offset, (0 == s64_chunk_size) ? "unexpected end of file" : strerror(errno));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+                break;
             }
+
+            u64_done_size += (u64)s64_chunk_size;
         }
     }
 
     return s32_ret_val;
 }
 
-
 /**
- * @brief 
+ * @brief Write a buffer at a file offset, without moving the file position
  * 
  * @param[in] p_file Pointer to the file to write to
  * @param[in] pc_write_buffer Pointer to the buffer containing data to write
  * @param[in] u64_write_size Size of the data to write
+ * @param[in] u64_offset File offset to write at
  * @return s32 SUCCESS_STATUS on success, error code otherwise  
  */
-s32 write_file(FILE *p_file, const char *pc_write_buffer, const u64 u64_write_size)
+s32 write_file_at(FILE *p_file, const char *pc_write_buffer, const u64 u64_write_size, const u64 u64_offset)
 {
     s32 s32_ret_val = FAILURE_STATUS;
 
@@ -239,35 +705,90 @@ s32 write_file(FILE *p_file, const char *pc_write_buffer, const u64 u64_write_si
         LOG_ERROR("NULL pointer provided for file or write buffer.");
         s32_ret_val = ERROR_NULL_POINTER;
     }
-    else if (0 == u64_write_size)
-    {
-        LOG_ERROR("Size of the data to write is zero.");
-        s32_ret_val = ERROR_INVALID_LENGTH;
-    }
     else
     {
-        size_t written_size = fwrite(pc_write_buffer, sizeof(char), u64_write_size, p_file);
+        u64 u64_done_size = 0;
 
-        if (written_size != u64_write_size)
-        {
-            LOG_ERROR("Error writing to file: %s", strerror(errno));
-            s32_ret_val = ERROR_FILE_WRITE_FAILED;
-        }
-        else
+        s32_ret_val = SUCCESS_STATUS;
+
+        while (u64_done_size < u64_write_size)
         {
-            LOG("Successfully wrote %zu bytes to file.", written_size);
-            s32_ret_val = SUCCESS_STATUS;
+            ssize_t s64_chunk_size = pwrite(fileno(p_file), &pc_write_buffer[u64_done_size], u64_write_size - u64_done_size, (off_t)(u64_offset + u64_done_size));
+
+            if ((s64_chunk_size < 0) && (EINTR == errno))
+            {
+                continue;
+            }
+
+            if (s64_chunk_size <= 0)
+            {
+                LOG_ERROR("Error writing %lu bytes at offset %lu: %s", u64_write_size, u64_offset, strerror(errno));
+                s32_ret_val = ERROR_FILE_WRITE_FAILED;
+                break;
+            }
+
+            u64_done_size += (u64)s64_chunk_size;
         }
     }
 
     return s32_ret_val;
 }
 
+/**
+ * @brief Set the size of a file, extending it with zeros or truncating it
+ * 
+ * @param[in] p_file Pointer to the file to resize
+ * @param[in] u64_file_size New size of the file
+ * @return s32 SUCCESS_STATUS on success, error code otherwise  
+ */
+s32 resize_file(FILE *p_file, const u64 u64_file_size)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == p_file)
+    {
+        LOG_ERROR("NULL pointer provided for file.");
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else if ((0 != fflush(p_file)) || (0 != ftruncate(fileno(p_file), (off_t)u64_file_size)))
+    {
+        LOG_ERROR("Error resizing file to %lu bytes: %s", u64_file_size, strerror(errno));
+        s32_ret_val = ERROR_FILE_WRITE_FAILED;
+    }
+    else
+    {
+        s32_ret_val = SUCCESS_STATUS;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Check whether a file is a regular file and get its size
+ * 
+ * @param[in] p_file Pointer to the file to check
+ * @param[in out] pu64_file_size Pointer to hold the file size, set only for regular files
+ * @return true if the file is a regular file, false otherwise (pipe, terminal, error)
+ */
+bool is_regular_file(FILE *p_file, u64 *pu64_file_size)
+{
+    struct stat str_file_stat;
+    bool b_regular = false;
+
+    if ((NULL != p_file) && (NULL != pu64_file_size) && (0 == fstat(fileno(p_file), &str_file_stat)) && S_ISREG(str_file_stat.st_mode))
+    {
+        *pu64_file_size = (u64)str_file_stat.st_size;
+        b_regular = true;
+    }
+
+    return b_regular;
+}
+
 /**
  * @brief Check the existence of a file
  * 
  * @param[in] pc_file_name Path to the file to check its existence
- * @return true if file exists, false otherwise
+ * @return true if file exists, false otherwise 
  */
 bool check_file_exists(const char *pc_file_name)
 {
@@ -300,7 +821,7 @@ bool check_file_exists(const char *pc_file_name)
  * @brief  Delete the specified file
  * 
  * @param[in] pc_file_name Path to the file to delete
- * @return true if file exists, false otherwise
+ * @return true if file exists, false otherwise 
  */
 s32 delete_file(const char *pc_file_name)
 {
@@ -505,6 +1026,34 @@ void free_allocated_memory(void *pv_data)
     }
 }
 
+/**
+ * @brief Get the time of a monotonic clock in milliseconds
+ * 
+ * @return u64 Milliseconds since an arbitrary fixed point
+ */
+u64 get_monotonic_time_ms(void)
+{
+    struct timespec str_now;
+
+    clock_gettime(CLOCK_MONOTONIC, &str_now);
+
+    return ((u64)str_now.tv_sec * 1000u) + ((u64)str_now.tv_nsec / 1000000u);
+}
+
+/**
+ * @brief Get the time of a monotonic clock in nanoseconds
+ * 
+ * @return u64 Nanoseconds since an arbitrary fixed point
+ */
+u64 get_monotonic_time_ns(void)
+{
+    struct timespec str_now;
+
+    clock_gettime(CLOCK_MONOTONIC, &str_now);
+
+    return ((u64)str_now.tv_sec * 1000000000u) + (u64)str_now.tv_nsec;
+}
+
 /**
  * @brief Print the program usage instructions
  * 
@@ -514,8 +1063,30 @@ void free_allocated_memory(void *pv_data)
 void print_prog_usage(const char *pc_prog_name)
 {
     printf("Usage:\n");
-    printf("%s -c <input_file> for compression\n", pc_prog_name);
-    printf("%s -d <input_file> for decompression\n", pc_prog_name);
+    printf("%s -c <input_file>... [-f rle|<codec>] [-j threads] for compression (default format: rle, threads: 1)\n", pc_prog_name);
+    printf("-f rle writes text .rle files, every other name selects a codec of .rle2 files, --codec <codec> is the same\n");
+    printf("packbits writes .rle2 files whose blocks keep literal bytes as they are and code only runs of three or more\n");
+    printf("--level 1|2 selects the compression level of rle2 (default: 1), level 2 entropy codes the runs of every block\n");
+    printf("with Huffman codes built for that block, and writes .rle2 files unless another format is given\n");
+    printf("lz77 writes .rle2 files whose blocks reference repeated strings, --level 1-9 compares 1 to 256 match candidates\n");
+    printf("per position (default: 4, 8 candidates)\n");
+    printf("%s -d <input_file>... [-j threads] for decompression (threads: 1), the codec is read from the file\n", pc_prog_name);
+    printf("%s -t <input_file>... [-j threads] to test compressed files: every block is decoded and checked against\n", pc_prog_name);
+    printf("its CRC32C, nothing is written, -d options but --flush apply\n");
+    printf("%s -d <input_file> -x <offset>[:<length>] writes one byte range of the original data to stdout, .rle2 block\n", pc_prog_name);
+    printf("files only decode the blocks covering it, a negative offset counts from the end, no length runs to the end\n");
+    printf("Both accept --io auto|uring|sync to select the file I/O backend (default: auto)\n");
+    printf("Both accept --files-from <list> to read more input files from a list, one per line, - for stdin\n");
+    printf("With several input files, -j files are processed at once, .rle2 files also split into blocks\n");
+    printf("Use - as the input file to read stdin and write stdout, --flush line|<ms> flushes the output\n");
+    printf("at every new line or at most <ms> milliseconds after its input arrived (default: when windows fill up)\n");
+    printf("Both accept --stats text|json to report phase timings, sizes and memory of every file on stderr\n");
+    printf("All operations accept --log none|error|info|debug to select the messages printed (default: info),\n");
+    printf("--log-async prints them from a background thread so workers never wait for the terminal\n");
+    printf("%s -a <directory> [-j threads] to archive a directory into <directory>.rlea\n", pc_prog_name);
+    printf("%s -l <archive> to list the files of an archive\n", pc_prog_name);
+    printf("%s -e <archive> [member]... [-j threads] to extract an archive, or some of its files, into <archive name>/\n", pc_prog_name);
+    printf("%s --list-codecs to list the codecs and their IDs\n", pc_prog_name);
     printf("%s -h to see this menu\n", pc_prog_name);
 }
 
@@ -546,10 +1117,341 @@ void parse_input_args(int argc, const char *argv[], tstr_input_args *pstr_args)
         {
             LOG("Help argument detected");
         }
-        else if ((0 == strcmp(argv[1], "-c") || 0 == strcmp(argv[1], "-d")) && argc == 3)
+        else if (0 == strcmp(argv[1], "--list-codecs"))
+        {
+            pstr_args->enu_operation = OP_LIST_CODECS;
+        }
+        else if ((0 == strcmp(argv[1], "-c") || 0 == strcmp(argv[1], "-d") || 0 == strcmp(argv[1], "-t") || 0 == strcmp(argv[1], "-a") ||
+                  0 == strcmp(argv[1], "-l") || 0 == strcmp(argv[1], "-e")) && argc >= 3)
         {
-            pstr_args->enu_operation = (argv[1][1] == 'c') ? OP_COMPRESS : OP_DECOMPRESS;
-            pstr_args->pc_input_file = argv[2];
+            switch (argv[1][1])
+            {
+                case 'c': pstr_args->enu_operation = OP_COMPRESS;   break;
+                case 'd': pstr_args->enu_operation = OP_DECOMPRESS; break;
+                case 't': pstr_args->enu_operation = OP_DECOMPRESS; break;
+                case 'a': pstr_args->enu_operation = OP_ARCHIVE;    break;
+                case 'l': pstr_args->enu_operation = OP_LIST;       break;
+                default:  pstr_args->enu_operation = OP_EXTRACT;    break;
+            }
+
+            pstr_args->ppc_input_files = (const char **)calloc((size_t)argc, sizeof(const char *));
+            pstr_args->u32_input_count = 0;
+            pstr_args->pc_file_list = NULL;
+            pstr_args->str_options.enu_format = FILE_FORMAT_RLE;
+            pstr_args->str_options.enu_block_codec = BLOCK_CODEC_RLE2;
+            pstr_args->str_options.u32_search_depth = 0;
+            pstr_args->str_options.u32_thread_count = 1;
+            pstr_args->str_options.enu_io_backend = IO_BACKEND_AUTO;
+            pstr_args->str_options.enu_flush_policy = FLUSH_POLICY_NONE;
+            pstr_args->str_options.u32_flush_ms = 0;
+            pstr_args->str_options.enu_stats_output = STATS_OUTPUT_NONE;
+            pstr_args->str_options.b_test_only = ('t' == argv[1][1]);
+            pstr_args->enu_log_level = (tenu_log_level)LOG_LEVEL;
+            pstr_args->b_log_async = false;
+            pstr_args->b_range = false;
+            pstr_args->s64_range_offset = 0;
+            pstr_args->u64_range_length = UINT64_MAX;
+
+            if (NULL == pstr_args->ppc_input_files)
+            {
+                LOG_ERROR("Error allocating memory for the input files: %s", strerror(errno));
+                pstr_args->enu_operation = OP_HELP;
+                return;
+            }
+
+            u32 u32_level = 0;
+            bool b_format_given = false;
+
+            for (int i = 2; i < argc; i++)
+            {
+                // -l lists archives, the compression level has its own long option
+                if (0 == strcmp(argv[i], "--level") && (i + 1) < argc && OP_COMPRESS == pstr_args->enu_operation)
+                {
+                    i++;
+
+                    if ((argv[i][0] < '1') || (argv[i][0] > '9') || ('\0' != argv[i][1]))
+                    {
+                        LOG_ERROR("Invalid compression level: %s (expected 1 to 9)", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+
+                    u32_level = (u32)(argv[i][0] - '0');
+                }
+                else if ((0 == strcmp(argv[i], "-f") || 0 == strcmp(argv[i], "--codec")) && (i + 1) < argc && OP_COMPRESS == pstr_args->enu_operation)
+                {
+                    const tstr_codec_entry *pstr_codec = NULL;
+
+                    i++;
+
+                    if (0 == strcmp(argv[i], "rle"))
+                    {
+                        pstr_args->str_options.enu_format = FILE_FORMAT_RLE;
+                    }
+                    else if (NULL != (pstr_codec = codec_registry_find(argv[i])))
+                    {
+                        pstr_args->str_options.enu_format = FILE_FORMAT_RLE2;
+                        pstr_args->str_options.enu_block_codec = (tenu_block_codec)pstr_codec->u8_id;
+                    }
+                    else
+                    {
+                        LOG_ERROR("Unknown codec: %s (see --list-codecs)", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+
+                    b_format_given = true;
+                }
+                else if (0 == strcmp(argv[i], "--io") && (i + 1) < argc)
+                {
+                    i++;
+
+                    if (0 == strcmp(argv[i], "auto"))
+                    {
+                        pstr_args->str_options.enu_io_backend = IO_BACKEND_AUTO;
+                    }
+                    else if (0 == strcmp(argv[i], "uring"))
+                    {
+                        pstr_args->str_options.enu_io_backend = IO_BACKEND_URING;
+                    }
+                    else if (0 == strcmp(argv[i], "sync"))
+                    {
+                        pstr_args->str_options.enu_io_backend = IO_BACKEND_SYNC;
+                    }
+                    else
+                    {
+                        LOG_ERROR("Unknown I/O backend: %s", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+                }
+                else if (0 == strcmp(argv[i], "-j") && (i + 1) < argc)
+                {
+                    char *pc_end = NULL;
+                    unsigned long ul_thread_count = 0;
+
+                    i++;
+                    errno = 0;
+                    ul_thread_count = strtoul(argv[i], &pc_end, 10);
+
+                    if ((0 != errno) || (pc_end == argv[i]) || ('\0' != *pc_end) || (0 == ul_thread_count) || (THREAD_POOL_MAX_THREADS < ul_thread_count))
+                    {
+                        LOG_ERROR("Invalid thread count: %s (expected 1 to %u)", argv[i], THREAD_POOL_MAX_THREADS);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+
+                    pstr_args->str_options.u32_thread_count = (u32)ul_thread_count;
+                }
+                else if (0 == strcmp(argv[i], "--files-from") && (i + 1) < argc &&
+                         (OP_COMPRESS == pstr_args->enu_operation || OP_DECOMPRESS == pstr_args->enu_operation))
+                {
+                    i++;
+                    pstr_args->pc_file_list = argv[i];
+                }
+                else if (0 == strcmp(argv[i], "--flush") && (i + 1) < argc &&
+                         (OP_COMPRESS == pstr_args->enu_operation || OP_DECOMPRESS == pstr_args->enu_operation))
+                {
+                    char *pc_end = NULL;
+                    unsigned long ul_flush_ms = 0;
+
+                    i++;
+
+                    if (0 == strcmp(argv[i], "line"))
+                    {
+                        pstr_args->str_options.enu_flush_policy = FLUSH_POLICY_LINE;
+                        continue;
+                    }
+
+                    errno = 0;
+                    ul_flush_ms = strtoul(argv[i], &pc_end, 10);
+
+                    if ((0 != errno) || (pc_end == argv[i]) || ('\0' != *pc_end) || (INT32_MAX < ul_flush_ms))
+                    {
+                        LOG_ERROR("Invalid flush policy: %s (expected line or milliseconds)", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+
+                    pstr_args->str_options.enu_flush_policy = FLUSH_POLICY_INTERVAL;
+                    pstr_args->str_options.u32_flush_ms = (u32)ul_flush_ms;
+                }
+                else if (0 == strcmp(argv[i], "--stats") && (i + 1) < argc &&
+                         (OP_COMPRESS == pstr_args->enu_operation || OP_DECOMPRESS == pstr_args->enu_operation))
+                {
+                    i++;
+
+                    if (0 == strcmp(argv[i], "text"))
+                    {
+                        pstr_args->str_options.enu_stats_output = STATS_OUTPUT_TEXT;
+                    }
+                    else if (0 == strcmp(argv[i], "json"))
+                    {
+                        pstr_args->str_options.enu_stats_output = STATS_OUTPUT_JSON;
+                    }
+                    else
+                    {
+                        LOG_ERROR("Unknown statistics output: %s", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+                }
+                else if (0 == strcmp(argv[i], "--log") && (i + 1) < argc)
+                {
+                    i++;
+
+                    if (0 == strcmp(argv[i], "none"))
+                    {
+                        pstr_args->enu_log_level = LOG_LEVEL_NONE;
+                    }
+                    else if (0 == strcmp(argv[i], "error"))
+                    {
+                        pstr_args->enu_log_level = LOG_LEVEL_ERROR;
+                    }
+                    else if (0 == strcmp(argv[i], "info"))
+                    {
+                        pstr_args->enu_log_level = LOG_LEVEL_INFO;
+                    }
+                    else if (0 == strcmp(argv[i], "debug"))
+                    {
+                        pstr_args->enu_log_level = LOG_LEVEL_DEBUG;
+                    }
+                    else
+                    {
+                        LOG_ERROR("Unknown log level: %s", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+                }
+                else if (0 == strcmp(argv[i], "--log-async"))
+                {
+                    pstr_args->b_log_async = true;
+                }
+                else if (0 == strcmp(argv[i], "-x") && (i + 1) < argc &&
+                         (OP_DECOMPRESS == pstr_args->enu_operation) && (false == pstr_args->str_options.b_test_only))
+                {
+                    char *pc_end = NULL;
+
+                    i++;
+                    errno = 0;
+                    pstr_args->s64_range_offset = strtol(argv[i], &pc_end, 10);
+
+                    // <offset>[:<length>], no or an empty length runs to the end of the data
+                    if ((0 == errno) && (pc_end != argv[i]) && (':' == *pc_end) && ('\0' != pc_end[1]))
+                    {
+                        const char *pc_length = &pc_end[1];
+
+                        pstr_args->u64_range_length = strtoul(pc_length, &pc_end, 10);
+
+                        if (('-' == *pc_length) || (pc_end == pc_length))
+                        {
+                            errno = EINVAL;
+                        }
+                    }
+                    else if ((0 == errno) && (pc_end != argv[i]) && (':' == *pc_end))
+                    {
+                        pc_end++;
+                    }
+
+                    if ((0 != errno) || ('\0' != *pc_end))
+                    {
+                        LOG_ERROR("Invalid range: %s (expected <offset>[:<length>], negative offsets count from the end)", argv[i]);
+                        pstr_args->enu_operation = OP_HELP;
+                        break;
+                    }
+
+                    pstr_args->b_range = true;
+                }
+                else if (('-' != argv[i][0]) || (0 == strcmp(argv[i], "-")))
+                {
+                    pstr_args->ppc_input_files[pstr_args->u32_input_count] = argv[i];
+                    pstr_args->u32_input_count++;
+                }
+                else
+                {
+                    LOG_ERROR("Invalid argument: %s", argv[i]);
+                    pstr_args->enu_operation = OP_HELP;
+                    break;
+                }
+            }
+
+            // lz77 levels double the match candidates compared per position
+            if ((OP_HELP != pstr_args->enu_operation) && (BLOCK_CODEC_LZ77 == pstr_args->str_options.enu_block_codec))
+            {
+                if (0 != u32_level)
+                {
+                    pstr_args->str_options.u32_search_depth = 1u << (u32_level - 1u);
+                }
+            }
+            else if ((OP_HELP != pstr_args->enu_operation) && (2u < u32_level))
+            {
+                LOG_ERROR("Levels above 2 are only supported with -f lz77");
+                pstr_args->enu_operation = OP_HELP;
+            }
+            // Level 2 is a second stage on top of the runs, only the rle2 block coding has one
+            else if ((OP_HELP != pstr_args->enu_operation) && (2u == u32_level))
+            {
+                if ((true == b_format_given) && ((FILE_FORMAT_RLE2 != pstr_args->str_options.enu_format) ||
+                                                 ((BLOCK_CODEC_RLE2 != pstr_args->str_options.enu_block_codec) &&
+                                                  (BLOCK_CODEC_HUFFMAN != pstr_args->str_options.enu_block_codec))))
+                {
+                    LOG_ERROR("--level 2 is only supported with -f rle2");
+                    pstr_args->enu_operation = OP_HELP;
+                }
+                else
+                {
+                    pstr_args->str_options.enu_format = FILE_FORMAT_RLE2;
+                    pstr_args->str_options.enu_block_codec = BLOCK_CODEC_HUFFMAN;
+                }
+            }
+
+            if ((OP_HELP != pstr_args->enu_operation) && (0 == pstr_args->u32_input_count) && (NULL == pstr_args->pc_file_list))
+            {
+                LOG_ERROR("No input files given");
+                pstr_args->enu_operation = OP_HELP;
+            }
+
+            // "-" streams stdin to stdout, it cannot share the run with files
+            for (u32 i = 0; (OP_HELP != pstr_args->enu_operation) && (i < pstr_args->u32_input_count); i++)
+            {
+                if ((0 == strcmp(pstr_args->ppc_input_files[i], "-")) &&
+                    ((OP_COMPRESS != pstr_args->enu_operation && OP_DECOMPRESS != pstr_args->enu_operation) ||
+                     (1 != pstr_args->u32_input_count) || (NULL != pstr_args->pc_file_list)))
+                {
+                    LOG_ERROR("- (stdin/stdout) must be the only input");
+                    pstr_args->enu_operation = OP_HELP;
+                }
+            }
+
+            if ((FLUSH_POLICY_NONE != pstr_args->str_options.enu_flush_policy) &&
+                ((1 != pstr_args->u32_input_count) || (0 != strcmp(pstr_args->ppc_input_files[0], "-")) ||
+                 (true == pstr_args->str_options.b_test_only)))
+            {
+                LOG_ERROR("--flush only applies to - (stdin/stdout)");
+                pstr_args->enu_operation = OP_HELP;
+            }
+
+            if ((true == pstr_args->b_range) && ((1 != pstr_args->u32_input_count) || (NULL != pstr_args->pc_file_list) ||
+                                                 (0 == strcmp(pstr_args->ppc_input_files[0], "-"))))
+            {
+                LOG_ERROR("-x takes exactly one compressed file");
+                pstr_args->enu_operation = OP_HELP;
+            }
+
+            // -a and -l take one path, -e an archive then member names
+            if (((OP_ARCHIVE == pstr_args->enu_operation) || (OP_LIST == pstr_args->enu_operation)) && (1 != pstr_args->u32_input_count))
+            {
+                LOG_ERROR("%s takes exactly one path", argv[1]);
+                pstr_args->enu_operation = OP_HELP;
+            }
+
+            // The text format is one stream, a single .rle file cannot be coded in parallel
+            if ((OP_COMPRESS == pstr_args->enu_operation) && (FILE_FORMAT_RLE == pstr_args->str_options.enu_format) &&
+                (1 < pstr_args->str_options.u32_thread_count) && (1 == pstr_args->u32_input_count) && (NULL == pstr_args->pc_file_list))
+            {
+                LOG_ERROR("-j is only supported with -f rle2 or several input files");
+                pstr_args->enu_operation = OP_HELP;
+            }
         }
         else
         {
@@ -557,3 +1459,19 @@ void parse_input_args(int argc, const char *argv[], tstr_input_args *pstr_args)
         }
     }
 }
+
+/**
+ * @brief Release the memory held by parsed arguments
+ * 
+ * @param[in out] pstr_args Parsed arguments
+ * @return void
+ */
+void free_input_args(tstr_input_args *pstr_args)
+{
+    if (NULL != pstr_args)
+    {
+        free_allocated_memory((void *)pstr_args->ppc_input_files);
+        pstr_args->ppc_input_files = NULL;
+        pstr_args->u32_input_count = 0;
+    }
+}
@@ -0,0 +1,649 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "../header_files/utils.h"
+#include "../header_files/buffer.h"
+#include "../header_files/rle2.h"
+#include "../header_files/container.h"
+#include "../header_files/vfile.h"
+
+// Cached decoded block, linked in its hash bucket and in the LRU list
+typedef struct tstr_vfile_cache_entry {
+    tstr_vfile_key str_key;
+    u32 u32_block_idx;
+    u32 u32_pin_count;                                // Reads copying from the block outside the lock
+    bool b_detached;                                  // Out of the cache while pinned, freed by the last unpin
+    tstr_byte_buffer str_data;                        // Decoded block, u64_size is the raw size of the block
+    struct tstr_vfile_cache_entry *pstr_hash_next;
+    struct tstr_vfile_cache_entry *pstr_lru_prev;     // Toward the most recently used block
+    struct tstr_vfile_cache_entry *pstr_lru_next;     // Toward the next block to evict
+} tstr_vfile_cache_entry;
+
+// Block cache shared by every open virtual file, guarded by str_mutex
+typedef struct {
+    pthread_mutex_t str_mutex;
+    tstr_vfile_cache_entry *apstr_buckets[VFILE_CACHE_BUCKET_COUNT];
+    tstr_vfile_cache_entry *pstr_lru_head;     // Most recently used block
+    tstr_vfile_cache_entry *pstr_lru_tail;     // Next block to evict
+    tstr_vfile_cache_stats str_stats;
+} tstr_vfile_cache;
+
+static tstr_vfile_cache gstr_vfile_cache = {PTHREAD_MUTEX_INITIALIZER, {NULL}, NULL, NULL, {0, 0, 0, 0, VFILE_CACHE_DEFAULT_CAPACITY_BYTES, 0}};
+
+
+/**
+ * @brief Get the hash bucket of one block
+ * 
+ * @param[in] pstr_key Cache key of the file
+ * @param[in] u32_block_idx Index of the block in the file
+ * @return u32 Bucket index
+ */
+static u32 u32_vfile_cache_bucket(const tstr_vfile_key *pstr_key, const u32 u32_block_idx)
+{
+    const u64 u64_hash = ((pstr_key->u64_inode << 32) ^ (pstr_key->u64_device << 20) ^ u32_block_idx) * 0x9E3779B97F4A7C15ull;
+
+    return (u32)(u64_hash >> 40) & (VFILE_CACHE_BUCKET_COUNT - 1);
+}
+
+/**
+ * @brief Look a block up in the cache, called with the cache lock held
+ * 
+ * A block cached for another version of the file has the same device, inode and index
+ * but not the same size or mtime, it is found too and the caller drops it.
+ * 
+ * @param[in] pstr_key Cache key of the file
+ * @param[in] u32_block_idx Index of the block in the file
+ * @return tstr_vfile_cache_entry* Cached block, NULL when not cached
+ */
+static tstr_vfile_cache_entry *pstr_vfile_cache_find(const tstr_vfile_key *pstr_key, const u32 u32_block_idx)
+{
+    tstr_vfile_cache_entry *pstr_entry = gstr_vfile_cache.apstr_buckets[u32_vfile_cache_bucket(pstr_key, u32_block_idx)];
+
+    while ((NULL != pstr_entry) && ((pstr_entry->str_key.u64_device != pstr_key->u64_device) || (pstr_entry->str_key.u64_inode != pstr_key->u64_inode) ||
+                                    (pstr_entry->u32_block_idx != u32_block_idx)))
+    {
+        pstr_entry = pstr_entry->pstr_hash_next;
+    }
+
+    return pstr_entry;
+}
+
+/**
+ * @brief Check that a cached block was decoded from the current version of its file
+ * 
+ * @param[in] pstr_entry Cached block
+ * @param[in] pstr_key Cache key of the open file
+ * @return true The size and mtime of the file match the cached block
+ * @return false The file changed since the block was cached
+ */
+static bool b_vfile_cache_fresh(const tstr_vfile_cache_entry *pstr_entry, const tstr_vfile_key *pstr_key)
+{
+    return (pstr_entry->str_key.u64_file_size == pstr_key->u64_file_size) && (pstr_entry->str_key.u64_mtime_ns == pstr_key->u64_mtime_ns);
+}
+
+/**
+ * @brief Take a block out of the LRU list, called with the cache lock held
+ * 
+ * @param[in out] pstr_entry Cached block
+ * @return void
+ */
+static void vfile_cache_lru_unlink(tstr_vfile_cache_entry *pstr_entry)
+{
+    if (NULL != pstr_entry->pstr_lru_prev)
+    {
+        pstr_entry->pstr_lru_prev->pstr_lru_next = pstr_entry->pstr_lru_next;
+    }
+    else
+    {
+        gstr_vfile_cache.pstr_lru_head = pstr_entry->pstr_lru_next;
+    }
+
+    if (NULL != pstr_entry->pstr_lru_next)
+    {
+        pstr_entry->pstr_lru_next->pstr_lru_prev = pstr_entry->pstr_lru_prev;
+    }
+    else
+    {
+        gstr_vfile_cache.pstr_lru_tail = pstr_entry->pstr_lru_prev;
+    }
+
+    pstr_entry->pstr_lru_prev = NULL;
+    pstr_entry->pstr_lru_next = NULL;
+}
+
+/**
+ * @brief Put a block at the most recently used end of the LRU list, called with the cache lock held
+ * 
+ * @param[in out] pstr_entry Cached block, not in the list
+ * @return void
+ */
+static void vfile_cache_lru_push_front(tstr_vfile_cache_entry *pstr_entry)
+{
+    pstr_entry->pstr_lru_prev = NULL;
+    pstr_entry->pstr_lru_next = gstr_vfile_cache.pstr_lru_head;
+
+    if (NULL != gstr_vfile_cache.pstr_lru_head)
+    {
+        gstr_vfile_cache.pstr_lru_head->pstr_lru_prev = pstr_entry;
+    }
+    else
+    {
+        gstr_vfile_cache.pstr_lru_tail = pstr_entry;
+    }
+
+    gstr_vfile_cache.pstr_lru_head = pstr_entry;
+}
+
+/**
+ * @brief Free a block taken out of the cache
+ * 
+ * @param[in out] pstr_entry Block out of the hash table and the LRU list, not pinned
+ * @return void
+ */
+static void vfile_cache_entry_free(tstr_vfile_cache_entry *pstr_entry)
+{
+    byte_buffer_free(&pstr_entry->str_data);
+    free_allocated_memory(pstr_entry);
+}
+
+/**
+ * @brief Drop a block from the cache, called with the cache lock held
+ * 
+ * A pinned block is only detached, the read copying from it frees it when done.
+ * 
+ * @param[in out] pstr_entry Cached block
+ * @return void
+ */
+static void vfile_cache_remove(tstr_vfile_cache_entry *pstr_entry)
+{
+    tstr_vfile_cache_entry **ppstr_link = &gstr_vfile_cache.apstr_buckets[u32_vfile_cache_bucket(&pstr_entry->str_key, pstr_entry->u32_block_idx)];
+
+    while (*ppstr_link != pstr_entry)
+    {
+        ppstr_link = &(*ppstr_link)->pstr_hash_next;
+    }
+
+    *ppstr_link = pstr_entry->pstr_hash_next;
+
+    vfile_cache_lru_unlink(pstr_entry);
+
+    gstr_vfile_cache.str_stats.u64_cached_bytes -= pstr_entry->str_data.u64_capacity;
+    gstr_vfile_cache.str_stats.u32_cached_blocks--;
+
+    if (0 == pstr_entry->u32_pin_count)
+    {
+        vfile_cache_entry_free(pstr_entry);
+    }
+    else
+    {
+        pstr_entry->b_detached = true;
+    }
+}
+
+/**
+ * @brief Release a block pinned by a read
+ * 
+ * @param[in out] pstr_entry Pinned block, freed when it was dropped from the cache meanwhile
+ * @return void
+ */
+static void vfile_cache_unpin(tstr_vfile_cache_entry *pstr_entry)
+{
+    bool b_free = false;
+
+    pthread_mutex_lock(&gstr_vfile_cache.str_mutex);
+
+    pstr_entry->u32_pin_count--;
+    b_free = (0 == pstr_entry->u32_pin_count) && (true == pstr_entry->b_detached);
+
+    pthread_mutex_unlock(&gstr_vfile_cache.str_mutex);
+
+    if (true == b_free)
+    {
+        vfile_cache_entry_free(pstr_entry);
+    }
+}
+
+/**
+ * @brief Evict the least recently used blocks until the cache fits a budget, called with the cache lock held
+ * 
+ * @param[in] u64_budget_bytes Memory the cached blocks may keep
+ * @return void
+ */
+static void vfile_cache_trim(const u64 u64_budget_bytes)
+{
+    while ((gstr_vfile_cache.str_stats.u64_cached_bytes > u64_budget_bytes) && (NULL != gstr_vfile_cache.pstr_lru_tail))
+    {
+        vfile_cache_remove(gstr_vfile_cache.pstr_lru_tail);
+        gstr_vfile_cache.str_stats.u64_evictions++;
+    }
+}
+
+/**
+ * @brief Hand a decoded block over to the cache
+ * 
+ * Blocks larger than the whole cache, or cached meanwhile by another thread, are left to
+ * the caller. A block cached for an older version of the file is replaced. Running out
+ * of memory for the entry only skips caching.
+ * 
+ * @param[in] pstr_file Open virtual file the block was decoded from
+ * @param[in] u32_block_idx Index of the block in the file
+ * @param[in out] pstr_data Decoded block, reset to an empty buffer when the cache takes it
+ * @return void
+ */
+static void vfile_cache_insert(const tstr_vfile *pstr_file, const u32 u32_block_idx, tstr_byte_buffer *pstr_data)
+{
+    pthread_mutex_lock(&gstr_vfile_cache.str_mutex);
+
+    tstr_vfile_cache_entry *pstr_entry = pstr_vfile_cache_find(&pstr_file->str_key, u32_block_idx);
+
+    if ((NULL != pstr_entry) && (false == b_vfile_cache_fresh(pstr_entry, &pstr_file->str_key)))
+    {
+        vfile_cache_remove(pstr_entry);
+        pstr_entry = NULL;
+    }
+
+    if ((pstr_data->u64_capacity <= gstr_vfile_cache.str_stats.u64_capacity_bytes) && (NULL == pstr_entry))
+    {
+        pstr_entry = (tstr_vfile_cache_entry *)malloc(sizeof(tstr_vfile_cache_entry));
+
+        if (NULL != pstr_entry)
+        {
+            const u32 u32_bucket = u32_vfile_cache_bucket(&pstr_file->str_key, u32_block_idx);
+
+            vfile_cache_trim(gstr_vfile_cache.str_stats.u64_capacity_bytes - pstr_data->u64_capacity);
+
+            pstr_entry->str_key = pstr_file->str_key;
+            pstr_entry->u32_block_idx = u32_block_idx;
+            pstr_entry->u32_pin_count = 0;
+            pstr_entry->b_detached = false;
+            pstr_entry->str_data = *pstr_data;
+            pstr_entry->pstr_hash_next = gstr_vfile_cache.apstr_buckets[u32_bucket];
+            gstr_vfile_cache.apstr_buckets[u32_bucket] = pstr_entry;
+
+            vfile_cache_lru_push_front(pstr_entry);
+
+            gstr_vfile_cache.str_stats.u64_cached_bytes += pstr_data->u64_capacity;
+            gstr_vfile_cache.str_stats.u32_cached_blocks++;
+
+            byte_buffer_init(pstr_data);
+        }
+    }
+
+    pthread_mutex_unlock(&gstr_vfile_cache.str_mutex);
+}
+
+/**
+ * @brief Read and decode one block of a virtual file
+ * 
+ * @param[in] pstr_file Open virtual file
+ * @param[in] u32_block_idx Index of the block in the file
+ * @param[in out] pstr_data Empty buffer to hold the decoded block, sized to the block
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_vfile_decode_block(const tstr_vfile *pstr_file, const u32 u32_block_idx, tstr_byte_buffer *pstr_data)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    const tstr_block_index_entry *pstr_entry = &pstr_file->pstr_entries[u32_block_idx];
+    char *pc_coded = (char *)malloc(CONTAINER_BLOCK_HEADER_SIZE + (u64)pstr_entry->u32_compressed_size);
+    tstr_output_window str_window = {{NULL, 0, 0}, 0, 0, NULL, NULL, NULL, 0};
+    tstr_block_header str_header = {0};
+
+    do
+    {
+        if (NULL == pc_coded)
+        {
+            LOG_ERROR("Error allocating memory for block %u: %s", u32_block_idx, strerror(errno));
+            s32_ret_val = ERROR_MEMORY_ALLOCATION_FAILED;
+            break;
+        }
+
+        s32_ret_val = container_read_indexed_block(pstr_file->pf_file, pstr_entry, pc_coded, &str_header);
+        ERROR_BREAK(s32_ret_val);
+
+        // A window of exactly one block never flushes, the window buffer becomes the cached block
+        s32_ret_val = output_window_reserve(&str_window, str_header.u32_raw_size);
+        ERROR_BREAK(s32_ret_val);
+
+        s32_ret_val = container_decode_block(&str_header, &pc_coded[CONTAINER_BLOCK_HEADER_SIZE], &str_window);
+        ERROR_BREAK(s32_ret_val);
+
+        if ((0 != str_window.u64_total_size) || (str_window.str_buffer.u64_size != str_header.u32_raw_size))
+        {
+            LOG_ERROR("Block %u does not decode to its %u bytes.", u32_block_idx, str_header.u32_raw_size);
+            s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+            break;
+        }
+
+        // Capacity is reserved in powers of two with slack for the run stores, the cache keeps the data only
+        s32_ret_val = byte_buffer_shrink_to_fit(&str_window.str_buffer);
+        ERROR_BREAK(s32_ret_val);
+
+        *pstr_data = str_window.str_buffer;
+        byte_buffer_init(&str_window.str_buffer);
+
+    } while (0);
+
+    free_allocated_memory(pc_coded);
+    byte_buffer_free(&str_window.str_buffer);
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Copy part of one block of a virtual file, through the shared cache
+ * 
+ * Hits pin the block and copy outside the cache lock, an eviction meanwhile leaves the
+ * block to the read. Misses decode outside the lock, two threads missing the same block
+ * both decode it.
+ * 
+ * @param[in] pstr_file Open virtual file
+ * @param[in] u32_block_idx Index of the block in the file
+ * @param[in] u64_block_offset Offset of the first byte to copy in the block
+ * @param[in] u64_copy_size Number of bytes to copy, within the block
+ * @param[in out] pc_output_data Buffer to hold the bytes
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+static s32 s32_vfile_read_block(const tstr_vfile *pstr_file, const u32 u32_block_idx, const u64 u64_block_offset, const u64 u64_copy_size, char *pc_output_data)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    tstr_vfile_cache_entry *pstr_entry = NULL;
+
+    pthread_mutex_lock(&gstr_vfile_cache.str_mutex);
+
+    pstr_entry = pstr_vfile_cache_find(&pstr_file->str_key, u32_block_idx);
+
+    if ((NULL != pstr_entry) && (false == b_vfile_cache_fresh(pstr_entry, &pstr_file->str_key)))
+    {
+        vfile_cache_remove(pstr_entry);
+        pstr_entry = NULL;
+    }
+
+    if (NULL != pstr_entry)
+    {
+        gstr_vfile_cache.str_stats.u64_hits++;
+
+        vfile_cache_lru_unlink(pstr_entry);
+        vfile_cache_lru_push_front(pstr_entry);
+
+        pstr_entry->u32_pin_count++;
+    }
+    else
+    {
+        gstr_vfile_cache.str_stats.u64_misses++;
+    }
+
+    pthread_mutex_unlock(&gstr_vfile_cache.str_mutex);
+
+    if (NULL != pstr_entry)
+    {
+        memcpy(pc_output_data, &pstr_entry->str_data.pc_data[u64_block_offset], u64_copy_size);
+
+        vfile_cache_unpin(pstr_entry);
+    }
+    else
+    {
+        tstr_byte_buffer str_data;
+
+        byte_buffer_init(&str_data);
+
+        s32_ret_val = s32_vfile_decode_block(pstr_file, u32_block_idx, &str_data);
+
+        if (SUCCESS_STATUS == s32_ret_val)
+        {
+            memcpy(pc_output_data, &str_data.pc_data[u64_block_offset], u64_copy_size);
+
+            vfile_cache_insert(pstr_file, u32_block_idx, &str_data);
+        }
+
+        byte_buffer_free(&str_data);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Open a seekable .rle2 block file for random-access reads of its original data
+ * 
+ * Only the file header and the block index are read, blocks are decoded on demand by
+ * vfile_pread() and kept in the block cache shared by all open files.
+ * 
+ * @param[in out] pstr_file Virtual file to open
+ * @param[in] pc_path Path to the compressed file
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 vfile_open(tstr_vfile *pstr_file, const char *pc_path)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_file || NULL == pc_path)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        FILE *pf_file = NULL;
+        tstr_block_index_entry *pstr_entries = NULL;
+        u32 u32_block_count = 0;
+        u64 u64_file_size = 0;
+        char ac_rle2_header[RLE2_HEADER_SIZE];
+        tstr_rle2_header str_rle2_header = {0};
+        struct stat str_file_stat;
+
+        pstr_file->pf_file = NULL;
+        pstr_file->pstr_entries = NULL;
+
+        do
+        {
+            s32_ret_val = open_file(pc_path, "rb", &pf_file);
+            ERROR_BREAK(s32_ret_val);
+
+            if (0 != fstat(fileno(pf_file), &str_file_stat))
+            {
+                LOG_ERROR("Error reading the status of %s: %s", pc_path, strerror(errno));
+                s32_ret_val = ERROR_FILE_READ_FAILED;
+                break;
+            }
+
+            // Text .rle files and version 1 streams have no block index to seek with
+            if ((false == is_regular_file(pf_file, &u64_file_size)) || (SUCCESS_STATUS != read_file_at(pf_file, ac_rle2_header, RLE2_HEADER_SIZE, 0)) ||
+                (false == rle2_has_magic(ac_rle2_header, RLE2_HEADER_SIZE)))
+            {
+                LOG_ERROR("%s is not a seekable .rle2 file.", pc_path);
+                s32_ret_val = ERROR_INVALID_ARGUMENTS;
+                break;
+            }
+
+            s32_ret_val = rle2_read_header(ac_rle2_header, RLE2_HEADER_SIZE, &str_rle2_header);
+            ERROR_BREAK(s32_ret_val);
+
+            if (RLE2_VERSION_BLOCKS != str_rle2_header.u8_version)
+            {
+                LOG_ERROR("%s is a version %u .rle2 stream without block index.", pc_path, str_rle2_header.u8_version);
+                s32_ret_val = ERROR_INVALID_ARGUMENTS;
+                break;
+            }
+
+            s32_ret_val = container_load_index(pf_file, u64_file_size, &pstr_entries, &u32_block_count);
+            ERROR_BREAK(s32_ret_val);
+
+            const u64 u64_raw_size = container_index_raw_size(pstr_entries, u32_block_count);
+
+            if ((0 == (str_rle2_header.u8_flags & RLE2_FLAG_SIZE_UNKNOWN)) && (u64_raw_size != str_rle2_header.u64_original_size))
+            {
+                LOG_ERROR("Block index covers %lu bytes, the original size is %lu.", u64_raw_size, str_rle2_header.u64_original_size);
+                s32_ret_val = ERROR_DECOMPRESSION_FAILED;
+                break;
+            }
+
+            pstr_file->pf_file = pf_file;
+            pstr_file->pstr_entries = pstr_entries;
+            pstr_file->u32_block_count = u32_block_count;
+            pstr_file->str_key.u64_device = (u64)str_file_stat.st_dev;
+            pstr_file->str_key.u64_inode = (u64)str_file_stat.st_ino;
+            pstr_file->str_key.u64_file_size = u64_file_size;
+            pstr_file->str_key.u64_mtime_ns = ((u64)str_file_stat.st_mtim.tv_sec * 1000000000ull) + (u64)str_file_stat.st_mtim.tv_nsec;
+            pstr_file->u64_size = u64_raw_size;
+            pf_file = NULL;
+            pstr_entries = NULL;
+
+        } while (0);
+
+        free_allocated_memory(pstr_entries);
+
+        if (NULL != pf_file)
+        {
+            close_file(&pf_file);
+        }
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Read bytes of the original data at an offset, like pread()
+ * 
+ * Reads stop at the end of the data, so fewer bytes than requested are read only there.
+ * Any number of threads may read the same file at the same time.
+ * 
+ * @param[in] pstr_file Open virtual file
+ * @param[in out] pc_buffer Buffer to hold the data (at least u64_size bytes)
+ * @param[in] u64_size Number of bytes to read
+ * @param[in] u64_offset Offset of the first byte in the original data
+ * @param[in out] pu64_read_size Pointer to hold the number of bytes read, 0 at or past the end
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 vfile_pread(const tstr_vfile *pstr_file, char *pc_buffer, const u64 u64_size, const u64 u64_offset, u64 *pu64_read_size)
+{
+    s32 s32_ret_val = SUCCESS_STATUS;
+
+    if (NULL == pstr_file || NULL == pstr_file->pf_file || NULL == pc_buffer || NULL == pu64_read_size)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        u64 u64_end = u64_offset;
+        u64 u64_position = u64_offset;
+
+        if (u64_offset < pstr_file->u64_size)
+        {
+            u64_end = ((pstr_file->u64_size - u64_offset) < u64_size) ? pstr_file->u64_size : (u64_offset + u64_size);
+        }
+
+        for (u32 i = container_find_block(pstr_file->pstr_entries, pstr_file->u32_block_count, u64_offset); u64_position < u64_end; i++)
+        {
+            const tstr_block_index_entry *pstr_entry = &pstr_file->pstr_entries[i];
+            const u64 u64_block_offset = u64_position - pstr_entry->u64_raw_offset;
+            u64 u64_copy_size = pstr_entry->u32_raw_size - u64_block_offset;
+
+            if (u64_copy_size > (u64_end - u64_position))
+            {
+                u64_copy_size = u64_end - u64_position;
+            }
+
+            s32_ret_val = s32_vfile_read_block(pstr_file, i, u64_block_offset, u64_copy_size, &pc_buffer[u64_position - u64_offset]);
+            ERROR_BREAK(s32_ret_val);
+
+            u64_position += u64_copy_size;
+        }
+
+        *pu64_read_size = u64_position - u64_offset;
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Get the size of the original data of an open virtual file
+ * 
+ * @param[in] pstr_file Open virtual file
+ * @return u64 Size of the original data
+ */
+u64 vfile_size(const tstr_vfile *pstr_file)
+{
+    return (NULL != pstr_file) ? pstr_file->u64_size : 0;
+}
+
+/**
+ * @brief Close a virtual file
+ * 
+ * Its blocks stay in the shared cache for the next open of the file until the LRU evicts them.
+ * 
+ * @param[in out] pstr_file Virtual file to close, no read may be running on it
+ * @return s32 SUCCESS_STATUS on success, error code otherwise 
+ */
+s32 vfile_close(tstr_vfile *pstr_file)
+{
+    s32 s32_ret_val = FAILURE_STATUS;
+
+    if (NULL == pstr_file || NULL == pstr_file->pf_file)
+    {
+        s32_ret_val = ERROR_NULL_POINTER;
+    }
+    else
+    {
+        free_allocated_memory(pstr_file->pstr_entries);
+        pstr_file->pstr_entries = NULL;
+        pstr_file->u32_block_count = 0;
+        pstr_file->u64_size = 0;
+
+        s32_ret_val = close_file(&pstr_file->pf_file);
+    }
+
+    return s32_ret_val;
+}
+
+/**
+ * @brief Set the memory budget of the shared block cache, evicting blocks down to it
+ * 
+ * @param[in] u64_capacity_bytes Budget in bytes, 0 to disable caching
+ * @return void
+ */
+void vfile_cache_set_capacity(const u64 u64_capacity_bytes)
+{
+    pthread_mutex_lock(&gstr_vfile_cache.str_mutex);
+
+    gstr_vfile_cache.str_stats.u64_capacity_bytes = u64_capacity_bytes;
+    vfile_cache_trim(u64_capacity_bytes);
+
+    pthread_mutex_unlock(&gstr_vfile_cache.str_mutex);
+}
+
+/**
+ * @brief Get a snapshot of the shared block cache counters
+ * 
+ * @param[in out] pstr_stats Pointer to hold the counters
+ * @return void
+ */
+void vfile_cache_get_stats(tstr_vfile_cache_stats *pstr_stats)
+{
+    if (NULL != pstr_stats)
+    {
+        pthread_mutex_lock(&gstr_vfile_cache.str_mutex);
+
+        *pstr_stats = gstr_vfile_cache.str_stats;
+
+        pthread_mutex_unlock(&gstr_vfile_cache.str_mutex);
+    }
+}
+
+/**
+ * @brief Reset the hit, miss and eviction counters of the shared block cache
+ * 
+ * @return void
+ */
+void vfile_cache_reset_stats(void)
+{
+    pthread_mutex_lock(&gstr_vfile_cache.str_mutex);
+
+    gstr_vfile_cache.str_stats.u64_hits = 0;
+    gstr_vfile_cache.str_stats.u64_misses = 0;
+    gstr_vfile_cache.str_stats.u64_evictions = 0;
+
+    pthread_mutex_unlock(&gstr_vfile_cache.str_mutex);
+}
\ No newline at end of file